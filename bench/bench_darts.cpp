@@ -0,0 +1,231 @@
+#include <benchmark/benchmark.h>
+#include "Distribution.h"
+#include "Game.h"
+#include "Geometry.h"
+#include "MatchSimulator.h"
+#include "Random.h"
+#include "Solver.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Microbenchmarks of the solver hot paths on the board of the web app.
+ *
+ * Run with --benchmark_out=file.json --benchmark_out_format=json (or build the
+ * bench_json target) to keep results for comparison, e.g. with
+ * tools/compare.py from Google Benchmark. Build with CMAKE_BUILD_TYPE=Release,
+ * the default build is unoptimised.
+ */
+
+namespace {
+
+// Standard deviations in mm, from a strong player to a beginner
+constexpr std::array<double, 3> SIGMAS = {10.0, 25.0, 40.0};
+constexpr size_t NUM_POINTS = 4096;
+
+const Target& board() {
+    static const Target target(DARTS_BENCH_TARGET);
+    return target;
+}
+
+NormalDistribution::covariance covariance_for(int64_t index) {
+    double var = SIGMAS[index] * SIGMAS[index];
+    return {{{var, 0.1 * var}, {0.1 * var, 0.8 * var}}};
+}
+
+std::string sigma_label(int64_t index) {
+    return "sigma=" + std::to_string(static_cast<int>(SIGMAS[index]));
+}
+
+// Uniform points over the padded board bounds, the same for every run
+std::vector<Vec2> board_points(size_t n) {
+    NormalDistributionQuadrature dist(covariance_for(0));
+    GameFinishOnDouble game(board(), dist);
+    auto bounds = game.get_target_bounds();
+    RandomEngine rng(SEED);
+    std::vector<Vec2> points;
+    points.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        double u = rng.uniform();
+        double v = rng.uniform();
+        points.emplace_back(bounds.min.x + u * (bounds.max.x - bounds.min.x),
+                            bounds.min.y + v * (bounds.max.y - bounds.min.y));
+    }
+    return points;
+}
+
+void covariances(benchmark::internal::Benchmark* b) {
+    b->DenseRange(0, SIGMAS.size() - 1);
+}
+
+} // namespace
+
+static void BM_PolygonContains(benchmark::State& state) {
+    const auto& beds = board().get_beds();
+    const auto points = board_points(NUM_POINTS);
+    size_t i = 0;
+    for (auto _ : state) {
+        Vec2 p = points[i++ % points.size()];
+        for (const auto& bed : beds) {
+            benchmark::DoNotOptimize(bed.get_shape().contains(p));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * beds.size()));
+}
+BENCHMARK(BM_PolygonContains);
+
+static void BM_TargetAfterHit(benchmark::State& state) {
+    const auto points = board_points(NUM_POINTS);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(board().after_hit(points[i++ % points.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TargetAfterHit);
+
+static void BM_QuadraturePolygonBed(benchmark::State& state) {
+    NormalDistributionQuadrature dist(covariance_for(state.range(0)));
+    const auto& beds = board().get_beds();
+    const auto aims = board_points(64);
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& bed = beds[i % beds.size()];
+        benchmark::DoNotOptimize(dist.integrate_probability(bed.get_shape(), aims[i / beds.size() % aims.size()]));
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(sigma_label(state.range(0)));
+}
+BENCHMARK(BM_QuadraturePolygonBed)->Apply(covariances);
+
+static void BM_QuadratureSectorBed(benchmark::State& state) {
+    NormalDistributionQuadrature dist(covariance_for(state.range(0)));
+    std::vector<PolarSector> sectors;
+    for (const auto& bed : board().get_beds()) {
+        if (bed.get_sector()) sectors.push_back(*bed.get_sector());
+    }
+    if (sectors.empty()) {
+        state.SkipWithError("board has no sector beds");
+        return;
+    }
+    const auto aims = board_points(64);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dist.integrate_probability(sectors[i % sectors.size()], aims[i / sectors.size() % aims.size()]));
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(sigma_label(state.range(0)));
+}
+BENCHMARK(BM_QuadratureSectorBed)->Apply(covariances);
+
+// First call on a fresh game: builds the outcome list and compiles the aim's row
+static void BM_ThrowAtDistributionCold(benchmark::State& state) {
+    NormalDistributionQuadrature dist(covariance_for(state.range(0)));
+    const auto aims = board_points(64);
+    size_t i = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto game = std::make_unique<GameFinishOnDouble>(board(), dist);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(game->throw_at_distribution(aims[i++ % aims.size()]));
+        state.PauseTiming();
+        game.reset();
+        state.ResumeTiming();
+    }
+    state.SetLabel(sigma_label(state.range(0)));
+}
+BENCHMARK(BM_ThrowAtDistributionCold)->Apply(covariances);
+
+// Repeated calls on already compiled aims
+static void BM_ThrowAtDistributionWarm(benchmark::State& state) {
+    NormalDistributionQuadrature dist(covariance_for(state.range(0)));
+    GameFinishOnDouble game(board(), dist);
+    const auto aims = board_points(64);
+    for (Vec2 aim : aims) benchmark::DoNotOptimize(game.throw_at_distribution(aim));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(game.throw_at_distribution(aims[i++ % aims.size()]));
+    }
+    state.SetLabel(sigma_label(state.range(0)));
+}
+BENCHMARK(BM_ThrowAtDistributionWarm)->Apply(covariances);
+
+// Full solve of states 1..101 from scratch, range(1) aims
+static void BM_SolverMinThrowsSolve(benchmark::State& state) {
+    NormalDistributionQuadrature dist(covariance_for(state.range(0)));
+    const size_t num_aims = static_cast<size_t>(state.range(1));
+    for (auto _ : state) {
+        GameFinishOnDouble game(board(), dist);
+        SolverMinThrows solver(game, num_aims);
+        for (Game::State s = 1; s <= 101; ++s) {
+            benchmark::DoNotOptimize(solver.solve(s));
+        }
+    }
+    state.SetLabel(sigma_label(state.range(0)));
+}
+BENCHMARK(BM_SolverMinThrowsSolve)
+    ->ArgsProduct({{0, 1, 2}, {400, 2500}})
+    ->Unit(benchmark::kMillisecond);
+
+// Full solve of round start states 2..170 from scratch, range(1) aims
+static void BM_SolverMinRoundsSolve(benchmark::State& state) {
+    NormalDistributionQuadrature dist(covariance_for(state.range(0)));
+    const size_t num_aims = static_cast<size_t>(state.range(1));
+    for (auto _ : state) {
+        GameFinishOnDouble game(board(), dist);
+        SolverMinRounds solver(game, 3, num_aims);
+        for (Game::State s = 2; s <= 170; ++s) {
+            benchmark::DoNotOptimize(solver.solve(s));
+        }
+    }
+    state.SetLabel(sigma_label(state.range(0)));
+}
+// The round solver is far slower per aim than SolverMinThrows, so it runs on a coarse grid
+BENCHMARK(BM_SolverMinRoundsSolve)
+    ->ArgsProduct({{0, 2}, {100}})
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(1);
+
+// Heat map of one state on a solved SolverMinThrows, range(1) x range(1) cells
+static void BM_HeatMap(benchmark::State& state) {
+    NormalDistributionQuadrature dist(covariance_for(state.range(0)));
+    GameFinishOnDouble game(board(), dist);
+    SolverMinThrows solver(game, 2500);
+    solver.solve_all(101, 1);
+    const size_t cells = static_cast<size_t>(state.range(1));
+    for (auto _ : state) {
+        HeatMapVisualizer visualizer(solver, cells, cells);
+        benchmark::DoNotOptimize(visualizer.heat_map(101));
+    }
+    state.SetLabel(sigma_label(state.range(0)));
+}
+BENCHMARK(BM_HeatMap)
+    ->ArgsProduct({{0, 2}, {50, 100}})
+    ->Unit(benchmark::kMillisecond);
+
+// Legs of 101 played with a solved SolverMinThrows policy, items are darts
+static void BM_MatchSimulator(benchmark::State& state) {
+    NormalDistributionQuadrature dist(covariance_for(state.range(0)));
+    GameFinishOnDouble game(board(), dist);
+    SolverMinThrows solver(game, 2500);
+    MatchSimulator simulator(game, LegPolicy::from_solver(solver, 101));
+    uint64_t darts = 0;
+    for (auto _ : state) {
+        auto result = simulator.simulate(101, 100000);
+        darts += result.darts_thrown;
+        benchmark::DoNotOptimize(result.darts.mean);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(darts));
+    state.SetLabel(sigma_label(state.range(0)));
+}
+BENCHMARK(BM_MatchSimulator)
+    ->Apply(covariances)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
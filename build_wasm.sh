@@ -14,10 +14,11 @@ emcmake cmake .. \
   -DCMAKE_BUILD_TYPE=Release \
   -DBUILD_TESTING=OFF
 
-# Build
-emmake make darts_wasm -j$(nproc)
+# Build the single-threaded module and the pthreads one for cross-origin isolated pages
+emmake make darts_wasm darts_wasm_mt -j$(nproc)
 
 echo ""
 echo "Build complete! WebAssembly files generated in src/web/"
 echo "To test, run: python3 -m http.server 8000"
+echo "(http.server does not send the COOP/COEP headers, so the page uses the single-thread module)"
 echo "Then open: http://localhost:8000/src/web/"
@@ -1,10 +1,23 @@
 #include "Game.h"
 #include "Solver.h"
 #include "Distribution.h"
+#include "CovarianceBatch.h"
 #include "Geometry.h"
+#include "HitProbabilityField.h"
+#include "Instrumentation.h"
+#include "ResultStream.h"
+#include "SolutionTable.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 
 void try_avg_dist(NormalDistribution* dist, int NUM_SAMPLE_ITERATIONS = 10000) {
@@ -32,8 +45,8 @@ void print_results(SolverMinThrows &solver, int MAX_DARTS_STATE = 101, size_t GR
         std::cout << "Heat map for state " << state << ":\n";
         std::cout << "Heat map extent: " << min_point.x << " " << min_point.y << " " 
                   << max_point.x << " " << max_point.y << "\n";
-        for (const auto& row : heat_map) {
-            for (const auto& cell : row) {
+        for (size_t r = 0; r < heat_map.rows(); ++r) {
+            for (double cell : heat_map[r]) {
                 std::cout << cell << " ";
             }
             std::cout << "\n";
@@ -43,14 +56,265 @@ void print_results(SolverMinThrows &solver, int MAX_DARTS_STATE = 101, size_t GR
     }
 }
 
-int main() {
+// Options of --stream, see main()
+struct StreamOptions {
+    std::string path;
+    Game::State first_state = 1;
+    Game::State last_state = 101;
+    size_t rows = 100;
+    size_t cols = 100;
+    bool heat_maps = true;
+    std::string solver = "min-throws";
+    NormalDistribution::covariance cov = {{{1600, 0}, {0, 1600}}};
+};
+
+StreamOptions parse_stream_options(int argc, char** argv) {
+    StreamOptions options;
+    options.path = argv[2];
+    for (int i = 3; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--no-heat-maps") {
+            options.heat_maps = false;
+            continue;
+        }
+        if (i + 1 >= argc) throw std::invalid_argument("Missing value of " + option);
+        const std::string value = argv[++i];
+        if (option == "--states") {
+            const size_t colon = value.find(':');
+            options.first_state = static_cast<Game::State>(std::stoul(value.substr(0, colon)));
+            options.last_state = colon == std::string::npos ? options.first_state
+                                                            : static_cast<Game::State>(std::stoul(value.substr(colon + 1)));
+        } else if (option == "--grid") {
+            const size_t x = value.find('x');
+            options.rows = std::stoul(value.substr(0, x));
+            options.cols = x == std::string::npos ? options.rows : std::stoul(value.substr(x + 1));
+        } else if (option == "--solver") {
+            options.solver = value;
+        } else if (option == "--sigma") {
+            const double sigma = std::stod(value);
+            options.cov = {{{sigma * sigma, 0}, {0, sigma * sigma}}};
+        } else if (option == "--cov") {
+            // xx,xy,yy
+            const size_t first = value.find(',');
+            const size_t second = value.find(',', first + 1);
+            if (second == std::string::npos) throw std::invalid_argument("--cov expects xx,xy,yy");
+            const double xy = std::stod(value.substr(first + 1, second - first - 1));
+            options.cov = {{{std::stod(value.substr(0, first)), xy}, {xy, std::stod(value.substr(second + 1))}}};
+        } else {
+            throw std::invalid_argument("Unknown option " + option);
+        }
+    }
+    if (options.first_state < 1 || options.last_state < options.first_state) {
+        throw std::invalid_argument("--states expects first:last with 1 <= first <= last");
+    }
+    if (options.rows == 0 || options.cols == 0) throw std::invalid_argument("--grid expects positive sizes");
+    return options;
+}
+
+// Solve the selected states and stream them to a .npy file, see ResultStream. The writer
+// thread converts and writes each state while the next one is computed.
+void stream_results(const StreamOptions& options) {
+    NormalDistributionQuadrature dist(options.cov, Vec2{0, 0});
+    Target target("target.out");
+    GameFinishOnDouble game(target, dist);
+    HitProbabilityField field(target, dist, game.aim_grid(10000));
+    game.use_hit_probability_field(field);
+
+    std::unique_ptr<Solver> solver;
+    if (options.solver == "min-throws") {
+        auto min_throws = std::make_unique<SolverMinThrows>(game, 10000, SearchPolicy::exhaustive(true));
+        min_throws->solve_all(options.last_state);
+        solver = std::move(min_throws);
+    } else if (options.solver == "min-rounds") {
+        solver = std::make_unique<SolverMinRounds>(game, 3, 10000);
+    } else if (options.solver == "max-points") {
+        solver = std::make_unique<MaxPointsSolver>(game, 10000);
+    } else {
+        throw std::invalid_argument("Unknown solver " + options.solver + ", expected min-throws, min-rounds or max-points");
+    }
+
+    const size_t rows = options.heat_maps ? options.rows : 0;
+    const size_t cols = options.heat_maps ? options.cols : 0;
+    HeatMapVisualizer visualizer(*solver, options.rows, options.cols);
+    ResultStream stream(options.path, options.last_state - options.first_state + 1, rows, cols,
+                        game.get_target_bounds());
+    for (Game::State state = options.first_state; state <= options.last_state; ++state) {
+        auto [score, aim] = solver->solve(state);
+        HeatMap heat_map = options.heat_maps ? visualizer.heat_map(state) : HeatMap();
+        visualizer.trim_memo(0); // Every state is visited once
+        stream.push({state, score, aim, std::move(heat_map)});
+    }
+    stream.close();
+    std::cerr << "Wrote " << options.last_state - options.first_state + 1 << " states to " << options.path << std::endl;
+}
+
+// Solve the standard board with double and with float hit probabilities, see Precision,
+// and print how far expected throws and optimal aims of the float run drift per state.
+// Hit probabilities come from the quadrature, or from a HitProbabilityField with use_field.
+void validate_precision(double sigma, bool use_field) {
+    constexpr Game::State MAX_STATE = 101;
+    const NormalDistribution::covariance cov = {{{sigma * sigma, 0}, {0, sigma * sigma}}};
+    Target target("target.out");
+
+    struct Run {
+        std::vector<std::pair<double, Vec2>> solutions; // Index state - 1
+        double seconds;
+    };
+    auto run = [&](Precision precision) {
+        const auto start = std::chrono::steady_clock::now();
+        NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+        dist.set_precision(precision);
+        GameFinishOnDouble game(target, dist);
+        std::optional<HitProbabilityField> field;
+        if (use_field) {
+            field.emplace(target, dist, game.aim_grid(10000), 1.0, precision);
+            game.use_hit_probability_field(*field);
+        }
+        SolverMinThrows solver(game, 10000, SearchPolicy::exhaustive(true));
+        solver.solve_all(MAX_STATE);
+        Run result;
+        for (Game::State state = 1; state <= MAX_STATE; ++state) result.solutions.push_back(solver.solve(state));
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    };
+    const Run reference = run(Precision::DOUBLE);
+    const Run rounded = run(Precision::FLOAT);
+
+    double max_delta = 0.0;
+    double max_relative = 0.0;
+    double max_drift = 0.0;
+    int moved = 0;
+    std::cout << "state double_throws float_throws delta aim_drift_mm" << std::endl;
+    for (Game::State state = 1; state <= MAX_STATE; ++state) {
+        const auto [score, aim] = reference.solutions[state - 1];
+        const auto [float_score, float_aim] = rounded.solutions[state - 1];
+        const double delta = float_score - score;
+        const double drift = std::hypot(float_aim.x - aim.x, float_aim.y - aim.y);
+        std::cout << state << " " << score << " " << float_score << " " << delta << " " << drift << std::endl;
+        if (std::isfinite(score) && std::isfinite(float_score)) {
+            max_delta = std::max(max_delta, std::abs(delta));
+            max_relative = std::max(max_relative, std::abs(delta) / score);
+        }
+        max_drift = std::max(max_drift, drift);
+        if (drift > 0.0) ++moved;
+    }
+    std::cout << "Max |delta| expected throws: " << max_delta << " (relative " << max_relative << ")\n"
+              << "States whose aim moved: " << moved << " of " << MAX_STATE << ", max drift " << max_drift << " mm\n"
+              << "Time double: " << reference.seconds << " s, float: " << rounded.seconds << " s" << std::endl;
+}
+
+// Usage: darts [solution_table]
+//        darts --convert-target input output
+//        darts --solve-profiles output_directory sigma [sigma ...]
+//        darts --stream output.npy [--states first:last] [--grid rowsxcols] [--solver name]
+//                                  [--sigma s | --cov xx,xy,yy] [--no-heat-maps]
+//        darts --validate-precision [sigma] [--field]
+// With a table path, solutions are loaded from it when it matches this configuration,
+// otherwise they are computed and written to it for the next run.
+// --convert-target writes a text or binary target in the binary target format.
+// --solve-profiles writes the table of this run for each standard deviation sigma (in mm),
+// as output_directory/sigma_<sigma>.dsol, solving the profiles together.
+// --stream writes score, aim and float heat map of each state as a .npy record array instead
+// of text. Defaults: states 1:101, a 100x100 grid, the min-throws solver (or min-rounds,
+// max-points) and sigma 40.
+// --validate-precision compares the min-throws solutions of double and float hit probabilities
+// on the standard board (sigma 40 by default), integrated by quadrature or with --field by
+// a HitProbabilityField, and prints the drift of every state and a summary.
+// Built with DARTS_INSTRUMENTATION, the profiling counters are printed to stderr at the end.
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--convert-target") {
+        if (argc != 4) {
+            std::cerr << "Usage: " << argv[0] << " --convert-target input output" << std::endl;
+            return 1;
+        }
+        Target(std::string(argv[2])).save_binary(std::string(argv[3]));
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--solve-profiles") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " --solve-profiles output_directory sigma [sigma ...]" << std::endl;
+            return 1;
+        }
+        std::vector<NormalDistribution::covariance> covariances;
+        std::vector<std::string> paths;
+        for (int i = 3; i < argc; ++i) {
+            double sigma = std::stod(argv[i]);
+            covariances.push_back({{{sigma * sigma, 0}, {0, sigma * sigma}}});
+            paths.push_back((std::filesystem::path(argv[2]) / ("sigma_" + std::string(argv[i]) + ".dsol")).string());
+        }
+        Target target("target.out");
+        CovarianceBatch<GameFinishOnDouble> batch(target, covariances, 10000, SearchPolicy::exhaustive(true));
+        batch.write(paths, 101, 0, 100, 100);
+        for (const auto& path : paths) std::cerr << "Wrote solutions to " << path << std::endl;
+        if (Instrumentation::ENABLED) Instrumentation::print(std::cerr);
+        return 0;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--stream") {
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " --stream output.npy [--states first:last] [--grid rowsxcols]"
+                      << " [--solver min-throws|min-rounds|max-points] [--sigma s | --cov xx,xy,yy] [--no-heat-maps]"
+                      << std::endl;
+            return 1;
+        }
+        try {
+            stream_results(parse_stream_options(argc, argv));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        if (Instrumentation::ENABLED) Instrumentation::print(std::cerr);
+        return 0;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--validate-precision") {
+        double sigma = 40.0;
+        bool use_field = false;
+        try {
+            for (int i = 2; i < argc; ++i) {
+                const std::string option = argv[i];
+                if (option == "--field") {
+                    use_field = true;
+                } else {
+                    sigma = std::stod(option);
+                }
+            }
+            validate_precision(sigma, use_field);
+        } catch (const std::exception& e) {
+            std::cerr << "Usage: " << argv[0] << " --validate-precision [sigma] [--field]: " << e.what() << std::endl;
+            return 1;
+        }
+        if (Instrumentation::ENABLED) Instrumentation::print(std::cerr);
+        return 0;
+    }
+
     NormalDistribution::covariance cov = {{{1600, 0}, {0, 1600}}};
     NormalDistributionQuadrature dist(cov, Vec2{0, 0});
     try_avg_dist(&dist);
     Target target("target.out");
     GameFinishOnDouble game(target, dist);
-    SolverMinThrows solver(game, 10000);
+    // Same 100x100 grid the solver samples with 10000 aims.
+    HitProbabilityField field(target, dist, game.aim_grid(10000));
+    game.use_hit_probability_field(field);
+    SolverMinThrows solver(game, 10000, SearchPolicy::exhaustive(true)); // Pruning, same results
+
+    const int MAX_DARTS_STATE = 101;
+    const std::string table_path = argc > 1 ? argv[1] : "";
+    if (!table_path.empty() && std::filesystem::exists(table_path)) {
+        try {
+            solver.use_solution_table(SolutionTable::open(table_path));
+            std::cerr << "Loaded solutions from " << table_path << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Ignoring " << table_path << ": " << e.what() << std::endl;
+        }
+    }
+    solver.solve_all(MAX_DARTS_STATE); // Bottom-up on all cores, print_results then only reads the memo
+    if (!table_path.empty() && solver.get_solution_table() == nullptr) {
+        SolutionTable::write(table_path, solver, MAX_DARTS_STATE, 100, 100); // Planes of print_results' heat maps
+        std::cerr << "Wrote solutions to " << table_path << std::endl;
+    }
 
     print_results(solver);
+    if (Instrumentation::ENABLED) Instrumentation::print(std::cerr);
     return 0;
 }
\ No newline at end of file
@@ -4,9 +4,13 @@
 #include "../cpp/Game.h"
 #include "../cpp/Distribution.h"
 #include "../cpp/Solver.h"
+#include "../cpp/SolutionTable.h"
+#include "../cpp/Instrumentation.h"
 #include <string>
+#include <algorithm>
 #include <array>
 #include <sstream>
+#include <thread>
 
 using namespace emscripten;
 
@@ -61,7 +65,8 @@ SolveResult solverSolveMinRoundsRoundState(
     return SolveResult{score, aim};
 }
 
-std::vector<std::vector<double>> solverHeatMapMinRoundsRoundState(
+// Map of an in-round state in passes, to be driven with step(); the job refers to solver
+ProgressiveHeatMap* solverProgressiveHeatMapMinRoundsRoundState(
     SolverMinRounds& solver,
     Game::State round_start_score,
     Game::State current_score,
@@ -69,24 +74,104 @@ std::vector<std::vector<double>> solverHeatMapMinRoundsRoundState(
     size_t rows,
     size_t cols
 ) {
-    auto bounds = solver.get_game().get_target_bounds();
-    std::vector<std::vector<double>> heat_map(rows, std::vector<double>(cols, 0.0));
-
-    for (size_t c = 0; c < cols; ++c) {
-        for (size_t r = 0; r < rows; ++r) {
-            double x = bounds.min.x + (bounds.max.x - bounds.min.x) * (c + 0.5) / cols;
-            double y = bounds.min.y + (bounds.max.y - bounds.min.y) * (r + 0.5) / rows;
-            heat_map[r][c] = solver.solve_aim_round_state(round_start_score, current_score, throw_number, Vec2{x, y});
+    if (solver.get_retain_aim_scores()) {
+        (void)solver.solve_round_state(round_start_score, current_score, throw_number);
+        if (auto heat_map = solver.retained_heat_map_round_state(round_start_score, current_score, throw_number,
+                                                                 solver.get_game().get_target_bounds(), rows, cols)) {
+            return new ProgressiveHeatMap(std::move(*heat_map));
         }
     }
+    return new ProgressiveHeatMap(solver.get_game().get_target_bounds(), rows, cols, [=, &solver](Vec2 aim) {
+        return solver.solve_aim_round_state(round_start_score, current_score, throw_number, aim);
+    });
+}
+
+// Progressive heat map of a visualizer; the job refers to the visualizer
+ProgressiveHeatMap* heatMapVisualizerProgressive(HeatMapVisualizer& visualizer, Game::State state) {
+    return new ProgressiveHeatMap(visualizer.progressive(state));
+}
+
+// Threads ThreadPool uses by default: the pthread pool in darts_wasm_mt, 1 in darts_wasm
+unsigned int wasmThreadCount() {
+#ifdef __EMSCRIPTEN_PTHREADS__
+    return std::max(1u, std::thread::hardware_concurrency());
+#else
+    return 1;
+#endif
+}
+
+// Native map of an in-round state, cells are evaluated on the module's threads
+HeatMap solverHeatMapMinRoundsRoundState(
+    SolverMinRounds& solver,
+    Game::State round_start_score,
+    Game::State current_score,
+    unsigned int throw_number,
+    size_t rows,
+    size_t cols
+) {
+    return solver.heat_map(round_start_score, current_score, throw_number, rows, cols, wasmThreadCount());
+}
 
-    return heat_map;
+// Solve states 1..max_state with the parallel bottom-up scan, so later solves are memo lookups
+void solverSolveAll(SolverMinThrows& solver, Game::State max_state) {
+    solver.solve_all(max_state, wasmThreadCount());
+}
+
+// Keeps a solution table alive on the JS side, one table can serve several solvers
+struct SolutionTableHandle {
+    std::shared_ptr<const SolutionTable> table;
+};
+
+// Table from the bytes of a .dsol file, e.g. a fetched ArrayBuffer passed as Uint8Array
+SolutionTableHandle* createSolutionTable(const std::string& bytes) {
+    return new SolutionTableHandle{SolutionTable::from_bytes(std::as_bytes(std::span(bytes.data(), bytes.size())))};
+}
+
+// Returns false instead of throwing when the table belongs to another configuration
+bool solverUseSolutionTable(Solver& solver, const SolutionTableHandle& handle) {
+    if (handle.table->get_key() != solver.solution_key()) return false;
+    solver.use_solution_table(handle.table);
+    return true;
+}
+
+// Instrumentation::report() as a plain object; counts become Numbers, exact below 2^53
+val instrumentationReport() {
+    const auto report = Instrumentation::report();
+    val result = val::object();
+    result.set("enabled", Instrumentation::ENABLED);
+    val counters = val::object();
+    for (size_t k = 0; k < Instrumentation::COUNTERS; ++k) {
+        counters.set(std::string(Instrumentation::name(static_cast<Instrumentation::Counter>(k))),
+                     static_cast<double>(report.counters[k]));
+    }
+    result.set("counters", counters);
+    val timers = val::object();
+    for (size_t k = 0; k < Instrumentation::TIMERS; ++k) {
+        val timer = val::object();
+        timer.set("seconds", report.seconds[k]);
+        timer.set("calls", static_cast<double>(report.timer_calls[k]));
+        timers.set(std::string(Instrumentation::name(static_cast<Instrumentation::Timer>(k))), timer);
+    }
+    result.set("timers", timers);
+    val by_state = val::array();
+    for (uint64_t evaluations : report.aim_evaluations_by_state) by_state.call<void>("push", static_cast<double>(evaluations));
+    result.set("aimEvaluationsByState", by_state);
+    val rounds = val::array();
+    for (const auto& round : report.round_convergence) {
+        val entry = val::object();
+        entry.set("state", round.state);
+        entry.set("iterations", round.iterations);
+        entry.set("delta", round.delta);
+        rounds.call<void>("push", entry);
+    }
+    result.set("roundConvergence", rounds);
+    result.set("roundDpCacheEntries", static_cast<double>(report.round_dp_cache_entries));
+    return result;
 }
 
 EMSCRIPTEN_BINDINGS(darts_module) {
     // Register vector types
     register_vector<double>("VectorDouble");
-    register_vector<std::vector<double>>("VectorVectorDouble");
     
     // Vec2 value type
     value_object<Vec2>("Vec2")
@@ -102,6 +187,13 @@ EMSCRIPTEN_BINDINGS(darts_module) {
     value_object<SolveResult>("SolveResult")
         .field("expected_throws", &SolveResult::expected_throws)
         .field("optimal_aim", &SolveResult::optimal_aim);
+
+    // Memory of one cache, see LruCache
+    value_object<CacheUsage>("CacheUsage")
+        .field("bytes", &CacheUsage::bytes)
+        .field("budget", &CacheUsage::budget)
+        .field("entries", &CacheUsage::entries)
+        .field("evictions", &CacheUsage::evictions);
     
     // Constructor function for Vec2
     function("createVec2", optional_override([](double x, double y) {
@@ -118,7 +210,11 @@ EMSCRIPTEN_BINDINGS(darts_module) {
         .function("sample", &Distribution::sample);
     
     // Abstract NormalDistribution - no constructor
-    class_<NormalDistribution, base<Distribution>>("NormalDistribution");
+    class_<NormalDistribution, base<Distribution>>("NormalDistribution")
+        .function("add_point", &NormalDistribution::add_point)
+        .function("set_parameters", optional_override([](NormalDistribution& dist, const val& cov_array, Vec2 mean) {
+            dist.set_parameters(js_to_covariance(cov_array), mean);
+        }));
     
     // Concrete distribution classes - use wrapper constructors
     class_<NormalDistributionRandom, base<NormalDistribution>>("NormalDistributionRandom")
@@ -130,8 +226,12 @@ EMSCRIPTEN_BINDINGS(darts_module) {
     
     // Abstract Game base - expose inherited functions
     class_<Game>("Game")
-        .function("throw_at_sample", &Game::throw_at_sample)
-        .function("get_target_bounds", &Game::get_target_bounds);
+        .function("throw_at_sample", select_overload<Game::State(Vec2, Game::State) const>(&Game::throw_at_sample))
+        .function("get_target_bounds", &Game::get_target_bounds)
+        .function("refresh_distribution", &Game::refresh_distribution)
+        .function("get_outcome_table_usage", &Game::get_outcome_table_usage)
+        .function("set_outcome_table_budget", &Game::set_outcome_table_budget)
+        .function("trim_off_grid_rows", &Game::trim_off_grid_rows);
     
     // Concrete game classes
     class_<GameFinishOnAny, base<Game>>("GameFinishOnAny")
@@ -142,25 +242,81 @@ EMSCRIPTEN_BINDINGS(darts_module) {
     
     // Abstract Solver base - no constructor (pure virtual)
     class_<Solver>("Solver")
-        .function("solve_aim", &Solver::solve_aim);
+        .function("solve_aim", &Solver::solve_aim)
+        .function("set_retain_aim_scores", &Solver::set_retain_aim_scores)
+        .function("get_retain_aim_scores", &Solver::get_retain_aim_scores)
+        .function("set_aim_score_budget", &Solver::set_aim_score_budget)
+        .function("get_aim_score_usage", &Solver::get_aim_score_usage)
+        .function("trim_aim_scores", &Solver::trim_aim_scores);
     
     // Concrete solver implementations
     class_<SolverMinThrows, base<Solver>>("SolverMinThrows")
-        .constructor<const Game&, size_t>();
+        .constructor<const Game&, size_t>()
+        .function("warm_start", optional_override([](SolverMinThrows& solver) { solver.warm_start(); }));
     
     class_<MaxPointsSolver, base<Solver>>("MaxPointsSolver")
         .constructor<const Game&, size_t>();
     
     class_<SolverMinRounds, base<Solver>>("SolverMinRounds")
-        .constructor<const Game&, unsigned int, size_t>();
+        .constructor<const Game&, unsigned int, size_t>()
+        .function("warm_start", &SolverMinRounds::warm_start)
+        .function("set_round_cache_budget", &SolverMinRounds::set_round_cache_budget)
+        .function("get_round_cache_usage", &SolverMinRounds::get_round_cache_usage)
+        .function("trim_round_cache", &SolverMinRounds::trim_round_cache);
     
     // Wrapper function for Solver::solve (returns SolveResult instead of std::pair)
     function("solverSolve", &solverSolve);
     function("solverSolveMinRoundsRoundState", &solverSolveMinRoundsRoundState);
     function("solverHeatMapMinRoundsRoundState", &solverHeatMapMinRoundsRoundState);
+    function("solverSolveAll", &solverSolveAll);
+    function("wasmThreadCount", &wasmThreadCount);
+
+    // Precomputed solutions, see SolutionTable
+    class_<SolutionTableHandle>("SolutionTable")
+        .constructor(&createSolutionTable, allow_raw_pointers())
+        .function("state_count", optional_override([](const SolutionTableHandle& handle) {
+            return handle.table->get_state_count();
+        }));
+    function("solverUseSolutionTable", &solverUseSolutionTable);
+
+    // Profiling counters, all zero unless built with DARTS_INSTRUMENTATION
+    function("instrumentationReport", &instrumentationReport);
+    function("instrumentationReset", &Instrumentation::reset);
     
+    // Flat heat map; view() is a Float64Array over WASM memory, valid until the map is
+    // deleted or memory grows, so copy it before calling back into the module
+    class_<HeatMap>("HeatMap")
+        .function("rows", &HeatMap::rows)
+        .function("cols", &HeatMap::cols)
+        .function("view", optional_override([](const HeatMap& heat_map) {
+            return val(typed_memory_view(heat_map.size(), heat_map.data()));
+        }));
+
     // HeatMapVisualizer
     class_<HeatMapVisualizer>("HeatMapVisualizer")
         .constructor<Solver&, size_t, size_t>()
-        .function("heat_map", &HeatMapVisualizer::heat_map);
+        .function("heat_map", &HeatMapVisualizer::heat_map)
+        .function("set_memo_budget", &HeatMapVisualizer::set_memo_budget)
+        .function("get_memo_usage", &HeatMapVisualizer::get_memo_usage)
+        .function("trim_memo", &HeatMapVisualizer::trim_memo);
+
+    // Heat maps in coarse-to-fine passes. step(maxCells) returns true when done; between
+    // steps the caller can post result_view() and drop the job to cancel it.
+    class_<ProgressiveHeatMap>("ProgressiveHeatMap")
+        .function("step", optional_override([](ProgressiveHeatMap& job, size_t max_cells) {
+            return job.step(max_cells);
+        }))
+        .function("is_done", &ProgressiveHeatMap::is_done)
+        .function("pass_finished", &ProgressiveHeatMap::pass_finished)
+        .function("passes_done", &ProgressiveHeatMap::passes_done)
+        .function("pass_count", &ProgressiveHeatMap::pass_count)
+        .function("cells_done", &ProgressiveHeatMap::cells_done)
+        .function("cells_total", &ProgressiveHeatMap::cells_total)
+        .function("rows", optional_override([](const ProgressiveHeatMap& job) { return job.result().rows(); }))
+        .function("cols", optional_override([](const ProgressiveHeatMap& job) { return job.result().cols(); }))
+        .function("result_view", optional_override([](const ProgressiveHeatMap& job) {
+            return val(typed_memory_view(job.result().size(), job.result().data()));
+        }));
+    function("heatMapVisualizerProgressive", &heatMapVisualizerProgressive, allow_raw_pointers());
+    function("solverProgressiveHeatMapMinRoundsRoundState", &solverProgressiveHeatMapMinRoundsRoundState, allow_raw_pointers());
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "AimGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+AimGrid::AimGrid(Vec2 min, Vec2 max, size_t width, size_t height)
+    : min_(min), max_(max), width_(width), height_(height) {
+    if (width_ == 0 || height_ == 0) {
+        throw std::invalid_argument("AimGrid needs at least one aim");
+    }
+    aims_.reserve(width_ * height_);
+    for (size_t i = 0; i < width_; ++i) {
+        for (size_t j = 0; j < height_; ++j) {
+            aims_.emplace_back(aim_x(i), aim_y(j));
+        }
+    }
+}
+
+AimGrid AimGrid::with_samples(Vec2 min, Vec2 max, size_t num_samples) {
+    size_t height = static_cast<size_t>(std::sqrt(num_samples));
+    size_t width = height == 0 ? 0 : num_samples / height;
+    return AimGrid(min, max, width, height);
+}
+
+double AimGrid::aim_x(size_t i) const {
+    return min_.x + (max_.x - min_.x) * (i + 0.5) / width_;
+}
+
+double AimGrid::aim_y(size_t j) const {
+    return min_.y + (max_.y - min_.y) * (j + 0.5) / height_;
+}
+
+bool AimGrid::find(Vec2 aim, size_t& i, size_t& j) const {
+    double u = (aim.x - min_.x) / (max_.x - min_.x) * width_ - 0.5;
+    double v = (aim.y - min_.y) / (max_.y - min_.y) * height_ - 0.5;
+    double ru = std::round(u);
+    double rv = std::round(v);
+    if (!(ru >= 0 && rv >= 0 && ru < static_cast<double>(width_) && rv < static_cast<double>(height_))) {
+        return false;
+    }
+    i = static_cast<size_t>(ru);
+    j = static_cast<size_t>(rv);
+    // Only exact grid points count, anything else takes the off-grid path of the caller.
+    return aim_x(i) == aim.x && aim_y(j) == aim.y;
+}
+
+bool AimGrid::find(Vec2 aim, size_t& index) const {
+    size_t i, j;
+    if (!find(aim, i, j)) return false;
+    index = this->index(i, j);
+    return true;
+}
+
+void AimGrid::nearest(Vec2 aim, size_t& i, size_t& j) const {
+    double u = std::round((aim.x - min_.x) / (max_.x - min_.x) * width_ - 0.5);
+    double v = std::round((aim.y - min_.y) / (max_.y - min_.y) * height_ - 0.5);
+    // NaN and negative positions clamp to the first column and row
+    i = u > 0 ? static_cast<size_t>(std::min(u, static_cast<double>(width_ - 1))) : 0;
+    j = v > 0 ? static_cast<size_t>(std::min(v, static_cast<double>(height_ - 1))) : 0;
+}
@@ -0,0 +1,79 @@
+#ifndef AIM_GRID_HEADER
+#define AIM_GRID_HEADER
+
+#include "Geometry.h"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Fixed, uniform grid of aim points with a stable index per aim.
+ * @ingroup game
+ *
+ * Column i and row j map to the aim at the centre of cell (i, j) of a
+ * width x height subdivision of [min, max]. Aims are stored with x as the
+ * outer loop, so index(i, j) = i * height + j. Grids are built once and
+ * shared: Game reserves one outcome table row per grid aim, so solvers and
+ * HitProbabilityField can address outcomes by index instead of hashing points.
+ *
+ * find() recognises grid aims from their coordinates alone, with an exact
+ * comparison, so any other point is reported as off the grid.
+ *
+ * Example usage:
+ * @code
+ * AimGrid grid = AimGrid::with_samples(bounds.min, bounds.max, 10000); // 100 x 100
+ * size_t index;
+ * if (grid.find(Vec2{2.5, -1.0}, index)) { ... grid[index] ... }
+ * @endcode
+ */
+class AimGrid {
+private:
+    Vec2 min_;
+    Vec2 max_;
+    size_t width_;
+    size_t height_;
+    std::vector<Vec2> aims_;
+
+public:
+    /**
+     * @brief Build a width x height grid over [min, max].
+     * @throws std::invalid_argument if the grid is empty
+     */
+    AimGrid(Vec2 min, Vec2 max, size_t width, size_t height);
+
+    /**
+     * @brief Build the grid solvers use for num_samples aims.
+     * The height is floor(sqrt(num_samples)) and the width num_samples / height.
+     */
+    [[nodiscard]] static AimGrid with_samples(Vec2 min, Vec2 max, size_t num_samples);
+
+    /** @brief X coordinate of column i. */
+    [[nodiscard]] double aim_x(size_t i) const;
+    /** @brief Y coordinate of row j. */
+    [[nodiscard]] double aim_y(size_t j) const;
+    /** @brief Flat index of column i and row j. */
+    [[nodiscard]] size_t index(size_t i, size_t j) const { return i * height_ + j; }
+
+    /** @brief Find column i and row j of aim, returns false when aim is not exactly a grid point. */
+    [[nodiscard]] bool find(Vec2 aim, size_t& i, size_t& j) const;
+    /** @brief Find the flat index of aim, returns false when aim is not exactly a grid point. */
+    [[nodiscard]] bool find(Vec2 aim, size_t& index) const;
+    /** @brief Column i and row j of the grid aim closest to aim, which may lie anywhere. */
+    void nearest(Vec2 aim, size_t& i, size_t& j) const;
+
+    [[nodiscard]] size_t size() const { return aims_.size(); }
+    [[nodiscard]] Vec2 operator[](size_t index) const { return aims_[index]; }
+    [[nodiscard]] std::span<const Vec2> aims() const { return aims_; }
+    [[nodiscard]] size_t get_width() const { return width_; }
+    [[nodiscard]] size_t get_height() const { return height_; }
+    [[nodiscard]] Vec2 get_min() const { return min_; }
+    [[nodiscard]] Vec2 get_max() const { return max_; }
+
+    /** @brief Grids are equal when they produce the same aims. */
+    [[nodiscard]] bool operator==(const AimGrid& other) const {
+        return min_ == other.min_ && max_ == other.max_ && width_ == other.width_ && height_ == other.height_;
+    }
+};
+
+#endif
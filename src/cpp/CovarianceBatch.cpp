@@ -0,0 +1,60 @@
+#include "CovarianceBatch.h"
+#include "HitProbabilityField.h"
+#include "SolutionTable.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+template <typename GameType>
+CovarianceBatch<GameType>::CovarianceBatch(const Target& target, std::vector<NormalDistribution::covariance> covariances,
+                                           size_t num_samples, SearchPolicy search_policy, Vec2 mean)
+    : target_(target), covariances_(std::move(covariances)), mean_(mean), num_samples_(num_samples),
+      search_policy_(search_policy) {}
+
+template <typename GameType>
+std::vector<uint64_t> CovarianceBatch<GameType>::write(const std::vector<std::string>& paths, Game::State max_state,
+                                                       size_t num_threads, size_t plane_rows, size_t plane_cols) const {
+    if (paths.size() != covariances_.size()) {
+        throw std::invalid_argument("CovarianceBatch needs one output path per covariance");
+    }
+    std::vector<uint64_t> keys(covariances_.size(), 0);
+    if (covariances_.empty()) return keys;
+
+    // The aim grid only depends on the target, any profile's game gives the same one
+    const NormalDistributionQuadrature first(covariances_.front(), mean_);
+    const AimGrid grid = GameType(target_, first).aim_grid(num_samples_);
+
+    ThreadPool pool(num_threads);
+    for (size_t group = 0; group < covariances_.size(); group += FIELD_GROUP_SIZE) {
+        const size_t group_end = std::min(group + FIELD_GROUP_SIZE, covariances_.size());
+
+        std::vector<std::unique_ptr<NormalDistributionQuadrature>> distributions;
+        std::vector<const NormalDistribution*> views;
+        for (size_t p = group; p < group_end; ++p) {
+            distributions.push_back(std::make_unique<NormalDistributionQuadrature>(covariances_[p], mean_));
+            views.push_back(distributions.back().get());
+        }
+        const auto fields = HitProbabilityField::batch(target_, views, grid);
+
+        // Profiles take turns from a shared counter, their solve times differ widely with sigma
+        std::atomic<size_t> next{0};
+        pool.run([&](size_t) {
+            for (size_t k = next.fetch_add(1); k < distributions.size(); k = next.fetch_add(1)) {
+                GameType game(target_, *distributions[k]);
+                game.use_hit_probability_field(fields[k]);
+                SolverMinThrows solver(game, num_samples_, search_policy_);
+                solver.solve_all(max_state, 1);
+                SolutionTable::write(paths[group + k], solver, max_state, plane_rows, plane_cols);
+                keys[group + k] = solver.solution_key();
+            }
+        });
+    }
+    return keys;
+}
+
+template class CovarianceBatch<GameFinishOnAny>;
+template class CovarianceBatch<GameFinishOnDouble>;
@@ -0,0 +1,82 @@
+#ifndef COVARIANCE_BATCH_HEADER
+#define COVARIANCE_BATCH_HEADER
+
+#include "Distribution.h"
+#include "Game.h"
+#include "Geometry.h"
+#include "Solver.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Solution tables of one game on one target for many throw covariances.
+ * @ingroup solver
+ *
+ * Player profiles differ only in their covariance, so most of the work of
+ * solving them one by one is repeated. The batch shares it:
+ * - the target and the aim grid are built once
+ * - hit probabilities come from HitProbabilityField::batch(), which rasterizes and
+ *   transforms the beds once for a group of covariances
+ * - each profile then runs SolverMinThrows::solve_all() on its own thread, and its
+ *   table is written with SolutionTable::write() as soon as it is solved
+ *
+ * Covariances are processed in groups of FIELD_GROUP_SIZE, which bounds the memory
+ * held by kernel spectra and fields at a time. Every table carries the same key as
+ * a solver built for that profile by hand, so a server opens it with
+ * Solver::use_solution_table() as usual. Grid aims use the FFT field, off-grid aims
+ * (polishing and heat map planes) the quadrature, as in the console application.
+ *
+ * Example usage:
+ * @code
+ * CovarianceBatch<GameFinishOnDouble> batch(target, {beginner, club, pro}, 10000);
+ * batch.write({"beginner.dsol", "club.dsol", "pro.dsol"}, 501);
+ * @endcode
+ */
+template <typename GameType>
+class CovarianceBatch {
+public:
+    static constexpr size_t FIELD_GROUP_SIZE = 8; ///< Covariances whose fields are computed in one sweep
+
+private:
+    const Target& target_;
+    std::vector<NormalDistribution::covariance> covariances_;
+    Vec2 mean_;
+    size_t num_samples_;
+    SearchPolicy search_policy_;
+
+public:
+    /**
+     * @brief Set up a batch; nothing is computed until write().
+     * @param target Target shared by all profiles, must outlive the batch
+     * @param covariances One throw covariance per profile
+     * @param num_samples Number of aims, as for Solver
+     * @param search_policy Search policy of every profile's solver
+     * @param mean Mean throw offset shared by all profiles
+     */
+    CovarianceBatch(const Target& target, std::vector<NormalDistribution::covariance> covariances,
+                    size_t num_samples = 10000, SearchPolicy search_policy = {}, Vec2 mean = Vec2{0, 0});
+
+    [[nodiscard]] const std::vector<NormalDistribution::covariance>& get_covariances() const { return covariances_; }
+
+    /**
+     * @brief Solve states 1 .. max_state for every profile and write one table per profile.
+     * @param paths Output file of each profile, in the order of the covariances
+     * @param max_state Highest state stored
+     * @param num_threads Number of profiles solved at once, 0 for std::thread::hardware_concurrency()
+     * @param plane_rows Rows of the stored heat map planes, 0 for none
+     * @param plane_cols Columns of the stored heat map planes, 0 for none
+     * @return Solution key of each table
+     * @throws std::invalid_argument if there is not one path per covariance
+     * @throws std::runtime_error if a table cannot be written
+     */
+    std::vector<uint64_t> write(const std::vector<std::string>& paths, Game::State max_state, size_t num_threads = 0,
+                                size_t plane_rows = 0, size_t plane_cols = 0) const;
+};
+
+extern template class CovarianceBatch<GameFinishOnAny>;
+extern template class CovarianceBatch<GameFinishOnDouble>;
+
+#endif
@@ -1,50 +1,58 @@
 #include "Distribution.h"
 #include "Geometry.h"
+#include "QuadratureRule.h"
 #include "Random.h"
+#include <algorithm>
+#include <array>
 #include <cmath>
-#include <random>
+#include <utility>
+#include <vector>
 
 namespace {
-    // Dunavant rule 10 (25 quadrature points) for unit reference triangle
-    // (0,0)-(1,0)-(0,1). Expanded from compressed barycentric suborders.
-    // Weights sum to 1.0 (normalized to reference triangle area).
-    // Reference: Dunavant, "High Degree Efficient Symmetrical Gaussian Quadrature
-    // Rules for the Triangle", IJNME Vol 21, 1985, pp. 1129-1148.
-    constexpr int QUAD_NPTS = 25;
-    constexpr double quad_r[QUAD_NPTS] = {
-        0.333333333333333, 0.028844733232685, 0.485577633383657,
-        0.485577633383657, 0.109481575485037, 0.109481575485037,
-        0.781036849029926, 0.141707219414880, 0.141707219414880,
-        0.307939838764121, 0.307939838764121, 0.550352941820999,
-        0.550352941820999, 0.025003534476269, 0.025003534476269,
-        0.246672560639903, 0.246672560639903, 0.728323904597411,
-        0.728323904597411, 0.009540815400299, 0.009540815400299,
-        0.066803251012200, 0.066803251012200, 0.923655933587500,
-        0.923655933587500,
-    };
-    constexpr double quad_s[QUAD_NPTS] = {
-        0.333333333333333, 0.485577633383657, 0.028844733232685,
-        0.485577633383657, 0.109481575485037, 0.781036849029926,
-        0.109481575485037, 0.307939838764121, 0.550352941820999,
-        0.141707219414880, 0.550352941820999, 0.141707219414880,
-        0.307939838764121, 0.246672560639903, 0.728323904597411,
-        0.025003534476269, 0.728323904597411, 0.025003534476269,
-        0.246672560639903, 0.066803251012200, 0.923655933587500,
-        0.009540815400299, 0.923655933587500, 0.009540815400299,
-        0.066803251012200,
+    constexpr size_t QUAD_TRIANGLES_PER_PASS = 8; // Fan triangles handed to the SIMD kernel at once
+
+    // 10-point Gauss-Legendre rule on [-1, 1], used for the angular integral over sectors.
+    constexpr int GL_NPTS = 10;
+    constexpr double gl_x[GL_NPTS] = {
+        -0.973906528517172, -0.865063366688985, -0.679409568299024,
+        -0.433395394129247, -0.148874338981631, 0.148874338981631,
+        0.433395394129247, 0.679409568299024, 0.865063366688985,
+        0.973906528517172,
     };
-    constexpr double quad_w[QUAD_NPTS] = {
-        0.090817990382754, 0.036725957756467, 0.036725957756467,
-        0.036725957756467, 0.045321059435528, 0.045321059435528,
-        0.045321059435528, 0.072757916845420, 0.072757916845420,
-        0.072757916845420, 0.072757916845420, 0.072757916845420,
-        0.072757916845420, 0.028327242531057, 0.028327242531057,
-        0.028327242531057, 0.028327242531057, 0.028327242531057,
-        0.028327242531057, 0.009421666963733, 0.009421666963733,
-        0.009421666963733, 0.009421666963733, 0.009421666963733,
-        0.009421666963733,
+    constexpr double gl_w[GL_NPTS] = {
+        0.066671344308688, 0.149451349150581, 0.219086362515982,
+        0.269266719309996, 0.295524224714753, 0.295524224714753,
+        0.269266719309996, 0.219086362515982, 0.149451349150581,
+        0.066671344308688,
     };
 
+    constexpr double SECTOR_CUTOFF_SIGMAS = 9.0;   // Mass beyond this many standard deviations is ignored
+    constexpr double SECTOR_PANEL_SIGMAS = 2.0;    // Widest angular panel, in standard deviations of arc length
+    constexpr int SECTOR_MAX_PANELS = 512;
+
+    // erf(x1) - erf(x0) without cancellation when both arguments are in the same tail.
+    template <typename Real>
+    Real erf_difference(Real x0, Real x1) {
+        if (x0 >= Real(0)) return std::erfc(x0) - std::erfc(x1);
+        if (x1 <= Real(0)) return std::erfc(-x1) - std::erfc(-x0);
+        return std::erf(x1) - std::erf(x0);
+    }
+
+    // Integral of r * exp(-q(r) / 2) over [r0, r1] for q(r) = a r^2 - 2 b r + c.
+    // Completing the square, q = a (r - m)^2 + k with m = b / a and k = c - b^2 / a >= 0.
+    template <typename Real>
+    Real radial_integral(Real a, Real b, Real c, Real r0, Real r1) {
+        Real m = b / a;
+        Real k = std::max(c - b * m, Real(0));
+        Real t0 = r0 - m;
+        Real t1 = r1 - m;
+        Real s = std::sqrt(Real(0.5) * a);
+        Real edge_terms = (std::exp(Real(-0.5) * (a * t0 * t0 + k)) - std::exp(Real(-0.5) * (a * t1 * t1 + k))) / a;
+        Real centre_term = m * std::sqrt(Real(M_PI) / (Real(2) * a)) * std::exp(Real(-0.5) * k)
+                         * erf_difference(s * t0, s * t1);
+        return edge_terms + centre_term;
+    }
+
     Vec2 ref_to_physical(Vec2 v0, Vec2 v1, Vec2 v2, double r, double s) {
         return Vec2{
             v0.x * (1.0 - r - s) + v1.x * r + v2.x * s,
@@ -74,6 +82,24 @@ void NormalDistribution::calculate_covariance_() {
     cov_[0][1] /= points_.size();
     cov_[1][0] /= points_.size();
     cov_[1][1] /= points_.size();
+
+    count_ = points_.size();
+    for (size_t r = 0; r < 2; ++r) {
+        for (size_t c = 0; c < 2; ++c) co_moments_[r][c] = cov_[r][c] * static_cast<double>(count_);
+    }
+    update_parameters_();
+}
+
+void NormalDistribution::update_parameters_() {
+    inv_cov_ = cov_inverse_();
+    log_normaliser_ = -std::log(2 * M_PI * std::sqrt(cov_determinant_()));
+
+    cholesky_[0][0] = std::sqrt(cov_[0][0]);
+    cholesky_[1][0] = cov_[0][1] / cholesky_[0][0];
+    cholesky_[0][1] = 0.0;
+    cholesky_[1][1] = std::sqrt(cov_[1][1] - cholesky_[1][0] * cholesky_[1][0]);
+
+    kernel_ = GaussianKernel(inv_cov_, log_normaliser_, mean_);
 }
 
 double NormalDistribution::cov_determinant_() const {
@@ -85,44 +111,89 @@ NormalDistribution::covariance NormalDistribution::cov_inverse_() const {
     return {{{cov_[1][1] / det, -cov_[0][1] / det}, {-cov_[1][0] / det, cov_[0][0] / det}}};
 }
 
-NormalDistribution::NormalDistribution(const covariance& cov, Vec2 mean) : cov_(cov), mean_(mean) {}
+NormalDistribution::NormalDistribution(const covariance& cov, Vec2 mean) : cov_(cov), mean_(mean) {
+    update_parameters_();
+}
 
 NormalDistribution::NormalDistribution(std::vector<Vec2> points) : Distribution(std::move(points)) {
     calculate_covariance_();
+    // The running sums carry the fit from here on, add_point() keeps no points either
+    points_.clear();
+    points_.shrink_to_fit();
 }
 
 double NormalDistribution::probability_density(Vec2 p) const {
-    double c = 1.0 / (2 * M_PI * std::sqrt(cov_determinant_()));
     Vec2 diff = p - mean_;
-    covariance inv_cov = cov_inverse_();
     double exponent = -0.5 * (
-        diff.x * (inv_cov[0][0] * diff.x + inv_cov[0][1] * diff.y) +
-        diff.y * (inv_cov[1][0] * diff.x + inv_cov[1][1] * diff.y)
+        diff.x * (inv_cov_[0][0] * diff.x + inv_cov_[0][1] * diff.y) +
+        diff.y * (inv_cov_[1][0] * diff.x + inv_cov_[1][1] * diff.y)
     );
-    return c * std::exp(exponent);
+    return std::exp(log_normaliser_ + exponent);
 }
 
-Vec2 NormalDistribution::sample() const {
-    std::normal_distribution<double> nd(0.0, 1.0);
-    double z1 = nd(random_engine);
-    double z2 = nd(random_engine);
+void NormalDistribution::probability_density(std::span<const Vec2> points, std::span<double> densities) const {
+    const double a = -0.5 * inv_cov_[0][0];
+    const double b = -0.5 * (inv_cov_[0][1] + inv_cov_[1][0]);
+    const double c = -0.5 * inv_cov_[1][1];
+    for (size_t i = 0; i < points.size(); ++i) {
+        double dx = points[i].x - mean_.x;
+        double dy = points[i].y - mean_.y;
+        densities[i] = std::exp(log_normaliser_ + dx * (a * dx + b * dy) + c * dy * dy);
+    }
+}
 
-    // Cholesky decomposition of covariance matrix
-    covariance cholesky{};
-    cholesky[0][0] = std::sqrt(cov_[0][0]);
-    cholesky[1][0] = cov_[0][1] / cholesky[0][0];
-    cholesky[0][1] = 0.0;
-    cholesky[1][1] = std::sqrt(cov_[1][1] - cholesky[1][0] * cholesky[1][0]);
+Vec2 NormalDistribution::sample(RandomEngine& rng) const {
+    std::array<double, 2> z;
+    normal_samples(rng, z);
 
     return Vec2{
-        mean_.x + cholesky[0][0] * z1,
-        mean_.y + cholesky[1][0] * z1 + cholesky[1][1] * z2
+        mean_.x + cholesky_[0][0] * z[0],
+        mean_.y + cholesky_[1][0] * z[0] + cholesky_[1][1] * z[1]
     };
 }
 
+void NormalDistribution::sample(RandomEngine& rng, std::span<Vec2> out) const {
+    std::array<double, 512> z;
+    for (size_t done = 0; done < out.size(); done += z.size() / 2) {
+        size_t n = std::min(z.size() / 2, out.size() - done);
+        normal_samples(rng, std::span<double>(z.data(), 2 * n));
+        for (size_t i = 0; i < n; ++i) {
+            out[done + i] = Vec2{
+                mean_.x + cholesky_[0][0] * z[2 * i],
+                mean_.y + cholesky_[1][0] * z[2 * i] + cholesky_[1][1] * z[2 * i + 1]
+            };
+        }
+    }
+}
+
 void NormalDistribution::add_point(Vec2 p) {
-    points_.push_back(p);
-    calculate_covariance_();
+    if (count_ == 0) {
+        mean_ = Vec2{0.0, 0.0};
+        co_moments_ = {{{0.0, 0.0}, {0.0, 0.0}}};
+    }
+    ++count_;
+    const double n = static_cast<double>(count_);
+    // Deviations from the old and the new mean, their product keeps the co-moments exact
+    const Vec2 before = p - mean_;
+    mean_ = mean_ + before * (1.0 / n);
+    const Vec2 after = p - mean_;
+    co_moments_[0][0] += before.x * after.x;
+    co_moments_[0][1] += before.x * after.y;
+    co_moments_[1][0] = co_moments_[0][1]; // Equal in exact arithmetic, kept symmetric
+    co_moments_[1][1] += before.y * after.y;
+    for (size_t r = 0; r < 2; ++r) {
+        for (size_t c = 0; c < 2; ++c) cov_[r][c] = co_moments_[r][c] / n;
+    }
+    update_parameters_();
+}
+
+void NormalDistribution::set_parameters(const covariance& cov, Vec2 mean) {
+    cov_ = cov;
+    mean_ = mean;
+    points_.clear();
+    count_ = 0;
+    co_moments_ = {{{0.0, 0.0}, {0.0, 0.0}}};
+    update_parameters_();
 }
 
 NormalDistributionRandom::NormalDistributionRandom(const covariance& cov, Vec2 mean, size_t num_samples)
@@ -135,66 +206,181 @@ double NormalDistributionRandom::integrate_probability(const Polygon& region) co
     return integrate_probability(region, Vec2{0.0, 0.0});
 }
 
-double NormalDistributionRandom::integrate_probability(const Polygon& region, Vec2 offset) const {
+template <typename Region>
+double NormalDistributionRandom::fraction_inside_(const Region& region, Vec2 offset) const {
+    RandomEngine rng(seed_);
+    std::array<Vec2, SAMPLE_BLOCK_> block;
     size_t count = 0;
-    for (size_t i = 0; i < num_samples_; ++i) {
-        if (region.contains(sample() + offset)) {
-            ++count;
+    for (size_t done = 0; done < num_samples_; done += SAMPLE_BLOCK_) {
+        std::span<Vec2> samples(block.data(), std::min(SAMPLE_BLOCK_, num_samples_ - done));
+        sample(rng, samples);
+        for (Vec2 p : samples) {
+            if (region.contains(p + offset)) {
+                ++count;
+            }
         }
     }
     return static_cast<double>(count) / static_cast<double>(num_samples_);
 }
 
+double NormalDistributionRandom::integrate_probability(const Polygon& region, Vec2 offset) const {
+    return fraction_inside_(region, offset);
+}
+
+double NormalDistributionRandom::integrate_probability(const PolarSector& region) const {
+    return integrate_probability(region, Vec2{0.0, 0.0});
+}
+
+double NormalDistributionRandom::integrate_probability(const PolarSector& region, Vec2 offset) const {
+    return fraction_inside_(region, offset);
+}
 
 double NormalDistributionQuadrature::integrate_probability(const Polygon& region) const {
     return integrate_probability(region, Vec2{0.0, 0.0});
 }
 
 double NormalDistributionQuadrature::integrate_probability(const Polygon& region, Vec2 offset) const {
+    if (precision_ == Precision::FLOAT) return integrate_polygon_<float>(region, offset);
+    return integrate_polygon_<double>(region, offset);
+}
+
+template <typename Real>
+double NormalDistributionQuadrature::integrate_polygon_(const Polygon& region, Vec2 offset) const {
+    switch (rule_) {
+        case Rule::DUNAVANT_7:
+            return integrate_polygon_<DUNAVANT_7, Real>(region, offset);
+        case Rule::DUNAVANT_12:
+            return integrate_polygon_<DUNAVANT_12, Real>(region, offset);
+        case Rule::DUNAVANT_25:
+            break;
+    }
+    return integrate_polygon_<DUNAVANT_25, Real>(region, offset);
+}
+
+template <const auto& RULE, typename Real>
+double NormalDistributionQuadrature::integrate_polygon_(const Polygon& region, Vec2 offset) const {
     const auto& verts = region.get_vertices();
     if (verts.size() < 3) return 0.0;
 
-    double poly_area = 0.0;
-    for (size_t i = 1; i + 1 < verts.size(); ++i) {
-        poly_area += signed_triangle_area(verts[0], verts[i], verts[i + 1]);
-    }
-    poly_area = std::abs(poly_area);
+    // Area, fan apex and fan triangle areas are cached by the polygon
+    const double poly_area = region.get_area();
 
     double var_measure = cov_[0][0] + cov_[1][1];
     
     // Narrow distribution fallback: if the polygon is much bigger than the variance,
     // the quadrature method breaks. Use a fast sampling strategy instead.
     if (poly_area > 200.0 * var_measure) {
-        size_t num_samples = 50; 
+        // A local generator keeps the result independent of call order and thread
+        RandomEngine rng(SEED);
+        std::array<Vec2, 50> samples;
+        sample(rng, samples);
         size_t count = 0;
-        for (size_t i = 0; i < num_samples; ++i) {
-            if (region.contains(sample() + offset)) {
+        for (Vec2 p : samples) {
+            if (region.contains(p + offset)) {
                 ++count;
             }
         }
-        return static_cast<double>(count) / static_cast<double>(num_samples);
+        return static_cast<double>(count) / static_cast<double>(samples.size());
     }
 
-    Vec2 center(0.0, 0.0);
-    for (const auto& v : verts) {
-        center.x += v.x;
-        center.y += v.y;
-    }
-    center.x /= verts.size();
-    center.y /= verts.size();
+    // Rule points of up to QUAD_TRIANGLES_PER_PASS triangles in structure-of-arrays layout,
+    // with the triangle area folded into the weights.
+    constexpr size_t PASS_POINTS = QUAD_TRIANGLES_PER_PASS * RULE.POINTS;
+    std::array<Real, PASS_POINTS> xs;
+    std::array<Real, PASS_POINTS> ys;
+    std::array<Real, PASS_POINTS> ws;
 
     double total = 0.0;
+    const auto fan_areas = region.get_fan_areas();
+    const Vec2 v0 = region.get_fan_center() - offset;
+    for (size_t first = 0; first < verts.size(); first += QUAD_TRIANGLES_PER_PASS) {
+        size_t count = 0;
+        for (size_t i = first; i < std::min(first + QUAD_TRIANGLES_PER_PASS, verts.size()); ++i) {
+            Vec2 v1 = verts[i] - offset;
+            Vec2 v2 = verts[(i + 1) % verts.size()] - offset;
+            double area = fan_areas[i];
 
-    for (size_t i = 0; i < verts.size(); ++i) {
-        Vec2 v0 = center;
-        Vec2 v1 = verts[i];
-        Vec2 v2 = verts[(i + 1) % verts.size()];
-        double area = signed_triangle_area(v0, v1, v2);
-
-        for (int q = 0; q < QUAD_NPTS; ++q) {
-            Vec2 p = ref_to_physical(v0, v1, v2, quad_r[q], quad_s[q]);
-            total += area * quad_w[q] * probability_density(p - offset);
+            for (size_t q = 0; q < RULE.POINTS; ++q, ++count) {
+                Vec2 p = ref_to_physical(v0, v1, v2, RULE.r[q], RULE.s[q]);
+                xs[count] = static_cast<Real>(p.x);
+                ys[count] = static_cast<Real>(p.y);
+                ws[count] = static_cast<Real>(area * RULE.w[q]);
+            }
         }
+        total += kernel_.weighted_sum(std::span<const Real>(xs.data(), count), std::span<const Real>(ys.data(), count),
+                                      std::span<const Real>(ws.data(), count));
     }
     return std::abs(total);
 }
+
+
+double NormalDistributionQuadrature::integrate_probability(const PolarSector& region) const {
+    return integrate_probability(region, Vec2{0.0, 0.0});
+}
+
+double NormalDistributionQuadrature::integrate_probability(const PolarSector& region, Vec2 offset) const {
+    if (precision_ == Precision::FLOAT) return integrate_sector_<float>(region, offset);
+    return integrate_sector_<double>(region, offset);
+}
+
+template <typename Real>
+double NormalDistributionQuadrature::integrate_sector_(const PolarSector& region, Vec2 offset) const {
+    const double det = cov_determinant_();
+    if (det <= 0.0 || region.r_outer <= region.r_inner) return 0.0;
+    const covariance& inv_cov = inv_cov_;
+    const Vec2 centre = mean_ + offset;
+
+    double half_trace = 0.5 * (cov_[0][0] + cov_[1][1]);
+    double spread = std::sqrt(std::max(half_trace * half_trace - det, 0.0));
+    double sigma_max = std::sqrt(half_trace + spread);
+    double sigma_min = std::sqrt(std::max(half_trace - spread, 0.0));
+    if (sigma_min <= 0.0) return 0.0;
+
+    double cutoff = SECTOR_CUTOFF_SIGMAS * sigma_max;
+    double rho = std::hypot(centre.x, centre.y);
+    if (rho - region.r_outer > cutoff) return 0.0;
+
+    // Angles that can carry mass: all of them when the origin is close to the centre,
+    // otherwise a window around the direction of the centre.
+    std::vector<std::pair<double, double>> ranges;
+    if (rho <= cutoff) {
+        ranges.emplace_back(region.angle_start, region.angle_end);
+    } else {
+        double direction = std::atan2(centre.y, centre.x);
+        double half_width = std::asin(cutoff / rho);
+        for (int turn = -2; turn <= 2; ++turn) {
+            double lo = std::max(region.angle_start, direction - half_width + turn * 2.0 * M_PI);
+            double hi = std::min(region.angle_end, direction + half_width + turn * 2.0 * M_PI);
+            if (lo < hi) ranges.emplace_back(lo, hi);
+        }
+    }
+
+    const double c = centre.x * (inv_cov[0][0] * centre.x + inv_cov[0][1] * centre.y)
+                   + centre.y * (inv_cov[1][0] * centre.x + inv_cov[1][1] * centre.y);
+    const double arc_radius = std::min(region.r_outer, rho + cutoff);
+
+    double total = 0.0;
+    for (const auto& [lo, hi] : ranges) {
+        int panels = static_cast<int>(std::ceil((hi - lo) * arc_radius / (SECTOR_PANEL_SIGMAS * sigma_min)));
+        panels = std::clamp(panels, 1, SECTOR_MAX_PANELS);
+        double width = (hi - lo) / panels;
+        for (int panel = 0; panel < panels; ++panel) {
+            double mid = lo + (panel + 0.5) * width;
+            for (int q = 0; q < GL_NPTS; ++q) {
+                double theta = mid + 0.5 * width * gl_x[q];
+                Vec2 u{std::cos(theta), std::sin(theta)};
+                double a = u.x * (inv_cov[0][0] * u.x + inv_cov[0][1] * u.y)
+                         + u.y * (inv_cov[1][0] * u.x + inv_cov[1][1] * u.y);
+                double b = u.x * (inv_cov[0][0] * centre.x + inv_cov[0][1] * centre.y)
+                         + u.y * (inv_cov[1][0] * centre.x + inv_cov[1][1] * centre.y);
+                // Panel sums stay in double, only the radial integral is evaluated in Real
+                Real radial = radial_integral<Real>(static_cast<Real>(a), static_cast<Real>(b), static_cast<Real>(c),
+                                                    static_cast<Real>(region.r_inner), static_cast<Real>(region.r_outer));
+                total += 0.5 * width * gl_w[q] * static_cast<double>(radial);
+            }
+        }
+    }
+
+    double probability = total * std::exp(log_normaliser_);
+    return std::clamp(probability, 0.0, 1.0);
+}
\ No newline at end of file
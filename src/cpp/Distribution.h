@@ -1,9 +1,13 @@
 #ifndef DISTRIBUTION_HEADER
 #define DISTRIBUTION_HEADER
 
+#include "GaussianKernel.h"
 #include "Geometry.h"
+#include "Precision.h"
+#include "Random.h"
 
 #include <cstddef>
+#include <span>
 #include <stdexcept>
 #include <vector>
 #include <array>
@@ -35,12 +39,36 @@ public:
      * @return Probability density value
      */
     [[nodiscard]] virtual double probability_density(Vec2 p) const = 0;
+
+    /**
+     * @brief Evaluate probability density function at many points at once.
+     * @param points Points to evaluate
+     * @param densities Output, densities[i] is the density at points[i] (same size as points)
+     */
+    virtual void probability_density(std::span<const Vec2> points, std::span<double> densities) const {
+        for (size_t i = 0; i < points.size(); ++i) {
+            densities[i] = probability_density(points[i]);
+        }
+    }
     
     /**
      * @brief Generate a random sample from the distribution.
+     * @param rng Generator to draw from, the distribution itself holds no random state
      * @return Sampled point
      */
-    [[nodiscard]] virtual Vec2 sample() const = 0;
+    [[nodiscard]] virtual Vec2 sample(RandomEngine& rng) const = 0;
+
+    /**
+     * @brief Generate a random sample with the calling thread's generator.
+     */
+    [[nodiscard]] Vec2 sample() const { return sample(thread_random_engine()); }
+
+    /**
+     * @brief Fill out with random samples drawn from rng.
+     */
+    virtual void sample(RandomEngine& rng, std::span<Vec2> out) const {
+        for (auto& p : out) p = sample(rng);
+    }
     
     /**
      * @brief Integrate probability over a polygonal region.
@@ -56,6 +84,21 @@ public:
      * @return Total probability mass in region (between 0 and 1)
      */
     [[nodiscard]] virtual double integrate_probability(const Polygon& region, Vec2 offset) const = 0;
+
+    /**
+     * @brief Integrate probability over an annular sector.
+     * @param region Sector to integrate over
+     * @return Total probability mass in region (between 0 and 1)
+     */
+    [[nodiscard]] virtual double integrate_probability(const PolarSector& region) const = 0;
+
+    /**
+     * @brief Integrate probability over an annular sector with a translated distribution.
+     * @param region Sector to integrate over
+     * @param offset Translation to apply to distribution
+     * @return Total probability mass in region (between 0 and 1)
+     */
+    [[nodiscard]] virtual double integrate_probability(const PolarSector& region, Vec2 offset) const = 0;
     
     /**
      * @brief Add a data point and recompute distribution parameters.
@@ -89,7 +132,19 @@ protected:
     covariance cov_;
     Vec2 mean_;
 
+    // Derived from cov_, kept in sync by update_parameters_().
+    covariance inv_cov_;     ///< Inverse covariance
+    covariance cholesky_;    ///< Lower triangular L with L * L^T = cov_
+    double log_normaliser_;  ///< log(1 / (2 pi sqrt(det cov_)))
+    GaussianKernel kernel_;  ///< Vectorised weighted density sums
+
+    // Running sums of the fitted points, see add_point()
+    size_t count_ = 0;          ///< Points the mean and covariance were fitted to, 0 for explicit parameters
+    covariance co_moments_{};   ///< Sum of the outer products of the deviations from mean_
+
     void calculate_covariance_();
+    /** @brief Recompute the cached inverse, Cholesky factor and normaliser from cov_. */
+    void update_parameters_();
     double cov_determinant_() const;
     covariance cov_inverse_() const;
 public:
@@ -114,16 +169,46 @@ public:
      * Uses formula: f(x) = (1/(2π√|Σ|)) * exp(-0.5(x-μ)ᵀΣ⁻¹(x-μ))
      */
     [[nodiscard]] double probability_density(Vec2 p) const override;
+
+    /**
+     * @brief Evaluate the Gaussian PDF at many points, with the cached parameters hoisted out of the loop.
+     */
+    void probability_density(std::span<const Vec2> points, std::span<double> densities) const override;
     
+    using Distribution::sample;
+
     /**
      * @brief Sample from 2D normal distribution using Cholesky decomposition.
      */
-    [[nodiscard]] Vec2 sample() const override;
+    [[nodiscard]] Vec2 sample(RandomEngine& rng) const override;
+
+    /**
+     * @brief Batch sampling, standard normals come from normal_samples() and are transformed by the Cholesky factor.
+     */
+    void sample(RandomEngine& rng, std::span<Vec2> out) const override;
     
     [[nodiscard]] virtual double integrate_probability(const Polygon& region) const override = 0;
     [[nodiscard]] virtual double integrate_probability(const Polygon& region, Vec2 offset) const override = 0;
-    
+    [[nodiscard]] virtual double integrate_probability(const PolarSector& region) const override = 0;
+    [[nodiscard]] virtual double integrate_probability(const PolarSector& region, Vec2 offset) const override = 0;
+
+    /**
+     * @brief Add a point to the fit in O(1) with Welford's update of the mean and covariance.
+     * A distribution built from explicit parameters starts a new fit at its first point.
+     */
     void add_point(Vec2 p) override;
+
+    /**
+     * @brief Replace mean and covariance, dropping any fitted points.
+     * Games using the distribution must be told with Game::refresh_distribution().
+     */
+    void set_parameters(const covariance& cov, Vec2 mean = Vec2{0, 0});
+
+    /** @brief Number of points the parameters were fitted to, 0 for explicit parameters. */
+    [[nodiscard]] size_t get_point_count() const { return count_; }
+
+    [[nodiscard]] const covariance& get_covariance() const { return cov_; }
+    [[nodiscard]] Vec2 get_mean() const { return mean_; }
 };
 
 /**
@@ -132,6 +217,10 @@ public:
  *
  * Integration over regions is performed by random sampling.
  * Faster for complex regions but approximate. Accuracy improves with more samples.
+ * Every integration draws from a fresh generator seeded with the same seed, so
+ * a result only depends on the region and offset, not on earlier calls or on
+ * which thread asks. The shared samples also make the estimates for the beds
+ * of a board sum to the fraction of samples that hit the board.
  *
  * Example usage:
  * @code
@@ -144,7 +233,13 @@ public:
  */
 class NormalDistributionRandom final : public NormalDistribution {
 private:
+    static constexpr size_t SAMPLE_BLOCK_ = 256; ///< Samples drawn per normal_samples() batch
+
     size_t num_samples_;
+    uint64_t seed_ = SEED;
+
+    template <typename Region>
+    [[nodiscard]] double fraction_inside_(const Region& region, Vec2 offset) const;
 public:
     /**
      * @brief Construct from covariance and mean.
@@ -171,6 +266,16 @@ public:
      * @brief Monte Carlo integration over translated region.
      */
     [[nodiscard]] double integrate_probability(const Polygon& region, Vec2 offset) const override;
+
+    /**
+     * @brief Monte Carlo integration over an annular sector.
+     */
+    [[nodiscard]] double integrate_probability(const PolarSector& region) const override;
+
+    /**
+     * @brief Monte Carlo integration over an annular sector with translated distribution.
+     */
+    [[nodiscard]] double integrate_probability(const PolarSector& region, Vec2 offset) const override;
     
     /**
      * @brief Adjust number of samples for integration.
@@ -180,14 +285,25 @@ public:
     void set_integration_precision(size_t num_samples) {
         num_samples_ = num_samples;
     }
+    [[nodiscard]] size_t get_integration_precision() const { return num_samples_; }
+
+    /**
+     * @brief Choose the seed of the generator every integration starts from.
+     */
+    void set_seed(uint64_t seed) {
+        seed_ = seed;
+    }
+    [[nodiscard]] uint64_t get_seed() const { return seed_; }
 };
 
 /**
  * @ingroup distributions
  * @brief Normal distribution using Gauss quadrature integration.
  *
- * Integration uses Dunavant's 7-point degree-5 quadrature rule on triangles.
- * Exact for polynomials up to degree 5. Much more accurate than Monte Carlo
+ * Integration uses Dunavant's 25-point degree-10 quadrature rule on triangles by
+ * default, exact for polynomials up to degree 10. set_rule() selects the cheaper
+ * 7- or 12-point rules of QuadratureRule.h, for quick previews. The rule points of several fan
+ * triangles are evaluated per pass with the SIMD GaussianKernel. Much more accurate than Monte Carlo
  * for smooth distributions but requires convex polygons.
  *
  * @note Assumes polygons are convex (uses fan triangulation).
@@ -203,11 +319,49 @@ public:
  */
 class NormalDistributionQuadrature final : public NormalDistribution {
     using NormalDistribution::NormalDistribution;
-    
+
+public:
+    /** @brief Triangle rule used for polygons, see QuadratureRule.h. */
+    enum class Rule {
+        DUNAVANT_7,  ///< 7 points, degree 5
+        DUNAVANT_12, ///< 12 points, degree 6
+        DUNAVANT_25, ///< 25 points, degree 10
+    };
+
+private:
+    Rule rule_ = Rule::DUNAVANT_25;
+    Precision precision_ = Precision::DOUBLE;
+
+    /** @brief Polygon integration with the selected rule, kernel inputs in Real. */
+    template <typename Real>
+    [[nodiscard]] double integrate_polygon_(const Polygon& region, Vec2 offset) const;
+
+    /** @brief Polygon integration with a rule fixed at compile time. */
+    template <const auto& RULE, typename Real>
+    [[nodiscard]] double integrate_polygon_(const Polygon& region, Vec2 offset) const;
+
+    /** @brief Sector integration with the radial integrals evaluated in Real. */
+    template <typename Real>
+    [[nodiscard]] double integrate_sector_(const PolarSector& region, Vec2 offset) const;
+
 public:
+    /**
+     * @brief Choose the triangle rule for polygons. Sectors are integrated semi-analytically either way.
+     * A Game compiles its rows with the rule set when they are computed, so call refresh_distribution() after changing it.
+     */
+    void set_rule(Rule rule) { rule_ = rule; }
+    [[nodiscard]] Rule get_rule() const { return rule_; }
+
+    /**
+     * @brief Evaluate the polygon kernel and the sector radial integrals in float, see Precision.
+     * Games compile their rows when they are computed, so call refresh_distribution() after changing it.
+     */
+    void set_precision(Precision precision) { precision_ = precision; }
+    [[nodiscard]] Precision get_precision() const { return precision_; }
+
     /**
      * @brief Gauss quadrature integration over convex polygon.
-     * Triangulates polygon from first vertex and applies 7-point quadrature.
+     * Triangulates polygon from its centroid and applies the selected rule to each triangle.
      * @note For very big polygons, numerical issues may arise. Use for polygons which arent much bigger than the standard deviation of the distribution.
      */
     [[nodiscard]] double integrate_probability(const Polygon& region) const override;
@@ -216,6 +370,20 @@ public:
      * @brief Gauss quadrature integration over translated convex polygon.
      */
     [[nodiscard]] double integrate_probability(const Polygon& region, Vec2 offset) const override;
+
+    /**
+     * @brief Semi-analytic integration over an annular sector.
+     * Along each ray from the origin the radial integral of the Gaussian has a closed form
+     * in terms of exp and erf. The angle is integrated with composite 10-point Gauss-Legendre,
+     * with panels no wider than a couple of standard deviations of arc length, restricted to
+     * the angles where the distribution has non-negligible mass.
+     */
+    [[nodiscard]] double integrate_probability(const PolarSector& region) const override;
+
+    /**
+     * @brief Semi-analytic integration over an annular sector with translated distribution.
+     */
+    [[nodiscard]] double integrate_probability(const PolarSector& region, Vec2 offset) const override;
 };
 
 #endif
\ No newline at end of file
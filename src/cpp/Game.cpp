@@ -1,5 +1,11 @@
 #include "Game.h"
 #include "Geometry.h"
+#include "HitProbabilityField.h"
+#include "Instrumentation.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <fstream>
 #include <stdexcept>
 #include <string>
@@ -7,40 +13,445 @@
 #include <utility>
 #include <unordered_map>
 #include <map>
+#include <algorithm>
+#include <memory>
+#include <span>
 
 
-// TODO remove dedup
-Game::HitDistribution Game::throw_at_distribution_(Vec2 p) const {
-    if (throw_at_cache_.contains(p)) {
-        return throw_at_cache_[p];
+// Beds sharing an outcome share its column of the outcome table
+void Game::build_outcome_list_() const {
+    if (!outcome_hits_.empty()) return;
+
+    std::map<HitData, size_t> indices;
+    for (const auto& bed : target_.get_beds()) {
+        indices[bed.after_hit()] = 0;
     }
+    indices[HitData(HitData::Type::NORMAL, 0)] = 0;
 
-    std::map<HitData, double> result;
+    for (auto& [hit, index] : indices) {
+        index = outcome_hits_.size();
+        outcome_hits_.push_back(hit);
+    }
+    for (const auto& bed : target_.get_beds()) {
+        bed_outcomes_.push_back(indices[bed.after_hit()]);
+        // Centred on the bounding box, reaching the furthest vertex or, for sectors, box corner
+        const auto [lo, hi] = bed.get_sector() ? bed.get_sector()->bounding_box() : bed.get_shape().bounding_box();
+        const Vec2 center{(lo.x + hi.x) / 2, (lo.y + hi.y) / 2};
+        double radius = std::hypot(hi.x - center.x, hi.y - center.y);
+        if (!bed.get_sector()) {
+            radius = 0.0;
+            for (Vec2 v : bed.get_shape().get_vertices()) radius = std::max(radius, std::hypot(v.x - center.x, v.y - center.y));
+        }
+        bed_circles_.push_back(BedCircle{center, radius});
+    }
+}
+
+Game::AimIndex Game::add_rows_(std::span<const Vec2> aims) const {
+    build_outcome_list_();
+    const size_t num_outcomes = outcome_hits_.size();
+    const AimIndex first = aims_.size();
+    for (Vec2 aim : aims) {
+        if (aims_.size() % AIMS_PER_BLOCK_ == 0) {
+            outcome_blocks_.push_back(std::make_unique<Outcome[]>(AIMS_PER_BLOCK_ * num_outcomes));
+        }
+        aims_.push_back(aim);
+    }
+    row_ready_.resize(aims_.size(), false);
+    row_epochs_.resize(aims_.size(), 0);
+    return first;
+}
+
+double Game::cull_distance_() const {
+    const auto* normal = dynamic_cast<const NormalDistribution*>(&distribution_);
+    if (strict_integration_ || normal == nullptr) return std::numeric_limits<double>::infinity();
+    // Largest eigenvalue of the covariance, the variance along its widest axis
+    const auto& cov = normal->get_covariance();
+    const double half_trace = (cov[0][0] + cov[1][1]) / 2;
+    const double half_gap = (cov[0][0] - cov[1][1]) / 2;
+    const double widest = half_trace + std::sqrt(half_gap * half_gap + cov[0][1] * cov[1][0]);
+    return cull_sigmas_ * std::sqrt(std::max(widest, 0.0));
+}
+
+void Game::bed_probabilities_(Vec2 p, std::span<double> probabilities) const {
+    const auto& beds = target_.get_beds();
+    const double cull_distance = cull_distance_();
+    const auto* normal = dynamic_cast<const NormalDistribution*>(&distribution_);
+    const Vec2 center = normal != nullptr ? p + normal->get_mean() : p;
+    for (size_t b = 0; b < beds.size(); ++b) {
+        const BedCircle& circle = bed_circles_[b];
+        if (std::hypot(circle.center.x - center.x, circle.center.y - center.y) - circle.radius > cull_distance) {
+            probabilities[b] = 0.0;
+            ++cull_stats_.skipped;
+            continue;
+        }
+        ++cull_stats_.integrated;
+        Instrumentation::count(Instrumentation::Counter::INTEGRATIONS);
+        const auto& sector = beds[b].get_sector();
+        probabilities[b] = sector
+            ? distribution_.integrate_probability(*sector, p)
+            : distribution_.integrate_probability(beds[b].get_shape(), p);
+    }
+}
+
+void Game::fill_row_(AimIndex index, std::span<const double> probabilities, std::span<const size_t> bed_images) const {
+    const size_t num_outcomes = outcome_hits_.size();
+    Outcome* row = outcome_blocks_[index / AIMS_PER_BLOCK_].get() + (index % AIMS_PER_BLOCK_) * num_outcomes;
+    for (size_t k = 0; k < num_outcomes; ++k) {
+        row[k] = Outcome{outcome_hits_[k], 0.0};
+    }
     double total_probability = 0.0;
-    
-    for (const auto& region : target_.get_beds()) {
-        double probability = distribution_.integrate_probability(
-            region.get_shape(),
-            p
-        );
-        total_probability += probability;
-        HitData diff = region.after_hit();
-        result[diff] += probability;
+    for (size_t b = 0; b < probabilities.size(); ++b) {
+        total_probability += probabilities[b];
+        row[bed_outcomes_[bed_images[b]]].probability += probabilities[b];
     }
-    
-    result[HitData(HitData::Type::NORMAL, 0)] += 1.0 - total_probability;
+    // The miss outcome is the first NORMAL entry with diff 0 in HitData order
+    auto miss = std::lower_bound(outcome_hits_.begin(), outcome_hits_.end(), HitData(HitData::Type::NORMAL, 0));
+    row[miss - outcome_hits_.begin()].probability += 1.0 - total_probability;
+    row_ready_[index] = true;
+}
+
+void Game::compile_row_(AimIndex index) const {
+    const size_t num_outcomes = outcome_hits_.size();
+    const Vec2 p = aims_[index];
+
+    size_t i, j;
+    if (hit_field_ != nullptr && hit_field_->find_aim(p, i, j)) {
+        Outcome* row = outcome_blocks_[index / AIMS_PER_BLOCK_].get() + (index % AIMS_PER_BLOCK_) * num_outcomes;
+        // Widened from the field table, which may be float
+        thread_local std::vector<double> probabilities;
+        probabilities.resize(num_outcomes);
+        hit_field_->probabilities_at(i, j, probabilities);
+        for (size_t k = 0; k < num_outcomes; ++k) {
+            row[k] = Outcome{outcome_hits_[k], probabilities[k]};
+        }
+        row_ready_[index] = true;
+        return;
+    }
+
+    const auto& symmetries = detect_symmetries_();
+    std::vector<double> probabilities(target_.get_beds().size());
+
+    GridRows* rows = nullptr;
+    if (use_symmetry_ && symmetries.size() > 1) {
+        for (auto& registered : aim_grids_) {
+            if (index >= registered.first_row && index - registered.first_row < registered.grid->size()) {
+                rows = &registered;
+                break;
+            }
+        }
+    }
+    if (rows != nullptr && !rows->symmetries_ready) prepare_grid_symmetries_(*rows);
+
+    if (rows == nullptr || rows->symmetries.size() <= 1) {
+        bed_probabilities_(p, probabilities);
+        fill_row_(index, probabilities, symmetries.front().bed_images);
+        return;
+    }
+
+    // Integrate the orbit's representative once, the mirrored and rotated aims see the same beds permuted
+    const size_t size = rows->grid->size();
+    const size_t aim = index - rows->first_row;
+    size_t representative = aim;
+    for (size_t k = 0; k < rows->symmetries.size(); ++k) {
+        representative = std::min(representative, rows->aim_images[k * size + aim]);
+    }
+    bed_probabilities_(aims_[rows->first_row + representative], probabilities);
+    for (size_t k = 0; k < rows->symmetries.size(); ++k) {
+        AimIndex image = rows->first_row + rows->aim_images[k * size + representative];
+        if (row_ready_[image]) continue;
+        if (hit_field_ != nullptr && hit_field_->covers(aims_[image])) continue;
+        fill_row_(image, probabilities, symmetries[rows->symmetries[k]].bed_images);
+    }
+}
+
+const std::vector<Game::Symmetry>& Game::detect_symmetries_() const {
+    if (symmetries_) return *symmetries_;
+    symmetries_.emplace();
+    const auto& beds = target_.get_beds();
+    std::vector<size_t> identity(beds.size());
+    for (size_t b = 0; b < beds.size(); ++b) identity[b] = b;
+    symmetries_->push_back(Symmetry{{1, 0, 0, 1}, std::move(identity)});
+
+    // Integrals of the quadrature are deterministic functions of the geometry, so a symmetric
+    // configuration gives the same probabilities; Monte Carlo estimates would only agree on average.
+    const auto* normal = dynamic_cast<const NormalDistributionQuadrature*>(&distribution_);
+    if (normal == nullptr) return *symmetries_;
+    double r_max = 0.0;
+    for (const auto& bed : beds) {
+        if (!bed.get_sector()) return *symmetries_;
+        r_max = std::max(r_max, bed.get_sector()->r_outer);
+    }
+    const auto& cov = normal->get_covariance();
+    const double cov_scale = std::max(std::abs(cov[0][0]), std::abs(cov[1][1]));
+    const Vec2 mean = normal->get_mean();
+    if (std::hypot(mean.x, mean.y) > SYMMETRY_TOLERANCE_ * std::sqrt(cov_scale)) return *symmetries_;
+
+    // Quarter turns and the four mirrors, as row-major matrices
+    static constexpr std::array<std::array<int, 4>, 7> CANDIDATES = {{
+        {0, -1, 1, 0}, {-1, 0, 0, -1}, {0, 1, -1, 0},
+        {-1, 0, 0, 1}, {1, 0, 0, -1}, {0, 1, 1, 0}, {0, -1, -1, 0}
+    }};
+    auto matches = [&](const PolarSector& a, const PolarSector& b) {
+        const double full = 2.0 * M_PI - SYMMETRY_TOLERANCE_;
+        const double span_a = a.angle_end - a.angle_start;
+        const double span_b = b.angle_end - b.angle_start;
+        if (std::abs(a.r_inner - b.r_inner) > SYMMETRY_TOLERANCE_ * r_max) return false;
+        if (std::abs(a.r_outer - b.r_outer) > SYMMETRY_TOLERANCE_ * r_max) return false;
+        if (span_a >= full && span_b >= full) return true;
+        return std::abs(span_a - span_b) <= SYMMETRY_TOLERANCE_
+            && std::abs(std::remainder(a.angle_start - b.angle_start, 2.0 * M_PI)) <= SYMMETRY_TOLERANCE_;
+    };
+
+    for (const auto& m : CANDIDATES) {
+        // The distribution is centred, so it only has to keep its covariance: G C G^T = C
+        bool invariant = true;
+        for (int r = 0; r < 2; ++r) {
+            for (int c = 0; c < 2; ++c) {
+                double image = 0.0;
+                for (int k = 0; k < 2; ++k) {
+                    for (int l = 0; l < 2; ++l) {
+                        image += m[2 * r + k] * cov[k][l] * m[2 * c + l];
+                    }
+                }
+                invariant = invariant && std::abs(image - cov[r][c]) <= SYMMETRY_TOLERANCE_ * cov_scale;
+            }
+        }
+        if (!invariant) continue;
+
+        // Rotations by phi move both angles, mirrors across the line at phi / 2 map theta to phi - theta
+        const double phi = std::atan2(m[2], m[0]);
+        const bool mirror = m[0] * m[3] - m[1] * m[2] < 0;
+        std::vector<size_t> bed_images(beds.size());
+        bool maps = true;
+        for (size_t b = 0; b < beds.size() && maps; ++b) {
+            PolarSector sector = *beds[b].get_sector();
+            PolarSector image = mirror
+                ? PolarSector{sector.r_inner, sector.r_outer, phi - sector.angle_end, phi - sector.angle_start}
+                : PolarSector{sector.r_inner, sector.r_outer, sector.angle_start + phi, sector.angle_end + phi};
+            maps = false;
+            for (size_t other = 0; other < beds.size(); ++other) {
+                if (matches(image, *beds[other].get_sector())) {
+                    bed_images[b] = other;
+                    maps = true;
+                    break;
+                }
+            }
+        }
+        if (maps) symmetries_->push_back(Symmetry{m, std::move(bed_images)});
+    }
+    return *symmetries_;
+}
+
+void Game::prepare_grid_symmetries_(GridRows& rows) const {
+    rows.symmetries_ready = true;
+    const auto& symmetries = detect_symmetries_();
+    const AimGrid& grid = *rows.grid;
+    const size_t size = grid.size();
+    const Vec2 min = grid.get_min();
+    const Vec2 max = grid.get_max();
+    const double width = static_cast<double>(grid.get_width());
+    const double height = static_cast<double>(grid.get_height());
+
+    std::vector<size_t> images(size);
+    for (size_t k = 0; k < symmetries.size(); ++k) {
+        const auto& m = symmetries[k].matrix;
+        bool maps = true;
+        for (size_t a = 0; a < size && maps; ++a) {
+            Vec2 p = grid[a];
+            Vec2 q{m[0] * p.x + m[1] * p.y, m[2] * p.x + m[3] * p.y};
+            // Fractional column and row of the image, which must be a grid aim up to rounding
+            double u = (q.x - min.x) / (max.x - min.x) * width - 0.5;
+            double v = (q.y - min.y) / (max.y - min.y) * height - 0.5;
+            double ru = std::round(u);
+            double rv = std::round(v);
+            maps = ru >= 0 && rv >= 0 && ru < width && rv < height
+                && std::abs(u - ru) <= SYMMETRY_TOLERANCE_ && std::abs(v - rv) <= SYMMETRY_TOLERANCE_;
+            if (maps) images[a] = grid.index(static_cast<size_t>(ru), static_cast<size_t>(rv));
+        }
+        if (!maps) continue;
+        rows.symmetries.push_back(k);
+        rows.aim_images.insert(rows.aim_images.end(), images.begin(), images.end());
+    }
+}
+
+size_t Game::get_symmetry_order() const {
+    build_outcome_list_();
+    return detect_symmetries_().size();
+}
+
+void Game::refresh_distribution() {
+    hit_field_ = nullptr;
+    symmetries_.reset();
+    for (auto& rows : aim_grids_) {
+        rows.symmetries_ready = false;
+        rows.symmetries.clear();
+        rows.aim_images.clear();
+    }
+    std::fill(row_ready_.begin(), row_ready_.end(), false);
+}
 
-    throw_at_cache_[p] = std::vector<std::pair<HitData, double>>(result.begin(), result.end());
-    return throw_at_cache_[p];
+void Game::set_use_symmetry(bool use) {
+    use_symmetry_ = use;
+    std::fill(row_ready_.begin(), row_ready_.end(), false);
+}
+
+void Game::set_cull_sigmas(double sigmas) {
+    if (!(sigmas > 0)) {
+        throw std::invalid_argument("Bed culling needs a positive number of standard deviations");
+    }
+    cull_sigmas_ = sigmas;
+    std::fill(row_ready_.begin(), row_ready_.end(), false);
+}
+
+void Game::set_strict_integration(bool strict) {
+    strict_integration_ = strict;
+    std::fill(row_ready_.begin(), row_ready_.end(), false);
+}
+
+const AimGrid& Game::aim_grid(size_t num_samples) const {
+    Bounds bounds = get_target_bounds();
+    return aim_grid(AimGrid::with_samples(bounds.min, bounds.max, num_samples));
+}
+
+const AimGrid& Game::aim_grid(const AimGrid& grid) const {
+    for (const auto& registered : aim_grids_) {
+        if (*registered.grid == grid) return *registered.grid;
+    }
+    auto owned = std::make_unique<AimGrid>(grid);
+    AimIndex first_row = add_rows_(owned->aims());
+    aim_grids_.push_back(GridRows{std::move(owned), first_row, false, {}, {}});
+    return *aim_grids_.back().grid;
+}
+
+Game::AimIndex Game::first_row(const AimGrid& grid) const {
+    for (const auto& registered : aim_grids_) {
+        if (registered.grid.get() == &grid) return registered.first_row;
+    }
+    throw std::invalid_argument("AimGrid was not obtained from this game's aim_grid()");
+}
+
+Game::AimIndex Game::aim_index(Vec2 p) const {
+    for (const auto& registered : aim_grids_) {
+        size_t index;
+        if (registered.grid->find(p, index)) return registered.first_row + index;
+    }
+    if (const AimIndex* index = aim_indices_.find(p)) {
+        row_epochs_[*index] = scope_epoch_;
+        return *index;
+    }
+    AimIndex index;
+    if (!free_rows_.empty()) {
+        index = free_rows_.back();
+        free_rows_.pop_back();
+        aims_[index] = p;
+        row_ready_[index] = false;
+    } else {
+        index = add_rows_(std::span(&p, 1));
+    }
+    row_epochs_[index] = scope_epoch_;
+    // Recently used entries come first, so once the oldest row is pinned all of them are
+    aim_indices_.insert(p, index, outcome_hits_.size() * sizeof(Outcome),
+                        [this](Vec2, AimIndex evicted) { free_rows_.push_back(evicted); },
+                        [this](Vec2, AimIndex victim) { return scope_depth_ == 0 || row_epochs_[victim] != scope_epoch_; });
+    return index;
+}
+
+Game::OffGridScope::OffGridScope(const Game& game) : game_(game) {
+    if (game_.scope_depth_++ == 0) ++game_.scope_epoch_;
+}
+
+Game::OffGridScope::~OffGridScope() {
+    if (--game_.scope_depth_ == 0 && game_.aim_indices_.get_budget() != 0) {
+        game_.trim_off_grid_rows(game_.aim_indices_.get_budget());
+    }
+}
+
+CacheUsage Game::get_outcome_table_usage() const {
+    const size_t row_bytes = outcome_hits_.size() * sizeof(Outcome) + sizeof(Vec2);
+    CacheUsage usage = aim_indices_.usage();
+    usage.bytes = outcome_blocks_.size() * AIMS_PER_BLOCK_ * row_bytes + row_ready_.capacity() / 8
+        + aim_indices_.size() * LruCache<Vec2, AimIndex>::ENTRY_OVERHEAD + free_rows_.capacity() * sizeof(AimIndex)
+        + row_epochs_.capacity() * sizeof(uint64_t);
+    usage.entries = aims_.size() - free_rows_.size();
+    return usage;
+}
+
+void Game::set_outcome_table_budget(size_t bytes) {
+    if (bytes != 0 && bytes < outcome_hits_.size() * sizeof(Outcome) + LruCache<Vec2, AimIndex>::ENTRY_OVERHEAD) {
+        throw std::invalid_argument("Outcome table budget must hold at least one row");
+    }
+    // Trimmed here so the evicted rows go to the free list, set_budget() would drop them
+    if (bytes != 0) trim_off_grid_rows(bytes);
+    aim_indices_.set_budget(bytes);
+}
+
+size_t Game::trim_off_grid_rows(size_t max_bytes) const {
+    // The cache charges every off-grid row its outcomes plus the index entry
+    return aim_indices_.trim(max_bytes, [this](Vec2, AimIndex index) { free_rows_.push_back(index); });
+}
+
+std::span<const Game::Outcome> Game::outcomes(AimIndex aim) const {
+    if (!row_ready_[aim]) {
+        Instrumentation::count(Instrumentation::Counter::OUTCOME_ROW_MISSES);
+        Instrumentation::ScopedTimer timer(Instrumentation::Timer::COMPILE_ROWS);
+        compile_row_(aim);
+    } else {
+        Instrumentation::count(Instrumentation::Counter::OUTCOME_ROW_HITS);
+    }
+    const size_t num_outcomes = outcome_hits_.size();
+    const Outcome* row = outcome_blocks_[aim / AIMS_PER_BLOCK_].get() + (aim % AIMS_PER_BLOCK_) * num_outcomes;
+    return std::span(row, num_outcomes);
+}
+
+std::span<const Game::Outcome> Game::throw_at_outcomes(Vec2 p) const {
+    return outcomes(aim_index(p));
+}
+
+size_t Game::get_outcome_count() const {
+    build_outcome_list_();
+    return outcome_hits_.size();
 }
 
 Game::HitDistribution Game::throw_at_distribution(Vec2 p) const {
-    return throw_at_distribution_(p);
+    HitDistribution result;
+    for (const auto& [hit, probability] : throw_at_outcomes(p)) {
+        result.emplace_back(hit, probability);
+    }
+    return result;
+}
+
+Game::Transitions Game::throw_at(Vec2 p, State current_state) const {
+    return Transitions(*this, throw_at_outcomes(p), current_state);
+}
+
+Game::Transitions Game::throw_at(AimIndex aim, State current_state) const {
+    return Transitions(*this, outcomes(aim), current_state);
+}
+
+Game::State Game::throw_at_sample(Vec2 p, State current_state, RandomEngine& rng) const {
+    Vec2 sample = distribution_.sample(rng) + p;
+    HitData hit_data = target_.after_hit(sample);
+
+    return handle_throw(current_state, hit_data);
+}
+
+Game::State Game::throw_at_sample(Vec2 p, State current_state) const {
+    return throw_at_sample(p, current_state, thread_random_engine());
 }
 
 Game::Game(const Target& target, const Distribution& distribution) 
     : target_(target), distribution_(distribution) {}
 
+void Game::use_hit_probability_field(const HitProbabilityField& field) {
+    build_outcome_list_();
+    if (field.get_outcomes() != outcome_hits_) {
+        throw std::invalid_argument("HitProbabilityField outcomes do not match the game's target");
+    }
+    hit_field_ = &field;
+    // Rows keep their indices, they are recomputed on next use
+    std::fill(row_ready_.begin(), row_ready_.end(), false);
+}
+
 Game::Bounds Game::get_target_bounds() const {
     if (target_bounds_.min.x != std::numeric_limits<double>::max()) {
         return target_bounds_;
@@ -69,91 +480,165 @@ Game::Bounds Game::get_target_bounds() const {
     return target_bounds_;
 }
 
-Game::State GameFinishOnAny::handle_throw(State current_state, HitData hit_data) const {
-    if (hit_data.diff + static_cast<StateDifference>(current_state) < 0) {
-        return current_state;
+bool Target::Bed::inside(Vec2 p) const {
+    if (sector_) {
+        return sector_->contains(p);
     }
-    return current_state + hit_data.diff;
+    return shape_.contains(p);
 }
 
-Game::State GameFinishOnAny::throw_at_sample(Vec2 p, State current_state) const {
-    Vec2 sample = distribution_.sample() + p;
-    HitData hit_data = target_.after_hit(sample);
-
-    return handle_throw(current_state, hit_data);
+HitData Target::Bed::after_hit() const {
+    return after_hit_data_;
 }
 
-std::vector<std::pair<Game::State, double>> GameFinishOnAny::throw_at(Vec2 p, State current_state) const {
-    auto diff_distribution = throw_at_distribution_(p);
-    std::vector<std::pair<Game::State, double>> result;
-    
-    for (const auto& [hit_data, probability] : diff_distribution) {
-        result.emplace_back(handle_throw(current_state, hit_data), probability);
-    }
-    
-    return result;
+Target::Target(const std::vector<Bed>& beds) : beds_(beds) {
+    hit_index_.build(beds_);
 }
 
-
-Game::State GameFinishOnDouble::handle_throw(State current_state, HitData hit_data) const {
-    if (hit_data.diff + static_cast<StateDifference>(current_state) == 0) {
-        if (hit_data.type == HitData::Type::DOUBLE) {
-            return 0;
-        }
-        else return current_state;
-    }
-    if (hit_data.diff + static_cast<StateDifference>(current_state) < 0) {
-        return current_state;
-    }
-    return current_state + hit_data.diff;
+Target::Target(std::istream &input) {
+    import(input);
 }
 
-Game::State GameFinishOnDouble::throw_at_sample(Vec2 p, State current_state) const {
-    Vec2 sample = distribution_.sample() + p;
-    HitData hit_data = target_.after_hit(sample);
-
-    return handle_throw(current_state, hit_data);
+Target::Target(const std::string &filename) {
+    import(filename);
 }
 
-std::vector<std::pair<Game::State, double>> GameFinishOnDouble::throw_at(Vec2 p, State current_state) const {
-    auto diff_distribution = throw_at_distribution_(p);
-    std::vector<std::pair<Game::State, double>> result;
-    
-    for (const auto& [hit_data, probability] : diff_distribution) {
-        result.emplace_back(handle_throw(current_state, hit_data), probability);
+HitData Target::after_hit(Vec2 p) const {
+    for (uint32_t bed : hit_index_.candidates(p)) {
+        if (beds_[bed].inside(p)) {
+            return beds_[bed].after_hit();
+        }
     }
-    
-    return result;
+    return HitData(HitData::Type::NORMAL, MISS_STATE_DIFF_);
 }
 
-
-
-
-bool Target::Bed::inside(Vec2 p) const {
-    return shape_.contains(p);
+void Target::HitIndex::build(const std::vector<Bed>& beds) {
+    layout_ = Layout::EMPTY;
+    radii_.clear();
+    cell_offsets_.clear();
+    candidates_.clear();
+    if (beds.empty()) return;
+
+    bool all_sectors = std::all_of(beds.begin(), beds.end(), [](const Bed& bed) { return bed.get_sector().has_value(); });
+    if (all_sectors) {
+        build_polar_(beds);
+    } else {
+        build_grid_(beds);
+    }
 }
 
-HitData Target::Bed::after_hit() const {
-    return after_hit_data_;
+void Target::HitIndex::build_polar_(const std::vector<Bed>& beds) {
+    layout_ = Layout::POLAR;
+    for (const auto& bed : beds) {
+        radii_.push_back(bed.get_sector()->r_inner);
+        radii_.push_back(bed.get_sector()->r_outer);
+    }
+    std::sort(radii_.begin(), radii_.end());
+    radii_.erase(std::unique(radii_.begin(), radii_.end()), radii_.end());
+
+    const size_t rings = radii_.size() - 1;
+    const double bin_width = 2.0 * M_PI / ANGLE_BINS_;
+    cell_offsets_.push_back(0);
+    for (size_t ring = 0; ring < rings; ++ring) {
+        double slack = CELL_SLACK_ * radii_.back();
+        double r_lo = radii_[ring] - slack;
+        double r_hi = radii_[ring + 1] + slack;
+        for (size_t bin = 0; bin < ANGLE_BINS_; ++bin) {
+            double a_lo = -M_PI + bin * bin_width - CELL_SLACK_;
+            double a_hi = -M_PI + (bin + 1) * bin_width + CELL_SLACK_;
+            for (size_t b = 0; b < beds.size(); ++b) {
+                const PolarSector& sector = *beds[b].get_sector();
+                if (sector.r_outer <= r_lo || sector.r_inner >= r_hi) continue;
+                // Sector angles may extend past pi, compare against the bin shifted by a full turn too
+                bool overlaps = false;
+                for (double shift : {0.0, 2.0 * M_PI}) {
+                    overlaps = overlaps || (sector.angle_start < a_hi + shift && sector.angle_end > a_lo + shift);
+                }
+                if (overlaps) candidates_.push_back(static_cast<uint32_t>(b));
+            }
+            cell_offsets_.push_back(static_cast<uint32_t>(candidates_.size()));
+        }
+    }
 }
 
-Target::Target(const std::vector<Bed>& beds) : beds_(beds) {}
-
-Target::Target(std::istream &input) {
-    import(input);
-}
+void Target::HitIndex::build_grid_(const std::vector<Bed>& beds) {
+    layout_ = Layout::GRID;
+    std::vector<std::pair<Vec2, Vec2>> boxes;
+    Vec2 min{std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+    Vec2 max{std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+    for (const auto& bed : beds) {
+        std::pair<Vec2, Vec2> box{
+            Vec2{std::numeric_limits<double>::max(), std::numeric_limits<double>::max()},
+            Vec2{std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()}
+        };
+        if (bed.get_sector()) {
+            box = bed.get_sector()->bounding_box();
+        } else {
+            for (const auto& v : bed.get_shape().get_vertices()) {
+                box.first = Vec2{std::min(box.first.x, v.x), std::min(box.first.y, v.y)};
+                box.second = Vec2{std::max(box.second.x, v.x), std::max(box.second.y, v.y)};
+            }
+        }
+        min = Vec2{std::min(min.x, box.first.x), std::min(min.y, box.first.y)};
+        max = Vec2{std::max(max.x, box.second.x), std::max(max.y, box.second.y)};
+        boxes.push_back(box);
+    }
+    if (!(min.x <= max.x && min.y <= max.y)) {
+        layout_ = Layout::EMPTY;
+        return;
+    }
 
-Target::Target(const std::string &filename) {
-    import(filename);
+    // About one cell per bed along each axis, up to MAX_GRID_CELLS_
+    size_t cells = std::clamp<size_t>(static_cast<size_t>(std::ceil(std::sqrt(beds.size()))) * 2, 1, MAX_GRID_CELLS_);
+    cells_x_ = cells;
+    cells_y_ = cells;
+    grid_min_ = min;
+    cell_size_ = Vec2{std::max(max.x - min.x, 1e-12) / cells_x_, std::max(max.y - min.y, 1e-12) / cells_y_};
+
+    cell_offsets_.push_back(0);
+    for (size_t cy = 0; cy < cells_y_; ++cy) {
+        for (size_t cx = 0; cx < cells_x_; ++cx) {
+            Vec2 lo{grid_min_.x + cx * cell_size_.x, grid_min_.y + cy * cell_size_.y};
+            Vec2 hi{lo.x + cell_size_.x, lo.y + cell_size_.y};
+            double slack_x = CELL_SLACK_ * (std::abs(lo.x) + cell_size_.x);
+            double slack_y = CELL_SLACK_ * (std::abs(lo.y) + cell_size_.y);
+            for (size_t b = 0; b < beds.size(); ++b) {
+                const auto& [box_min, box_max] = boxes[b];
+                if (box_max.x < lo.x - slack_x || box_min.x > hi.x + slack_x) continue;
+                if (box_max.y < lo.y - slack_y || box_min.y > hi.y + slack_y) continue;
+                candidates_.push_back(static_cast<uint32_t>(b));
+            }
+            cell_offsets_.push_back(static_cast<uint32_t>(candidates_.size()));
+        }
+    }
 }
 
-HitData Target::after_hit(Vec2 p) const {
-    for (const auto& bed : beds_) {
-        if (bed.inside(p)) {
-            return bed.after_hit();
+size_t Target::HitIndex::cell_of_(Vec2 p) const {
+    if (layout_ == Layout::POLAR) {
+        double r = std::hypot(p.x, p.y);
+        if (!(r >= radii_.front() && r < radii_.back())) return SIZE_MAX;
+        size_t ring = std::upper_bound(radii_.begin(), radii_.end(), r) - radii_.begin() - 1;
+        double angle = std::atan2(p.y, p.x);
+        size_t bin = static_cast<size_t>((angle + M_PI) / (2.0 * M_PI) * ANGLE_BINS_);
+        return ring * ANGLE_BINS_ + std::min(bin, ANGLE_BINS_ - 1);
+    }
+    if (layout_ == Layout::GRID) {
+        double u = (p.x - grid_min_.x) / cell_size_.x;
+        double v = (p.y - grid_min_.y) / cell_size_.y;
+        if (!(u >= 0.0 && v >= 0.0 && u <= static_cast<double>(cells_x_) && v <= static_cast<double>(cells_y_))) {
+            return SIZE_MAX;
         }
+        size_t cx = std::min(static_cast<size_t>(u), cells_x_ - 1);
+        size_t cy = std::min(static_cast<size_t>(v), cells_y_ - 1);
+        return cy * cells_x_ + cx;
     }
-    return HitData(HitData::Type::NORMAL, MISS_STATE_DIFF_);
+    return SIZE_MAX;
+}
+
+std::span<const uint32_t> Target::HitIndex::candidates(Vec2 p) const {
+    size_t cell = cell_of_(p);
+    if (cell == SIZE_MAX) return {};
+    return std::span(candidates_.data() + cell_offsets_[cell], cell_offsets_[cell + 1] - cell_offsets_[cell]);
 }
 
 void Target::Bed::import(std::istream &input) {
@@ -179,9 +664,14 @@ void Target::Bed::import(std::istream &input) {
         input >> vertices[i].x >> vertices[i].y;
     }
     shape_.set_vertices(std::move(vertices));
+    sector_ = shape_.as_polar_sector();
 }
 
 void Target::import(std::istream &input) {
+    if (input.peek() == BINARY_MAGIC_[0]) {
+        import_binary_(input);
+        return;
+    }
     int num_beds;
     input >> num_beds;
     beds_.clear();
@@ -189,12 +679,177 @@ void Target::import(std::istream &input) {
     for (int i = 0; i < num_beds; ++i) {
         beds_[i].import(input);
     }
+    hit_index_.build(beds_);
 }
 
 void Target::import(const std::string &filename) {
-    std::ifstream file(filename);
+    std::ifstream file(filename, std::ios::binary); // Binary mode so both formats read the same everywhere
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open target file: " + filename);
     }
     import(file);
 }
+
+static_assert(sizeof(Vec2) == 2 * sizeof(double), "Binary targets store vertices as packed (x, y) pairs");
+
+namespace {
+    struct BinaryTargetHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t bed_count;
+        uint64_t vertex_count;
+    };
+
+    struct BinaryBedRecord {
+        int32_t diff;
+        uint32_t type;
+        uint32_t has_sector;
+        uint32_t reserved;
+        uint64_t first_vertex;
+        uint64_t vertex_count;
+        double area;
+        double fan_center[2];
+        double bbox_min[2];
+        double bbox_max[2];
+        double sector[4];   ///< r_inner, r_outer, angle_start, angle_end; zero without a sector
+    };
+
+    template <typename T>
+    void write_array(std::ostream& output, const T* data, size_t count) {
+        output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    }
+
+    template <typename T>
+    void read_array(std::istream& input, T* data, size_t count) {
+        input.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+        if (!input) throw std::runtime_error("Invalid binary target: truncated");
+    }
+
+    // Bytes left in a seekable stream, so header counts can be checked before anything is allocated
+    uint64_t remaining_bytes(std::istream& input) {
+        const std::istream::pos_type here = input.tellg();
+        input.seekg(0, std::ios::end);
+        const std::istream::pos_type end = input.tellg();
+        input.seekg(here);
+        if (here == std::istream::pos_type(-1) || end == std::istream::pos_type(-1) || !input) {
+            throw std::runtime_error("Invalid binary target: stream is not seekable");
+        }
+        return static_cast<uint64_t>(end - here);
+    }
+}
+
+void Target::save_binary(std::ostream &output) const {
+    BinaryTargetHeader header{};
+    std::memcpy(header.magic, BINARY_MAGIC_, sizeof(BINARY_MAGIC_));
+    header.version = BINARY_VERSION;
+    header.bed_count = static_cast<uint32_t>(beds_.size());
+
+    std::vector<BinaryBedRecord> records;
+    records.reserve(beds_.size());
+    for (const auto& bed : beds_) {
+        const auto& shape = bed.get_shape();
+        const auto& derived = shape.get_derived();
+        BinaryBedRecord record{};
+        record.diff = static_cast<int32_t>(bed.after_hit().diff);
+        record.type = static_cast<uint32_t>(bed.after_hit().type);
+        record.first_vertex = header.vertex_count;
+        record.vertex_count = shape.get_vertices().size();
+        record.area = derived.area;
+        record.fan_center[0] = derived.fan_center.x;
+        record.fan_center[1] = derived.fan_center.y;
+        record.bbox_min[0] = derived.bbox_min.x;
+        record.bbox_min[1] = derived.bbox_min.y;
+        record.bbox_max[0] = derived.bbox_max.x;
+        record.bbox_max[1] = derived.bbox_max.y;
+        if (const auto& sector = bed.get_sector()) {
+            record.has_sector = 1;
+            record.sector[0] = sector->r_inner;
+            record.sector[1] = sector->r_outer;
+            record.sector[2] = sector->angle_start;
+            record.sector[3] = sector->angle_end;
+        }
+        header.vertex_count += record.vertex_count;
+        records.push_back(record);
+    }
+
+    write_array(output, &header, 1);
+    write_array(output, records.data(), records.size());
+    for (const auto& bed : beds_) {
+        write_array(output, bed.get_shape().get_vertices().data(), bed.get_shape().get_vertices().size());
+    }
+    for (const auto& bed : beds_) {
+        const auto fan_areas = bed.get_shape().get_fan_areas();
+        write_array(output, fan_areas.data(), fan_areas.size());
+    }
+}
+
+void Target::save_binary(const std::string &filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot write target file: " + filename);
+    }
+    save_binary(file);
+    if (!file) {
+        throw std::runtime_error("Cannot write target file: " + filename);
+    }
+}
+
+void Target::import_binary_(std::istream &input) {
+    BinaryTargetHeader header;
+    read_array(input, &header, 1);
+    if (std::memcmp(header.magic, BINARY_MAGIC_, sizeof(BINARY_MAGIC_)) != 0) {
+        throw std::runtime_error("Invalid binary target: bad magic");
+    }
+    if (header.version != BINARY_VERSION) {
+        throw std::runtime_error("Unsupported binary target version " + std::to_string(header.version)
+                                 + ", expected " + std::to_string(BINARY_VERSION));
+    }
+
+    // Counts are checked by division so a corrupt header cannot overflow the expected size
+    const uint64_t available = remaining_bytes(input);
+    if (header.bed_count > available / sizeof(BinaryBedRecord)
+        || header.vertex_count > (available - header.bed_count * sizeof(BinaryBedRecord)) / (sizeof(Vec2) + sizeof(double))) {
+        throw std::runtime_error("Invalid binary target: truncated");
+    }
+
+    std::vector<BinaryBedRecord> records(header.bed_count);
+    read_array(input, records.data(), records.size());
+    uint64_t expected_first = 0;
+    for (const auto& record : records) {
+        // Ranges must tile the vertex array in bed order, which also bounds every index
+        if (record.first_vertex != expected_first || record.vertex_count > header.vertex_count - expected_first
+            || record.type > static_cast<uint32_t>(HitData::Type::TREBLE)) {
+            throw std::runtime_error("Invalid binary target: bad bed record");
+        }
+        expected_first += record.vertex_count;
+    }
+    if (expected_first != header.vertex_count) {
+        throw std::runtime_error("Invalid binary target: bad bed record");
+    }
+
+    std::vector<Vec2> vertices(header.vertex_count);
+    std::vector<double> fan_areas(header.vertex_count);
+    read_array(input, vertices.data(), vertices.size());
+    read_array(input, fan_areas.data(), fan_areas.size());
+
+    std::vector<Bed> beds;
+    beds.reserve(records.size());
+    for (const auto& record : records) {
+        const auto first = static_cast<std::ptrdiff_t>(record.first_vertex);
+        const auto last = first + static_cast<std::ptrdiff_t>(record.vertex_count);
+        Polygon::Derived derived;
+        derived.area = record.area;
+        derived.fan_center = Vec2(record.fan_center[0], record.fan_center[1]);
+        derived.bbox_min = Vec2(record.bbox_min[0], record.bbox_min[1]);
+        derived.bbox_max = Vec2(record.bbox_max[0], record.bbox_max[1]);
+        derived.fan_areas.assign(fan_areas.begin() + first, fan_areas.begin() + last);
+        std::optional<PolarSector> sector;
+        if (record.has_sector) {
+            sector = PolarSector{record.sector[0], record.sector[1], record.sector[2], record.sector[3]};
+        }
+        beds.emplace_back(Polygon(std::vector<Vec2>(vertices.begin() + first, vertices.begin() + last), std::move(derived)),
+                          sector, HitData(static_cast<HitData::Type>(record.type), record.diff));
+    }
+    beds_ = std::move(beds);
+    hit_index_.build(beds_);
+}
@@ -1,13 +1,20 @@
 #ifndef GAME_HEADER
 #define GAME_HEADER
 
+#include "AimGrid.h"
 #include "Distribution.h"
 #include "Geometry.h"
+#include "LruCache.h"
+#include <array>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 #include <string>
+#include <cstdint>
 #include <limits>
+#include <memory>
+#include <optional>
+#include <span>
 
 /**
  * @defgroup game Game Rules and Targets
@@ -15,6 +22,7 @@
  */
 
 class Target;
+class HitProbabilityField;
 
 struct HitData;
 
@@ -31,8 +39,43 @@ struct HitData;
  * GameFinishOnDouble game(standard_board, dist);
  * 
  * auto outcomes = game.throw_at(Vec2{10, 5}, 501); // Throw at (10,5) from 501
- * // Returns vector of (new_state, probability) pairs
+ * // Returns a view of (new_state, probability) pairs
  * @endcode
+ *
+ * The hit probabilities of every aim are computed once and stored in a flat
+ * outcome table, one row of get_outcome_count() entries per aim. Solvers share
+ * AimGrid objects from aim_grid(), whose aims occupy a contiguous range of rows;
+ * outcomes() returns a span over a row, so solvers can iterate transitions
+ * without hashing or heap allocation. Off-grid aims still work but are looked
+ * up through a hash map.
+ *
+ * When every bed is a polar sector and the target maps onto itself under some
+ * of the eight symmetries of the square (quarter turns and mirrors), as the
+ * standard board does, and the throw distribution is a centred
+ * NormalDistributionQuadrature whose covariance is invariant under them (any
+ * isotropic one), the hit probabilities of an aim are a permutation of those
+ * of its mirror and rotated images. Grid rows are then integrated once per
+ * orbit and the other rows of the orbit are filled by permuting beds. A
+ * symmetric grid has orbits of up to eight aims, so its rows are compiled up
+ * to eight times faster. Only these symmetries map the grid onto itself; the
+ * 18 degree rotations of the board do not.
+ *
+ * With a NormalDistribution, beds far from the aim are not integrated. Each bed
+ * has a precomputed bounding circle, and a bed whose circle lies more than
+ * get_cull_sigmas() standard deviations from the mean of the throw, measured
+ * along the covariance's widest axis, is given probability 0; its mass goes to
+ * the miss outcome. The largest eigenvalue makes this a lower bound on the
+ * Mahalanobis distance of every point of the bed, so at the default of 8 a culled
+ * bed holds less than 1e-15 of probability. get_bed_cull_stats() counts integrated
+ * and skipped beds, and set_strict_integration() turns culling off.
+ *
+ * The rows of off-grid aims are held within set_outcome_table_budget(), and a new
+ * off-grid aim may take over the row of the least recently used one. A caller that
+ * keeps an off-grid index or its outcomes() span while resolving other aims, as a
+ * solve does while it recurses into successor states, must hold an OffGridScope for
+ * the whole time: no row resolved inside the outermost open scope is given up
+ * before it closes. SolverMinThrows and SolverMinRounds open one around each solve,
+ * and SolverMinRounds::heat_map() around all of its cells.
  */
 class Game {
 public:
@@ -43,18 +86,86 @@ public:
         Vec2 min;
         Vec2 max;
     };
+    struct Outcome;
+    class Transitions;
+    using AimIndex = size_t; ///< Row of an aim in the outcome table
+    static constexpr double DEFAULT_CULL_SIGMAS = 8.0; ///< Default of set_cull_sigmas()
+
+    /** @brief Beds integrated and skipped while compiling rows, see set_cull_sigmas(). */
+    struct BedCullStats {
+        uint64_t integrated = 0;
+        uint64_t skipped = 0;
+    };
 protected:
     const Target& target_;
     const Distribution& distribution_;
-    
-    mutable std::unordered_map<Vec2, HitDistribution> throw_at_cache_;
+    const HitProbabilityField* hit_field_ = nullptr;
+
+    static constexpr size_t AIMS_PER_BLOCK_ = 256; ///< Rows per outcome table block
+
+    // Outcome table. Rows live in fixed-size blocks, so spans handed out stay valid
+    // when later aims are added. Each registered AimGrid owns a contiguous range of rows,
+    // other aims get a row on first use through aim_indices_. The off-grid budget and
+    // trim_off_grid_rows() hand the rows of the least recently used off-grid aims to later ones,
+    // except rows stamped with the epoch of the open OffGridScope, which stay until it closes.
+    struct GridRows {
+        std::unique_ptr<AimGrid> grid;
+        AimIndex first_row;
+        bool symmetries_ready = false;
+        std::vector<size_t> symmetries;   ///< Entries of symmetries_ that map the grid onto itself
+        std::vector<size_t> aim_images;   ///< [k * grid size + aim], image of aim under symmetries[k]
+    };
+
+    /** @brief A symmetry shared by the target, the distribution and possibly an aim grid. */
+    struct Symmetry {
+        std::array<int, 4> matrix;        ///< Row-major orthogonal 2x2 matrix with entries in {-1, 0, 1}
+        std::vector<size_t> bed_images;   ///< Bed that bed b maps onto
+    };
+    static constexpr double SYMMETRY_TOLERANCE_ = 1e-6; ///< Relative tolerance when matching sectors and aims
+    mutable std::vector<HitData> outcome_hits_;              ///< Distinct outcomes in HitData order, miss included
+    mutable std::vector<size_t> bed_outcomes_;               ///< Outcome index of each bed
+    mutable std::vector<std::unique_ptr<Outcome[]>> outcome_blocks_;
+    mutable std::vector<Vec2> aims_;                         ///< Aim of each row
+    mutable std::vector<bool> row_ready_;                    ///< Whether a row has been computed
+    mutable std::vector<GridRows> aim_grids_;
+    mutable LruCache<Vec2, AimIndex> aim_indices_;           ///< Rows of off-grid aims, most recently used first
+    mutable std::vector<AimIndex> free_rows_;                ///< Off-grid rows given up by eviction or trim_off_grid_rows()
+    mutable std::vector<uint64_t> row_epochs_;               ///< Scope epoch in which each row was last resolved
+    mutable unsigned int scope_depth_ = 0;                   ///< Open OffGridScope objects
+    mutable uint64_t scope_epoch_ = 0;                       ///< Advanced whenever an outermost OffGridScope opens
+    mutable std::optional<std::vector<Symmetry>> symmetries_; ///< Detected on first use, identity first
+    bool use_symmetry_ = true;
+
+    /** @brief Circle containing a bed, for culling beds far from the aim. */
+    struct BedCircle {
+        Vec2 center;
+        double radius;
+    };
+    mutable std::vector<BedCircle> bed_circles_;             ///< Bounding circle of each bed
+    double cull_sigmas_ = DEFAULT_CULL_SIGMAS;
+    bool strict_integration_ = false;
+    mutable BedCullStats cull_stats_;
     mutable Bounds target_bounds_ = {
         Vec2{std::numeric_limits<double>::max(), std::numeric_limits<double>::max()},
         Vec2{std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()}
     };
 
-    /** @brief Compute probability distribution of hits when aiming at p. Cached. */
-    HitDistribution throw_at_distribution_(Vec2 p) const;
+    /** @brief Collect the distinct outcomes of the target's beds on first use. */
+    void build_outcome_list_() const;
+    /** @brief Append uncomputed rows for aims and return the index of the first one. */
+    AimIndex add_rows_(std::span<const Vec2> aims) const;
+    /** @brief Compute the outcome row at index. */
+    void compile_row_(AimIndex index) const;
+    /** @brief Find the symmetries of the target and distribution on first use. */
+    const std::vector<Symmetry>& detect_symmetries_() const;
+    /** @brief Find which symmetries map a registered grid onto itself, and the aim images. */
+    void prepare_grid_symmetries_(GridRows& rows) const;
+    /** @brief Distance from the mean of a throw beyond which beds are culled, infinite for none. */
+    [[nodiscard]] double cull_distance_() const;
+    /** @brief Per bed hit probabilities of p, the miss is the rest. Culled beds get 0. */
+    void bed_probabilities_(Vec2 p, std::span<double> probabilities) const;
+    /** @brief Write outcome row index from per bed probabilities, with bed b counted as bed_images[b]. */
+    void fill_row_(AimIndex index, std::span<const double> probabilities, std::span<const size_t> bed_images) const;
 public:
     Game(const Target& target, const Distribution& distribution);
     
@@ -63,61 +174,180 @@ public:
      * @return (min_corner, max_corner) pair
      */
     [[nodiscard]] Bounds get_target_bounds() const;
+
+    [[nodiscard]] const Target& get_target() const { return target_; }
+    [[nodiscard]] const Distribution& get_distribution() const { return distribution_; }
     
     /** @brief Compute probability distribution of physical hits when aiming at p. Cached. */
     [[nodiscard]] HitDistribution throw_at_distribution(Vec2 p) const;
 
+    /**
+     * @brief Shared aim grid for num_samples aims over get_target_bounds().
+     * The grid is created on first request and owned by the game, every solver with
+     * the same grid dimensions gets the same object.
+     */
+    [[nodiscard]] const AimGrid& aim_grid(size_t num_samples) const;
+
+    /** @brief The game's own copy of grid, registering it on first request. */
+    [[nodiscard]] const AimGrid& aim_grid(const AimGrid& grid) const;
+
+    /**
+     * @brief Outcome table row of the first aim of a grid; aim i of the grid is row first_row(grid) + i.
+     * @throws std::invalid_argument if grid was not returned by aim_grid()
+     */
+    [[nodiscard]] AimIndex first_row(const AimGrid& grid) const;
+
+    /**
+     * @brief Keeps the off-grid rows resolved while it is open.
+     * Scopes nest. Rows resolved by aim_index() since the outermost scope opened are not
+     * evicted, so the table may grow past set_outcome_table_budget() meanwhile; closing
+     * the outermost scope trims it back. Not thread-safe, like aim_index() itself.
+     */
+    class OffGridScope {
+        const Game& game_;
+    public:
+        explicit OffGridScope(const Game& game);
+        ~OffGridScope();
+        OffGridScope(const OffGridScope&) = delete;
+        OffGridScope& operator=(const OffGridScope&) = delete;
+    };
+
+    /**
+     * @brief Index of the outcome table row for aim p.
+     * Aims of registered grids are found arithmetically; other aims go through a hash map
+     * and get a new row on first use. Indices are stable for the lifetime of the game,
+     * except for off-grid aims given up by trim_off_grid_rows() or evicted under
+     * set_outcome_table_budget() outside the OffGridScope they were resolved in.
+     */
+    [[nodiscard]] AimIndex aim_index(Vec2 p) const;
+
+    /** @brief Hit outcomes and probabilities of an indexed aim, in HitData order. Computed on first use. */
+    [[nodiscard]] std::span<const Outcome> outcomes(AimIndex aim) const;
+
+    /** @brief Hit outcomes and probabilities when aiming at p, in HitData order. */
+    [[nodiscard]] std::span<const Outcome> throw_at_outcomes(Vec2 p) const;
+
+    /** @brief Number of distinct outcomes, the length of every outcome row. */
+    [[nodiscard]] size_t get_outcome_count() const;
+
+    /**
+     * @brief Memory of the outcome table: every allocated row, including free ones, plus the off-grid index.
+     * entries counts the rows in use, budget is set_outcome_table_budget() and evictions counts
+     * the off-grid rows given up so far.
+     */
+    [[nodiscard]] CacheUsage get_outcome_table_usage() const;
+
+    /**
+     * @brief Bytes the rows of off-grid aims may take, 0 for no limit (the default).
+     * Rows are charged as by trim_off_grid_rows(). A new off-grid aim beyond the budget takes
+     * over the row of the least recently used one, which invalidates that aim's index and
+     * spans. Rows resolved inside an open OffGridScope are never taken over, so a solve or
+     * heat map may exceed the budget while it runs and is trimmed back when it returns.
+     * Trims to the new budget right away.
+     * @throws std::invalid_argument if bytes is not 0 but smaller than one row
+     */
+    void set_outcome_table_budget(size_t bytes);
+
+    /**
+     * @brief Give up the rows of the least recently used off-grid aims until those rows take at most max_bytes.
+     * Off-grid aims are the ones outside every registered grid, such as heat map cells and
+     * polished optima, and without trimming their rows accumulate for the lifetime of the
+     * game. Given up rows are not freed but reused by the next new off-grid aims, so the
+     * table stops growing. This invalidates the indices and spans of the evicted aims,
+     * pinned or not: call it between solves and heat maps, never inside an OffGridScope.
+     * Grid rows are never touched.
+     * @return Bytes of the rows given up
+     */
+    size_t trim_off_grid_rows(size_t max_bytes) const;
+
+    /**
+     * @brief Serve aims on the field's grid from a precomputed HitProbabilityField.
+     * Other aims are still integrated bed by bed. The field must outlive the game.
+     * @param field Field computed for this game's target and distribution
+     * @throws std::invalid_argument if the field's outcomes differ from the target's
+     */
+    void use_hit_probability_field(const HitProbabilityField& field);
+
+    /** @brief Field serving grid aims, nullptr when every row is integrated. */
+    [[nodiscard]] const HitProbabilityField* get_hit_probability_field() const { return hit_field_; }
+
+    /**
+     * @brief Drop everything computed from the distribution, after its parameters changed.
+     * Call after NormalDistribution::add_point() or set_parameters(). Rows keep their indices
+     * and are recomputed on next use, and symmetries are detected again. A HitProbabilityField
+     * was computed for the old parameters, so the game stops using it.
+     */
+    void refresh_distribution();
+
+    /**
+     * @brief Number of target symmetries also shared by the throw distribution, 1 when there are none.
+     * Grid rows are compiled once per orbit of these symmetries, see the class description.
+     */
+    [[nodiscard]] size_t get_symmetry_order() const;
+
+    /**
+     * @brief Enable or disable compiling grid rows through symmetry (on by default).
+     * Rows keep their indices and are recomputed on next use.
+     */
+    void set_use_symmetry(bool use);
+
+    /**
+     * @brief Skip beds more than sigmas standard deviations from the throw when compiling rows.
+     * Rows keep their indices and are recomputed on next use.
+     * @throws std::invalid_argument if sigmas is not positive
+     */
+    void set_cull_sigmas(double sigmas);
+    [[nodiscard]] double get_cull_sigmas() const { return cull_sigmas_; }
+
+    /**
+     * @brief Integrate every bed of every row, for exactness tests (off by default).
+     * Rows keep their indices and are recomputed on next use.
+     */
+    void set_strict_integration(bool strict);
+    [[nodiscard]] bool is_strict_integration() const { return strict_integration_; }
+
+    /** @brief Beds integrated and culled by rows compiled so far. Rows served by a HitProbabilityField count neither. */
+    [[nodiscard]] BedCullStats get_bed_cull_stats() const { return cull_stats_; }
+    void reset_bed_cull_stats() { cull_stats_ = {}; }
+
+    /**
+     * @brief State after hitting hit_data from current_state, according to the game rules.
+     */
+    [[nodiscard]] virtual State handle_throw(State current_state, HitData hit_data) const = 0;
+
+    /**
+     * @brief Call visit with the game's rules as a function object (State, HitData) -> State.
+     * Games built on GameWithRules pass their rule type, so a solver core instantiated
+     * for it inlines the rules into its outcome loops. Other games pass VirtualRules,
+     * which goes through handle_throw(). Dispatch once per solve, not per outcome.
+     */
+    template <typename Visit>
+    decltype(auto) with_rules(Visit&& visit) const;
+
     virtual ~Game() = default;
     
     /**
      * @brief Simulate a single sampled throw.
      * @param p Aim point
      * @param current_state Current game state
+     * @param rng Generator the throw is drawn from
      * @return Resulting state after throw
      */
-    [[nodiscard]] virtual State throw_at_sample(Vec2 p, State current_state) const = 0;
+    [[nodiscard]] State throw_at_sample(Vec2 p, State current_state, RandomEngine& rng) const;
+
+    /** @brief Simulate a single sampled throw with the calling thread's generator. */
+    [[nodiscard]] State throw_at_sample(Vec2 p, State current_state) const;
     
     /**
      * @brief Compute probability distribution of resulting states.
      * @param p Aim point
      * @param current_state Current game state
-     * @return Vector of (resulting_state, probability) pairs
+     * @return View of (resulting_state, probability) pairs over the aim's outcome row
      */
-    [[nodiscard]] virtual std::vector<std::pair<State, double>> throw_at(Vec2 p, State current_state) const = 0;
-};
+    [[nodiscard]] Transitions throw_at(Vec2 p, State current_state) const;
 
-/**
- * @brief Game variant where any hit that reaches exactly zero wins.
- * @ingroup game
- * 
- * Simpler rules: just reduce score by hit value. Busts (going below zero)
- * leave the state unchanged.
- */
-class GameFinishOnAny : public Game {
-    State handle_throw(State current_state, HitData hit_data) const;
-public:
-    using Game::Game;
-    [[nodiscard]] State throw_at_sample(Vec2 p, State current_state) const;
-    [[nodiscard]] std::vector<std::pair<State, double>> throw_at(Vec2 p, State current_state) const;
-};
-
-/**
- * @brief Standard darts rules: must finish on a double.
- * @ingroup game
- * 
- * To win, the final hit must:
- * - Be a double (hit type)
- * - Reduce score to exactly zero
- * 
- * Hitting exactly zero with non-double or reaching score 1 busts.
- */
-class GameFinishOnDouble : public Game {
-private:
-    State handle_throw(State current_state, HitData hit_data) const;
-public:
-    using Game::Game;
-    [[nodiscard]] State throw_at_sample(Vec2 p, State current_state) const;
-    [[nodiscard]] std::vector<std::pair<State, double>> throw_at(Vec2 p, State current_state) const;
+    /** @brief Resulting states of an indexed aim, see throw_at(Vec2, State). */
+    [[nodiscard]] Transitions throw_at(AimIndex aim, State current_state) const;
 };
 
 /**
@@ -142,6 +372,150 @@ struct HitData {
         }
         return diff < other.diff;
     }
+    bool operator==(const HitData& other) const = default;
+};
+
+/**
+ * @ingroup game
+ * @brief One entry of the outcome table: what was hit and with which probability.
+ */
+struct Game::Outcome {
+    HitData hit;
+    double probability;
+};
+
+/**
+ * @ingroup game
+ * @brief Non-owning view of the state transitions of one aim.
+ *
+ * Maps each outcome of the aim's row through Game::handle_throw() on access,
+ * so iterating it allocates nothing. Valid as long as the game is alive.
+ */
+class Game::Transitions {
+private:
+    const Game* game_;
+    std::span<const Outcome> outcomes_;
+    State current_state_;
+
+public:
+    class iterator {
+    private:
+        const Transitions* view_;
+        size_t index_;
+    public:
+        using value_type = std::pair<State, double>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(const Transitions* view, size_t index) : view_(view), index_(index) {}
+        value_type operator*() const { return (*view_)[index_]; }
+        iterator& operator++() { ++index_; return *this; }
+        iterator operator++(int) { iterator copy = *this; ++index_; return copy; }
+        bool operator==(const iterator& other) const { return index_ == other.index_; }
+    };
+
+    Transitions(const Game& game, std::span<const Outcome> outcomes, State current_state)
+        : game_(&game), outcomes_(outcomes), current_state_(current_state) {}
+
+    [[nodiscard]] size_t size() const { return outcomes_.size(); }
+    [[nodiscard]] std::pair<State, double> operator[](size_t i) const {
+        return {game_->handle_throw(current_state_, outcomes_[i].hit), outcomes_[i].probability};
+    }
+    [[nodiscard]] iterator begin() const { return iterator(this, 0); }
+    [[nodiscard]] iterator end() const { return iterator(this, outcomes_.size()); }
+};
+
+/**
+ * @ingroup game
+ * @brief Rules of GameFinishOnAny: reduce the score by the hit, busts leave it unchanged.
+ */
+struct FinishOnAnyRules {
+    [[nodiscard]] Game::State operator()(Game::State current_state, HitData hit_data) const {
+        if (hit_data.diff + static_cast<Game::StateDifference>(current_state) < 0) {
+            return current_state;
+        }
+        return current_state + hit_data.diff;
+    }
+};
+
+/**
+ * @ingroup game
+ * @brief Rules of GameFinishOnDouble: only a double may reach zero, anything else that reaches it busts.
+ */
+struct FinishOnDoubleRules {
+    [[nodiscard]] Game::State operator()(Game::State current_state, HitData hit_data) const {
+        if (hit_data.diff + static_cast<Game::StateDifference>(current_state) == 0) {
+            if (hit_data.type == HitData::Type::DOUBLE) {
+                return 0;
+            }
+            else return current_state;
+        }
+        if (hit_data.diff + static_cast<Game::StateDifference>(current_state) < 0) {
+            return current_state;
+        }
+        return current_state + hit_data.diff;
+    }
+};
+
+/**
+ * @ingroup game
+ * @brief Rules of a game without a compile-time rule type, through the virtual Game::handle_throw().
+ */
+struct VirtualRules {
+    const Game* game;
+    [[nodiscard]] Game::State operator()(Game::State current_state, HitData hit_data) const {
+        return game->handle_throw(current_state, hit_data);
+    }
+};
+
+/**
+ * @ingroup game
+ * @brief Game whose rules are the function object Rules, known at compile time.
+ *
+ * handle_throw() is final and forwards to Rules, and Game::with_rules() hands
+ * solvers the Rules type itself, so their outcome loops make no virtual calls.
+ */
+template <typename Rules>
+class GameWithRules : public Game {
+public:
+    using Game::Game;
+    [[nodiscard]] State handle_throw(State current_state, HitData hit_data) const final {
+        return Rules{}(current_state, hit_data);
+    }
+};
+
+template <typename Visit>
+decltype(auto) Game::with_rules(Visit&& visit) const {
+    if (dynamic_cast<const GameWithRules<FinishOnDoubleRules>*>(this)) return visit(FinishOnDoubleRules{});
+    if (dynamic_cast<const GameWithRules<FinishOnAnyRules>*>(this)) return visit(FinishOnAnyRules{});
+    return visit(VirtualRules{this});
+}
+
+/**
+ * @brief Game variant where any hit that reaches exactly zero wins.
+ * @ingroup game
+ * 
+ * Simpler rules: just reduce score by hit value. Busts (going below zero)
+ * leave the state unchanged.
+ */
+class GameFinishOnAny : public GameWithRules<FinishOnAnyRules> {
+public:
+    using GameWithRules::GameWithRules;
+};
+
+/**
+ * @brief Standard darts rules: must finish on a double.
+ * @ingroup game
+ * 
+ * To win, the final hit must:
+ * - Be a double (hit type)
+ * - Reduce score to exactly zero
+ * 
+ * Hitting exactly zero with non-double or reaching score 1 busts.
+ */
+class GameFinishOnDouble : public GameWithRules<FinishOnDoubleRules> {
+public:
+    using GameWithRules::GameWithRules;
 };
 
 /**
@@ -161,9 +535,53 @@ struct HitData {
 class Target {
     class Bed;
 
+    /**
+     * @brief Acceleration structure for after_hit().
+     *
+     * Maps a point to a short list of candidate beds in bed order, so only those get
+     * an exact inside() test. When every bed is a PolarSector the cells are rings
+     * between consecutive sector radii times uniform angle bins, which usually leaves
+     * a single candidate. Other targets use a uniform grid over the bed bounding boxes.
+     */
+    class HitIndex {
+    private:
+        static constexpr size_t ANGLE_BINS_ = 360;   ///< Angle bins of the polar layout
+        static constexpr size_t MAX_GRID_CELLS_ = 64; ///< Cells per axis of the uniform grid layout
+        static constexpr double CELL_SLACK_ = 1e-9;  ///< Relative padding when assigning beds to cells
+
+        enum class Layout { EMPTY, POLAR, GRID };
+        Layout layout_ = Layout::EMPTY;
+        std::vector<double> radii_;          ///< Ring boundaries of the polar layout, ascending
+        Vec2 grid_min_{0.0, 0.0};
+        Vec2 cell_size_{0.0, 0.0};
+        size_t cells_x_ = 0;
+        size_t cells_y_ = 0;
+        std::vector<uint32_t> cell_offsets_; ///< Candidates of cell c are [cell_offsets_[c], cell_offsets_[c + 1])
+        std::vector<uint32_t> candidates_;   ///< Bed indices, ascending within each cell
+
+        void build_polar_(const std::vector<Bed>& beds);
+        void build_grid_(const std::vector<Bed>& beds);
+        /** @brief Cell of p, or SIZE_MAX when p is outside every bed's cell. */
+        [[nodiscard]] size_t cell_of_(Vec2 p) const;
+
+    public:
+        /** @brief Rebuild for a new set of beds. */
+        void build(const std::vector<Bed>& beds);
+
+        /** @brief Indices of the beds that may contain p, in bed order. */
+        [[nodiscard]] std::span<const uint32_t> candidates(Vec2 p) const;
+    };
+
     std::vector<Bed> beds_;
+    HitIndex hit_index_;
     static constexpr int MISS_STATE_DIFF_ = 0;
+    static constexpr char BINARY_MAGIC_[8] = {'D', 'A', 'R', 'T', 'T', 'G', 'T', '\0'};
+
+    /** @brief Read the binary format after its magic has been seen; see save_binary(). */
+    void import_binary_(std::istream &input);
 public:
+    static constexpr uint32_t BINARY_VERSION = 1;
+
     Target() = default;
     Target(const std::vector<Bed>& beds);
     
@@ -173,11 +591,34 @@ public:
     /** @brief Load target from file. */
     explicit Target(const std::string &filename);
     
+    /**
+     * @brief Replace the beds with the target in input.
+     * Reads either the text format of gen_target.py or the binary format of save_binary(),
+     * told apart by the binary magic.
+     * @throws std::runtime_error if a binary target is truncated, corrupt or of another version
+     */
     void import(std::istream &input);
     void import(const std::string &filename);
 
+    /**
+     * @brief Write the target in the versioned binary format.
+     *
+     * The file stores what loading a text target would otherwise compute, so reading it
+     * does no parsing, sector detection or triangulation. All fields are in native byte order:
+     * - Header: magic "DARTTGT", format version, bed count, total vertex count
+     * - One record per bed: score, type, vertex range, the Polygon::Derived scalars and the
+     *   PolarSector, if the bed has one
+     * - All vertices of all beds as one contiguous array of (x, y) doubles
+     * - The fan triangle areas, one per vertex, in the same order
+     */
+    void save_binary(std::ostream &output) const;
+    /** @throws std::runtime_error if the file cannot be written */
+    void save_binary(const std::string &filename) const;
+
     /**
      * @brief Determine what was hit at position p.
+     * Only the beds the spatial index lists for p are tested, so this takes constant
+     * time for typical boards.
      * @param p Hit position
      * @return HitData with type and score, or miss (diff=0) if outside all beds
      */
@@ -193,18 +634,25 @@ public:
  * @ingroup game
  * 
  * Consists of a polygonal shape and the hit data returned when that
- * region is hit.
+ * region is hit. Shapes that approximate an annular sector around the
+ * origin (all beds generated by gen_target.py) are also stored as an exact
+ * PolarSector, which is used for hit tests and integration.
  */
 class Target::Bed {
 private:
     Polygon shape_;
+    std::optional<PolarSector> sector_;
     HitData after_hit_data_;
 
 public:
     Bed() = default;
     Bed(const Polygon& shape, Game::StateDifference diff, HitData::Type type = HitData::Type::NORMAL) :
-        shape_(shape), after_hit_data_(type, diff) {};
-    Bed(const Polygon& shape, HitData after_hit_data) : shape_(shape), after_hit_data_(after_hit_data) {};
+        shape_(shape), sector_(shape.as_polar_sector()), after_hit_data_(type, diff) {};
+    Bed(const Polygon& shape, HitData after_hit_data) :
+        shape_(shape), sector_(shape.as_polar_sector()), after_hit_data_(after_hit_data) {};
+    /** @brief Bed with a sector recognised earlier, e.g. read from a binary target. */
+    Bed(Polygon&& shape, std::optional<PolarSector> sector, HitData after_hit_data) :
+        shape_(std::move(shape)), sector_(sector), after_hit_data_(after_hit_data) {};
     void import(std::istream &input);
 
     /** @brief Check if point p is inside this bed. */
@@ -216,6 +664,11 @@ public:
     [[nodiscard]] const Polygon& get_shape() const {
         return shape_;
     }
+
+    /** @brief Exact annular sector of this bed, if its shape was recognised as one. */
+    [[nodiscard]] const std::optional<PolarSector>& get_sector() const {
+        return sector_;
+    }
 };
 
 #endif
\ No newline at end of file
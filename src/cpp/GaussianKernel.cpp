@@ -0,0 +1,462 @@
+#include "GaussianKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GAUSSIAN_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace {
+    // Exponents are clamped to this range before the vector exp so that 2^n stays a normal double.
+    // Densities below exp(-708) contribute nothing at the precision of the result.
+    [[maybe_unused]] constexpr double EXP_MIN = -708.0;
+    [[maybe_unused]] constexpr double EXP_MAX = 709.0;
+
+    // Cody-Waite split of ln(2): LN2_HI has trailing zero bits, so n * LN2_HI is exact for |n| < 2^11.
+    [[maybe_unused]] constexpr double LOG2E = 1.4426950408889634074;
+    [[maybe_unused]] constexpr double LN2_HI = 6.93145751953125e-1;
+    [[maybe_unused]] constexpr double LN2_LO = 1.42860682030941723212e-6;
+
+    // Taylor coefficients 1/k! for k = 13 down to 2. After range reduction |r| <= ln(2)/2,
+    // where the truncation error of the degree 13 polynomial is below 1e-17.
+    [[maybe_unused]] constexpr double EXP_COEFFS[] = {
+        1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0,
+        1.0 / 362880.0, 1.0 / 40320.0, 1.0 / 5040.0, 1.0 / 720.0,
+        1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 1.0 / 2.0,
+    };
+
+    // Float versions: 2^n stays a normal float, LN2_HI_F has trailing zero bits, and the
+    // degree 7 polynomial truncates below 1e-8 for |r| <= ln(2)/2, under float rounding.
+    [[maybe_unused]] constexpr float EXP_MIN_F = -87.0f;
+    [[maybe_unused]] constexpr float EXP_MAX_F = 88.0f;
+    [[maybe_unused]] constexpr float LOG2E_F = 1.44269504f;
+    [[maybe_unused]] constexpr float LN2_HI_F = 0.693359375f;
+    [[maybe_unused]] constexpr float LN2_LO_F = -2.12194440e-4f;
+    [[maybe_unused]] constexpr float EXP_COEFFS_F[] = {
+        1.0f / 5040.0f, 1.0f / 720.0f, 1.0f / 120.0f, 1.0f / 24.0f, 1.0f / 6.0f, 1.0f / 2.0f,
+    };
+
+#ifdef GAUSSIAN_KERNEL_X86
+    __attribute__((target("avx2,fma")))
+    inline __m256d exp_avx2(__m256d x) {
+        x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(EXP_MIN)), _mm256_set1_pd(EXP_MAX));
+        __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(LOG2E)),
+                                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_HI), x);
+        r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_LO), r);
+
+        __m256d p = _mm256_set1_pd(EXP_COEFFS[0]);
+        for (size_t k = 1; k < std::size(EXP_COEFFS); ++k) {
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_COEFFS[k]));
+        }
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+
+        __m256i bits = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n));
+        bits = _mm256_slli_epi64(_mm256_add_epi64(bits, _mm256_set1_epi64x(1023)), 52);
+        return _mm256_mul_pd(p, _mm256_castsi256_pd(bits));
+    }
+
+    __attribute__((target("avx2,fma")))
+    inline __m256 exp_avx2(__m256 x) {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_MIN_F)), _mm256_set1_ps(EXP_MAX_F));
+        __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(LOG2E_F)),
+                                   _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_HI_F), x);
+        r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_LO_F), r);
+
+        __m256 p = _mm256_set1_ps(EXP_COEFFS_F[0]);
+        for (size_t k = 1; k < std::size(EXP_COEFFS_F); ++k) {
+            p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_COEFFS_F[k]));
+        }
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+
+        __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(p, _mm256_castsi256_ps(bits));
+    }
+
+// GCC 12's avx512fintrin.h passes _mm512_undefined_* placeholders through max/min, roundscale,
+// scalef, extract and reduce, which -W(maybe-)uninitialized reports wherever they are inlined.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+    __attribute__((target("avx512f")))
+    inline __m512d exp_avx512(__m512d x) {
+        x = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(EXP_MIN)), _mm512_set1_pd(EXP_MAX));
+        __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(LOG2E)),
+                                         _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_HI), x);
+        r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_LO), r);
+
+        __m512d p = _mm512_set1_pd(EXP_COEFFS[0]);
+        for (size_t k = 1; k < std::size(EXP_COEFFS); ++k) {
+            p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_COEFFS[k]));
+        }
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+        return _mm512_scalef_pd(p, n);
+    }
+
+    __attribute__((target("avx512f")))
+    inline __m512 exp_avx512(__m512 x) {
+        x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(EXP_MIN_F)), _mm512_set1_ps(EXP_MAX_F));
+        __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(LOG2E_F)),
+                                        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(LN2_HI_F), x);
+        r = _mm512_fnmadd_ps(n, _mm512_set1_ps(LN2_LO_F), r);
+
+        __m512 p = _mm512_set1_ps(EXP_COEFFS_F[0]);
+        for (size_t k = 1; k < std::size(EXP_COEFFS_F); ++k) {
+            p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(EXP_COEFFS_F[k]));
+        }
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.0f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.0f));
+        return _mm512_scalef_ps(p, n);
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+#ifdef __wasm_simd128__
+    inline v128_t exp_wasm(v128_t x) {
+        x = wasm_f64x2_pmin(wasm_f64x2_pmax(x, wasm_f64x2_splat(EXP_MIN)), wasm_f64x2_splat(EXP_MAX));
+        v128_t n = wasm_f64x2_nearest(wasm_f64x2_mul(x, wasm_f64x2_splat(LOG2E)));
+        v128_t r = wasm_f64x2_sub(x, wasm_f64x2_mul(n, wasm_f64x2_splat(LN2_HI)));
+        r = wasm_f64x2_sub(r, wasm_f64x2_mul(n, wasm_f64x2_splat(LN2_LO)));
+
+        v128_t p = wasm_f64x2_splat(EXP_COEFFS[0]);
+        for (size_t k = 1; k < std::size(EXP_COEFFS); ++k) {
+            p = wasm_f64x2_add(wasm_f64x2_mul(p, r), wasm_f64x2_splat(EXP_COEFFS[k]));
+        }
+        p = wasm_f64x2_add(wasm_f64x2_mul(p, r), wasm_f64x2_splat(1.0));
+        p = wasm_f64x2_add(wasm_f64x2_mul(p, r), wasm_f64x2_splat(1.0));
+
+        v128_t bits = wasm_i64x2_extend_low_i32x4(wasm_i32x4_trunc_sat_f64x2_zero(n));
+        bits = wasm_i64x2_shl(wasm_i64x2_add(bits, wasm_i64x2_splat(1023)), 52);
+        return wasm_f64x2_mul(p, bits);
+    }
+
+    inline v128_t exp_wasm_f32(v128_t x) {
+        x = wasm_f32x4_pmin(wasm_f32x4_pmax(x, wasm_f32x4_splat(EXP_MIN_F)), wasm_f32x4_splat(EXP_MAX_F));
+        v128_t n = wasm_f32x4_nearest(wasm_f32x4_mul(x, wasm_f32x4_splat(LOG2E_F)));
+        v128_t r = wasm_f32x4_sub(x, wasm_f32x4_mul(n, wasm_f32x4_splat(LN2_HI_F)));
+        r = wasm_f32x4_sub(r, wasm_f32x4_mul(n, wasm_f32x4_splat(LN2_LO_F)));
+
+        v128_t p = wasm_f32x4_splat(EXP_COEFFS_F[0]);
+        for (size_t k = 1; k < std::size(EXP_COEFFS_F); ++k) {
+            p = wasm_f32x4_add(wasm_f32x4_mul(p, r), wasm_f32x4_splat(EXP_COEFFS_F[k]));
+        }
+        p = wasm_f32x4_add(wasm_f32x4_mul(p, r), wasm_f32x4_splat(1.0f));
+        p = wasm_f32x4_add(wasm_f32x4_mul(p, r), wasm_f32x4_splat(1.0f));
+
+        v128_t bits = wasm_i32x4_shl(wasm_i32x4_add(wasm_i32x4_trunc_sat_f32x4(n), wasm_i32x4_splat(127)), 23);
+        return wasm_f32x4_mul(p, bits);
+    }
+#endif
+}
+
+GaussianKernel::GaussianKernel(const std::array<std::array<double, 2>, 2>& inv_cov, double log_normaliser, Vec2 mean)
+    : xx_(-0.5 * inv_cov[0][0]),
+      xy_(-0.5 * (inv_cov[0][1] + inv_cov[1][0])),
+      yy_(-0.5 * inv_cov[1][1]),
+      log_normaliser_(log_normaliser),
+      mean_(mean) {}
+
+bool GaussianKernel::supports(Isa isa) {
+    switch (isa) {
+        case Isa::SCALAR:
+            return true;
+#ifdef GAUSSIAN_KERNEL_X86
+        case Isa::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Isa::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+#ifdef __wasm_simd128__
+        case Isa::WASM_SIMD128:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+GaussianKernel::Isa GaussianKernel::best_isa() {
+    static const Isa best = [] {
+        for (Isa isa : {Isa::AVX512, Isa::AVX2, Isa::WASM_SIMD128}) {
+            if (supports(isa)) return isa;
+        }
+        return Isa::SCALAR;
+    }();
+    return best;
+}
+
+double GaussianKernel::weighted_sum(std::span<const double> x, std::span<const double> y,
+                                    std::span<const double> weights) const {
+    static const Isa isa = best_isa();
+    return weighted_sum(isa, x, y, weights);
+}
+
+double GaussianKernel::weighted_sum(Isa isa, std::span<const double> x, std::span<const double> y,
+                                    std::span<const double> weights) const {
+    if (y.size() != x.size() || weights.size() != x.size()) {
+        throw std::invalid_argument("GaussianKernel input spans must have the same size");
+    }
+    switch (isa) {
+        case Isa::SCALAR:
+            return weighted_sum_scalar_(x.data(), y.data(), weights.data(), x.size());
+        case Isa::AVX2:
+            if (supports(isa)) return weighted_sum_avx2_(x.data(), y.data(), weights.data(), x.size());
+            break;
+        case Isa::AVX512:
+            if (supports(isa)) return weighted_sum_avx512_(x.data(), y.data(), weights.data(), x.size());
+            break;
+        case Isa::WASM_SIMD128:
+            if (supports(isa)) return weighted_sum_wasm_(x.data(), y.data(), weights.data(), x.size());
+            break;
+    }
+    throw std::invalid_argument("GaussianKernel instruction set is not supported on this platform");
+}
+
+double GaussianKernel::weighted_sum(std::span<const float> x, std::span<const float> y,
+                                    std::span<const float> weights) const {
+    static const Isa isa = best_isa();
+    return weighted_sum(isa, x, y, weights);
+}
+
+double GaussianKernel::weighted_sum(Isa isa, std::span<const float> x, std::span<const float> y,
+                                    std::span<const float> weights) const {
+    if (y.size() != x.size() || weights.size() != x.size()) {
+        throw std::invalid_argument("GaussianKernel input spans must have the same size");
+    }
+    switch (isa) {
+        case Isa::SCALAR:
+            return weighted_sum_scalar_(x.data(), y.data(), weights.data(), x.size());
+        case Isa::AVX2:
+            if (supports(isa)) return weighted_sum_avx2_(x.data(), y.data(), weights.data(), x.size());
+            break;
+        case Isa::AVX512:
+            if (supports(isa)) return weighted_sum_avx512_(x.data(), y.data(), weights.data(), x.size());
+            break;
+        case Isa::WASM_SIMD128:
+            if (supports(isa)) return weighted_sum_wasm_(x.data(), y.data(), weights.data(), x.size());
+            break;
+    }
+    throw std::invalid_argument("GaussianKernel instruction set is not supported on this platform");
+}
+
+double GaussianKernel::weighted_sum_scalar_(const double* x, const double* y, const double* w, size_t n) const {
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double dx = x[i] - mean_.x;
+        double dy = y[i] - mean_.y;
+        total += w[i] * std::exp(log_normaliser_ + dx * (xx_ * dx + xy_ * dy) + yy_ * dy * dy);
+    }
+    return total;
+}
+
+double GaussianKernel::weighted_sum_scalar_(const float* x, const float* y, const float* w, size_t n) const {
+    const float mx = static_cast<float>(mean_.x);
+    const float my = static_cast<float>(mean_.y);
+    const float xx = static_cast<float>(xx_);
+    const float xy = static_cast<float>(xy_);
+    const float yy = static_cast<float>(yy_);
+    const float norm = static_cast<float>(log_normaliser_);
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        float dx = x[i] - mx;
+        float dy = y[i] - my;
+        total += static_cast<double>(w[i] * std::exp(norm + dx * (xx * dx + xy * dy) + yy * dy * dy));
+    }
+    return total;
+}
+
+#ifdef GAUSSIAN_KERNEL_X86
+__attribute__((target("avx2,fma")))
+double GaussianKernel::weighted_sum_avx2_(const double* x, const double* y, const double* w, size_t n) const {
+    const __m256d mx = _mm256_set1_pd(mean_.x);
+    const __m256d my = _mm256_set1_pd(mean_.y);
+    const __m256d xx = _mm256_set1_pd(xx_);
+    const __m256d xy = _mm256_set1_pd(xy_);
+    const __m256d yy = _mm256_set1_pd(yy_);
+    const __m256d norm = _mm256_set1_pd(log_normaliser_);
+
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), mx);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), my);
+        __m256d e = _mm256_fmadd_pd(dx, _mm256_fmadd_pd(xx, dx, _mm256_mul_pd(xy, dy)), norm);
+        e = _mm256_fmadd_pd(_mm256_mul_pd(yy, dy), dy, e);
+        acc = _mm256_fmadd_pd(_mm256_loadu_pd(w + i), exp_avx2(e), acc);
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + weighted_sum_scalar_(x + i, y + i, w + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+double GaussianKernel::weighted_sum_avx2_(const float* x, const float* y, const float* w, size_t n) const {
+    const __m256 mx = _mm256_set1_ps(static_cast<float>(mean_.x));
+    const __m256 my = _mm256_set1_ps(static_cast<float>(mean_.y));
+    const __m256 xx = _mm256_set1_ps(static_cast<float>(xx_));
+    const __m256 xy = _mm256_set1_ps(static_cast<float>(xy_));
+    const __m256 yy = _mm256_set1_ps(static_cast<float>(yy_));
+    const __m256 norm = _mm256_set1_ps(static_cast<float>(log_normaliser_));
+
+    // Terms are widened to double before they are added
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), mx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), my);
+        __m256 e = _mm256_fmadd_ps(dx, _mm256_fmadd_ps(xx, dx, _mm256_mul_ps(xy, dy)), norm);
+        e = _mm256_fmadd_ps(_mm256_mul_ps(yy, dy), dy, e);
+        __m256 term = _mm256_mul_ps(_mm256_loadu_ps(w + i), exp_avx2(e));
+        acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(term)));
+        acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(term, 1)));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + weighted_sum_scalar_(x + i, y + i, w + i, n - i);
+}
+
+// Same avx512fintrin.h warnings as the AVX-512 exp above
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+__attribute__((target("avx512f")))
+double GaussianKernel::weighted_sum_avx512_(const double* x, const double* y, const double* w, size_t n) const {
+    const __m512d mx = _mm512_set1_pd(mean_.x);
+    const __m512d my = _mm512_set1_pd(mean_.y);
+    const __m512d xx = _mm512_set1_pd(xx_);
+    const __m512d xy = _mm512_set1_pd(xy_);
+    const __m512d yy = _mm512_set1_pd(yy_);
+    const __m512d norm = _mm512_set1_pd(log_normaliser_);
+
+    __m512d acc = _mm512_setzero_pd();
+    for (size_t i = 0; i < n; i += 8) {
+        // Lanes past the end load zero weight, so they add nothing to the sum
+        __mmask8 mask = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1u);
+        __m512d dx = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, x + i), mx);
+        __m512d dy = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, y + i), my);
+        __m512d e = _mm512_fmadd_pd(dx, _mm512_fmadd_pd(xx, dx, _mm512_mul_pd(xy, dy)), norm);
+        e = _mm512_fmadd_pd(_mm512_mul_pd(yy, dy), dy, e);
+        acc = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, w + i), exp_avx512(e), acc);
+    }
+    return _mm512_reduce_add_pd(acc);
+}
+
+__attribute__((target("avx512f")))
+double GaussianKernel::weighted_sum_avx512_(const float* x, const float* y, const float* w, size_t n) const {
+    const __m512 mx = _mm512_set1_ps(static_cast<float>(mean_.x));
+    const __m512 my = _mm512_set1_ps(static_cast<float>(mean_.y));
+    const __m512 xx = _mm512_set1_ps(static_cast<float>(xx_));
+    const __m512 xy = _mm512_set1_ps(static_cast<float>(xy_));
+    const __m512 yy = _mm512_set1_ps(static_cast<float>(yy_));
+    const __m512 norm = _mm512_set1_ps(static_cast<float>(log_normaliser_));
+
+    __m512d acc = _mm512_setzero_pd();
+    for (size_t i = 0; i < n; i += 16) {
+        // Lanes past the end load zero weight, so they add nothing to the sum
+        __mmask16 mask = n - i >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (n - i)) - 1u);
+        __m512 dx = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, x + i), mx);
+        __m512 dy = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, y + i), my);
+        __m512 e = _mm512_fmadd_ps(dx, _mm512_fmadd_ps(xx, dx, _mm512_mul_ps(xy, dy)), norm);
+        e = _mm512_fmadd_ps(_mm512_mul_ps(yy, dy), dy, e);
+        __m512 term = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, w + i), exp_avx512(e));
+        __m256 high = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(term), 1));
+        acc = _mm512_add_pd(acc, _mm512_cvtps_pd(_mm512_castps512_ps256(term)));
+        acc = _mm512_add_pd(acc, _mm512_cvtps_pd(high));
+    }
+    return _mm512_reduce_add_pd(acc);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+double GaussianKernel::weighted_sum_avx2_(const double* x, const double* y, const double* w, size_t n) const {
+    return weighted_sum_scalar_(x, y, w, n);
+}
+
+double GaussianKernel::weighted_sum_avx512_(const double* x, const double* y, const double* w, size_t n) const {
+    return weighted_sum_scalar_(x, y, w, n);
+}
+
+double GaussianKernel::weighted_sum_avx2_(const float* x, const float* y, const float* w, size_t n) const {
+    return weighted_sum_scalar_(x, y, w, n);
+}
+
+double GaussianKernel::weighted_sum_avx512_(const float* x, const float* y, const float* w, size_t n) const {
+    return weighted_sum_scalar_(x, y, w, n);
+}
+#endif
+
+#ifdef __wasm_simd128__
+double GaussianKernel::weighted_sum_wasm_(const double* x, const double* y, const double* w, size_t n) const {
+    const v128_t mx = wasm_f64x2_splat(mean_.x);
+    const v128_t my = wasm_f64x2_splat(mean_.y);
+    const v128_t xx = wasm_f64x2_splat(xx_);
+    const v128_t xy = wasm_f64x2_splat(xy_);
+    const v128_t yy = wasm_f64x2_splat(yy_);
+    const v128_t norm = wasm_f64x2_splat(log_normaliser_);
+
+    v128_t acc = wasm_f64x2_splat(0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        v128_t dx = wasm_f64x2_sub(wasm_v128_load(x + i), mx);
+        v128_t dy = wasm_f64x2_sub(wasm_v128_load(y + i), my);
+        v128_t inner = wasm_f64x2_add(wasm_f64x2_mul(xx, dx), wasm_f64x2_mul(xy, dy));
+        v128_t e = wasm_f64x2_add(wasm_f64x2_add(norm, wasm_f64x2_mul(dx, inner)),
+                                  wasm_f64x2_mul(wasm_f64x2_mul(yy, dy), dy));
+        acc = wasm_f64x2_add(acc, wasm_f64x2_mul(wasm_v128_load(w + i), exp_wasm(e)));
+    }
+    return wasm_f64x2_extract_lane(acc, 0) + wasm_f64x2_extract_lane(acc, 1)
+         + weighted_sum_scalar_(x + i, y + i, w + i, n - i);
+}
+
+double GaussianKernel::weighted_sum_wasm_(const float* x, const float* y, const float* w, size_t n) const {
+    const v128_t mx = wasm_f32x4_splat(static_cast<float>(mean_.x));
+    const v128_t my = wasm_f32x4_splat(static_cast<float>(mean_.y));
+    const v128_t xx = wasm_f32x4_splat(static_cast<float>(xx_));
+    const v128_t xy = wasm_f32x4_splat(static_cast<float>(xy_));
+    const v128_t yy = wasm_f32x4_splat(static_cast<float>(yy_));
+    const v128_t norm = wasm_f32x4_splat(static_cast<float>(log_normaliser_));
+
+    v128_t acc = wasm_f64x2_splat(0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        v128_t dx = wasm_f32x4_sub(wasm_v128_load(x + i), mx);
+        v128_t dy = wasm_f32x4_sub(wasm_v128_load(y + i), my);
+        v128_t inner = wasm_f32x4_add(wasm_f32x4_mul(xx, dx), wasm_f32x4_mul(xy, dy));
+        v128_t e = wasm_f32x4_add(wasm_f32x4_add(norm, wasm_f32x4_mul(dx, inner)),
+                                  wasm_f32x4_mul(wasm_f32x4_mul(yy, dy), dy));
+        v128_t term = wasm_f32x4_mul(wasm_v128_load(w + i), exp_wasm_f32(e));
+        acc = wasm_f64x2_add(acc, wasm_f64x2_promote_low_f32x4(term));
+        acc = wasm_f64x2_add(acc, wasm_f64x2_promote_low_f32x4(wasm_i32x4_shuffle(term, term, 2, 3, 0, 1)));
+    }
+    return wasm_f64x2_extract_lane(acc, 0) + wasm_f64x2_extract_lane(acc, 1)
+         + weighted_sum_scalar_(x + i, y + i, w + i, n - i);
+}
+#else
+double GaussianKernel::weighted_sum_wasm_(const double* x, const double* y, const double* w, size_t n) const {
+    return weighted_sum_scalar_(x, y, w, n);
+}
+
+double GaussianKernel::weighted_sum_wasm_(const float* x, const float* y, const float* w, size_t n) const {
+    return weighted_sum_scalar_(x, y, w, n);
+}
+#endif
@@ -0,0 +1,102 @@
+#ifndef GAUSSIAN_KERNEL_HEADER
+#define GAUSSIAN_KERNEL_HEADER
+
+#include "Geometry.h"
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+/**
+ * @brief Vectorised weighted sums of a bivariate Gaussian density.
+ * @ingroup distributions
+ *
+ * Evaluates sum_i w_i * f(x_i, y_i) for a Gaussian density f over
+ * structure-of-arrays input. This is the inner loop of the triangle
+ * quadrature in NormalDistributionQuadrature.
+ *
+ * Native x86-64 builds pick the widest supported instruction set at runtime
+ * (AVX-512F, then AVX2 with FMA, then scalar). WebAssembly builds compiled
+ * with -msimd128 use a 2-lane simd128 path. The vector paths use their own
+ * exp approximation, which agrees with std::exp to a few ulp, so all paths
+ * match the scalar one to well below 1e-12.
+ *
+ * The float overloads evaluate the density in float, with twice the lanes
+ * (8 for AVX2, 16 for AVX-512F, 4 for simd128), and add the weighted terms
+ * in double. They match the double result to about 1e-6 relative, the
+ * accuracy of Precision::FLOAT.
+ */
+class GaussianKernel {
+public:
+    /** @brief Instruction set used by weighted_sum(). */
+    enum class Isa {
+        SCALAR,
+        AVX2,
+        AVX512,
+        WASM_SIMD128,
+    };
+
+private:
+    double xx_ = 0.0;              ///< Coefficient of dx^2 in the exponent
+    double xy_ = 0.0;              ///< Coefficient of dx*dy in the exponent
+    double yy_ = 0.0;              ///< Coefficient of dy^2 in the exponent
+    double log_normaliser_ = 0.0;
+    Vec2 mean_{0.0, 0.0};
+
+public:
+    GaussianKernel() = default;
+
+    /**
+     * @brief Construct from cached Gaussian parameters.
+     * @param inv_cov Inverse covariance matrix
+     * @param log_normaliser Logarithm of the density normalisation constant
+     * @param mean Mean of the distribution
+     */
+    GaussianKernel(const std::array<std::array<double, 2>, 2>& inv_cov, double log_normaliser, Vec2 mean);
+
+    /**
+     * @brief Weighted sum of densities with the fastest instruction set available.
+     * @param x X coordinates of the points
+     * @param y Y coordinates of the points (same size as x)
+     * @param weights Weight of each point (same size as x)
+     * @return sum_i weights[i] * density(x[i], y[i])
+     */
+    [[nodiscard]] double weighted_sum(std::span<const double> x, std::span<const double> y,
+                                      std::span<const double> weights) const;
+
+    /**
+     * @brief Weighted sum of densities with an explicit instruction set.
+     * @throws std::invalid_argument if isa is not supported by this build or CPU
+     */
+    [[nodiscard]] double weighted_sum(Isa isa, std::span<const double> x, std::span<const double> y,
+                                      std::span<const double> weights) const;
+
+    /** @brief Weighted sum of densities evaluated in float, see the class description. */
+    [[nodiscard]] double weighted_sum(std::span<const float> x, std::span<const float> y,
+                                      std::span<const float> weights) const;
+
+    /**
+     * @brief Float weighted sum with an explicit instruction set.
+     * @throws std::invalid_argument if isa is not supported by this build or CPU
+     */
+    [[nodiscard]] double weighted_sum(Isa isa, std::span<const float> x, std::span<const float> y,
+                                      std::span<const float> weights) const;
+
+    /** @brief Check whether isa can be used on this build and CPU. */
+    [[nodiscard]] static bool supports(Isa isa);
+
+    /** @brief Widest supported instruction set, detected once. */
+    [[nodiscard]] static Isa best_isa();
+
+private:
+    [[nodiscard]] double weighted_sum_scalar_(const double* x, const double* y, const double* w, size_t n) const;
+    [[nodiscard]] double weighted_sum_avx2_(const double* x, const double* y, const double* w, size_t n) const;
+    [[nodiscard]] double weighted_sum_avx512_(const double* x, const double* y, const double* w, size_t n) const;
+    [[nodiscard]] double weighted_sum_wasm_(const double* x, const double* y, const double* w, size_t n) const;
+    [[nodiscard]] double weighted_sum_scalar_(const float* x, const float* y, const float* w, size_t n) const;
+    [[nodiscard]] double weighted_sum_avx2_(const float* x, const float* y, const float* w, size_t n) const;
+    [[nodiscard]] double weighted_sum_avx512_(const float* x, const float* y, const float* w, size_t n) const;
+    [[nodiscard]] double weighted_sum_wasm_(const float* x, const float* y, const float* w, size_t n) const;
+};
+
+#endif
@@ -1,5 +1,8 @@
 #include "Geometry.h"
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 
 bool Polygon::ray_segment_intersect_(Vec2 ray_origin, Vec2 seg_start, Vec2 seg_end) {
     if (seg_start.y > seg_end.y) {
@@ -15,10 +18,58 @@ bool Polygon::ray_segment_intersect_(Vec2 ray_origin, Vec2 seg_start, Vec2 seg_e
     return x_intersect >= ray_origin.x;
 }
 
-Polygon::Polygon(std::vector<Vec2>&& vertices) : vertices_(std::move(vertices)) {}
-Polygon::Polygon(const std::vector<Vec2>& vertices) : vertices_(vertices) {}
+Polygon::Polygon(std::vector<Vec2>&& vertices) : vertices_(std::move(vertices)) {
+    update_derived_();
+}
+
+Polygon::Polygon(const std::vector<Vec2>& vertices) : vertices_(vertices) {
+    update_derived_();
+}
+
+Polygon::Polygon(std::vector<Vec2>&& vertices, Derived derived) :
+    vertices_(std::move(vertices)), derived_(std::move(derived)) {
+    if (derived_.fan_areas.size() != vertices_.size()) {
+        throw std::invalid_argument("Polygon needs one fan triangle area per vertex");
+    }
+}
+
+void Polygon::update_derived_() {
+    derived_ = Derived{};
+    const size_t n = vertices_.size();
+    if (n == 0) return;
+
+    if (n >= 3) {
+        double area = 0.0;
+        for (size_t i = 1; i + 1 < n; ++i) {
+            area += signed_triangle_area(vertices_[0], vertices_[i], vertices_[i + 1]);
+        }
+        derived_.area = std::abs(area);
+    }
+
+    Vec2 center(0.0, 0.0);
+    derived_.bbox_min = vertices_[0];
+    derived_.bbox_max = vertices_[0];
+    for (const auto& v : vertices_) {
+        center.x += v.x;
+        center.y += v.y;
+        derived_.bbox_min = Vec2(std::min(derived_.bbox_min.x, v.x), std::min(derived_.bbox_min.y, v.y));
+        derived_.bbox_max = Vec2(std::max(derived_.bbox_max.x, v.x), std::max(derived_.bbox_max.y, v.y));
+    }
+    center.x /= n;
+    center.y /= n;
+    derived_.fan_center = center;
+
+    derived_.fan_areas.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        derived_.fan_areas[i] = signed_triangle_area(center, vertices_[i], vertices_[(i + 1) % n]);
+    }
+}
 
 bool Polygon::contains(Vec2 p) const {
+    // No edge spans a y outside [min, max), and none crosses right of the box
+    if (p.y < derived_.bbox_min.y || p.y >= derived_.bbox_max.y || p.x > derived_.bbox_max.x) {
+        return false;
+    }
     size_t intersections = 0;
     for (size_t i = 0; i < vertices_.size(); ++i) {
         const Vec2& a = vertices_[i];
@@ -28,4 +79,138 @@ bool Polygon::contains(Vec2 p) const {
         }
     }
     return intersections % 2 == 1;
-}
\ No newline at end of file
+}
+
+namespace {
+    constexpr double TWO_PI = 2.0 * M_PI;
+
+    /** Wrap an angle into [-pi, pi). */
+    double wrap_angle(double angle) {
+        angle = std::fmod(angle + M_PI, TWO_PI);
+        if (angle < 0) angle += TWO_PI;
+        return angle - M_PI;
+    }
+
+    struct ArcRun {
+        double start;   ///< Angle of the first vertex
+        double span;    ///< Signed sum of the angular steps
+        double radius;  ///< Mean radius of the vertices
+    };
+}
+
+bool PolarSector::contains(Vec2 p) const {
+    double r = std::hypot(p.x, p.y);
+    if (r < r_inner || r >= r_outer) return false;
+    double d = std::fmod(std::atan2(p.y, p.x) - angle_start, TWO_PI);
+    if (d < 0) d += TWO_PI;
+    if (d >= TWO_PI) d -= TWO_PI;
+    return d < angle_end - angle_start;
+}
+
+std::pair<Vec2, Vec2> PolarSector::bounding_box() const {
+    Vec2 min{std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+    Vec2 max{std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+    auto include = [&](double r, double angle) {
+        Vec2 p{r * std::cos(angle), r * std::sin(angle)};
+        min = Vec2{std::min(min.x, p.x), std::min(min.y, p.y)};
+        max = Vec2{std::max(max.x, p.x), std::max(max.y, p.y)};
+    };
+    include(r_inner, angle_start);
+    include(r_inner, angle_end);
+    include(r_outer, angle_start);
+    include(r_outer, angle_end);
+    // The outer arc reaches further wherever it crosses an axis
+    for (int k = -2; k <= 6; ++k) {
+        double axis = k * 0.5 * M_PI;
+        if (axis > angle_start && axis < angle_end) include(r_outer, axis);
+    }
+    return {min, max};
+}
+
+std::optional<PolarSector> Polygon::as_polar_sector() const {
+    const size_t n = vertices_.size();
+    if (n < 3) return std::nullopt;
+
+    std::vector<double> radii(n);
+    std::vector<double> angles(n);
+    double r_min = std::hypot(vertices_[0].x, vertices_[0].y);
+    double r_max = r_min;
+    for (size_t i = 0; i < n; ++i) {
+        radii[i] = std::hypot(vertices_[i].x, vertices_[i].y);
+        angles[i] = std::atan2(vertices_[i].y, vertices_[i].x);
+        r_min = std::min(r_min, radii[i]);
+        r_max = std::max(r_max, radii[i]);
+    }
+    const double tolerance = RADIUS_TOLERANCE * r_max;
+    if (r_max <= tolerance) return std::nullopt;
+
+    // Walks the vertices [first, first + count) cyclically and checks they form a fine arc.
+    auto arc_run = [&](size_t first, size_t count, bool closed) -> std::optional<ArcRun> {
+        ArcRun run{angles[first], 0.0, 0.0};
+        size_t steps = closed ? count : count - 1;
+        for (size_t k = 0; k < count; ++k) {
+            run.radius += radii[(first + k) % n];
+        }
+        run.radius /= static_cast<double>(count);
+        for (size_t k = 0; k < steps; ++k) {
+            double step = wrap_angle(angles[(first + k + 1) % n] - angles[(first + k) % n]);
+            if (step == 0.0 || std::abs(step) > MAX_ARC_STEP) return std::nullopt;
+            if (k > 0 && (step > 0) != (run.span > 0)) return std::nullopt;
+            run.span += step;
+        }
+        return run;
+    };
+
+    if (r_max - r_min <= tolerance) {
+        // Full disc: a single circle winding once around the origin.
+        auto run = arc_run(0, n, true);
+        if (!run || std::abs(std::abs(run->span) - TWO_PI) > ANGLE_TOLERANCE) return std::nullopt;
+        return PolarSector{0.0, run->radius, -M_PI, M_PI};
+    }
+
+    std::vector<bool> outer(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (std::abs(radii[i] - r_max) <= tolerance) outer[i] = true;
+        else if (std::abs(radii[i] - r_min) <= tolerance) outer[i] = false;
+        else return std::nullopt;
+    }
+
+    // The two radius classes must form exactly one contiguous run each.
+    size_t outer_first = n;
+    size_t transitions = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (outer[i] != outer[(i + n - 1) % n]) {
+            ++transitions;
+            if (outer[i]) outer_first = i;
+        }
+    }
+    if (transitions != 2) return std::nullopt;
+    size_t outer_count = 0;
+    while (outer_count < n && outer[(outer_first + outer_count) % n]) ++outer_count;
+    size_t inner_first = (outer_first + outer_count) % n;
+    size_t inner_count = n - outer_count;
+
+    auto outer_run = arc_run(outer_first, outer_count, false);
+    if (!outer_run || outer_count < 2) return std::nullopt;
+    double span = std::abs(outer_run->span);
+    double start = outer_run->span > 0 ? outer_run->start : outer_run->start + outer_run->span;
+    if (span >= TWO_PI - ANGLE_TOLERANCE) return std::nullopt;
+
+    double r_inner = 0.0;
+    if (r_min <= tolerance) {
+        // Pie slice: the only inner vertex is the origin.
+        if (inner_count != 1) return std::nullopt;
+    } else {
+        auto inner_run = arc_run(inner_first, inner_count, false);
+        if (!inner_run || inner_count < 2) return std::nullopt;
+        double inner_start = inner_run->span > 0 ? inner_run->start : inner_run->start + inner_run->span;
+        if (std::abs(std::abs(inner_run->span) - span) > ANGLE_TOLERANCE
+            || std::abs(wrap_angle(inner_start - start)) > ANGLE_TOLERANCE) {
+            return std::nullopt;
+        }
+        r_inner = inner_run->radius;
+    }
+
+    start = wrap_angle(start);
+    return PolarSector{r_inner, outer_run->radius, start, start + span};
+}
@@ -3,6 +3,9 @@
 
 #include <cstddef>
 #include <cstdlib>
+#include <optional>
+#include <span>
+#include <utility>
 #include <vector>
 
 /**
@@ -74,30 +77,102 @@ inline double signed_triangle_area(Vec2 v0, Vec2 v1, Vec2 v2) {
     return 0.5 * ((v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y));
 }
 
+/**
+ * @ingroup geometry
+ * @brief Annular sector around the origin: r_inner <= |p| < r_outer and angle_start <= angle(p) < angle_end.
+ *
+ * Angles are in radians, counter-clockwise from the positive x axis.
+ * angle_start lies in [-pi, pi) and angle_end - angle_start is in (0, 2pi].
+ * A full disc has r_inner = 0 and a span of 2pi.
+ */
+struct PolarSector {
+    double r_inner;
+    double r_outer;
+    double angle_start;
+    double angle_end;
+
+    /** @brief Check if p lies inside the sector (half-open in radius and angle). */
+    [[nodiscard]] bool contains(Vec2 p) const;
+
+    /** @brief Smallest axis-aligned box containing the sector, as (min, max) corners. */
+    [[nodiscard]] std::pair<Vec2, Vec2> bounding_box() const;
+};
+
 /**
  * @ingroup geometry
  * @brief A simple polygon represented by vertices.
  */
 class Polygon {
+public:
+    /**
+     * @brief Quantities derived from the vertices that integration and hit tests read.
+     *
+     * The polygon is fan-triangulated around the mean of its vertices: triangle i is
+     * (fan_center, v[i], v[(i + 1) % n]), so there is one triangle per vertex.
+     */
+    struct Derived {
+        double area = 0.0;              ///< Absolute area by the shoelace formula
+        Vec2 fan_center{0.0, 0.0};      ///< Mean of the vertices, the shared apex of the fan
+        Vec2 bbox_min{0.0, 0.0};        ///< Lower corner of the axis-aligned bounding box
+        Vec2 bbox_max{0.0, 0.0};        ///< Upper corner of the axis-aligned bounding box
+        std::vector<double> fan_areas;  ///< Signed area of fan triangle i
+    };
+
 private:
     std::vector<Vec2> vertices_;
+    Derived derived_;                   ///< Kept in sync with vertices_ by every mutator
     
+    static constexpr double MAX_ARC_STEP = 0.175;         ///< Largest angle between arc vertices (about 10 degrees)
+    static constexpr double RADIUS_TOLERANCE = 1e-5;      ///< Relative radius tolerance for arc vertices
+    static constexpr double ANGLE_TOLERANCE = 1e-5;       ///< Tolerance when matching arc end angles
+
     /** @brief Helper for ray casting: checks if horizontal ray from p intersects segment [a,b). */
     static bool ray_segment_intersect_(Vec2 p, Vec2 a, Vec2 b);
+    /** @brief Recompute derived_ from vertices_. */
+    void update_derived_();
 public:
     Polygon() = default;
     Polygon(std::vector<Vec2>&& vertices);
     Polygon(const std::vector<Vec2>& vertices);
+    /**
+     * @brief Polygon with derived data computed earlier, e.g. read from a binary target.
+     * The data is trusted as given; it must match what the other constructors compute.
+     * @throws std::invalid_argument if derived.fan_areas does not have one entry per vertex
+     */
+    Polygon(std::vector<Vec2>&& vertices, Derived derived);
     
     /**
      * @brief Point-in-polygon test using ray casting algorithm.
      * Casts a horizontal ray from p to the right and counts intersections.
      * @param p Point to test
+     * Points outside the bounding box are rejected without looking at the edges.
      * @return true if p is inside the polygon (odd number of intersections)
      */
     [[nodiscard]] bool contains(Vec2 p) const;
+
+    /**
+     * @brief Recognise a polygon that approximates an annular sector around the origin.
+     *
+     * Matches the shapes produced by gen_target.py: an inner and an outer arc over the same
+     * angle range, a full disc, or a pie slice with a vertex at the origin. Arcs need at least
+     * MAX_ARC_STEP angular resolution, so coarse polygons such as squares are not matched.
+     * @return The sector the polygon approximates, or std::nullopt
+     */
+    [[nodiscard]] std::optional<PolarSector> as_polar_sector() const;
+
     [[nodiscard]] const std::vector<Vec2>& get_vertices() const { return vertices_; }
-    void set_vertices(std::vector<Vec2>&& v) { vertices_ = std::move(v); }
+    void set_vertices(std::vector<Vec2>&& v) {
+        vertices_ = std::move(v);
+        update_derived_();
+    }
+
+    [[nodiscard]] const Derived& get_derived() const { return derived_; }
+    [[nodiscard]] double get_area() const { return derived_.area; }
+    [[nodiscard]] Vec2 get_fan_center() const { return derived_.fan_center; }
+    /** @brief Smallest axis-aligned box containing the polygon, as (min, max) corners. */
+    [[nodiscard]] std::pair<Vec2, Vec2> bounding_box() const { return {derived_.bbox_min, derived_.bbox_max}; }
+    /** @brief Signed areas of the fan triangles, see Derived. */
+    [[nodiscard]] std::span<const double> get_fan_areas() const { return derived_.fan_areas; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,424 @@
+#include "HitProbabilityField.h"
+#include "Game.h"
+#include "Geometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+    using Complex = std::complex<double>;
+
+    // Written out by hand: the generic operator* handles inf/nan corner cases
+    // through a library call, which dominates the butterfly in unoptimised builds.
+    inline Complex mul(Complex a, Complex b) {
+        return Complex{a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+    }
+
+    size_t next_power_of_two(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    size_t odd_ceil(double value) {
+        auto n = static_cast<size_t>(std::ceil(value));
+        if (n < 1) n = 1;
+        if (n % 2 == 0) ++n;
+        return n;
+    }
+
+    /**
+     * Iterative radix-2 Cooley-Tukey FFT for one fixed power-of-two length.
+     * The inverse transform is unnormalised.
+     */
+    class Fft {
+        size_t n_;
+        std::vector<size_t> bit_reverse_;
+        std::vector<Complex> twiddles_;         ///< Per stage, contiguous: stage of length len starts at len / 2 - 1
+        std::vector<Complex> inverse_twiddles_;
+    public:
+        explicit Fft(size_t n) : n_(n), bit_reverse_(n, 0) {
+            size_t bits = 0;
+            while ((size_t{1} << bits) < n_) ++bits;
+            for (size_t i = 0; i < n_; ++i) {
+                size_t r = 0;
+                for (size_t b = 0; b < bits; ++b) {
+                    if (i & (size_t{1} << b)) r |= size_t{1} << (bits - 1 - b);
+                }
+                bit_reverse_[i] = r;
+            }
+            for (size_t len = 2; len <= n_; len <<= 1) {
+                for (size_t k = 0; k < len / 2; ++k) {
+                    double angle = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(len);
+                    twiddles_.emplace_back(std::cos(angle), std::sin(angle));
+                    inverse_twiddles_.emplace_back(std::cos(angle), -std::sin(angle));
+                }
+            }
+        }
+
+        void transform(Complex* data, bool inverse) const {
+            for (size_t i = 0; i < n_; ++i) {
+                if (i < bit_reverse_[i]) std::swap(data[i], data[bit_reverse_[i]]);
+            }
+            const Complex* stage = inverse ? inverse_twiddles_.data() : twiddles_.data();
+            for (size_t len = 2; len <= n_; len <<= 1) {
+                size_t half = len / 2;
+                for (size_t start = 0; start < n_; start += len) {
+                    for (size_t k = 0; k < half; ++k) {
+                        Complex w = stage[k];
+                        Complex u = data[start + k];
+                        Complex v = mul(data[start + k + half], w);
+                        data[start + k] = u + v;
+                        data[start + k + half] = u - v;
+                    }
+                }
+                stage += half;
+            }
+        }
+    };
+
+    /**
+     * Raster geometry: nx * ny pixels of size hx * hy with the lower left corner at origin.
+     */
+    struct Raster {
+        Vec2 origin;
+        double hx;
+        double hy;
+        size_t nx;
+        size_t ny;
+    };
+
+    /** Add the horizontal span [x0, x1] at one sub-scanline of pixel row y, with given weight. */
+    void add_span(const Raster& raster, double x0, double x1, double weight, double* row) {
+        double u0 = std::clamp((x0 - raster.origin.x) / raster.hx, 0.0, static_cast<double>(raster.nx));
+        double u1 = std::clamp((x1 - raster.origin.x) / raster.hx, 0.0, static_cast<double>(raster.nx));
+        if (u1 <= u0) return;
+        auto c0 = static_cast<size_t>(u0);
+        auto c1 = static_cast<size_t>(u1);
+        if (c0 == c1) {
+            row[c0] += (u1 - u0) * weight;
+            return;
+        }
+        row[c0] += (static_cast<double>(c0 + 1) - u0) * weight;
+        for (size_t c = c0 + 1; c < c1; ++c) row[c] += weight;
+        if (c1 < raster.nx) row[c1] += (u1 - static_cast<double>(c1)) * weight;
+    }
+
+    /**
+     * Accumulate anti-aliased coverage of a polygon into raster cells.
+     * Each pixel row is split into sub-scanlines whose spans are integrated exactly in x,
+     * using the same even-odd, half-open rule as Polygon::contains.
+     */
+    void rasterize(const Polygon& polygon, const Raster& raster, std::vector<double>& cells) {
+        constexpr int SUB_SCANLINES = 5;
+        const auto& verts = polygon.get_vertices();
+        if (verts.size() < 3) return;
+
+        double min_y = verts[0].y, max_y = verts[0].y;
+        for (const auto& v : verts) {
+            min_y = std::min(min_y, v.y);
+            max_y = std::max(max_y, v.y);
+        }
+        auto row_from = static_cast<long>(std::floor((min_y - raster.origin.y) / raster.hy));
+        auto row_to = static_cast<long>(std::floor((max_y - raster.origin.y) / raster.hy));
+        row_from = std::max(row_from, 0L);
+        row_to = std::min(row_to, static_cast<long>(raster.ny) - 1);
+
+        std::vector<double> crossings;
+        for (long row = row_from; row <= row_to; ++row) {
+            double* cells_row = cells.data() + static_cast<size_t>(row) * raster.nx;
+            for (int sub = 0; sub < SUB_SCANLINES; ++sub) {
+                double y = raster.origin.y + (row + (sub + 0.5) / SUB_SCANLINES) * raster.hy;
+                crossings.clear();
+                for (size_t i = 0; i < verts.size(); ++i) {
+                    Vec2 a = verts[i];
+                    Vec2 b = verts[(i + 1) % verts.size()];
+                    if (a.y > b.y) std::swap(a, b);
+                    if (y < a.y || y >= b.y) continue;
+                    double t = (y - a.y) / (b.y - a.y);
+                    crossings.push_back(a.x + t * (b.x - a.x));
+                }
+                std::sort(crossings.begin(), crossings.end());
+                for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+                    add_span(raster, crossings[k], crossings[k + 1], 1.0 / SUB_SCANLINES, cells_row);
+                }
+            }
+        }
+    }
+}
+
+HitProbabilityField::HitProbabilityField(const Target& target, const NormalDistribution& distribution,
+                                         Game::Bounds bounds, size_t width_samples, size_t height_samples,
+                                         double max_cell_size, Precision precision)
+    : HitProbabilityField(target, distribution, AimGrid(bounds.min, bounds.max, width_samples, height_samples),
+                          max_cell_size, precision) {}
+
+HitProbabilityField::HitProbabilityField(const Target& target, const NormalDistribution& distribution,
+                                         const AimGrid& grid, double max_cell_size, Precision precision)
+    : grid_(grid) {
+    const NormalDistribution* distributions[] = {&distribution};
+    *this = std::move(batch(target, distributions, grid, max_cell_size, precision).front());
+}
+
+std::vector<HitProbabilityField> HitProbabilityField::batch(const Target& target,
+                                                            std::span<const NormalDistribution* const> distributions,
+                                                            const AimGrid& grid, double max_cell_size,
+                                                            Precision precision) {
+    std::vector<HitProbabilityField> fields;
+    if (distributions.empty()) return fields;
+    const Game::Bounds bounds{grid.get_min(), grid.get_max()};
+    const size_t width_samples = grid.get_width();
+    const size_t height_samples = grid.get_height();
+
+    // The narrowest distribution sets the raster, the finer raster is only more accurate for the others.
+    double cell_size = max_cell_size;
+    for (const NormalDistribution* distribution : distributions) {
+        const auto& cov = distribution->get_covariance();
+        // Smallest principal standard deviation bounds how fine the raster has to be.
+        double half_trace = 0.5 * (cov[0][0] + cov[1][1]);
+        double det = cov[0][0] * cov[1][1] - cov[0][1] * cov[1][0];
+        double sigma_min = std::sqrt(std::max(half_trace - std::sqrt(std::max(half_trace * half_trace - det, 0.0)), 0.0));
+        if (sigma_min > 0.0) cell_size = std::min(cell_size, sigma_min / 2.0);
+    }
+
+    // Pick an odd subdivision of the aim spacing so aims land on pixel centres.
+    double width = bounds.max.x - bounds.min.x;
+    double height = bounds.max.y - bounds.min.y;
+    size_t sub_x = odd_ceil(width / width_samples / cell_size);
+    size_t sub_y = odd_ceil(height / height_samples / cell_size);
+    while (sub_x > 1 && width_samples * sub_x > MAX_RASTER_SIZE_) sub_x -= 2;
+    while (sub_y > 1 && height_samples * sub_y > MAX_RASTER_SIZE_) sub_y -= 2;
+
+    Raster raster{bounds.min, 0.0, 0.0, width_samples * sub_x, height_samples * sub_y};
+    raster.hx = width / raster.nx;
+    raster.hy = height / raster.ny;
+
+    // Kernel offsets (in pixels) that carry non-negligible probability, clipped to offsets that
+    // can actually connect a raster pixel with an aim.
+    struct Support {
+        long lo_x, hi_x, lo_y, hi_y;
+        bool clipped;
+    };
+    const auto max_offset_x = static_cast<long>(raster.nx) - 1;
+    const auto max_offset_y = static_cast<long>(raster.ny) - 1;
+    std::vector<Support> supports;
+    size_t fft_nx = 1;
+    size_t fft_ny = 1;
+    for (const NormalDistribution* distribution : distributions) {
+        const auto& cov = distribution->get_covariance();
+        const Vec2 mean = distribution->get_mean();
+        double sigma_x = std::sqrt(cov[0][0]);
+        double sigma_y = std::sqrt(cov[1][1]);
+        Support support{};
+        support.lo_x = static_cast<long>(std::floor((mean.x - KERNEL_SIGMAS_ * sigma_x) / raster.hx));
+        support.hi_x = static_cast<long>(std::ceil((mean.x + KERNEL_SIGMAS_ * sigma_x) / raster.hx));
+        support.lo_y = static_cast<long>(std::floor((mean.y - KERNEL_SIGMAS_ * sigma_y) / raster.hy));
+        support.hi_y = static_cast<long>(std::ceil((mean.y + KERNEL_SIGMAS_ * sigma_y) / raster.hy));
+        support.clipped = support.lo_x < -max_offset_x || support.hi_x > max_offset_x
+                          || support.lo_y < -max_offset_y || support.hi_y > max_offset_y;
+        support.lo_x = std::max(support.lo_x, -max_offset_x);
+        support.hi_x = std::min(support.hi_x, max_offset_x);
+        support.lo_y = std::max(support.lo_y, -max_offset_y);
+        support.hi_y = std::min(support.hi_y, max_offset_y);
+        supports.push_back(support);
+
+        // Transform size large enough that the circular correlation equals the linear one on the raster.
+        fft_nx = std::max(fft_nx, next_power_of_two(raster.nx + static_cast<size_t>(std::max({-support.lo_x, support.hi_x, 0L}))));
+        fft_ny = std::max(fft_ny, next_power_of_two(raster.ny + static_cast<size_t>(std::max({-support.lo_y, support.hi_y, 0L}))));
+    }
+    Fft fft_x(fft_nx);
+    Fft fft_y(fft_ny);
+    std::vector<Complex> column(fft_ny);
+
+    // Kernel planes: probability of landing in the pixel at offset d from the aim.
+    std::vector<std::vector<Complex>> kernels(distributions.size());
+    std::vector<std::vector<size_t>> spectrum_rows(distributions.size());
+    std::vector<bool> any_spectrum_row(fft_ny, false);
+    for (size_t d = 0; d < distributions.size(); ++d) {
+        const Support& support = supports[d];
+        auto& kernel = kernels[d];
+        kernel.assign(fft_nx * fft_ny, Complex{0.0, 0.0});
+        double kernel_mass = 0.0;
+        for (long dy = support.lo_y; dy <= support.hi_y; ++dy) {
+            for (long dx = support.lo_x; dx <= support.hi_x; ++dx) {
+                double value = distributions[d]->probability_density(Vec2{dx * raster.hx, dy * raster.hy}) * raster.hx * raster.hy;
+                size_t kx = static_cast<size_t>((dx % static_cast<long>(fft_nx) + static_cast<long>(fft_nx)) % static_cast<long>(fft_nx));
+                size_t ky = static_cast<size_t>((dy % static_cast<long>(fft_ny) + static_cast<long>(fft_ny)) % static_cast<long>(fft_ny));
+                kernel[ky * fft_nx + kx] = Complex{value, 0.0};
+                kernel_mass += value;
+            }
+        }
+        // With the full support on the plane the kernel should hold unit mass, renormalising removes
+        // the sampling error of very narrow distributions.
+        if (!support.clipped && kernel_mass > 0.0) {
+            for (auto& k : kernel) k /= kernel_mass;
+        }
+        for (size_t y = 0; y < fft_ny; ++y) {
+            fft_x.transform(kernel.data() + y * fft_nx, false);
+        }
+        for (size_t x = 0; x < fft_nx; ++x) {
+            for (size_t y = 0; y < fft_ny; ++y) column[y] = kernel[y * fft_nx + x];
+            fft_y.transform(column.data(), false);
+            for (size_t y = 0; y < fft_ny; ++y) kernel[y * fft_nx + x] = std::conj(column[y]);
+        }
+
+        // A Gaussian has a Gaussian spectrum, so most frequency rows of the product vanish.
+        // Rows where the kernel spectrum is negligible are skipped entirely.
+        double dc = std::abs(kernel[0]);
+        for (size_t y = 0; y < fft_ny; ++y) {
+            double row_max = 0.0;
+            for (size_t x = 0; x < fft_nx; ++x) row_max = std::max(row_max, std::abs(kernel[y * fft_nx + x]));
+            if (row_max > SPECTRUM_CUTOFF_ * dc) {
+                spectrum_rows[d].push_back(y);
+                any_spectrum_row[y] = true;
+            }
+        }
+    }
+
+    // Group beds by their outcome, the miss outcome absorbs whatever is left.
+    std::map<HitData, std::vector<const Polygon*>> beds_by_outcome;
+    for (const auto& bed : target.get_beds()) {
+        beds_by_outcome[bed.after_hit()].push_back(&bed.get_shape());
+    }
+    const HitData miss(HitData::Type::NORMAL, 0);
+    beds_by_outcome[miss];
+    std::vector<HitData> outcomes;
+    std::vector<std::pair<size_t, const std::vector<const Polygon*>*>> scoring;
+    size_t miss_index = 0;
+    for (const auto& [hit, polygons] : beds_by_outcome) {
+        if (hit.type == miss.type && hit.diff == miss.diff) {
+            miss_index = outcomes.size();
+        } else {
+            scoring.emplace_back(outcomes.size(), &polygons);
+        }
+        outcomes.push_back(hit);
+    }
+
+    const size_t num_outcomes = outcomes.size();
+    for (size_t d = 0; d < distributions.size(); ++d) {
+        fields.push_back(HitProbabilityField(grid));
+        fields.back().outcomes_ = outcomes;
+        fields.back().probabilities_.assign(width_samples * height_samples * num_outcomes, 0.0);
+    }
+    const double scale = 1.0 / static_cast<double>(fft_nx * fft_ny);
+
+    // Two real rasters share one complex transform: the kernel is real, so the real and
+    // imaginary parts of the result are the two correlations. Rasterizing and the forward
+    // transform depend only on the beds, so they are done once for all distributions.
+    std::vector<Complex> plane(fft_nx * fft_ny);
+    std::vector<Complex> product(distributions.size() > 1 ? fft_nx * fft_ny : 0);
+    std::vector<double> cells_re(raster.nx * raster.ny);
+    std::vector<double> cells_im(raster.nx * raster.ny);
+    for (size_t pair = 0; pair < scoring.size(); pair += 2) {
+        bool has_second = pair + 1 < scoring.size();
+        std::fill(cells_re.begin(), cells_re.end(), 0.0);
+        std::fill(cells_im.begin(), cells_im.end(), 0.0);
+        for (const Polygon* polygon : *scoring[pair].second) rasterize(*polygon, raster, cells_re);
+        if (has_second) {
+            for (const Polygon* polygon : *scoring[pair + 1].second) rasterize(*polygon, raster, cells_im);
+        }
+
+        // Forward transform along y, only raster columns are non-zero.
+        std::fill(plane.begin(), plane.end(), Complex{0.0, 0.0});
+        for (size_t x = 0; x < raster.nx; ++x) {
+            std::fill(column.begin(), column.end(), Complex{0.0, 0.0});
+            for (size_t y = 0; y < raster.ny; ++y) {
+                column[y] = Complex{cells_re[y * raster.nx + x], cells_im[y * raster.nx + x]};
+            }
+            fft_y.transform(column.data(), false);
+            for (size_t y = 0; y < fft_ny; ++y) plane[y * fft_nx + x] = column[y];
+        }
+        // Forward along x, on every row some distribution needs.
+        for (size_t y = 0; y < fft_ny; ++y) {
+            if (any_spectrum_row[y]) fft_x.transform(plane.data() + y * fft_nx, false);
+        }
+
+        for (size_t d = 0; d < distributions.size(); ++d) {
+            // A single distribution works on the shared plane directly
+            std::vector<Complex>& work = product.empty() ? plane : product;
+            // Multiply by the kernel spectrum and transform back along x.
+            for (size_t y : spectrum_rows[d]) {
+                Complex* row = work.data() + y * fft_nx;
+                const Complex* plane_row = plane.data() + y * fft_nx;
+                const Complex* kernel_row = kernels[d].data() + y * fft_nx;
+                for (size_t x = 0; x < fft_nx; ++x) row[x] = mul(plane_row[x], kernel_row[x]);
+                fft_x.transform(row, true);
+            }
+            // Inverse along y is only needed for columns holding aims.
+            double* probabilities = fields[d].probabilities_.data();
+            for (size_t i = 0; i < width_samples; ++i) {
+                size_t x = i * sub_x + sub_x / 2;
+                std::fill(column.begin(), column.end(), Complex{0.0, 0.0});
+                for (size_t y : spectrum_rows[d]) column[y] = work[y * fft_nx + x];
+                fft_y.transform(column.data(), true);
+                for (size_t j = 0; j < height_samples; ++j) {
+                    Complex value = column[j * sub_y + sub_y / 2] * scale;
+                    double* aim_probabilities = probabilities + (i * height_samples + j) * num_outcomes;
+                    aim_probabilities[scoring[pair].first] = std::clamp(value.real(), 0.0, 1.0);
+                    if (has_second) aim_probabilities[scoring[pair + 1].first] = std::clamp(value.imag(), 0.0, 1.0);
+                }
+            }
+        }
+    }
+
+    for (auto& field : fields) {
+        for (size_t aim = 0; aim < width_samples * height_samples; ++aim) {
+            double* aim_probabilities = field.probabilities_.data() + aim * num_outcomes;
+            double total = 0.0;
+            for (size_t k = 0; k < num_outcomes; ++k) {
+                if (k != miss_index) total += aim_probabilities[k];
+            }
+            aim_probabilities[miss_index] = std::max(0.0, 1.0 - total);
+        }
+        // Narrowed once the whole table is computed, the transforms always run in double
+        field.precision_ = precision;
+        field.max_cell_size_ = max_cell_size;
+        if (precision == Precision::FLOAT) {
+            field.float_probabilities_.assign(field.probabilities_.begin(), field.probabilities_.end());
+            field.probabilities_ = {};
+        }
+    }
+    return fields;
+}
+
+bool HitProbabilityField::covers(Vec2 aim) const {
+    size_t i, j;
+    return find_aim(aim, i, j);
+}
+
+bool HitProbabilityField::find_aim(Vec2 aim, size_t& i, size_t& j) const {
+    return grid_.find(aim, i, j);
+}
+
+Game::HitDistribution HitProbabilityField::distribution_at(Vec2 aim) const {
+    size_t i, j;
+    if (!find_aim(aim, i, j)) {
+        throw std::out_of_range("Aim is not on the HitProbabilityField grid");
+    }
+    return distribution_at(i, j);
+}
+
+void HitProbabilityField::probabilities_at(size_t i, size_t j, std::span<double> out) const {
+    const size_t first = grid_.index(i, j) * outcomes_.size();
+    if (precision_ == Precision::FLOAT) {
+        std::copy_n(float_probabilities_.begin() + static_cast<std::ptrdiff_t>(first), outcomes_.size(), out.begin());
+    } else {
+        std::copy_n(probabilities_.begin() + static_cast<std::ptrdiff_t>(first), outcomes_.size(), out.begin());
+    }
+}
+
+Game::HitDistribution HitProbabilityField::distribution_at(size_t i, size_t j) const {
+    std::vector<double> aim_probabilities(outcomes_.size());
+    probabilities_at(i, j, aim_probabilities);
+    Game::HitDistribution result;
+    result.reserve(outcomes_.size());
+    for (size_t k = 0; k < outcomes_.size(); ++k) {
+        result.emplace_back(outcomes_[k], aim_probabilities[k]);
+    }
+    return result;
+}
@@ -0,0 +1,135 @@
+#ifndef HIT_PROBABILITY_FIELD_HEADER
+#define HIT_PROBABILITY_FIELD_HEADER
+
+#include "AimGrid.h"
+#include "Distribution.h"
+#include "Game.h"
+#include "Geometry.h"
+#include "Precision.h"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Hit distributions for a whole grid of aim points, computed by FFT convolution.
+ * @ingroup game
+ *
+ * The throw distribution does not depend on the aim, so the probability of
+ * hitting a bed as a function of the aim point is the cross-correlation of
+ * the bed's indicator function with the throw density. Every distinct HitData
+ * outcome is rasterized once over the target bounds (with anti-aliased
+ * coverage), transformed with a 2D FFT, multiplied by the transformed
+ * Gaussian kernel and transformed back. The result is sampled at the aim grid
+ * (an AimGrid, the same as the solvers use for matching bounds and sizes).
+ *
+ * The raster is an odd integer subdivision of the aim grid, so every aim lies
+ * exactly on a pixel centre and no interpolation is needed. Frequency rows where
+ * the Gaussian spectrum is negligible are skipped, which makes wide distributions
+ * as cheap as narrow ones.
+ *
+ * batch() computes the fields of several distributions in one sweep. The beds
+ * are rasterized and forward transformed once, then each distribution only
+ * multiplies by its own kernel spectrum and transforms back. The shared raster
+ * is fine enough for the narrowest distribution.
+ *
+ * With Precision::FLOAT the table is computed in double and stored as float, which
+ * halves its memory; probabilities_at() widens the values back to double.
+ *
+ * Example usage:
+ * @code
+ * NormalDistributionQuadrature dist(cov);
+ * GameFinishOnDouble game(target, dist);
+ * HitProbabilityField field(target, dist, game.get_target_bounds(), 100, 100);
+ * game.use_hit_probability_field(field); // Grid aims now skip the per-bed quadrature
+ * SolverMinThrows solver(game, 10000);
+ * @endcode
+ */
+class HitProbabilityField {
+private:
+    static constexpr size_t MAX_RASTER_SIZE_ = 4096; ///< Upper limit on raster pixels per axis
+    static constexpr double KERNEL_SIGMAS_ = 7.0;     ///< Kernel support radius in standard deviations
+    static constexpr double SPECTRUM_CUTOFF_ = 1e-9;  ///< Relative kernel spectrum magnitude treated as zero
+
+    AimGrid grid_;
+    std::vector<HitData> outcomes_;     ///< Distinct outcomes in HitData order, miss included
+    Precision precision_ = Precision::DOUBLE;
+    double max_cell_size_ = 1.0;
+    std::vector<double> probabilities_;      ///< [grid_.index(i, j) * outcomes_.size() + outcome], DOUBLE only
+    std::vector<float> float_probabilities_; ///< Same layout, FLOAT only
+
+    explicit HitProbabilityField(const AimGrid& grid) : grid_(grid) {}
+
+public:
+    /**
+     * @brief Compute hit distributions for a uniform aim grid.
+     * @param target Target whose beds are rasterized
+     * @param distribution Throw distribution (mean and covariance are used)
+     * @param bounds Region covered by the aim grid, normally Game::get_target_bounds()
+     * @param width_samples Number of aim columns (x direction)
+     * @param height_samples Number of aim rows (y direction)
+     * @param max_cell_size Largest allowed raster pixel size, in target units
+     * @param precision Width of the stored table
+     */
+    HitProbabilityField(const Target& target, const NormalDistribution& distribution, Game::Bounds bounds,
+                        size_t width_samples, size_t height_samples, double max_cell_size = 1.0,
+                        Precision precision = Precision::DOUBLE);
+
+    /**
+     * @brief Compute hit distributions for the aims of an existing grid, e.g. Game::aim_grid().
+     * @param target Target whose beds are rasterized
+     * @param distribution Throw distribution (mean and covariance are used)
+     * @param grid Aim grid to evaluate
+     * @param max_cell_size Largest allowed raster pixel size, in target units
+     * @param precision Width of the stored table
+     */
+    HitProbabilityField(const Target& target, const NormalDistribution& distribution, const AimGrid& grid,
+                        double max_cell_size = 1.0, Precision precision = Precision::DOUBLE);
+
+    /**
+     * @brief Compute the fields of several distributions over one aim grid, sharing the bed transforms.
+     * A single distribution gives exactly the field of the constructor. With several, the raster
+     * and transform size fit all of them, so a field can differ from its own constructor by the
+     * discretisation error of the finer raster.
+     * @param target Target whose beds are rasterized
+     * @param distributions Throw distributions (mean and covariance are used)
+     * @param grid Aim grid to evaluate
+     * @param max_cell_size Largest allowed raster pixel size, in target units
+     * @param precision Width of the stored tables
+     * @return One field per distribution, in order
+     */
+    [[nodiscard]] static std::vector<HitProbabilityField> batch(const Target& target,
+                                                                std::span<const NormalDistribution* const> distributions,
+                                                                const AimGrid& grid, double max_cell_size = 1.0,
+                                                                Precision precision = Precision::DOUBLE);
+
+    /** @brief Check whether aim lies on the precomputed grid. */
+    [[nodiscard]] bool covers(Vec2 aim) const;
+
+    /** @brief Find the grid column i and row j of an aim, returns false when the aim is off the grid. */
+    [[nodiscard]] bool find_aim(Vec2 aim, size_t& i, size_t& j) const;
+
+    /**
+     * @brief Hit distribution for an aim on the grid.
+     * @throws std::out_of_range if aim is not a grid point
+     */
+    [[nodiscard]] Game::HitDistribution distribution_at(Vec2 aim) const;
+
+    /** @brief Hit distribution for grid column i and row j. */
+    [[nodiscard]] Game::HitDistribution distribution_at(size_t i, size_t j) const;
+
+    /**
+     * @brief Copy the probabilities of get_outcomes() for grid column i and row j into out.
+     * @param out One entry per outcome
+     */
+    void probabilities_at(size_t i, size_t j, std::span<double> out) const;
+
+    [[nodiscard]] size_t get_width_samples() const { return grid_.get_width(); }
+    [[nodiscard]] size_t get_height_samples() const { return grid_.get_height(); }
+    [[nodiscard]] const AimGrid& get_grid() const { return grid_; }
+    [[nodiscard]] const std::vector<HitData>& get_outcomes() const { return outcomes_; }
+    [[nodiscard]] Precision get_precision() const { return precision_; }
+    [[nodiscard]] double get_max_cell_size() const { return max_cell_size_; }
+};
+
+#endif
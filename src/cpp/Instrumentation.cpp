@@ -0,0 +1,135 @@
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <mutex>
+
+std::array<std::atomic<uint64_t>, Instrumentation::COUNTERS> Instrumentation::counters_{};
+std::array<std::atomic<uint64_t>, Instrumentation::TIMERS> Instrumentation::nanoseconds_{};
+std::array<std::atomic<uint64_t>, Instrumentation::TIMERS> Instrumentation::timer_calls_{};
+std::atomic<uint64_t> Instrumentation::round_dp_cache_entries_{0};
+
+namespace {
+
+// Per-state data is appended once per solved state, far off the hot loops
+std::mutex& state_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+std::vector<uint64_t>& state_evaluations() {
+    static std::vector<uint64_t> evaluations;
+    return evaluations;
+}
+std::vector<Instrumentation::RoundConvergence>& round_convergence() {
+    static std::vector<Instrumentation::RoundConvergence> convergence;
+    return convergence;
+}
+
+} // namespace
+
+void Instrumentation::record_state_evaluations_(Game::State s, uint64_t evaluations) {
+    std::lock_guard lock(state_mutex());
+    auto& by_state = state_evaluations();
+    if (by_state.size() <= s) by_state.resize(static_cast<size_t>(s) + 1, 0);
+    by_state[s] += evaluations;
+}
+
+void Instrumentation::record_round_convergence_(RoundConvergence convergence) {
+    std::lock_guard lock(state_mutex());
+    round_convergence().push_back(convergence);
+}
+
+#if DARTS_INSTRUMENTATION
+namespace {
+thread_local std::array<unsigned int, Instrumentation::TIMERS> timer_depth{};
+}
+
+Instrumentation::ScopedTimer::ScopedTimer(Timer timer)
+    : timer_(timer), outermost_(timer_depth[static_cast<size_t>(timer)]++ == 0),
+      start_(outermost_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}) {}
+
+Instrumentation::ScopedTimer::~ScopedTimer() {
+    const size_t index = static_cast<size_t>(timer_);
+    --timer_depth[index];
+    if (!outermost_) return;
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+    nanoseconds_[index].fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+    timer_calls_[index].fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+std::string_view Instrumentation::name(Counter counter) {
+    static constexpr std::array<std::string_view, COUNTERS> NAMES = {
+        "integrations", "outcome_row_hits", "outcome_row_misses", "aim_evaluations", "pruned_aims", "round_iterations", "heat_map_cells"
+    };
+    return NAMES[static_cast<size_t>(counter)];
+}
+
+std::string_view Instrumentation::name(Timer timer) {
+    static constexpr std::array<std::string_view, TIMERS> NAMES = {
+        "compile_rows", "solve_min_throws", "solve_min_rounds", "heat_maps"
+    };
+    return NAMES[static_cast<size_t>(timer)];
+}
+
+Instrumentation::Report Instrumentation::report() {
+    Report report;
+    for (size_t k = 0; k < COUNTERS; ++k) report.counters[k] = counters_[k].load(std::memory_order_relaxed);
+    for (size_t k = 0; k < TIMERS; ++k) {
+        report.seconds[k] = static_cast<double>(nanoseconds_[k].load(std::memory_order_relaxed)) * 1e-9;
+        report.timer_calls[k] = timer_calls_[k].load(std::memory_order_relaxed);
+    }
+    report.round_dp_cache_entries = round_dp_cache_entries_.load(std::memory_order_relaxed);
+    std::lock_guard lock(state_mutex());
+    report.aim_evaluations_by_state = state_evaluations();
+    report.round_convergence = round_convergence();
+    return report;
+}
+
+void Instrumentation::reset() {
+    for (auto& counter : counters_) counter.store(0, std::memory_order_relaxed);
+    for (auto& time : nanoseconds_) time.store(0, std::memory_order_relaxed);
+    for (auto& calls : timer_calls_) calls.store(0, std::memory_order_relaxed);
+    round_dp_cache_entries_.store(0, std::memory_order_relaxed);
+    std::lock_guard lock(state_mutex());
+    state_evaluations().clear();
+    round_convergence().clear();
+}
+
+void Instrumentation::print(std::ostream& out) {
+    if (!ENABLED) {
+        out << "Instrumentation is off, configure with -DDARTS_INSTRUMENTATION=ON" << std::endl;
+        return;
+    }
+    const Report data = report();
+    for (size_t k = 0; k < COUNTERS; ++k) {
+        out << name(static_cast<Counter>(k)) << ": " << data.counters[k] << std::endl;
+    }
+    for (size_t k = 0; k < TIMERS; ++k) {
+        out << name(static_cast<Timer>(k)) << ": " << data.seconds[k] << " s in " << data.timer_calls[k] << " calls" << std::endl;
+    }
+    out << "round_dp_cache_entries: " << data.round_dp_cache_entries << std::endl;
+
+    uint64_t states = 0;
+    uint64_t total = 0;
+    uint64_t most = 0;
+    for (uint64_t evaluations : data.aim_evaluations_by_state) {
+        if (evaluations == 0) continue;
+        ++states;
+        total += evaluations;
+        most = std::max(most, evaluations);
+    }
+    if (states > 0) {
+        out << "aim_evaluations_per_state: " << static_cast<double>(total) / static_cast<double>(states)
+            << " mean, " << most << " max over " << states << " states" << std::endl;
+    }
+    if (!data.round_convergence.empty()) {
+        unsigned int iterations = 0;
+        double delta = 0.0;
+        for (const auto& round : data.round_convergence) {
+            iterations = std::max(iterations, round.iterations);
+            delta = std::max(delta, round.delta);
+        }
+        out << "round_convergence: " << data.round_convergence.size() << " states, at most " << iterations
+            << " iterations, largest final delta " << delta << std::endl;
+    }
+}
@@ -0,0 +1,147 @@
+#ifndef INSTRUMENTATION_HEADER
+#define INSTRUMENTATION_HEADER
+
+#include "Game.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+/**
+ * Set to 1 by the DARTS_INSTRUMENTATION CMake option. Without it every hook below is
+ * an empty inline function, so the hot loops compile exactly as without instrumentation.
+ */
+#ifndef DARTS_INSTRUMENTATION
+#define DARTS_INSTRUMENTATION 0
+#endif
+
+/**
+ * @brief Process-wide profiling counters and timers of the solver hot paths.
+ * @ingroup solver
+ *
+ * Counts bed integrations, outcome row lookups, aim evaluations (also per solved
+ * state), SolverMinRounds Newton iterations with their final convergence delta, the
+ * size of the round DP cache and heat map cells. Timers measure row compilation,
+ * solves and heat maps; nested scopes of the same timer, such as recursive solves,
+ * are only timed at the outermost one.
+ *
+ * Collection is compiled in only with the DARTS_INSTRUMENTATION CMake option. Without
+ * it ENABLED is false, the hooks do nothing and report() is all zeros. Counters are
+ * relaxed atomics, so threads of solve_all() may count concurrently.
+ *
+ * Example usage:
+ * @code
+ * Instrumentation::reset();
+ * solver.solve_all(501);
+ * Instrumentation::print(std::cerr);
+ * @endcode
+ */
+class Instrumentation {
+public:
+    static constexpr bool ENABLED = DARTS_INSTRUMENTATION != 0;
+
+    enum class Counter : size_t {
+        INTEGRATIONS,       ///< Distribution::integrate_probability() calls for outcome rows
+        OUTCOME_ROW_HITS,   ///< Game::outcomes() calls served from a compiled row
+        OUTCOME_ROW_MISSES, ///< Game::outcomes() calls that compiled the row
+        AIM_EVALUATIONS,    ///< Aims evaluated by solver searches
+        PRUNED_AIMS,        ///< Evaluations SolverMinThrows stopped early by branch and bound
+        ROUND_ITERATIONS,   ///< Newton iterations of SolverMinRounds round start states
+        HEAT_MAP_CELLS,     ///< Heat map cells evaluated
+        COUNT               ///< Number of counters
+    };
+
+    enum class Timer : size_t {
+        COMPILE_ROWS,       ///< Game::outcomes() compiling rows
+        SOLVE_MIN_THROWS,   ///< SolverMinThrows::solve() and solve_all()
+        SOLVE_MIN_ROUNDS,   ///< SolverMinRounds::solve() and solve_round_state()
+        HEAT_MAPS,          ///< ProgressiveHeatMap::step(), which also serves HeatMapVisualizer::heat_map()
+        COUNT               ///< Number of timers
+    };
+
+    static constexpr size_t COUNTERS = static_cast<size_t>(Counter::COUNT);
+    static constexpr size_t TIMERS = static_cast<size_t>(Timer::COUNT);
+
+    /** @brief Newton iterations of one solved round start state. */
+    struct RoundConvergence {
+        Game::State state;
+        unsigned int iterations;
+        double delta;       ///< Relative change of X in the last iteration
+    };
+
+    struct Report {
+        std::array<uint64_t, COUNTERS> counters{};
+        std::array<double, TIMERS> seconds{};
+        std::array<uint64_t, TIMERS> timer_calls{};     ///< Outermost scopes timed
+        std::vector<uint64_t> aim_evaluations_by_state; ///< [state], of SolverMinThrows and round start states
+        std::vector<RoundConvergence> round_convergence; ///< In order of solving
+        uint64_t round_dp_cache_entries = 0;             ///< Largest SolverMinRounds round DP cache seen
+    };
+
+private:
+    static std::array<std::atomic<uint64_t>, COUNTERS> counters_;
+    static std::array<std::atomic<uint64_t>, TIMERS> nanoseconds_;
+    static std::array<std::atomic<uint64_t>, TIMERS> timer_calls_;
+    static std::atomic<uint64_t> round_dp_cache_entries_;
+
+    static void record_state_evaluations_(Game::State s, uint64_t evaluations);
+    static void record_round_convergence_(RoundConvergence convergence);
+
+public:
+    static void count(Counter counter, uint64_t n = 1) {
+        if constexpr (ENABLED) counters_[static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /** @brief Aims evaluated to solve state s, counted once per solved state. */
+    static void record_state_evaluations(Game::State s, uint64_t evaluations) {
+        if constexpr (ENABLED) record_state_evaluations_(s, evaluations);
+    }
+
+    static void record_round_convergence(Game::State s, unsigned int iterations, double delta) {
+        if constexpr (ENABLED) record_round_convergence_(RoundConvergence{s, iterations, delta});
+    }
+
+    static void record_round_dp_cache_size(size_t entries) {
+        if constexpr (ENABLED) {
+            uint64_t seen = round_dp_cache_entries_.load(std::memory_order_relaxed);
+            while (entries > seen && !round_dp_cache_entries_.compare_exchange_weak(seen, entries, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    /** @brief Times its scope into timer, unless the calling thread is already inside a scope of it. */
+    class ScopedTimer {
+#if DARTS_INSTRUMENTATION
+    private:
+        Timer timer_;
+        bool outermost_;
+        std::chrono::steady_clock::time_point start_;
+
+    public:
+        explicit ScopedTimer(Timer timer);
+        ~ScopedTimer();
+#else
+    public:
+        explicit ScopedTimer(Timer) {}
+#endif
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+
+    [[nodiscard]] static std::string_view name(Counter counter);
+    [[nodiscard]] static std::string_view name(Timer timer);
+
+    /** @brief Everything collected since the last reset(). */
+    [[nodiscard]] static Report report();
+    static void reset();
+
+    /** @brief Counters, timers and summaries of the per-state data, one per line. */
+    static void print(std::ostream& out);
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef LRU_CACHE_HEADER
+#define LRU_CACHE_HEADER
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief Memory use of one cache, as reported by the classes that own one.
+ * @ingroup solver
+ */
+struct CacheUsage {
+    size_t bytes = 0;     ///< Payload and bookkeeping of the entries held
+    size_t budget = 0;    ///< Bytes the cache may hold, 0 for no limit
+    size_t entries = 0;
+    size_t evictions = 0; ///< Entries dropped to stay within the budget since construction
+};
+
+/**
+ * @brief Map with a byte budget that evicts the least recently used entries.
+ * @ingroup solver
+ *
+ * Every entry is charged the bytes given on insert, the heap memory its value owns,
+ * plus ENTRY_OVERHEAD for the key, the value itself and the list and hash nodes.
+ * Lookups with find() move an entry to the front. An insert that would exceed the
+ * budget first evicts from the back, and an entry larger than the whole budget is
+ * not kept at all. A budget of 0 means no limit.
+ *
+ * Example usage:
+ * @code
+ * LruCache<Game::State, std::vector<float>> memo(64 << 20); // 64 MiB
+ * memo.insert(s, plane, plane.size() * sizeof(float));
+ * if (const auto* hit = memo.find(s)) use(*hit);
+ * @endcode
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t bytes;
+    };
+    using List = std::list<Entry>;
+
+public:
+    static constexpr size_t ENTRY_OVERHEAD = sizeof(Entry) + 6 * sizeof(void*); ///< List node, hash node and bucket
+
+private:
+    List entries_; ///< Most recently used first
+    std::unordered_map<Key, typename List::iterator, Hash> index_;
+    size_t budget_ = 0;
+    size_t bytes_ = 0;
+    size_t evictions_ = 0;
+
+    template <typename OnEvict>
+    void evict_back_(OnEvict&& on_evict) {
+        Entry& victim = entries_.back();
+        bytes_ -= victim.bytes;
+        index_.erase(victim.key);
+        ++evictions_;
+        on_evict(victim.key, victim.value);
+        entries_.pop_back();
+    }
+
+public:
+    explicit LruCache(size_t budget = 0) : budget_(budget) {}
+
+    /** @brief Value of key, marked as most recently used; null if absent. */
+    [[nodiscard]] Value* find(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) return nullptr;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &it->second->value;
+    }
+
+    [[nodiscard]] bool contains(const Key& key) const { return index_.contains(key); }
+
+    /**
+     * @brief Insert or replace key, evicting least recently used entries to stay within the budget.
+     * @param bytes Heap memory owned by value, the cache adds ENTRY_OVERHEAD
+     * @param on_evict Called with the key and value of every evicted entry, before it is destroyed
+     */
+    template <typename OnEvict>
+    void insert(const Key& key, Value value, size_t bytes, OnEvict&& on_evict) {
+        insert(key, std::move(value), bytes, on_evict, [](const Key&, const Value&) { return true; });
+    }
+
+    /**
+     * @brief insert() that only evicts while can_evict accepts the least recently used entry.
+     * Eviction stops at the first entry it rejects, and the cache then holds more than its
+     * budget until a later insert or trim() brings it back.
+     */
+    template <typename OnEvict, typename CanEvict>
+    void insert(const Key& key, Value value, size_t bytes, OnEvict&& on_evict, CanEvict&& can_evict) {
+        erase(key);
+        const size_t charged = bytes + ENTRY_OVERHEAD;
+        if (budget_ != 0 && charged > budget_) return;
+        while (budget_ != 0 && !entries_.empty() && bytes_ + charged > budget_
+               && can_evict(entries_.back().key, entries_.back().value)) {
+            evict_back_(on_evict);
+        }
+        entries_.push_front(Entry{key, std::move(value), charged});
+        index_[key] = entries_.begin();
+        bytes_ += charged;
+    }
+
+    void insert(const Key& key, Value value, size_t bytes) {
+        insert(key, std::move(value), bytes, [](const Key&, const Value&) {});
+    }
+
+    void erase(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) return;
+        bytes_ -= it->second->bytes;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    /** @brief Evict least recently used entries until at most max_bytes are held. Returns the bytes freed. */
+    template <typename OnEvict>
+    size_t trim(size_t max_bytes, OnEvict&& on_evict) {
+        const size_t before = bytes_;
+        while (!entries_.empty() && bytes_ > max_bytes) evict_back_(on_evict);
+        return before - bytes_;
+    }
+
+    size_t trim(size_t max_bytes) {
+        return trim(max_bytes, [](const Key&, const Value&) {});
+    }
+
+    /** @brief Change the budget, trimming to it right away. */
+    void set_budget(size_t budget) {
+        budget_ = budget;
+        if (budget_ != 0) trim(budget_);
+    }
+
+    void clear() {
+        entries_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+
+    [[nodiscard]] size_t size() const { return entries_.size(); }
+    [[nodiscard]] bool empty() const { return entries_.empty(); }
+    [[nodiscard]] size_t get_bytes() const { return bytes_; }
+    [[nodiscard]] size_t get_budget() const { return budget_; }
+    [[nodiscard]] CacheUsage usage() const { return CacheUsage{bytes_, budget_, entries_.size(), evictions_}; }
+
+    /** @brief Entries from most to least recently used, without touching their order. */
+    template <typename Visit>
+    void for_each(Visit&& visit) const {
+        for (const Entry& entry : entries_) visit(entry.key, entry.value);
+    }
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include "MatchSimulator.h"
+#include "Solver.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+LegPolicy::LegPolicy(Game::State max_state, unsigned int throws_per_round, size_t round_span)
+    : max_state_(max_state), throws_per_round_(throws_per_round), round_span_(round_span),
+      aims_(throws_per_round == 0 ? static_cast<size_t>(max_state) + 1
+                                  : (static_cast<size_t>(max_state) + 1) * round_span * throws_per_round,
+            Vec2{0.0, 0.0}),
+      winable_(static_cast<size_t>(max_state) + 1, false) {
+    winable_[0] = true;
+}
+
+LegPolicy LegPolicy::from_solver(SolverMinThrows& solver, Game::State max_state) {
+    solver.solve_all(max_state);
+    LegPolicy policy(max_state, 0, 1);
+    for (Game::State s = 1; s <= max_state; ++s) {
+        policy.aims_[s] = solver.solve(s).second;
+        policy.winable_[s] = solver.is_winable(s);
+    }
+    return policy;
+}
+
+LegPolicy LegPolicy::from_solver(SolverMinRounds& solver, Game::State max_state) {
+    const unsigned int throws = solver.get_throws_per_round();
+    Game::StateDifference max_points = 0;
+    for (const auto& bed : solver.get_game().get_target().get_beds()) {
+        max_points = std::max<Game::StateDifference>(max_points, -bed.after_hit().diff);
+    }
+    const size_t span = static_cast<size_t>(throws - 1) * static_cast<size_t>(max_points) + 1;
+
+    LegPolicy policy(max_state, throws, span);
+    for (Game::State s = 1; s <= max_state; ++s) {
+        (void)solver.solve(s);
+        policy.winable_[s] = solver.is_winable(s);
+    }
+    for (Game::State s = 1; s <= max_state; ++s) {
+        if (!policy.winable_[s]) continue; // Legs only get here as their start score
+        const size_t base = static_cast<size_t>(s) * span;
+        policy.aims_[base * throws] = solver.solve(s).second;
+        // Later throws are only ever taken from the start score (after misses) or from a winable score
+        for (size_t offset = 0; offset < span && offset < s; ++offset) {
+            const Game::State current = s - static_cast<Game::State>(offset);
+            if (offset != 0 && !policy.winable_[current]) continue;
+            for (unsigned int t = 2; t <= throws; ++t) {
+                policy.aims_[(base + offset) * throws + t - 1] = solver.solve_round_state(s, current, t).second;
+            }
+        }
+    }
+    return policy;
+}
+
+MatchSimulator::MatchSimulator(const Game& game, LegPolicy policy, uint64_t seed)
+    : game_(game), policy_(std::move(policy)), seed_(seed) {}
+
+void MatchSimulator::simulate_batch_(Game::State start, size_t legs, unsigned int max_darts,
+                                     RandomEngine& rng, Tally& tally) const {
+    const Target& target = game_.get_target();
+    const Distribution& distribution = game_.get_distribution();
+    const unsigned int throws = policy_.get_throws_per_round();
+
+    // Lane state of the unfinished legs, compacted after every dart
+    std::vector<Game::State> round_start(legs, start);
+    std::vector<Game::State> current(legs, start);
+    std::vector<unsigned int> throw_number(legs, 1);
+    std::vector<unsigned int> darts(legs, 0);
+    std::vector<unsigned int> rounds(legs, 1);
+    std::vector<Vec2> offsets(legs);
+
+    auto record = [](std::vector<uint64_t>& histogram, size_t count) {
+        if (histogram.size() <= count) histogram.resize(count + 1, 0);
+        ++histogram[count];
+    };
+
+    size_t active = legs;
+    while (active > 0) {
+        distribution.sample(rng, std::span(offsets.data(), active));
+        tally.darts_thrown += active;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < active; ++i) {
+            const Game::State from = current[i];
+            const Vec2 aim = policy_.aim(round_start[i], from, throw_number[i]);
+            const HitData hit = target.after_hit(aim + offsets[i]);
+            const Game::State next = game_.handle_throw(from, hit);
+            const unsigned int thrown = darts[i] + 1;
+
+            if (next == 0) {
+                record(tally.darts, thrown);
+                record(tally.rounds, throws == 0 ? (thrown + DEFAULT_THROWS_PER_ROUND - 1) / DEFAULT_THROWS_PER_ROUND
+                                                 : rounds[i]);
+                continue;
+            }
+            if (thrown >= max_darts) {
+                ++tally.unfinished;
+                continue;
+            }
+
+            // A miss is not a bust, an unchanged score after a hit always is
+            const bool bust = hit.diff != 0 && (next == from || !policy_.is_winable(next));
+            Game::State start_of_round = round_start[i];
+            Game::State score = bust ? from : next;
+            unsigned int next_throw = throw_number[i] + 1;
+            unsigned int round = rounds[i];
+            if (throws != 0) {
+                if (bust) score = start_of_round;
+                if (bust || next_throw > throws) {
+                    start_of_round = score;
+                    next_throw = 1;
+                    ++round;
+                }
+            }
+
+            round_start[kept] = start_of_round;
+            current[kept] = score;
+            throw_number[kept] = next_throw;
+            darts[kept] = thrown;
+            rounds[kept] = round;
+            ++kept;
+        }
+        active = kept;
+    }
+}
+
+MatchSimulator::Summary MatchSimulator::summarise_(std::vector<uint64_t> histogram) {
+    Summary summary;
+    double n = 0.0;
+    double sum = 0.0;
+    for (size_t k = 0; k < histogram.size(); ++k) {
+        n += static_cast<double>(histogram[k]);
+        sum += static_cast<double>(histogram[k]) * static_cast<double>(k);
+    }
+    if (n > 0) {
+        summary.mean = sum / n;
+        double squares = 0.0;
+        for (size_t k = 0; k < histogram.size(); ++k) {
+            const double d = static_cast<double>(k) - summary.mean;
+            squares += static_cast<double>(histogram[k]) * d * d;
+        }
+        summary.std_dev = n > 1 ? std::sqrt(squares / (n - 1)) : 0.0;
+        const double half_width = CONFIDENCE_Z * summary.std_dev / std::sqrt(n);
+        summary.ci_low = summary.mean - half_width;
+        summary.ci_high = summary.mean + half_width;
+    }
+    summary.histogram = std::move(histogram);
+    return summary;
+}
+
+MatchSimulator::Result MatchSimulator::simulate(Game::State start, size_t legs, size_t num_threads,
+                                                unsigned int max_darts) const {
+    if (start == 0 || start > policy_.get_max_state()) {
+        throw std::out_of_range("Start score " + std::to_string(start) + " is outside the policy's states 1 .. "
+                                + std::to_string(policy_.get_max_state()));
+    }
+
+    const size_t num_batches = (legs + BATCH_LEGS - 1) / BATCH_LEGS;
+    ThreadPool pool(num_threads);
+    std::vector<Tally> tallies(pool.size());
+    std::atomic<size_t> next_batch{0};
+    pool.run([&](size_t thread) {
+        for (size_t b = next_batch.fetch_add(1); b < num_batches; b = next_batch.fetch_add(1)) {
+            RandomEngine rng(seed_, b);
+            simulate_batch_(start, std::min(BATCH_LEGS, legs - b * BATCH_LEGS), max_darts, rng, tallies[thread]);
+        }
+    });
+
+    Tally total;
+    for (const Tally& tally : tallies) {
+        for (auto [into, from] : {std::pair{&total.darts, &tally.darts}, std::pair{&total.rounds, &tally.rounds}}) {
+            if (into->size() < from->size()) into->resize(from->size(), 0);
+            for (size_t k = 0; k < from->size(); ++k) (*into)[k] += (*from)[k];
+        }
+        total.unfinished += tally.unfinished;
+        total.darts_thrown += tally.darts_thrown;
+    }
+
+    Result result;
+    result.legs = legs;
+    result.unfinished = total.unfinished;
+    result.darts_thrown = total.darts_thrown;
+    result.darts = summarise_(std::move(total.darts));
+    result.rounds = summarise_(std::move(total.rounds));
+    return result;
+}
@@ -0,0 +1,144 @@
+#ifndef MATCH_SIMULATOR_HEADER
+#define MATCH_SIMULATOR_HEADER
+
+#include "Game.h"
+#include "Geometry.h"
+#include "Random.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SolverMinThrows;
+class SolverMinRounds;
+
+/**
+ * @brief Aim of every state of a solved strategy, in a flat table the simulator can index.
+ * @ingroup solver
+ *
+ * A policy from SolverMinThrows has one aim per score. A policy from SolverMinRounds has
+ * one aim per round state (round start score, current score, throw number), for every
+ * current score a round from the start score can reach: at most
+ * (throws_per_round - 1) * the highest bed score below it. States the solver could not
+ * finish are marked, and the simulator treats reaching one as a bust, like the solvers do.
+ */
+class LegPolicy {
+private:
+    Game::State max_state_ = 0;
+    unsigned int throws_per_round_ = 0; ///< 0 for a per-dart policy
+    size_t round_span_ = 1;             ///< Current scores a round can reach, counting the start score
+    std::vector<Vec2> aims_;            ///< [state], or [(start * round_span_ + start - current) * throws_per_round_ + throw - 1]
+    std::vector<bool> winable_;         ///< [state]
+
+    LegPolicy(Game::State max_state, unsigned int throws_per_round, size_t round_span);
+
+public:
+    /**
+     * @brief Best aims of states 1 .. max_state, solved with solve_all() first.
+     */
+    [[nodiscard]] static LegPolicy from_solver(SolverMinThrows& solver, Game::State max_state);
+
+    /**
+     * @brief Best aims of every round state with a start score of at most max_state.
+     * Extraction solves each reachable in-round state once, which is the bulk of the cost.
+     */
+    [[nodiscard]] static LegPolicy from_solver(SolverMinRounds& solver, Game::State max_state);
+
+    [[nodiscard]] Game::State get_max_state() const { return max_state_; }
+    /** @brief Throws per round of a round policy, 0 when the aim only depends on the current score. */
+    [[nodiscard]] unsigned int get_throws_per_round() const { return throws_per_round_; }
+    [[nodiscard]] bool is_winable(Game::State s) const { return s == 0 || (s <= max_state_ && winable_[s]); }
+
+    /** @brief Aim for the throw_number-th dart (1-based) of a round that started at round_start. */
+    [[nodiscard]] Vec2 aim(Game::State round_start, Game::State current, unsigned int throw_number) const {
+        if (throws_per_round_ == 0) return aims_[current];
+        return aims_[(static_cast<size_t>(round_start) * round_span_ + (round_start - current)) * throws_per_round_ + throw_number - 1];
+    }
+};
+
+/**
+ * @brief Monte Carlo legs played with a LegPolicy, for validating solved strategies.
+ * @ingroup solver
+ *
+ * Every dart is drawn from the game's distribution around the policy's aim and
+ * classified with Target::after_hit(); the game's rules give the next score.
+ * - With a per-dart policy a bust only wastes the dart, as SolverMinThrows assumes.
+ *   Rounds are counted as groups of DEFAULT_THROWS_PER_ROUND darts.
+ * - With a round policy a bust ends the round and resets the score to the round
+ *   start, as SolverMinRounds assumes.
+ *
+ * Legs are simulated in batches of BATCH_LEGS. The state of a batch lives in
+ * separate arrays (start score, score, throw and dart counters), and every step
+ * samples one dart for all unfinished legs with a single batched call to the
+ * distribution. Finished legs are compacted away. Batches are spread over a thread
+ * pool; batch b draws from stream b of the seed, and the histograms are integer
+ * sums, so results do not depend on the number of threads.
+ *
+ * Example usage:
+ * @code
+ * solver.solve_all(501);
+ * MatchSimulator simulator(game, LegPolicy::from_solver(solver, 501));
+ * auto result = simulator.simulate(501, 1000000);
+ * std::cout << result.darts.mean << " +- " << result.darts.ci_high - result.darts.mean << std::endl;
+ * @endcode
+ */
+class MatchSimulator {
+public:
+    static constexpr size_t BATCH_LEGS = 256;                 ///< Legs simulated together on one stream
+    static constexpr unsigned int DEFAULT_THROWS_PER_ROUND = 3;
+    static constexpr double CONFIDENCE_Z = 1.959963984540054; ///< Two-sided 95 % quantile of the normal distribution
+
+    /** @brief Distribution of a count over the finished legs. */
+    struct Summary {
+        double mean = 0.0;
+        double std_dev = 0.0;
+        double ci_low = 0.0;                ///< 95 % confidence interval of the mean
+        double ci_high = 0.0;
+        std::vector<uint64_t> histogram;    ///< Finished legs by count
+    };
+
+    struct Result {
+        uint64_t legs = 0;
+        uint64_t unfinished = 0;  ///< Legs stopped at max_darts, not part of the summaries
+        uint64_t darts_thrown = 0;
+        Summary darts;
+        Summary rounds;
+    };
+
+private:
+    const Game& game_;
+    LegPolicy policy_;
+    uint64_t seed_;
+
+    /** @brief Histograms of one thread, merged after all batches are done. */
+    struct Tally {
+        std::vector<uint64_t> darts;
+        std::vector<uint64_t> rounds;
+        uint64_t unfinished = 0;
+        uint64_t darts_thrown = 0;
+    };
+
+    void simulate_batch_(Game::State start, size_t legs, unsigned int max_darts, RandomEngine& rng, Tally& tally) const;
+    [[nodiscard]] static Summary summarise_(std::vector<uint64_t> histogram);
+
+public:
+    /**
+     * @param game Game whose target, distribution and rules the legs are played with; must outlive the simulator
+     * @param policy Strategy to play, for the same target and rules
+     * @param seed Seed of the batch streams
+     */
+    MatchSimulator(const Game& game, LegPolicy policy, uint64_t seed = SEED);
+
+    /**
+     * @brief Play legs from start and summarise how many darts and rounds they took.
+     * @param start Score every leg starts from
+     * @param legs Number of legs
+     * @param num_threads Number of threads, 0 for std::thread::hardware_concurrency()
+     * @param max_darts Darts after which a leg counts as unfinished
+     * @throws std::out_of_range if start exceeds the policy's max_state
+     */
+    [[nodiscard]] Result simulate(Game::State start, size_t legs, size_t num_threads = 0,
+                                  unsigned int max_darts = 1000) const;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef PRECISION_HEADER
+#define PRECISION_HEADER
+
+/**
+ * @brief Floating point width of hit probability computation and storage.
+ * @ingroup distributions
+ *
+ * Hit probabilities only need to rank aims, which takes about 1e-6 relative accuracy.
+ * With FLOAT, NormalDistributionQuadrature runs its integration kernels in float, twice
+ * the SIMD lanes of double, and HitProbabilityField stores its table as float, half the
+ * memory. Sums of kernel terms, the outcome rows of a Game and all solver arithmetic stay
+ * in double, so the rounding is introduced once per probability and does not accumulate
+ * through the dynamic programming.
+ *
+ * `darts_solver --validate-precision` reports how far the optimal aims and expected throws
+ * of FLOAT move from DOUBLE on the standard board.
+ */
+enum class Precision {
+    DOUBLE, ///< Default, every result as before
+    FLOAT,  ///< Probabilities rounded to float, relative error around 1e-7
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef QUADRATURE_RULE_HEADER
+#define QUADRATURE_RULE_HEADER
+
+#include <array>
+#include <cstddef>
+
+/**
+ * @brief Symmetric quadrature rule on the unit reference triangle (0,0)-(1,0)-(0,1).
+ * @ingroup distributions
+ *
+ * Point q is (r[q], s[q]) in reference coordinates. Weights sum to 1.0, so they
+ * are multiplied by the area of the physical triangle. The rules are constexpr,
+ * so NormalDistributionQuadrature instantiates its polygon integration once per
+ * rule with the point count known at compile time.
+ *
+ * Reference: Dunavant, "High Degree Efficient Symmetrical Gaussian Quadrature
+ * Rules for the Triangle", IJNME Vol 21, 1985, pp. 1129-1148.
+ */
+template <size_t N>
+struct TriangleRule {
+    static constexpr size_t POINTS = N;
+    int degree; ///< Highest polynomial degree integrated exactly
+    std::array<double, N> r;
+    std::array<double, N> s;
+    std::array<double, N> w;
+};
+
+/** @brief Dunavant rule 5: 7 points, degree 5. */
+inline constexpr TriangleRule<7> DUNAVANT_7 = {
+    5,
+    {
+        0.333333333333333,
+        0.470142064105115, 0.059715871789770, 0.470142064105115,
+        0.101286507323456, 0.797426985353087, 0.101286507323456,
+    },
+    {
+        0.333333333333333,
+        0.470142064105115, 0.470142064105115, 0.059715871789770,
+        0.101286507323456, 0.101286507323456, 0.797426985353087,
+    },
+    {
+        0.225000000000000,
+        0.132394152788506, 0.132394152788506, 0.132394152788506,
+        0.125939180544827, 0.125939180544827, 0.125939180544827,
+    },
+};
+
+/** @brief Dunavant rule 6: 12 points, degree 6. */
+inline constexpr TriangleRule<12> DUNAVANT_12 = {
+    6,
+    {
+        0.249286745170910, 0.501426509658179, 0.249286745170910,
+        0.063089014491502, 0.873821971016996, 0.063089014491502,
+        0.053145049844817, 0.310352451033784, 0.053145049844817,
+        0.636502499121399, 0.310352451033784, 0.636502499121399,
+    },
+    {
+        0.249286745170910, 0.249286745170910, 0.501426509658179,
+        0.063089014491502, 0.063089014491502, 0.873821971016996,
+        0.310352451033784, 0.053145049844817, 0.636502499121399,
+        0.053145049844817, 0.636502499121399, 0.310352451033784,
+    },
+    {
+        0.116786275726379, 0.116786275726379, 0.116786275726379,
+        0.050844906370207, 0.050844906370207, 0.050844906370207,
+        0.082851075618374, 0.082851075618374, 0.082851075618374,
+        0.082851075618374, 0.082851075618374, 0.082851075618374,
+    },
+};
+
+/** @brief Dunavant rule 10: 25 points, degree 10. Expanded from compressed barycentric suborders. */
+inline constexpr TriangleRule<25> DUNAVANT_25 = {
+    10,
+    {
+        0.333333333333333, 0.028844733232685, 0.485577633383657,
+        0.485577633383657, 0.109481575485037, 0.109481575485037,
+        0.781036849029926, 0.141707219414880, 0.141707219414880,
+        0.307939838764121, 0.307939838764121, 0.550352941820999,
+        0.550352941820999, 0.025003534476269, 0.025003534476269,
+        0.246672560639903, 0.246672560639903, 0.728323904597411,
+        0.728323904597411, 0.009540815400299, 0.009540815400299,
+        0.066803251012200, 0.066803251012200, 0.923655933587500,
+        0.923655933587500,
+    },
+    {
+        0.333333333333333, 0.485577633383657, 0.028844733232685,
+        0.485577633383657, 0.109481575485037, 0.781036849029926,
+        0.109481575485037, 0.307939838764121, 0.550352941820999,
+        0.141707219414880, 0.550352941820999, 0.141707219414880,
+        0.307939838764121, 0.246672560639903, 0.728323904597411,
+        0.025003534476269, 0.728323904597411, 0.025003534476269,
+        0.246672560639903, 0.066803251012200, 0.923655933587500,
+        0.009540815400299, 0.923655933587500, 0.009540815400299,
+        0.066803251012200,
+    },
+    {
+        0.090817990382754, 0.036725957756467, 0.036725957756467,
+        0.036725957756467, 0.045321059435528, 0.045321059435528,
+        0.045321059435528, 0.072757916845420, 0.072757916845420,
+        0.072757916845420, 0.072757916845420, 0.072757916845420,
+        0.072757916845420, 0.028327242531057, 0.028327242531057,
+        0.028327242531057, 0.028327242531057, 0.028327242531057,
+        0.028327242531057, 0.009421666963733, 0.009421666963733,
+        0.009421666963733, 0.009421666963733, 0.009421666963733,
+        0.009421666963733,
+    },
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include "Random.h"
+
+#include <atomic>
+#include <cmath>
+#include <numbers>
+
+void Xoshiro256::jump() {
+    static constexpr std::array<uint64_t, 4> JUMP = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    std::array<uint64_t, 4> jumped = {0, 0, 0, 0};
+    for (uint64_t word : JUMP) {
+        for (int b = 0; b < 64; ++b) {
+            if (word & (uint64_t{1} << b)) {
+                for (size_t k = 0; k < 4; ++k) jumped[k] ^= s_[k];
+            }
+            operator()();
+        }
+    }
+    s_ = jumped;
+}
+
+RandomEngine& thread_random_engine() {
+    static std::atomic<uint64_t> next_stream{0};
+    thread_local RandomEngine engine(SEED, next_stream.fetch_add(1, std::memory_order_relaxed));
+    return engine;
+}
+
+void normal_samples(RandomEngine& rng, std::span<double> out) {
+    const size_t n = out.size();
+    const size_t pairs = n / 2;
+    for (size_t i = 0; i < 2 * pairs; ++i) {
+        out[i] = rng.uniform();
+    }
+
+    for (size_t k = 0; k < pairs; ++k) {
+        double r = std::sqrt(-2.0 * std::log(out[2 * k]));
+        double theta = 2.0 * std::numbers::pi * out[2 * k + 1];
+        out[2 * k] = r * std::cos(theta);
+        out[2 * k + 1] = r * std::sin(theta);
+    }
+
+    if (n % 2 == 1) {
+        double r = std::sqrt(-2.0 * std::log(rng.uniform()));
+        out[n - 1] = r * std::cos(2.0 * std::numbers::pi * rng.uniform());
+    }
+}
@@ -1,8 +1,113 @@
 #ifndef SEED_HEADER
 #define SEED_HEADER
 
-#include <random>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+
 constexpr unsigned int SEED = 123456789;
-inline std::mt19937 random_engine(SEED);
 
-#endif
\ No newline at end of file
+/**
+ * @brief SplitMix64, used to expand a single 64 bit seed into generator state.
+ * @ingroup distributions
+ */
+class SplitMix64 {
+private:
+    uint64_t state_;
+
+public:
+    explicit SplitMix64(uint64_t seed) : state_(seed) {}
+
+    /** @brief The SplitMix64 finaliser, a bijective 64 bit mix. */
+    [[nodiscard]] static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t operator()() {
+        state_ += 0x9e3779b97f4a7c15ULL;
+        return mix(state_);
+    }
+};
+
+/**
+ * @brief xoshiro256++ generator with independent, seekable streams.
+ * @ingroup distributions
+ *
+ * Satisfies UniformRandomBitGenerator, so it works with the <random>
+ * distributions as well as with normal_samples(). A generator is identified by
+ * (seed, stream): the pair is mixed and expanded with SplitMix64, so every
+ * stream of a seed is reproducible on its own, regardless of what other
+ * streams or threads draw. Nothing is shared between instances.
+ *
+ * Example usage:
+ * @code
+ * RandomEngine rng(SEED, thread_index); // One stream per worker
+ * Vec2 p = dist.sample(rng);
+ * @endcode
+ */
+class Xoshiro256 {
+private:
+    std::array<uint64_t, 4> s_;
+
+    [[nodiscard]] static uint64_t rotl_(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    using result_type = uint64_t;
+
+    /**
+     * @brief Seed stream number stream of seed.
+     */
+    explicit Xoshiro256(uint64_t seed = SEED, uint64_t stream = 0) {
+        SplitMix64 expand(seed ^ SplitMix64::mix(stream + 1));
+        for (auto& word : s_) word = expand();
+    }
+
+    [[nodiscard]] static constexpr result_type min() { return 0; }
+    [[nodiscard]] static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        const uint64_t result = rotl_(s_[0] + s_[3], 23) + s_[0];
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl_(s_[3], 45);
+        return result;
+    }
+
+    /** @brief Uniform double in (0, 1], never 0 so it is safe to take the logarithm. */
+    double uniform() { return static_cast<double>((operator()() >> 11) + 1) * 0x1.0p-53; }
+
+    /** @brief Advance by 2^128 draws, which splits one stream into non-overlapping substreams. */
+    void jump();
+
+    [[nodiscard]] bool operator==(const Xoshiro256& other) const = default;
+};
+
+/** @brief Generator type the library passes into sampling calls. */
+using RandomEngine = Xoshiro256;
+
+/**
+ * @brief Generator owned by the calling thread.
+ *
+ * Seeded with SEED and a stream number handed out in order of first use, so the
+ * first thread that samples (normally the main thread) always gets stream 0.
+ * Used by the convenience overloads that take no generator.
+ */
+[[nodiscard]] RandomEngine& thread_random_engine();
+
+/**
+ * @brief Fill out with independent standard normal samples using Box-Muller.
+ *
+ * Uniforms are drawn for the whole array first, then transformed in place in
+ * a second loop without dependencies between pairs, which the compiler can
+ * vectorise. An odd last element discards the second value of its pair.
+ */
+void normal_samples(RandomEngine& rng, std::span<double> out);
+
+#endif
@@ -0,0 +1,171 @@
+#include "ResultStream.h"
+
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+static_assert(std::numeric_limits<float>::is_iec559 && std::numeric_limits<double>::is_iec559,
+              "Result streams store IEEE 754 floats");
+
+namespace {
+    constexpr char NPY_MAGIC[] = "\x93NUMPY";
+    constexpr size_t NPY_PREAMBLE = 10;  // Magic, version and header length
+    constexpr size_t NPY_ALIGNMENT = 64; // Records start at a multiple of this
+
+    constexpr char ENDIAN = std::endian::native == std::endian::little ? '<' : '>';
+
+    template <typename T>
+    std::byte* put(std::byte* out, T value) {
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+}
+
+std::string ResultStream::dtype_descr(size_t rows, size_t cols) {
+    const std::string e(1, ENDIAN);
+    std::string descr = "[('state', '" + e + "u4'), ('score', '" + e + "f8'), ('aim', '" + e + "f8', (2,)), "
+                        "('extent', '" + e + "f8', (4,))";
+    if (rows != 0) {
+        descr += ", ('heat_map', '" + e + "f4', (" + std::to_string(rows) + ", " + std::to_string(cols) + "))";
+    }
+    return descr + "]";
+}
+
+size_t ResultStream::record_size(size_t rows, size_t cols) {
+    return sizeof(uint32_t) + 7 * sizeof(double) + rows * cols * sizeof(float);
+}
+
+ResultStream::ResultStream(const std::string& path, size_t state_count, size_t rows, size_t cols,
+                           Game::Bounds extent, bool background)
+    : output_(path, std::ios::binary | std::ios::trunc),
+      state_count_(state_count), rows_(rows), cols_(cols), extent_(extent) {
+    if ((rows == 0) != (cols == 0)) {
+        throw std::invalid_argument("ResultStream heat maps need both rows and columns, or neither");
+    }
+    if (!output_) {
+        throw std::runtime_error("Cannot write result stream: " + path);
+    }
+
+    std::string header = "{'descr': " + dtype_descr(rows, cols) + ", 'fortran_order': False, 'shape': ("
+                         + std::to_string(state_count) + ",), }";
+    // Pad with spaces and end with a newline so the records start aligned
+    const size_t unpadded = NPY_PREAMBLE + header.size() + 1;
+    header.append((NPY_ALIGNMENT - unpadded % NPY_ALIGNMENT) % NPY_ALIGNMENT, ' ');
+    header += '\n';
+    if (header.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::invalid_argument("ResultStream header does not fit the .npy 1.0 format");
+    }
+    const uint16_t header_size = static_cast<uint16_t>(header.size());
+    output_.write(NPY_MAGIC, sizeof(NPY_MAGIC) - 1);
+    output_.put(1).put(0);
+    output_.put(static_cast<char>(header_size & 0xFF)).put(static_cast<char>(header_size >> 8));
+    output_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    if (!output_) {
+        throw std::runtime_error("Cannot write result stream: " + path);
+    }
+
+    record_.resize(record_size(rows, cols));
+    if (background) {
+        writer_ = std::jthread([this] { writer_loop_(); });
+    }
+}
+
+ResultStream::~ResultStream() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // Reported by close() when called explicitly
+    }
+}
+
+void ResultStream::write_record_(const Result& result) {
+    std::byte* out = record_.data();
+    out = put(out, static_cast<uint32_t>(result.state));
+    out = put(out, result.score);
+    out = put(out, result.aim.x);
+    out = put(out, result.aim.y);
+    out = put(out, extent_.min.x);
+    out = put(out, extent_.min.y);
+    out = put(out, extent_.max.x);
+    out = put(out, extent_.max.y);
+    for (double cell : result.heat_map.values()) {
+        out = put(out, static_cast<float>(cell));
+    }
+    output_.write(reinterpret_cast<const char*>(record_.data()), static_cast<std::streamsize>(record_.size()));
+    if (!output_) {
+        throw std::runtime_error("Cannot write result stream record of state " + std::to_string(result.state));
+    }
+}
+
+void ResultStream::writer_loop_() {
+    while (true) {
+        Result result;
+        {
+            std::unique_lock lock(mutex_);
+            changed_.wait(lock, [this] { return !queue_.empty() || closing_; });
+            if (queue_.empty()) return;
+            result = std::move(queue_.front());
+        }
+        try {
+            write_record_(result);
+        } catch (...) {
+            std::lock_guard lock(mutex_);
+            if (!error_) error_ = std::current_exception();
+        }
+        {
+            std::lock_guard lock(mutex_);
+            queue_.pop_front();
+        }
+        changed_.notify_all();
+    }
+}
+
+void ResultStream::rethrow_error_() {
+    std::lock_guard lock(mutex_);
+    if (error_) std::rethrow_exception(error_);
+}
+
+void ResultStream::push(Result result) {
+    if (pushed_ >= state_count_) {
+        throw std::invalid_argument("ResultStream received more results than its header announced");
+    }
+    if (rows_ != 0 && (result.heat_map.rows() != rows_ || result.heat_map.cols() != cols_)) {
+        throw std::invalid_argument("ResultStream heat map has the wrong size");
+    }
+    if (rows_ == 0) result.heat_map = HeatMap();
+    ++pushed_;
+
+    if (!writer_.joinable()) {
+        write_record_(result);
+        return;
+    }
+    rethrow_error_();
+    {
+        std::unique_lock lock(mutex_);
+        changed_.wait(lock, [this] { return queue_.size() < MAX_PENDING; });
+        queue_.push_back(std::move(result));
+    }
+    changed_.notify_all();
+}
+
+void ResultStream::close() {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard lock(mutex_);
+            closing_ = true;
+        }
+        changed_.notify_all();
+        writer_.join();
+    }
+    if (!output_.is_open()) return;
+    output_.close();
+    rethrow_error_();
+    if (!output_) {
+        throw std::runtime_error("Cannot finish result stream");
+    }
+    if (pushed_ != state_count_) {
+        throw std::runtime_error("ResultStream closed after " + std::to_string(pushed_) + " of "
+                                 + std::to_string(state_count_) + " results");
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef RESULT_STREAM_HEADER
+#define RESULT_STREAM_HEADER
+
+#include "Game.h"
+#include "Geometry.h"
+#include "Solver.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Per-state results written as a NumPy .npy file while they are computed.
+ * @ingroup solver
+ *
+ * The file is a one-dimensional array of structured records, so np.load() reads it
+ * directly and np.load(path, mmap_mode="r") maps it without parsing. Each record holds:
+ * - state: uint32
+ * - score: float64, what the solver minimises or maximises
+ * - aim: 2 float64, the best aim
+ * - extent: 4 float64, min x, min y, max x, max y of the heat map
+ * - heat_map: rows x cols float32, only when the stream has heat maps
+ *
+ * The record count is fixed in the header, so records are appended as they arrive and
+ * nothing is rewritten. Fields are little-endian on little-endian hosts and described
+ * as such in the header. With background writing, push() hands the result to a writer
+ * thread that converts the heat map to float and writes it while the caller computes
+ * the next state; at most MAX_PENDING results wait in between.
+ *
+ * Example usage:
+ * @code
+ * ResultStream stream("results.npy", 101, 100, 100, game.get_target_bounds());
+ * for (Game::State s = 1; s <= 101; ++s) {
+ *     auto [score, aim] = solver.solve(s);
+ *     stream.push({s, score, aim, visualizer.heat_map(s)});
+ * }
+ * stream.close();
+ * @endcode
+ */
+class ResultStream {
+public:
+    /** @brief One state's result; heat_map is ignored by streams without heat maps. */
+    struct Result {
+        Game::State state;
+        double score;
+        Vec2 aim;
+        HeatMap heat_map;
+    };
+
+    static constexpr size_t MAX_PENDING = 2; ///< Results queued for the writer before push() blocks
+
+private:
+    std::ofstream output_;
+    size_t state_count_;
+    size_t rows_;
+    size_t cols_;
+    Game::Bounds extent_;
+    size_t pushed_ = 0;
+    std::vector<std::byte> record_; ///< Scratch buffer of one record, used by the writer only
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<Result> queue_;
+    bool closing_ = false;
+    std::exception_ptr error_;      ///< First write error, rethrown by push() and close()
+    std::jthread writer_;           ///< Not started without background writing
+
+    void writer_loop_();
+    void write_record_(const Result& result);
+    void rethrow_error_();
+
+public:
+    /**
+     * @brief Create path and write the header.
+     * @param path Output file, replaced if it exists
+     * @param state_count Number of results that will be pushed
+     * @param rows Rows of every heat map, 0 for a stream without heat maps
+     * @param cols Columns of every heat map, 0 for a stream without heat maps
+     * @param extent Bounds the heat maps cover, stored in every record
+     * @param background Write on a separate thread, overlapping with the caller
+     * @throws std::runtime_error if the file cannot be written
+     */
+    ResultStream(const std::string& path, size_t state_count, size_t rows, size_t cols, Game::Bounds extent,
+                 bool background = true);
+
+    /** @brief Waits for pending records; errors are dropped, call close() to see them. */
+    ~ResultStream();
+
+    ResultStream(const ResultStream&) = delete;
+    ResultStream& operator=(const ResultStream&) = delete;
+
+    /**
+     * @brief Append a result, blocking while MAX_PENDING results are queued.
+     * @throws std::invalid_argument if the heat map has the wrong size or more than state_count results are pushed
+     * @throws std::runtime_error if an earlier write failed
+     */
+    void push(Result result);
+
+    /**
+     * @brief Write the pending results and close the file.
+     * @throws std::runtime_error if a write failed or fewer than state_count results were pushed
+     */
+    void close();
+
+    /** @brief NumPy dtype description of the records, as stored in the header. */
+    [[nodiscard]] static std::string dtype_descr(size_t rows, size_t cols);
+
+    /** @brief Bytes of one record. */
+    [[nodiscard]] static size_t record_size(size_t rows, size_t cols);
+};
+
+#endif
@@ -0,0 +1,177 @@
+#include "SolutionTable.h"
+#include "Solver.h"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(double) == 8 && std::numeric_limits<double>::is_iec559, "Tables store IEEE 754 doubles");
+
+SolutionTable::~SolutionTable() {
+#ifndef _WIN32
+    if (mapping_ != nullptr) munmap(mapping_, size_);
+#endif
+}
+
+void SolutionTable::validate_() {
+    if (size_ < sizeof(Header)) {
+        throw std::runtime_error("Invalid solution table: file is shorter than the header");
+    }
+    std::memcpy(&header_, data_, sizeof(Header));
+    if (std::memcmp(header_.magic, MAGIC_, sizeof(MAGIC_)) != 0) {
+        throw std::runtime_error("Invalid solution table: bad magic");
+    }
+    if (header_.version != VERSION) {
+        throw std::runtime_error("Unsupported solution table version " + std::to_string(header_.version)
+                                 + ", expected " + std::to_string(VERSION));
+    }
+    // Sizes are checked by division so a corrupt header cannot overflow the expected size
+    const uint64_t available = size_ - sizeof(Header);
+    const uint64_t n = header_.state_count;
+    if (n > available / sizeof(Record)) {
+        throw std::runtime_error("Invalid solution table: truncated state records");
+    }
+    uint64_t rest = available - n * sizeof(Record);
+    uint64_t plane_cells = 0;
+    if (header_.plane_rows != 0 || header_.plane_cols != 0) {
+        if (header_.plane_rows == 0 || header_.plane_cols == 0
+            || header_.plane_cols > std::numeric_limits<uint64_t>::max() / header_.plane_rows) {
+            throw std::runtime_error("Invalid solution table: bad plane size");
+        }
+        plane_cells = header_.plane_rows * header_.plane_cols;
+    }
+    if (plane_cells != 0 && n > rest / sizeof(double) / plane_cells) {
+        throw std::runtime_error("Invalid solution table: truncated planes");
+    }
+    if (rest != n * plane_cells * sizeof(double)) {
+        throw std::runtime_error("Invalid solution table: unexpected trailing bytes");
+    }
+}
+
+const SolutionTable::Record* SolutionTable::records_() const {
+    return reinterpret_cast<const Record*>(data_ + sizeof(Header));
+}
+
+std::shared_ptr<const SolutionTable> SolutionTable::open(const std::string& path) {
+#ifdef _WIN32
+    // No mmap, the file is read into an owned buffer instead
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Cannot open solution table: " + path);
+    }
+    std::shared_ptr<SolutionTable> table(new SolutionTable());
+    input.seekg(0, std::ios::end);
+    table->buffer_.resize(static_cast<size_t>(input.tellg()));
+    input.seekg(0, std::ios::beg);
+    if (!input.read(reinterpret_cast<char*>(table->buffer_.data()), static_cast<std::streamsize>(table->buffer_.size()))) {
+        throw std::runtime_error("Cannot read solution table: " + path);
+    }
+    table->data_ = table->buffer_.data();
+    table->size_ = table->buffer_.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open solution table: " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot read solution table: " + path);
+    }
+
+    std::shared_ptr<SolutionTable> table(new SolutionTable());
+    table->size_ = static_cast<size_t>(info.st_size);
+    if (table->size_ > 0) {
+        void* mapping = mmap(nullptr, table->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map solution table: " + path);
+        }
+        table->mapping_ = mapping;
+        table->data_ = static_cast<const std::byte*>(mapping);
+    }
+    ::close(fd); // The mapping keeps the file alive
+#endif
+    table->validate_();
+    return table;
+}
+
+std::shared_ptr<const SolutionTable> SolutionTable::from_bytes(std::span<const std::byte> bytes) {
+    std::shared_ptr<SolutionTable> table(new SolutionTable());
+    table->buffer_.assign(bytes.begin(), bytes.end());
+    table->data_ = table->buffer_.data();
+    table->size_ = table->buffer_.size();
+    table->validate_();
+    return table;
+}
+
+void SolutionTable::write(const std::string& path, Solver& solver, Game::State max_state,
+                          size_t plane_rows, size_t plane_cols) {
+    if ((plane_rows == 0) != (plane_cols == 0)) {
+        throw std::invalid_argument("Solution table planes need both rows and columns");
+    }
+    const size_t n = static_cast<size_t>(max_state) + 1;
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC_, sizeof(MAGIC_));
+    header.version = VERSION;
+    header.key = solver.solution_key();
+    header.state_count = n;
+    header.plane_rows = plane_rows;
+    header.plane_cols = plane_cols;
+
+    std::vector<Record> records(n, Record{0.0, 0.0, 0.0});
+    for (Game::State s = 1; s < n; ++s) {
+        auto [score, aim] = solver.solve(s);
+        records[s] = Record{score, aim.x, aim.y};
+    }
+
+    // Written next to the destination and renamed, so readers never map a partial file
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Cannot write solution table: " + path);
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(n * sizeof(Record)));
+        if (plane_rows != 0) {
+            HeatMapVisualizer visualizer(solver, plane_rows, plane_cols);
+            const std::vector<double> empty(plane_rows * plane_cols, 0.0);
+            out.write(reinterpret_cast<const char*>(empty.data()), static_cast<std::streamsize>(empty.size() * sizeof(double)));
+            for (Game::State s = 1; s < n; ++s) {
+                // Heat maps are row-major like the planes, so they are written as they are
+                const auto heat_map = visualizer.heat_map(s);
+                out.write(reinterpret_cast<const char*>(heat_map.data()), static_cast<std::streamsize>(heat_map.size() * sizeof(double)));
+            }
+        }
+        if (!out) {
+            throw std::runtime_error("Cannot write solution table: " + path);
+        }
+    }
+    std::filesystem::rename(temporary, path);
+}
+
+std::optional<std::pair<double, Vec2>> SolutionTable::find(Game::State s) const {
+    if (s >= header_.state_count) return std::nullopt;
+    const Record& record = records_()[s];
+    if (std::isnan(record.score)) return std::nullopt;
+    return std::pair{record.score, Vec2{record.x, record.y}};
+}
+
+std::span<const double> SolutionTable::plane(Game::State s) const {
+    if (header_.plane_rows == 0 || !find(s)) return {};
+    const size_t cells = header_.plane_rows * header_.plane_cols;
+    const auto* planes = reinterpret_cast<const double*>(data_ + sizeof(Header) + header_.state_count * sizeof(Record));
+    return std::span(planes + s * cells, cells);
+}
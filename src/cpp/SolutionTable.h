@@ -0,0 +1,169 @@
+#ifndef SOLUTION_TABLE_HEADER
+#define SOLUTION_TABLE_HEADER
+
+#include "Game.h"
+#include "Geometry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class Solver;
+
+/**
+ * @brief 64 bit FNV-1a hash used for solution table keys.
+ * @ingroup solver
+ *
+ * Values are hashed by their bytes in native order, so a key is only stable
+ * across builds for the same platform byte order.
+ */
+class SolutionKeyHasher {
+private:
+    uint64_t hash_ = 0xcbf29ce484222325ULL;
+
+public:
+    SolutionKeyHasher() = default;
+    /** @brief Continue from an existing key, e.g. the base part computed by Solver. */
+    explicit SolutionKeyHasher(uint64_t key) : hash_(key) {}
+
+    SolutionKeyHasher& add(std::span<const std::byte> bytes) {
+        for (std::byte b : bytes) {
+            hash_ = (hash_ ^ static_cast<uint64_t>(b)) * 0x100000001b3ULL;
+        }
+        return *this;
+    }
+    SolutionKeyHasher& add(uint64_t value) { return add(std::as_bytes(std::span(&value, 1))); }
+    SolutionKeyHasher& add(double value) { return add(std::as_bytes(std::span(&value, 1))); }
+    /** @brief Strings are hashed with their length, so consecutive strings cannot run together. */
+    SolutionKeyHasher& add(std::string_view text) {
+        add(static_cast<uint64_t>(text.size()));
+        return add(std::as_bytes(std::span(text.data(), text.size())));
+    }
+
+    [[nodiscard]] uint64_t value() const { return hash_; }
+};
+
+/**
+ * @brief Solved states of one solver configuration, in a versioned binary file.
+ * @ingroup solver
+ *
+ * The file is a fixed header followed by flat arrays. All fields are stored in
+ * native byte order, and every array starts 8-byte aligned:
+ * - Header: magic "DARTSOL", format version, key, state count, plane rows and columns
+ * - One {score, aim x, aim y} record per state 0 .. state count - 1, with a NaN score for states not stored
+ * - Optionally, a plane of rows x columns doubles per state: the scores at the cell centres
+ *   of a HeatMapVisualizer of that size, [state][row][column]
+ *
+ * The key is Solver::solution_key(). It hashes everything a solution depends on:
+ * - the target's beds
+ * - the distribution's type, covariance and mean, and quadrature rule and precision
+ * - the HitProbabilityField serving the game, if any: its grid, cell size and precision
+ * - the game's bed culling
+ * - the game rules
+ * - the solver type and its parameters
+ * - the aim grid and the search policy
+ *
+ * A solver only accepts a table with its own key.
+ *
+ * open() maps the file read-only and checks the header. Records and planes are then
+ * read straight from the mapping, so loading does no parsing at any file size. Pages
+ * are only read when a state is looked up. Without POSIX mmap (Windows) the file is
+ * read into memory instead.
+ *
+ * Example usage:
+ * @code
+ * solver.solve_all(501);
+ * SolutionTable::write("min_throws.dsol", solver, 501, 100, 100); // With 100x100 heat map planes
+ *
+ * // Later, in another process
+ * SolverMinThrows server(game, 10000);
+ * server.use_solution_table(SolutionTable::open("min_throws.dsol"));
+ * auto [throws, aim] = server.solve(301); // Read from the table
+ * @endcode
+ */
+class SolutionTable {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t key;
+        uint64_t state_count;
+        uint64_t plane_rows;
+        uint64_t plane_cols;
+    };
+    struct Record {
+        double score;
+        double x;
+        double y;
+    };
+    static constexpr char MAGIC_[8] = {'D', 'A', 'R', 'T', 'S', 'O', 'L', '\0'};
+
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+    void* mapping_ = nullptr;            ///< Start of the file mapping, null when the bytes are owned
+    std::vector<std::byte> buffer_;      ///< Owned copy, for tables built from memory or read without mmap
+    Header header_{};
+
+    SolutionTable() = default;
+
+    /** @brief Check the header and the file size against it. */
+    void validate_();
+    [[nodiscard]] const Record* records_() const;
+
+public:
+    SolutionTable(const SolutionTable&) = delete;
+    SolutionTable& operator=(const SolutionTable&) = delete;
+    ~SolutionTable();
+
+    /**
+     * @brief Map a table file read-only.
+     * @throws std::runtime_error if the file cannot be opened or is not a valid table of this version
+     */
+    [[nodiscard]] static std::shared_ptr<const SolutionTable> open(const std::string& path);
+
+    /**
+     * @brief Table from bytes in memory, e.g. a file fetched by the browser. The bytes are copied.
+     * @throws std::runtime_error if bytes are not a valid table of this version
+     */
+    [[nodiscard]] static std::shared_ptr<const SolutionTable> from_bytes(std::span<const std::byte> bytes);
+
+    /**
+     * @brief Solve states 0 .. max_state with solver and write them to path.
+     * @param path Output file, replaced if it exists
+     * @param solver Solver to query; states it has already solved are reused
+     * @param max_state Highest state stored
+     * @param plane_rows Rows of the stored heat map planes, 0 for none
+     * @param plane_cols Columns of the stored heat map planes, 0 for none
+     * @throws std::runtime_error if the file cannot be written
+     */
+    static void write(const std::string& path, Solver& solver, Game::State max_state,
+                      size_t plane_rows = 0, size_t plane_cols = 0);
+
+    /** @brief Key of the configuration the table was written for, see Solver::solution_key(). */
+    [[nodiscard]] uint64_t get_key() const { return header_.key; }
+    /** @brief Number of states stored, the states are 0 .. get_state_count() - 1. */
+    [[nodiscard]] size_t get_state_count() const { return header_.state_count; }
+
+    /** @brief Stored score and aim of s, if s is in the table. */
+    [[nodiscard]] std::optional<std::pair<double, Vec2>> find(Game::State s) const;
+
+    /** @brief Whether the table has heat map planes of rows x cols cells. */
+    [[nodiscard]] bool has_planes(size_t rows, size_t cols) const {
+        return rows > 0 && header_.plane_rows == rows && header_.plane_cols == cols;
+    }
+
+    /** @brief Heat map plane of s in row-major order, empty if there are no planes or s is not stored. */
+    [[nodiscard]] std::span<const double> plane(Game::State s) const;
+};
+
+#endif
@@ -1,39 +1,348 @@
 #include "Solver.h"
 #include "Game.h"
+#include "HitProbabilityField.h"
+#include "SolutionTable.h"
+#include "ThreadPool.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
 #include <utility>
 #include <vector>
-#include <cmath>
 
-std::vector<Vec2> Solver::sample_aims_() const {
-    std::vector<Vec2> aims;
-    auto [min_point, max_point] = game_.get_target_bounds();
+std::vector<size_t> Solver::seed_aims_() const {
+    std::vector<size_t> aims;
+    const size_t width = aim_grid_.get_width();
+    const size_t height = aim_grid_.get_height();
+    for (size_t i = std::min(SEED_STRIDE_ / 2, width - 1); i < width; i += SEED_STRIDE_) {
+        for (size_t j = std::min(SEED_STRIDE_ / 2, height - 1); j < height; j += SEED_STRIDE_) {
+            aims.push_back(aim_grid_.index(i, j));
+        }
+    }
+    return aims;
+}
+
+std::optional<std::pair<Solver::Score, Vec2>> Solver::stored_solution_(Game::State s) const {
+    if (solution_table_ == nullptr) return std::nullopt;
+    return solution_table_->find(s);
+}
+
+void Solver::drop_stale_solution_table_() {
+    if (solution_table_ != nullptr && solution_table_->get_key() != solution_key()) {
+        solution_table_.reset();
+    }
+}
 
-    size_t height_samples = static_cast<size_t>(std::sqrt(num_samples_));
-    size_t width_samples = num_samples_ / height_samples;
+uint64_t Solver::solution_key() const {
+    SolutionKeyHasher hasher;
+    hasher.add(std::string_view("darts solution")).add(static_cast<uint64_t>(SolutionTable::VERSION));
 
-    for (size_t i = 0; i < width_samples; ++i) {
-        for (size_t j = 0; j < height_samples; ++j) {
-            double x = min_point.x + (max_point.x - min_point.x) * (i + 0.5) / width_samples;
-            double y = min_point.y + (max_point.y - min_point.y) * (j + 0.5) / height_samples;
-            aims.emplace_back(x, y);
+    for (const auto& bed : game_.get_target().get_beds()) {
+        const HitData hit = bed.after_hit();
+        hasher.add(static_cast<uint64_t>(hit.type)).add(static_cast<uint64_t>(static_cast<int64_t>(hit.diff)));
+        const auto& vertices = bed.get_shape().get_vertices();
+        hasher.add(static_cast<uint64_t>(vertices.size()));
+        for (Vec2 v : vertices) hasher.add(v.x).add(v.y);
+    }
+
+    const Distribution& distribution = game_.get_distribution();
+    if (const auto* random = dynamic_cast<const NormalDistributionRandom*>(&distribution)) {
+        hasher.add(std::string_view("monte carlo")).add(static_cast<uint64_t>(random->get_integration_precision()))
+              .add(random->get_seed());
+    } else if (const auto* quadrature = dynamic_cast<const NormalDistributionQuadrature*>(&distribution)) {
+        hasher.add(std::string_view("quadrature"));
+        // Tables written before the rule was selectable used the default one
+        if (quadrature->get_rule() != NormalDistributionQuadrature::Rule::DUNAVANT_25) {
+            hasher.add(static_cast<uint64_t>(quadrature->get_rule()));
+        }
+        if (quadrature->get_precision() != Precision::DOUBLE) {
+            hasher.add(std::string_view("float"));
         }
+    } else {
+        hasher.add(std::string_view(typeid(distribution).name()));
+    }
+    if (const auto* normal = dynamic_cast<const NormalDistribution*>(&distribution)) {
+        for (const auto& row : normal->get_covariance()) hasher.add(row[0]).add(row[1]);
+        hasher.add(normal->get_mean().x).add(normal->get_mean().y);
     }
 
-    return aims;
+    // Where grid probabilities come from: a field differs from the quadrature by its discretisation
+    if (const HitProbabilityField* field = game_.get_hit_probability_field()) {
+        const AimGrid& grid = field->get_grid();
+        hasher.add(std::string_view("hit probability field"))
+              .add(grid.get_min().x).add(grid.get_min().y).add(grid.get_max().x).add(grid.get_max().y)
+              .add(static_cast<uint64_t>(grid.get_width())).add(static_cast<uint64_t>(grid.get_height()))
+              .add(field->get_max_cell_size()).add(static_cast<uint64_t>(field->get_precision()));
+    }
+    // Tables written before culling was configurable used the default
+    if (game_.is_strict_integration()) {
+        hasher.add(std::string_view("strict integration"));
+    } else if (game_.get_cull_sigmas() != Game::DEFAULT_CULL_SIGMAS) {
+        hasher.add(std::string_view("cull sigmas")).add(game_.get_cull_sigmas());
+    }
+
+    if (dynamic_cast<const GameFinishOnDouble*>(&game_)) {
+        hasher.add(std::string_view("finish on double"));
+    } else if (dynamic_cast<const GameFinishOnAny*>(&game_)) {
+        hasher.add(std::string_view("finish on any"));
+    } else {
+        hasher.add(std::string_view(typeid(game_).name()));
+    }
+
+    hasher.add(aim_grid_.get_min().x).add(aim_grid_.get_min().y).add(aim_grid_.get_max().x).add(aim_grid_.get_max().y)
+          .add(static_cast<uint64_t>(aim_grid_.get_width())).add(static_cast<uint64_t>(aim_grid_.get_height()));
+
+    hasher.add(static_cast<uint64_t>(search_policy_.mode));
+    if (search_policy_.mode != SearchPolicy::Mode::EXHAUSTIVE) {
+        hasher.add(static_cast<uint64_t>(search_policy_.coarse_aims)).add(static_cast<uint64_t>(search_policy_.keep))
+              .add(static_cast<uint64_t>(search_policy_.polish_steps));
+    }
+    return hasher.value();
 }
 
-SolverMinThrows::Score SolverMinThrows::solve_aim(Game::State s, Vec2 aim) {
-    auto states = game_.throw_at(aim, s);
+void Solver::use_solution_table(std::shared_ptr<const SolutionTable> table) {
+    if (table != nullptr && table->get_key() != solution_key()) {
+        throw std::invalid_argument("Solution table was written for a different target, distribution, game or solver");
+    }
+    solution_table_ = std::move(table);
+}
+
+void Solver::set_retain_aim_scores(bool retain) {
+    retain_aim_scores_ = retain;
+    if (!retain) aim_score_planes_.clear();
+}
+
+void Solver::store_aim_scores_(uint64_t key, std::vector<float> plane) {
+    const size_t bytes = plane.size() * sizeof(float);
+    aim_score_planes_.insert(key, std::move(plane), bytes);
+}
+
+std::optional<HeatMap> Solver::resample_aim_scores_(uint64_t key, Game::Bounds bounds, size_t rows, size_t cols) {
+    const std::vector<float>* plane = aim_score_planes_.find(key);
+    if (plane == nullptr) return std::nullopt;
+
+    const size_t width = aim_grid_.get_width();
+    const size_t height = aim_grid_.get_height();
+    const Vec2 min = aim_grid_.get_min();
+    const Vec2 max = aim_grid_.get_max();
+    HeatMap heat_map(rows, cols);
+    if (rows == height && cols == width && bounds.min == min && bounds.max == max) {
+        // Row r of the map is row j of the grid, column c is column i
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < cols; ++c) heat_map(r, c) = (*plane)[aim_grid_.index(c, r)];
+        }
+        return heat_map;
+    }
+
+    // Grid index below a cell centre and the weight of the one above, per column and per row
+    struct Sample {
+        size_t below;
+        size_t above;
+        double t;
+    };
+    auto samples = [](double from, double to, size_t cells, double grid_min, double grid_max, size_t n) {
+        std::vector<Sample> result(cells);
+        for (size_t k = 0; k < cells; ++k) {
+            const double p = from + (to - from) * (k + 0.5) / cells;
+            const double u = grid_max > grid_min ? (p - grid_min) / (grid_max - grid_min) * n - 0.5 : 0.0;
+            const double clamped = std::clamp(u, 0.0, static_cast<double>(n - 1));
+            const size_t below = static_cast<size_t>(clamped);
+            result[k] = {below, std::min(below + 1, n - 1), clamped - below};
+        }
+        return result;
+    };
+    const std::vector<Sample> xs = samples(bounds.min.x, bounds.max.x, cols, min.x, max.x, width);
+    const std::vector<Sample> ys = samples(bounds.min.y, bounds.max.y, rows, min.y, max.y, height);
+    auto at = [&](size_t i, size_t j) { return static_cast<double>((*plane)[aim_grid_.index(i, j)]); };
+    for (size_t r = 0; r < rows; ++r) {
+        const Sample& y = ys[r];
+        for (size_t c = 0; c < cols; ++c) {
+            const Sample& x = xs[c];
+            const double low = at(x.below, y.below) * (1.0 - x.t) + at(x.above, y.below) * x.t;
+            const double high = at(x.below, y.above) * (1.0 - x.t) + at(x.above, y.above) * x.t;
+            heat_map(r, c) = low * (1.0 - y.t) + high * y.t;
+        }
+    }
+    return heat_map;
+}
+
+template <typename Objective>
+std::pair<Solver::Score, Vec2> Solver::search_(std::pair<Score, Vec2> best, Objective&& objective) {
+    auto score_of = [&](Game::AimIndex aim, Score to_beat) -> Score {
+        if constexpr (std::is_invocable_v<Objective&, Game::AimIndex, Score>) {
+            return objective(aim, to_beat);
+        } else {
+            return objective(aim);
+        }
+    };
+
+    if (search_policy_.mode == SearchPolicy::Mode::EXHAUSTIVE) {
+        std::vector<Score> seeded;
+        Score seed = std::numeric_limits<Score>::infinity();
+        if constexpr (std::is_invocable_v<Objective&, Game::AimIndex, Score>) {
+            // A sparse subgrid first gives the bound a good score to beat from the first aim on.
+            // The scan below still visits aims in index order, so the result does not change.
+            seeded.assign(aim_grid_.size(), std::numeric_limits<Score>::quiet_NaN());
+            for (size_t index : seed_aims_()) {
+                seeded[index] = score_of(first_row_ + index, std::numeric_limits<Score>::infinity());
+                ++aim_evaluations_;
+                seed = std::min(seed, seeded[index]);
+            }
+        }
+        for (size_t a = 0; a < aim_grid_.size(); ++a) {
+            Score score;
+            if (!seeded.empty() && !std::isnan(seeded[a])) {
+                score = seeded[a];
+            } else {
+                score = score_of(first_row_ + a, std::min(best.first, seed));
+                ++aim_evaluations_;
+            }
+            if (score < best.first) {
+                best = {score, aim_grid_[a]};
+            }
+        }
+        return best;
+    }
+
+    const size_t width = aim_grid_.get_width();
+    const size_t height = aim_grid_.get_height();
+    std::unordered_map<size_t, Score> evaluated; // Grid index -> score
+    auto evaluate = [&](size_t i, size_t j) {
+        size_t index = aim_grid_.index(i, j);
+        auto [it, inserted] = evaluated.try_emplace(index, 0.0);
+        if (inserted) {
+            it->second = score_of(first_row_ + index, std::numeric_limits<Score>::infinity());
+            ++aim_evaluations_;
+        }
+    };
+    // Ordered by score, then index, so the outcome does not depend on hash order
+    auto ranked = [&] {
+        std::vector<std::pair<Score, size_t>> order;
+        order.reserve(evaluated.size());
+        for (const auto& [index, score] : evaluated) order.emplace_back(score, index);
+        std::sort(order.begin(), order.end());
+        return order;
+    };
+
+    const double cells_per_coarse_aim = static_cast<double>(width * height) / std::max<size_t>(1, search_policy_.coarse_aims);
+    size_t stride = std::max<size_t>(1, static_cast<size_t>(std::lround(std::sqrt(cells_per_coarse_aim))));
+    for (size_t i = std::min(stride / 2, width - 1); i < width; i += stride) {
+        for (size_t j = std::min(stride / 2, height - 1); j < height; j += stride) {
+            evaluate(i, j);
+        }
+    }
+
+    while (stride > 1) {
+        auto order = ranked();
+        order.resize(std::min(order.size(), std::max<size_t>(1, search_policy_.keep)));
+        stride = (stride + 1) / 2;
+        for (const auto& [score, index] : order) {
+            const size_t i = index / height;
+            const size_t j = index % height;
+            for (int di = -1; di <= 1; ++di) {
+                for (int dj = -1; dj <= 1; ++dj) {
+                    // Unsigned wrap-around makes negative coordinates fail the range check
+                    size_t ni = i + di * static_cast<ptrdiff_t>(stride);
+                    size_t nj = j + dj * static_cast<ptrdiff_t>(stride);
+                    if (ni < width && nj < height) evaluate(ni, nj);
+                }
+            }
+        }
+    }
+
+    const auto order = ranked();
+    if (order.empty() || !(order.front().first < best.first)) {
+        return best;
+    }
+    best = {order.front().first, aim_grid_[order.front().second]};
+
+    // Compass search off the grid, the points are off-grid rows of the outcome table
+    const Vec2 min = aim_grid_.get_min();
+    const Vec2 max = aim_grid_.get_max();
+    Vec2 step{(max.x - min.x) / width * 0.5, (max.y - min.y) / height * 0.5};
+    for (unsigned int level = 0; level < search_policy_.polish_steps; ++level) {
+        bool moved = true;
+        for (int move = 0; move < 4 && moved; ++move) {
+            moved = false;
+            const std::array<Vec2, 4> candidates = {
+                best.second + Vec2{step.x, 0.0}, best.second - Vec2{step.x, 0.0},
+                best.second + Vec2{0.0, step.y}, best.second - Vec2{0.0, step.y},
+            };
+            for (Vec2 aim : candidates) {
+                if (aim.x < min.x || aim.x > max.x || aim.y < min.y || aim.y > max.y) continue;
+                Score score = score_of(game_.aim_index(aim), best.first);
+                ++aim_evaluations_;
+                if (score < best.first) {
+                    best = {score, aim};
+                    moved = true;
+                }
+            }
+        }
+        step = step * 0.5;
+    }
+    return best;
+}
+
+template <typename Objective>
+std::pair<Solver::Score, Vec2> Solver::search_near_(Vec2 center, size_t radius, std::pair<Score, Vec2> best,
+                                                    Objective&& objective) {
+    const size_t height = aim_grid_.get_height();
+    size_t ci, cj;
+    aim_grid_.nearest(center, ci, cj);
+    const size_t i_from = ci > radius ? ci - radius : 0;
+    const size_t j_from = cj > radius ? cj - radius : 0;
+    const size_t i_to = std::min(ci + radius, aim_grid_.get_width() - 1);
+    const size_t j_to = std::min(cj + radius, height - 1);
+
+    Score seed = std::numeric_limits<Score>::infinity();
+    const size_t center_index = aim_grid_.index(ci, cj);
+    if constexpr (std::is_invocable_v<Objective&, Game::AimIndex, Score>) {
+        seed = objective(first_row_ + center_index, std::numeric_limits<Score>::infinity());
+        ++aim_evaluations_;
+    }
+    // Columns outside, rows inside, so aims are visited in index order and ties go to the lowest index
+    for (size_t i = i_from; i <= i_to; ++i) {
+        for (size_t j = j_from; j <= j_to; ++j) {
+            const size_t a = aim_grid_.index(i, j);
+            Score score;
+            if constexpr (std::is_invocable_v<Objective&, Game::AimIndex, Score>) {
+                if (a == center_index) {
+                    score = seed;
+                } else {
+                    score = objective(first_row_ + a, std::min(best.first, seed));
+                    ++aim_evaluations_;
+                }
+            } else {
+                score = objective(first_row_ + a);
+                ++aim_evaluations_;
+            }
+            if (score < best.first) {
+                best = {score, aim_grid_[a]};
+            }
+        }
+    }
+    return best;
+}
+
+template <typename Rules, typename ScoreOf>
+SolverMinThrows::Score SolverMinThrows::expected_throws_(const Rules& rules, Game::State s, Game::AimIndex aim,
+                                                         ScoreOf&& score_of) const {
     SolverMinThrows::Score expected = 0;
     double same_state_prob = 0;
 
-    for (const auto& [state, probability] : states) {
+    for (const auto& [hit, probability] : game_.outcomes(aim)) {
+        const Game::State state = rules(s, hit);
         if (state == s) {
             same_state_prob += probability;
             continue;
         }
-        SolverMinThrows::Score state_score = solve(state).first;
+        SolverMinThrows::Score state_score = score_of(state);
 
         if (!winable_.contains(state)) {
             same_state_prob += probability;
@@ -52,96 +361,464 @@ SolverMinThrows::Score SolverMinThrows::solve_aim(Game::State s, Vec2 aim) {
     return expected;
 }
 
+template <typename Rules, typename ScoreOf>
+SolverMinThrows::Successors SolverMinThrows::successors_(const Rules& rules, Game::State s, ScoreOf&& score_of) const {
+    const auto row = game_.outcomes(first_row_);
+    Successors successors;
+    successors.score.resize(row.size());
+    for (size_t k = 0; k < row.size(); ++k) {
+        Game::State state = rules(s, row[k].hit);
+        Score score = -1.0;
+        if (state != s) {
+            score = score_of(state);
+            if (!winable_.contains(state)) score = -1.0;
+        }
+        successors.score[k] = score;
+        if (score >= 0.0) successors.lowest = std::min(successors.lowest, score);
+    }
+    return successors;
+}
+
+const std::vector<uint16_t>& SolverMinThrows::outcome_order_of_(Game::AimIndex aim) {
+    if (aim >= outcome_order_.size()) outcome_order_.resize(aim + 1);
+    auto& order = outcome_order_[aim];
+    if (order.empty()) {
+        const auto row = game_.outcomes(aim);
+        if (row.size() > std::numeric_limits<uint16_t>::max()) {
+            throw std::length_error("SolverMinThrows pruning supports at most 65535 outcomes");
+        }
+        order.resize(row.size());
+        std::iota(order.begin(), order.end(), uint16_t{0});
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint16_t a, uint16_t b) { return row[a].probability > row[b].probability; });
+    }
+    return order;
+}
+
+bool SolverMinThrows::prunable_(Game::AimIndex aim, const std::vector<uint16_t>& order,
+                                const Successors& successors, Score to_beat) const {
+    if (!(to_beat < INFINITE_SCORE)) return false;
+    const auto row = game_.outcomes(aim);
+    double remaining = 0.0;
+    for (const auto& outcome : row) remaining += std::max(0.0, outcome.probability);
+
+    const double limit = to_beat * (1.0 + PRUNE_TOLERANCE);
+    double expected = 0.0;
+    double stuck = 0.0;
+    for (uint16_t k : order) {
+        const double probability = std::max(0.0, row[k].probability);
+        const Score score = successors.score[k];
+        if (score < 0.0) {
+            stuck += probability;
+        } else {
+            expected += score * probability;
+        }
+        remaining -= probability;
+        const double lower = 1.0 + expected + std::max(0.0, remaining) * successors.lowest;
+        if (lower > limit * (1.0 - stuck)) return true;
+        if (remaining <= 0.0) break;
+    }
+    return false;
+}
+
+SolverMinThrows::Score SolverMinThrows::solved_score_(Game::State s) const {
+    if (s == 0) return 0.0;
+    auto it = memoization_.find(s);
+    if (it == memoization_.end()) {
+        throw std::logic_error("SolverMinThrows::solve_all needs transitions to smaller states only");
+    }
+    return it->second.first;
+}
+
+SolverMinThrows::Score SolverMinThrows::solve_aim(Game::State s, Vec2 aim) {
+    // The aim's row is read after the successor states are solved
+    Game::OffGridScope pinned(game_);
+    const Game::AimIndex index = game_.aim_index(aim);
+    return game_.with_rules([&](const auto& rules) {
+        return expected_throws_(rules, s, index, [this](Game::State state) { return solve(state).first; });
+    });
+}
+
 std::pair<SolverMinThrows::Score, Vec2> SolverMinThrows::solve(Game::State s) {
     if (s == 0) {
-        winable_.insert(0);
         return {0.0, Vec2{0.0, 0.0}};
     }
     
-    if (memoization_.contains(s)) {
-        return memoization_[s];
+    if (auto it = memoization_.find(s); it != memoization_.end()) {
+        return it->second;
     }
 
-    std::pair<SolverMinThrows::Score, Vec2> best_score = {INFINITE_SCORE, Vec2{0.0, 0.0}};
-    bool is_winable = false;
+    if (auto stored = stored_solution_(s)) {
+        if (stored->first < INFINITE_SCORE) winable_.insert(s);
+        memoization_[s] = *stored;
+        return *stored;
+    }
 
-    for (const auto& aim : sample_aims_()) {
-        SolverMinThrows::Score score = solve_aim(s, aim);
-        if (score < best_score.first) {
-            best_score = {score, aim};
+    Instrumentation::ScopedTimer timer(Instrumentation::Timer::SOLVE_MIN_THROWS);
+    EvaluationScope_ evaluations(*this, s);
+    Game::OffGridScope pinned(game_); // Polished aims are read while successor states are solved
+    auto score_of = [this](Game::State state) { return solve(state).first; };
+    // A warm-started state only searches around its previous best aim
+    std::optional<Vec2> warm_aim;
+    if (auto hint = warm_aims_.find(s); hint != warm_aims_.end()) {
+        warm_aim = hint->second;
+        warm_aims_.erase(hint);
+    }
+    auto search = [&](auto&& objective) {
+        const std::pair<Score, Vec2> unsolved = {INFINITE_SCORE, Vec2{0.0, 0.0}};
+        return warm_aim ? search_near_(*warm_aim, warm_radius_, unsolved, objective) : search_(unsolved, objective);
+    };
+    // Only a full scan has a score for every aim, pruned aims have none
+    std::vector<float> plane;
+    if (records_aim_scores_() && !warm_aim) plane.resize(aim_grid_.size());
+    const std::pair<SolverMinThrows::Score, Vec2> best_score = game_.with_rules([&](const auto& rules) {
+        if (!plane.empty()) {
+            return search([&](Game::AimIndex aim) {
+                const Score score = expected_throws_(rules, s, aim, score_of);
+                plane[aim - first_row_] = static_cast<float>(score);
+                return score;
+            });
         }
-        if (score < INFINITE_SCORE) {
-            is_winable = true;
+        if (search_policy_.prune) {
+            const Successors successors = successors_(rules, s, score_of);
+            return search([&](Game::AimIndex aim, Score to_beat) {
+                if (prunable_(aim, outcome_order_of_(aim), successors, to_beat)) {
+                    ++pruned_aims_;
+                    Instrumentation::count(Instrumentation::Counter::PRUNED_AIMS);
+                    return std::numeric_limits<Score>::infinity();
+                }
+                return expected_throws_(rules, s, aim, score_of);
+            });
         }
-    }
-    
-    if (is_winable) winable_.insert(s);
+        return search([&](Game::AimIndex aim) { return expected_throws_(rules, s, aim, score_of); });
+    });
+
+    if (best_score.first < INFINITE_SCORE) winable_.insert(s);
     memoization_[s] = best_score;
+    if (!plane.empty()) store_aim_scores_(aim_score_key_(s), std::move(plane));
 
     return best_score;
 }
 
-double SolverMinRounds::evaluate_dp(Game::State start_score, Game::State current_score, unsigned int throws_left, double X_start_guess, std::unordered_map<unsigned int, double>& inner_memo) {
-    if (current_score == 0) return 0.0;
-    if (throws_left == 0) {
-        if (current_score == start_score) return X_start_guess;
-        double cost = solve(current_score).first;
-        if (!winable_.contains(current_score)) return X_start_guess; // Treat unwinnable as bust
-        return cost;
+void SolverMinThrows::solve_all(Game::State max_state, size_t num_threads) {
+    // Warm-started states search small windows, filling the whole outcome table would defeat them
+    if (search_policy_.mode != SearchPolicy::Mode::EXHAUSTIVE || !warm_aims_.empty()) {
+        for (Game::State s = 1; s <= max_state; ++s) {
+            (void)solve(s);
+        }
+        return;
     }
 
-    // State packing just for internal memoization inside this single round
-    unsigned int state_key = (current_score << 8) | throws_left;
-    if (inner_memo.contains(state_key)) {
-        return inner_memo[state_key];
+    Instrumentation::ScopedTimer timer(Instrumentation::Timer::SOLVE_MIN_THROWS);
+    const bool retain = records_aim_scores_();
+    const bool prune = search_policy_.prune && !retain; // Pruned aims would leave holes in the planes
+    // Fill the game's outcome table up front, in the same aim order solve() would,
+    // so the parallel scan below only reads shared state.
+    for (size_t a = 0; a < aim_grid_.size(); ++a) {
+        (void)game_.outcomes(first_row_ + a);
+        if (prune) (void)outcome_order_of_(first_row_ + a);
     }
 
-    double best_expected = INFINITE_SCORE;
+    struct ChunkBest {
+        std::pair<Score, Vec2> best = {INFINITE_SCORE, Vec2{0.0, 0.0}};
+        bool is_winable = false;
+        size_t pruned = 0;
+    };
+
+    ThreadPool pool(num_threads);
+    std::vector<ChunkBest> chunks(pool.size());
+    auto score_of = [this](Game::State state) { return solved_score_(state); };
+    const std::vector<size_t> seed_aims = prune ? seed_aims_() : std::vector<size_t>{};
+
+    game_.with_rules([&](const auto& rules) {
+        for (Game::State s = 1; s <= max_state; ++s) {
+            if (memoization_.contains(s)) continue;
+            if (stored_solution_(s)) {
+                (void)solve(s);
+                continue;
+            }
+
+            EvaluationScope_ evaluations(*this, s);
+            Successors successors;
+            Score seed = INFINITE_SCORE;
+            std::vector<float> plane(retain ? aim_grid_.size() : 0);
+            if (prune) {
+                successors = successors_(rules, s, score_of);
+                // Best of the sparse subgrid, every chunk prunes against it
+                pool.for_chunks(seed_aims.size(), [&](size_t thread, size_t begin, size_t end) {
+                    ChunkBest chunk;
+                    for (size_t k = begin; k < end; ++k) {
+                        chunk.best.first = std::min(chunk.best.first, expected_throws_(rules, s, first_row_ + seed_aims[k], score_of));
+                    }
+                    chunks[thread] = chunk;
+                });
+                for (const auto& chunk : chunks) seed = std::min(seed, chunk.best.first);
+                aim_evaluations_ += seed_aims.size();
+            }
 
-    for (const auto& aim : sample_aims_()) {
-        auto states = game_.throw_at(aim, current_score);
-        auto hits = game_.throw_at_distribution(aim);
+            pool.for_chunks(aim_grid_.size(), [&](size_t thread, size_t begin, size_t end) {
+                ChunkBest chunk;
+                for (size_t a = begin; a < end; ++a) {
+                    const Game::AimIndex aim = first_row_ + a;
+                    // The bound never excludes an aim that could tie, so ties still go to the lowest index
+                    if (prune && prunable_(aim, outcome_order_[aim], successors, std::min(chunk.best.first, seed))) {
+                        ++chunk.pruned;
+                        continue;
+                    }
+                    Score score = expected_throws_(rules, s, aim, score_of);
+                    if (retain) plane[a] = static_cast<float>(score); // Chunks write disjoint aims
+                    if (score < chunk.best.first) {
+                        chunk.best = {score, aim_grid_[a]};
+                    }
+                    if (score < INFINITE_SCORE) {
+                        chunk.is_winable = true;
+                    }
+                }
+                chunks[thread] = chunk;
+            });
 
-        double expected = 0.0;
+            ChunkBest result;
+            for (const auto& chunk : chunks) {
+                if (chunk.best.first < result.best.first) {
+                    result.best = chunk.best;
+                }
+                result.is_winable = result.is_winable || chunk.is_winable;
+                pruned_aims_ += chunk.pruned;
+                Instrumentation::count(Instrumentation::Counter::PRUNED_AIMS, chunk.pruned);
+            }
+            aim_evaluations_ += aim_grid_.size();
+
+            if (result.is_winable) winable_.insert(s);
+            memoization_[s] = result.best;
+            if (retain) store_aim_scores_(aim_score_key_(s), std::move(plane));
+        }
+    });
+}
+
+void SolverMinThrows::warm_start(size_t radius) {
+    for (const auto& [state, solution] : memoization_) {
+        if (solution.first < INFINITE_SCORE) warm_aims_[state] = solution.second;
+    }
+    memoization_.clear();
+    winable_ = {0};
+    outcome_order_.clear();
+    aim_score_planes_.clear();
+    warm_radius_ = radius;
+    drop_stale_solution_table_();
+}
+
+template <typename Rules, typename ValueOf>
+std::vector<double> SolverMinRounds::outcome_values_(const Rules& rules, Game::State current_score,
+                                                     double round_start_value, ValueOf&& value_of) {
+    const auto hits = game_.outcomes(first_row_);
+    std::vector<double> values(hits.size(), 0.0);
+    for (size_t k = 0; k < hits.size(); ++k) {
+        const HitData hit = hits[k].hit;
+        Game::State next_state = rules(current_score, hit);
+        if (next_state == 0) continue;
+        if (hit.diff == 0) { // Miss, not a bust
+            values[k] = value_of(current_score);
+            continue;
+        }
+        // A hit that leaves the score unchanged is always an overshoot
+        bool is_bust = (next_state == current_score) || !winable_.contains(next_state);
+        values[k] = is_bust ? round_start_value : value_of(next_state);
+    }
+    return values;
+}
+
+double SolverMinRounds::expected_after_throw_(Game::AimIndex aim, std::span<const double> values) const {
+    const auto row = game_.outcomes(aim);
+    double expected = 0.0;
+    double prob_sum = 0.0;
+    for (size_t k = 0; k < values.size(); ++k) {
+        double prob = std::max(0.0, row[k].probability);
+        prob_sum += prob;
+        expected += prob * values[k];
+    }
+    return prob_sum > 0 ? expected / prob_sum : INFINITE_SCORE;
+}
+
+void SolverMinRounds::build_round_table_() {
+    const size_t num_aims = aim_grid_.size();
+    const size_t num_outcomes = game_.get_outcome_count();
+    round_table_.assign(num_outcomes * num_aims, 0.0);
+    empty_aims_.clear();
+    max_points_ = 0;
+    for (size_t a = 0; a < num_aims; ++a) {
+        const auto row = game_.outcomes(first_row_ + a);
         double prob_sum = 0.0;
-        for (size_t i = 0; i < states.size(); ++i) {
-            Game::State next_state = states[i].first;
-            double prob = std::max(0.0, states[i].second); prob_sum += prob;
-            HitData hit = hits[i].first;
-
-            if (next_state == 0) {
-                expected += prob * 0.0;
-            } else if (hit.diff == 0) { // Miss, not a bust
-                expected += prob * evaluate_dp(start_score, current_score, throws_left - 1, X_start_guess, inner_memo);
-            } else {
-                // Not a miss, check if bust
-                bool is_bust = (next_state == current_score) || (next_state != 0 && !winable_.contains(next_state));
-                // Add case: if current_score is NOT start_score, and we hit something that leaves score unchanged but diff != 0?
-                // Actually `next_state == current_score` for hit.diff != 0 is ALWAYS an overshoot (bust).
-                if (is_bust) {
-                    expected += prob * X_start_guess;
+        for (const auto& outcome : row) prob_sum += std::max(0.0, outcome.probability);
+        if (!(prob_sum > 0)) {
+            empty_aims_.push_back(a);
+            continue;
+        }
+        for (size_t k = 0; k < num_outcomes; ++k) {
+            round_table_[k * num_aims + a] = std::max(0.0, row[k].probability) / prob_sum;
+        }
+    }
+    for (const auto& outcome : game_.outcomes(first_row_)) {
+        max_points_ = std::max<Game::StateDifference>(max_points_, -outcome.hit.diff);
+    }
+}
+
+double SolverMinRounds::outcome_dot_(Game::AimIndex aim, std::span<const double> values) const {
+    const size_t num_aims = aim_grid_.size();
+    if (aim >= first_row_ && aim - first_row_ < num_aims) {
+        const size_t a = aim - first_row_;
+        if (std::binary_search(empty_aims_.begin(), empty_aims_.end(), a)) return INFINITE_SCORE;
+        double expected = 0.0;
+        for (size_t k = 0; k < values.size(); ++k) {
+            expected += round_table_[k * num_aims + a] * values[k];
+        }
+        return expected;
+    }
+    // Off-grid aims, reached by the polish of a coarse-to-fine search
+    const auto row = game_.outcomes(aim);
+    double expected = 0.0;
+    double prob_sum = 0.0;
+    for (size_t k = 0; k < values.size(); ++k) {
+        double prob = std::max(0.0, row[k].probability);
+        prob_sum += prob;
+        expected += prob * values[k];
+    }
+    return prob_sum > 0 ? expected / prob_sum : INFINITE_SCORE;
+}
+
+SolverMinRounds::RoundAim SolverMinRounds::best_aim_(std::span<const double> values) {
+    RoundAim best;
+    if (search_policy_.mode != SearchPolicy::Mode::EXHAUSTIVE) {
+        auto [score, point] = search_({INFINITE_SCORE, Vec2{0.0, 0.0}},
+                                      [&](Game::AimIndex aim) { return outcome_dot_(aim, values); });
+        if (score < INFINITE_SCORE) {
+            best.value = score;
+            best.point = point;
+            best.aim = game_.aim_index(point);
+        }
+        return best;
+    }
+
+    // scores = table * values, one column at a time so the inner loop runs over contiguous aims
+    const size_t num_aims = aim_grid_.size();
+    aim_scores_.assign(num_aims, 0.0);
+    double* scores = aim_scores_.data();
+    for (size_t k = 0; k < values.size(); ++k) {
+        const double value = values[k];
+        if (value == 0.0) continue;
+        const double* column = round_table_.data() + k * num_aims;
+        for (size_t a = 0; a < num_aims; ++a) {
+            scores[a] += column[a] * value;
+        }
+    }
+    for (size_t a : empty_aims_) scores[a] = INFINITE_SCORE;
+    aim_evaluations_ += num_aims;
+
+    for (size_t a = 0; a < num_aims; ++a) {
+        if (scores[a] < best.value) {
+            best.value = scores[a];
+            best.aim = first_row_ + a;
+            best.point = aim_grid_[a];
+        }
+    }
+    return best;
+}
+
+SolverMinRounds::RoundAim SolverMinRounds::evaluate_round_(Game::State s, double round_start_value, RoundLayers& layers) {
+    const size_t reach = static_cast<size_t>(max_points_);
+    const size_t width = layers.width;
+    const auto hits = game_.outcomes(first_row_);
+    const size_t num_outcomes = hits.size();
+    std::vector<double> values(num_outcomes);
+    std::vector<double> slopes(num_outcomes);
+
+    // Outcome values of a throw from current with throws_left - 1 throws after it
+    auto fill_outcomes = [&](Game::State current, unsigned int throws_left) {
+        const double* next_value = layers.value.data() + (throws_left - 1) * width;
+        const double* next_slope = layers.slope.data() + (throws_left - 1) * width;
+        game_.with_rules([&](const auto& rules) {
+            for (size_t k = 0; k < num_outcomes; ++k) {
+                const HitData hit = hits[k].hit;
+                Game::State next_state = rules(current, hit);
+                if (next_state == 0) {
+                    values[k] = 0.0;
+                    slopes[k] = 0.0;
+                } else if (hit.diff == 0) {
+                    values[k] = next_value[s - current];
+                    slopes[k] = next_slope[s - current];
+                } else if (next_state == current || !winable_.contains(next_state)) {
+                    values[k] = round_start_value;
+                    slopes[k] = 1.0;
                 } else {
-                    expected += prob * evaluate_dp(start_score, next_state, throws_left - 1, X_start_guess, inner_memo);
+                    values[k] = next_value[s - next_state];
+                    slopes[k] = next_slope[s - next_state];
                 }
             }
+        });
+    };
+
+    // Layer 0: the round is over
+    for (size_t index = 0; index < width && index <= s; ++index) {
+        Game::State current = s - static_cast<Game::State>(index);
+        double value = round_start_value;
+        double slope = 1.0;
+        if (current == 0) {
+            value = 0.0;
+            slope = 0.0;
+        } else if (current != s && winable_.contains(current)) {
+            value = solve(current).first;
+            slope = 0.0;
         }
-        if (prob_sum > 0) expected /= prob_sum; else expected = INFINITE_SCORE;
-            if (expected < best_expected) {
-            best_expected = expected;
+        layers.value[index] = value;
+        layers.slope[index] = slope;
+    }
+
+    // Layers 1 .. throws_per_round - 1, a state with t throws left is at most (throws_per_round - t) throws from s
+    for (unsigned int throws_left = 1; throws_left < throws_per_round_; ++throws_left) {
+        const size_t span = std::min<size_t>((throws_per_round_ - throws_left) * reach, s);
+        double* value = layers.value.data() + throws_left * width;
+        double* slope = layers.slope.data() + throws_left * width;
+        for (size_t index = 0; index <= span; ++index) {
+            Game::State current = s - static_cast<Game::State>(index);
+            if (current == 0) {
+                value[index] = 0.0;
+                slope[index] = 0.0;
+                continue;
+            }
+            fill_outcomes(current, throws_left);
+            RoundAim best = best_aim_(values);
+            value[index] = best.value;
+            slope[index] = best.value < INFINITE_SCORE ? outcome_dot_(best.aim, slopes) : 0.0;
         }
     }
 
-    inner_memo[state_key] = best_expected;
-    return best_expected;
+    fill_outcomes(s, throws_per_round_);
+    RoundAim start = best_aim_(values);
+    if (start.value < INFINITE_SCORE) start.slope = outcome_dot_(start.aim, slopes);
+    return start;
 }
 
 bool SolverMinRounds::is_valid_throw_number(unsigned int throw_number) const {
     return throw_number >= 1 && throw_number <= throws_per_round_;
 }
 
-SolverMinRounds::RoundStateKey SolverMinRounds::make_state_key(Game::State round_start_score, Game::State current_score,
-                                                                unsigned int throw_number) const {
-    return RoundStateKey{round_start_score, current_score, throw_number};
+const SolverMinRounds::RoundMemo* SolverMinRounds::find_memo_(Game::State round_start_score, Game::State current_score,
+                                                               unsigned int throw_number) const {
+    if (round_start_score >= memoization_.size() || current_score > round_start_score) return nullptr;
+    const auto& block = memoization_[round_start_score];
+    const size_t offset = (round_start_score - current_score) * throws_per_round_ + (throw_number - 1);
+    return offset < block.size() && block[offset].solved ? &block[offset] : nullptr;
+}
+
+std::pair<SolverMinRounds::Score, Vec2> SolverMinRounds::memoize_(Game::State round_start_score,
+                                                                  Game::State current_score, unsigned int throw_number,
+                                                                  std::pair<Score, Vec2> solution) {
+    if (current_score > round_start_score) return solution;
+    if (round_start_score >= memoization_.size()) memoization_.resize(round_start_score + 1);
+    auto& block = memoization_[round_start_score];
+    const size_t offset = (round_start_score - current_score) * throws_per_round_ + (throw_number - 1);
+    if (offset >= block.size()) block.resize((round_start_score - current_score + 1) * throws_per_round_);
+    block[offset] = {solution.first, solution.second, true};
+    return solution;
 }
 
 uint64_t SolverMinRounds::make_round_dp_cache_key(Game::State round_start_score, Game::State current_score,
@@ -169,49 +846,22 @@ double SolverMinRounds::evaluate_dp_cached(Game::State start_score, Game::State
     }
 
     uint64_t key = make_round_dp_cache_key(start_score, current_score, throws_left);
-    if (round_dp_cache_.contains(key)) {
-        return round_dp_cache_[key];
+    if (const double* cached = round_dp_cache_.find(key)) {
+        return *cached;
     }
 
-    double best_expected = INFINITE_SCORE;
-
-    for (const auto& aim : sample_aims_()) {
-        auto states = game_.throw_at(aim, current_score);
-        auto hits = game_.throw_at_distribution(aim);
-
-        double expected = 0.0;
-        double prob_sum = 0.0;
-        for (size_t i = 0; i < states.size(); ++i) {
-            Game::State next_state = states[i].first;
-            double prob = std::max(0.0, states[i].second); prob_sum += prob;
-            HitData hit = hits[i].first;
-
-            if (next_state == 0) {
-                expected += prob * 0.0;
-            } else if (hit.diff == 0) {
-                expected += prob * evaluate_dp_cached(start_score, current_score, throws_left - 1, round_start_value);
-            } else {
-                bool is_bust = (next_state == current_score) || (next_state != 0 && !winable_.contains(next_state));
-                if (is_bust) {
-                    expected += prob * round_start_value;
-                } else {
-                    expected += prob * evaluate_dp_cached(start_score, next_state, throws_left - 1, round_start_value);
-                }
-            }
-        }
-
-        if (prob_sum > 0) {
-            expected /= prob_sum;
-        } else {
-            expected = INFINITE_SCORE;
-        }
-
-        if (expected < best_expected) {
-            best_expected = expected;
-        }
-    }
-
-    round_dp_cache_[key] = best_expected;
+    auto value_of = [&](Game::State next_state) {
+        return evaluate_dp_cached(start_score, next_state, throws_left - 1, round_start_value);
+    };
+    const std::vector<double> values = game_.with_rules([&](const auto& rules) {
+        return outcome_values_(rules, current_score, round_start_value, value_of);
+    });
+    double best_expected = search_({INFINITE_SCORE, Vec2{0.0, 0.0}}, [&](Game::AimIndex aim) {
+        return expected_after_throw_(aim, values);
+    }).first;
+
+    round_dp_cache_.insert(key, best_expected, 0);
+    Instrumentation::record_round_dp_cache_size(round_dp_cache_.size());
     return best_expected;
 }
 
@@ -228,169 +878,172 @@ std::pair<SolverMinRounds::Score, Vec2> SolverMinRounds::solve_nonstart_round_st
         return {0.0, Vec2{0.0, 0.0}};
     }
 
-    const RoundStateKey key = make_state_key(round_start_score, current_score, throw_number);
-    if (memoization_.contains(key)) {
-        return memoization_[key];
+    if (const RoundMemo* memo = find_memo_(round_start_score, current_score, throw_number)) {
+        return {memo->score, memo->aim};
     }
 
+    Instrumentation::ScopedTimer timer(Instrumentation::Timer::SOLVE_MIN_ROUNDS);
     // Expected rounds from the start of this round, used when busting to reset.
     double round_start_value = solve(round_start_score).first;
     if (round_start_value >= INFINITE_SCORE - 1000.0) {
-        memoization_[key] = {INFINITE_SCORE, Vec2{0.0, 0.0}};
-        return memoization_[key];
+        return memoize_(round_start_score, current_score, throw_number, {INFINITE_SCORE, Vec2{0.0, 0.0}});
     }
 
+    EvaluationScope_ evaluations(*this, round_start_score);
     unsigned int throws_left_after = throws_per_round_ - throw_number;
-
-    std::pair<SolverMinRounds::Score, Vec2> best_score = {INFINITE_SCORE, Vec2{0.0, 0.0}};
-
-    for (const auto& aim : sample_aims_()) {
-        auto states = game_.throw_at(aim, current_score);
-        auto hits = game_.throw_at_distribution(aim);
-
-        double expected = 0.0;
-        double prob_sum = 0.0;
-        for (size_t i = 0; i < states.size(); ++i) {
-            Game::State next_state = states[i].first;
-            double prob = std::max(0.0, states[i].second); prob_sum += prob;
-            HitData hit = hits[i].first;
-
-            if (next_state == 0) {
-                expected += prob * 0.0;
-            } else if (hit.diff == 0) {
-                expected += prob * evaluate_dp_cached(round_start_score, current_score, throws_left_after, round_start_value);
-            } else {
-                bool is_bust = (next_state == current_score) || (next_state != 0 && !winable_.contains(next_state));
-                if (is_bust) {
-                    expected += prob * round_start_value;
-                } else {
-                    expected += prob * evaluate_dp_cached(round_start_score, next_state, throws_left_after, round_start_value);
-                }
-            }
-        }
-
-        if (prob_sum > 0) {
-            expected /= prob_sum;
-        } else {
-            expected = INFINITE_SCORE;
-        }
-
+    auto value_of = [&](Game::State next_state) {
+        return evaluate_dp_cached(round_start_score, next_state, throws_left_after, round_start_value);
+    };
+
+    const std::vector<double> values = game_.with_rules([&](const auto& rules) {
+        return outcome_values_(rules, current_score, round_start_value, value_of);
+    });
+    std::vector<float> plane(records_aim_scores_() ? aim_grid_.size() : 0);
+    std::pair<SolverMinRounds::Score, Vec2> best_score = search_({INFINITE_SCORE, Vec2{0.0, 0.0}}, [&](Game::AimIndex aim) {
         // Include the current round in the return value, matching solve(start_score).
-        expected += 1.0;
-        if (expected < best_score.first) {
-            best_score = {expected, aim};
-        }
+        const double score = expected_after_throw_(aim, values) + 1.0;
+        if (!plane.empty()) plane[aim - first_row_] = static_cast<float>(score);
+        return score;
+    });
+
+    memoize_(round_start_score, current_score, throw_number, best_score);
+    if (!plane.empty()) {
+        store_aim_scores_(make_round_dp_cache_key(round_start_score, current_score, throw_number), std::move(plane));
     }
-
-    memoization_[key] = best_score;
     return best_score;
 }
 
 std::pair<SolverMinRounds::Score, Vec2> SolverMinRounds::solve_round_start_state(Game::State s) {
-    const RoundStateKey key = make_state_key(s, s, 1);
-    if (memoization_.contains(key)) {
-        return memoization_[key];
+    if (const RoundMemo* memo = find_memo_(s, s, 1)) {
+        return {memo->score, memo->aim};
     }
 
     if (s == 0) {
         winable_.insert(0);
-        memoization_[key] = {0.0, Vec2{0.0, 0.0}};
-        return memoization_[key];
+        return memoize_(s, s, 1, {0.0, Vec2{0.0, 0.0}});
     }
 
-    // Pre-evaluate all strictly smaller states to populate winable_ and start-state memoization.
-    for (const auto& aim : sample_aims_()) {
-        auto states = game_.throw_at(aim, s);
-        for (const auto& state_prob : states) {
-            Game::State next_state = state_prob.first;
-            if (next_state < s && next_state != 0) {
-                solve(next_state);
-            }
-        }
+    if (auto stored = stored_solution_(s)) {
+        if (stored->first < INFINITE_SCORE - 1000.0) winable_.insert(s);
+        return memoize_(s, s, 1, *stored);
     }
 
-    bool has_progress_path = false;
-    for (const auto& aim : sample_aims_()) {
-        auto states = game_.throw_at(aim, s);
-        auto hits = game_.throw_at_distribution(aim);
-        for (size_t i = 0; i < states.size(); ++i) {
-            Game::State next_state = states[i].first;
-            HitData hit = hits[i].first;
-            if (next_state == 0) {
-                has_progress_path = true;
-                break;
-            }
-            if (hit.diff == 0) continue;
-            bool is_bust = (next_state == s) || (next_state != 0 && !winable_.contains(next_state));
-            if (!is_bust) {
-                has_progress_path = true;
-                break;
+    Instrumentation::ScopedTimer timer(Instrumentation::Timer::SOLVE_MIN_ROUNDS);
+    Game::OffGridScope pinned(game_); // The round layers keep the rows of polished aims
+    if (round_table_.empty()) build_round_table_();
+
+    // Solve every smaller score a round from s can end on, which also settles winable_ for them.
+    const size_t reach = static_cast<size_t>(max_points_) * throws_per_round_;
+    for (Game::State c = s > reach ? s - static_cast<Game::State>(reach) : 1; c < s; ++c) {
+        solve(c);
+    }
+    EvaluationScope_ evaluations(*this, s);
+
+    const bool has_progress_path = game_.with_rules([&](const auto& rules) {
+        for (size_t a = 0; a < aim_grid_.size(); ++a) {
+            for (const auto& outcome : game_.outcomes(first_row_ + a)) {
+                Game::State next_state = rules(s, outcome.hit);
+                HitData hit = outcome.hit;
+                if (next_state == 0) return true;
+                if (hit.diff == 0) continue;
+                bool is_bust = (next_state == s) || (next_state != 0 && !winable_.contains(next_state));
+                if (!is_bust) return true;
             }
         }
-        if (has_progress_path) break;
-    }
+        return false;
+    });
 
     if (!has_progress_path) {
-        memoization_[key] = {INFINITE_SCORE, Vec2{0.0, 0.0}};
-        return memoization_[key];
+        return memoize_(s, s, 1, {INFINITE_SCORE, Vec2{0.0, 0.0}});
     }
 
-    // Fixed-point iteration to resolve the start-of-round self-loop.
-    double current_guess = s / 20.0 + 1.0;
-    double last_guess = 0;
-    std::pair<SolverMinRounds::Score, Vec2> best_score = {INFINITE_SCORE, Vec2{0.0, 0.0}};
-    int iterations = 0;
-
-    while (std::abs(current_guess - last_guess) > EPSILON && iterations < 50) {
-        last_guess = current_guess;
-        double best_expected = INFINITE_SCORE;
-        Vec2 best_aim{0.0, 0.0};
-
-        std::unordered_map<unsigned int, double> inner_memo;
-
-        for (const auto& aim : sample_aims_()) {
-            auto states = game_.throw_at(aim, s);
-            auto hits = game_.throw_at_distribution(aim);
+    // Newton's method on g(X) = 1 + F(X) - X, where F(X) is the best first throw when a bust is worth X.
+    // F is concave and piecewise linear, so after the first step the iterates decrease monotonically
+    // to the root and stop once the policy no longer changes. A slope of 1 below the root means every
+    // best aim busts for certain, the guess is then raised until busting costs more than progress.
+    RoundLayers layers;
+    layers.width = std::min<size_t>(static_cast<size_t>(max_points_) * throws_per_round_, s) + 1;
+    layers.value.assign(throws_per_round_ * layers.width, 0.0);
+    layers.slope.assign(throws_per_round_ * layers.width, 0.0);
+
+    double guess = s / 20.0 + 1.0;
+    if (auto warm = warm_values_.find(s); warm != warm_values_.end()) {
+        guess = warm->second;
+        warm_values_.erase(warm);
+    }
+    RoundAim start;
+    bool converged = false;
+    [[maybe_unused]] double delta = 0.0;
+    int iteration = 0;
+    while (iteration < MAX_ROUND_ITERATIONS && !converged) {
+        ++iteration;
+        Instrumentation::count(Instrumentation::Counter::ROUND_ITERATIONS);
+        start = evaluate_round_(s, guess, layers);
+        // Still below the root at an absurd number of rounds, the state cannot be finished in practice
+        if (!(start.value < INFINITE_SCORE) || (guess > 1e4 && 1.0 + start.value > guess)) {
+            start.value = INFINITE_SCORE;
+            break;
+        }
+        double next_guess = start.slope < 1.0 - NEWTON_TOLERANCE
+            ? (1.0 + start.value - start.slope * guess) / (1.0 - start.slope)
+            : INFINITE_SCORE;
+        if (1.0 + start.value > guess) {
+            // Below the root a nearly flat F overshoots wildly, grow the guess at most geometrically instead
+            next_guess = std::min(next_guess, std::max(1.0 + start.value, 2.0 * guess));
+        }
+        delta = std::abs(next_guess - guess) / std::max(1.0, std::abs(guess));
+        converged = delta <= NEWTON_TOLERANCE;
+        guess = next_guess;
+    }
+    Instrumentation::record_round_convergence(s, static_cast<unsigned int>(iteration), delta);
 
-            double expected = 0.0;
-            double prob_sum = 0.0;
-            for (size_t i = 0; i < states.size(); ++i) {
-                Game::State next_state = states[i].first;
-                double prob = std::max(0.0, states[i].second); prob_sum += prob;
-                HitData hit = hits[i].first;
+    std::pair<SolverMinRounds::Score, Vec2> best_score = {INFINITE_SCORE, Vec2{0.0, 0.0}};
+    if (start.value < INFINITE_SCORE) {
+        best_score = {start.value + 1.0, start.point};
+        // The last pass left the first throw's value of every aim in aim_scores_, within the Newton tolerance of X
+        if (records_aim_scores_()) {
+            std::vector<float> plane(aim_scores_.size());
+            for (size_t a = 0; a < plane.size(); ++a) plane[a] = static_cast<float>(aim_scores_[a] + 1.0);
+            store_aim_scores_(aim_score_key_(s), std::move(plane));
+        }
+    }
 
-                if (next_state == 0) {
-                    expected += prob * 0.0;
-                } else if (hit.diff == 0) {
-                    expected += prob * evaluate_dp(s, s, throws_per_round_ - 1, current_guess, inner_memo);
-                } else {
-                    bool is_bust = (next_state == s) || (next_state != 0 && !winable_.contains(next_state));
-                    if (is_bust) {
-                        expected += prob * current_guess;
-                    } else {
-                        expected += prob * evaluate_dp(s, next_state, throws_per_round_ - 1, current_guess, inner_memo);
-                    }
+    if (best_score.first > 1e4) { best_score.first = INFINITE_SCORE; }
+    if (best_score.first < INFINITE_SCORE - 1000.0) winable_.insert(s);
+    // After convergence the layers hold X to within the Newton tolerance, mid-round queries from s reuse them.
+    // A pass cut off by MAX_ROUND_ITERATIONS was evaluated at a guess that may be far from X, those
+    // queries then solve their states on their own.
+    if (converged && best_score.first < INFINITE_SCORE - 1000.0) {
+        for (unsigned int throws_left = 1; throws_left < throws_per_round_; ++throws_left) {
+            // The span evaluate_round_() filled, without current score 0 which never reaches the cache
+            const size_t span = std::min<size_t>((throws_per_round_ - throws_left) * max_points_, s);
+            for (size_t index = 0; index <= span && index < s; ++index) {
+                Game::State current = s - static_cast<Game::State>(index);
+                const uint64_t key = make_round_dp_cache_key(s, current, throws_left);
+                if (!round_dp_cache_.contains(key)) {
+                    round_dp_cache_.insert(key, layers.value[throws_left * layers.width + index], 0);
                 }
             }
-
-            if (prob_sum > 0) expected /= prob_sum; else expected = INFINITE_SCORE;
-            if (expected < best_expected) {
-                best_expected = expected;
-                best_aim = aim;
-            }
         }
-
-        current_guess = best_expected + 1.0;
-        best_score = {current_guess, best_aim};
-        iterations++;
+        Instrumentation::record_round_dp_cache_size(round_dp_cache_.size());
     }
+    return memoize_(s, s, 1, best_score);
+}
 
-    if (best_score.first > 1e4) { best_score.first = INFINITE_SCORE; }
-    if (best_score.first < INFINITE_SCORE - 1000.0) {
-        winable_.insert(s);
+void SolverMinRounds::warm_start() {
+    // Entry 0 of a start's block is the start of the round
+    for (Game::State s = 1; s < memoization_.size(); ++s) {
+        const auto& block = memoization_[s];
+        if (!block.empty() && block[0].solved && block[0].score < INFINITE_SCORE - 1000.0) {
+            warm_values_[s] = block[0].score;
+        }
     }
-    memoization_[key] = best_score;
-    return best_score;
+    memoization_.clear();
+    winable_.clear();
+    round_dp_cache_.clear();
+    aim_score_planes_.clear();
+    round_table_.clear();
+    drop_stale_solution_table_();
 }
 
 SolverMinRounds::Score SolverMinRounds::solve_aim(Game::State s, Vec2 aim) {
@@ -409,6 +1062,7 @@ SolverMinRounds::Score SolverMinRounds::solve_aim_round_state(Game::State round_
     if (current_score == 0) {
         return 0.0;
     }
+    Game::OffGridScope pinned(game_);
 
     // Ensure both the round start score and current score are solved from round start
     // before evaluating bust/winnable transitions.
@@ -419,38 +1073,64 @@ SolverMinRounds::Score SolverMinRounds::solve_aim_round_state(Game::State round_
     }
 
     unsigned int throws_left_after = throws_per_round_ - throw_number;
+    auto value_of = [&](Game::State next_state) {
+        return evaluate_dp_cached(round_start_score, next_state, throws_left_after, round_start_value);
+    };
+    const Game::AimIndex index = game_.aim_index(aim);
+    const std::vector<double> values = game_.with_rules([&](const auto& rules) {
+        return outcome_values_(rules, current_score, round_start_value, value_of);
+    });
+    return expected_after_throw_(index, values) + 1.0;
+}
 
-    auto states = game_.throw_at(aim, current_score);
-    auto hits = game_.throw_at_distribution(aim);
-
-    double expected = 0.0;
-    double prob_sum = 0.0;
-    for (size_t i = 0; i < states.size(); ++i) {
-        Game::State next_state = states[i].first;
-        double prob = std::max(0.0, states[i].second); prob_sum += prob;
-        HitData hit = hits[i].first;
-
-        if (next_state == 0) {
-            expected += prob * 0.0;
-        } else if (hit.diff == 0) {
-            expected += prob * evaluate_dp_cached(round_start_score, current_score, throws_left_after, round_start_value);
-        } else {
-            bool is_bust = (next_state == current_score) || (next_state != 0 && !winable_.contains(next_state));
-            if (is_bust) {
-                expected += prob * round_start_value;
-            } else {
-                expected += prob * evaluate_dp_cached(round_start_score, next_state, throws_left_after, round_start_value);
-            }
+HeatMap SolverMinRounds::heat_map(Game::State round_start_score, Game::State current_score, unsigned int throw_number,
+                                  size_t rows, size_t cols, size_t num_threads) {
+    if (!is_valid_throw_number(throw_number)) return HeatMap(rows, cols, INFINITE_SCORE);
+    if (current_score == 0) return HeatMap(rows, cols, 0.0);
+    if (retain_aim_scores_) {
+        (void)solve_round_state(round_start_score, current_score, throw_number);
+        if (auto retained = retained_heat_map_round_state(round_start_score, current_score, throw_number,
+                                                          game_.get_target_bounds(), rows, cols)) {
+            return std::move(*retained);
         }
     }
 
-    if (prob_sum > 0) {
-        expected /= prob_sum;
-    } else {
-        expected = INFINITE_SCORE;
+    // Cells share no rows even under a small outcome table budget, the table is trimmed back on return
+    Game::OffGridScope pinned(game_);
+    // Everything solve_aim_round_state() does before looking at the aim, once for every cell
+    double round_start_value = solve(round_start_score).first;
+    solve(current_score);
+    if (round_start_value >= INFINITE_SCORE - 1000.0) return HeatMap(rows, cols, INFINITE_SCORE);
+    Instrumentation::ScopedTimer timer(Instrumentation::Timer::HEAT_MAPS);
+    unsigned int throws_left_after = throws_per_round_ - throw_number;
+    auto value_of = [&](Game::State next_state) {
+        return evaluate_dp_cached(round_start_score, next_state, throws_left_after, round_start_value);
+    };
+    const std::vector<double> values = game_.with_rules([&](const auto& rules) {
+        return outcome_values_(rules, current_score, round_start_value, value_of);
+    });
+
+    // Rows of the cell centres are looked up and compiled here, the parallel loop only reads them
+    const auto [min_point, max_point] = game_.get_target_bounds();
+    std::vector<Game::AimIndex> aims(rows * cols);
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t c = 0; c < cols; ++c) {
+            double x = min_point.x + (max_point.x - min_point.x) * (c + 0.5) / cols;
+            double y = min_point.y + (max_point.y - min_point.y) * (r + 0.5) / rows;
+            aims[r * cols + c] = game_.aim_index(Vec2{x, y});
+            (void)game_.outcomes(aims[r * cols + c]);
+        }
     }
 
-    return expected + 1.0;
+    HeatMap result(rows, cols);
+    ThreadPool pool(num_threads);
+    pool.for_chunks(aims.size(), [&](size_t, size_t begin, size_t end) {
+        for (size_t cell = begin; cell < end; ++cell) {
+            result.data()[cell] = expected_after_throw_(aims[cell], values) + 1.0;
+        }
+    });
+    Instrumentation::count(Instrumentation::Counter::HEAT_MAP_CELLS, aims.size());
+    return result;
 }
 
 std::pair<SolverMinRounds::Score, Vec2> SolverMinRounds::solve_round_state(Game::State round_start_score,
@@ -471,7 +1151,7 @@ std::pair<SolverMinRounds::Score, Vec2> SolverMinRounds::solve_round_state(Game:
     return solve_nonstart_round_state(round_start_score, current_score, throw_number);
 }
 
-MaxPointsSolver::Score MaxPointsSolver::solve_aim(Game::State s, Vec2 aim) {
+double MaxPointsSolver::expected_points_(Game::State s, Game::AimIndex aim) const {
     auto states = game_.throw_at(aim, s);
     MaxPointsSolver::Score expected = 0;
 
@@ -483,35 +1163,146 @@ MaxPointsSolver::Score MaxPointsSolver::solve_aim(Game::State s, Vec2 aim) {
     return expected;
 }
 
+MaxPointsSolver::Score MaxPointsSolver::solve_aim(Game::State s, Vec2 aim) {
+    return expected_points_(s, game_.aim_index(aim));
+}
+
 std::pair<MaxPointsSolver::Score, Vec2> MaxPointsSolver::solve(Game::State s) {
-    std::pair<MaxPointsSolver::Score, Vec2> best_score = {MaxPointsSolver::LOWEST_SCORE, Vec2{0.0, 0.0}};
+    if (auto stored = stored_solution_(s)) return *stored;
+    EvaluationScope_ evaluations(*this, s);
+    std::vector<float> plane(records_aim_scores_() ? aim_grid_.size() : 0);
+    // search_() minimises, so search the negated points
+    auto [negated, aim] = search_({-LOWEST_SCORE, Vec2{0.0, 0.0}}, [&](Game::AimIndex row) {
+        const Score points = expected_points_(s, row);
+        if (!plane.empty()) plane[row - first_row_] = static_cast<float>(points);
+        return -points;
+    });
+    if (!plane.empty()) store_aim_scores_(aim_score_key_(s), std::move(plane));
+    return {-negated, aim};
+}
+
+uint64_t SolverMinThrows::solution_key() const {
+    return SolutionKeyHasher(Solver::solution_key()).add(std::string_view("SolverMinThrows")).value();
+}
+
+uint64_t SolverMinRounds::solution_key() const {
+    return SolutionKeyHasher(Solver::solution_key()).add(std::string_view("SolverMinRounds"))
+        .add(static_cast<uint64_t>(throws_per_round_)).value();
+}
+
+uint64_t MaxPointsSolver::solution_key() const {
+    return SolutionKeyHasher(Solver::solution_key()).add(std::string_view("MaxPointsSolver")).value();
+}
 
-    for (const auto& aim : Solver::sample_aims_()) {
-        MaxPointsSolver::Score score = solve_aim(s, aim);
-        if (score > best_score.first) {
-            best_score = {score, aim};
+ProgressiveHeatMap::ProgressiveHeatMap(Game::Bounds bounds, size_t rows, size_t cols, Evaluator evaluate,
+                                       std::span<const size_t> coarse_sizes, Completion on_complete)
+    : bounds_(bounds), evaluate_(std::move(evaluate)), on_complete_(std::move(on_complete)),
+      map_(rows, cols), evaluated_(rows * cols, false) {
+    for (size_t n : coarse_sizes) {
+        if (n == 0) continue;
+        const Pass pass{std::max<size_t>(1, (rows + n - 1) / n), std::max<size_t>(1, (cols + n - 1) / n)};
+        const bool refines = passes_.empty()
+            || (pass.row_stride <= passes_.back().row_stride && pass.col_stride <= passes_.back().col_stride
+                && (pass.row_stride < passes_.back().row_stride || pass.col_stride < passes_.back().col_stride));
+        if (refines && (pass.row_stride > 1 || pass.col_stride > 1)) passes_.push_back(pass);
+    }
+    passes_.push_back(Pass{1, 1});
+}
+
+ProgressiveHeatMap::ProgressiveHeatMap(HeatMap finished)
+    : map_(std::move(finished)), cells_done_(map_.size()) {}
+
+bool ProgressiveHeatMap::step(size_t max_cells, const CancellationToken* cancel) {
+    pass_finished_ = false;
+    if (is_done()) return true;
+    Instrumentation::ScopedTimer timer(Instrumentation::Timer::HEAT_MAPS);
+
+    const Pass& pass = passes_[pass_];
+    const size_t rows = map_.rows();
+    const size_t cols = map_.cols();
+    const auto [min_point, max_point] = bounds_;
+    while (next_cell_ < map_.size()) {
+        const size_t r = next_cell_ / cols;
+        const size_t c = next_cell_ % cols;
+        if (r % pass.row_stride != 0) {
+            next_cell_ = (r + 1) * cols;
+            continue;
         }
+        if (c % pass.col_stride == 0 && !evaluated_[next_cell_]) {
+            if (max_cells == 0 || (cancel != nullptr && cancel->is_cancelled())) return false;
+            double x = min_point.x + (max_point.x - min_point.x) * (c + 0.5) / cols;
+            double y = min_point.y + (max_point.y - min_point.y) * (r + 0.5) / rows;
+            map_(r, c) = evaluate_(Vec2{x, y});
+            Instrumentation::count(Instrumentation::Counter::HEAT_MAP_CELLS);
+            evaluated_[next_cell_] = true;
+            ++cells_done_;
+            --max_cells;
+        }
+        ++next_cell_;
     }
+    finish_pass_();
+    return is_done();
+}
 
-    return best_score;
+void ProgressiveHeatMap::fill_preview_(const Pass& pass) {
+    for (size_t r = 0; r < map_.rows(); ++r) {
+        for (size_t c = 0; c < map_.cols(); ++c) {
+            if (!evaluated_[r * map_.cols() + c]) {
+                map_(r, c) = map_(r - r % pass.row_stride, c - c % pass.col_stride);
+            }
+        }
+    }
 }
 
-[[nodiscard]] HeatMapVisualizer::HeatMap HeatMapVisualizer::heat_map(Game::State s) {
-    if (heat_map_memo_.contains(s)) {
-        return heat_map_memo_[s];
+void ProgressiveHeatMap::finish_pass_() {
+    if (pass_ + 1 < passes_.size()) fill_preview_(passes_[pass_]);
+    ++pass_;
+    next_cell_ = 0;
+    pass_finished_ = true;
+    if (is_done() && on_complete_) on_complete_(map_);
+}
+
+void HeatMapVisualizer::memoize_(Game::State s, const HeatMap& heat_map) {
+    std::vector<float> plane(heat_map.values().begin(), heat_map.values().end());
+    const size_t bytes = plane.size() * sizeof(float);
+    heat_map_memo_.insert(s, std::move(plane), bytes);
+}
+
+ProgressiveHeatMap HeatMapVisualizer::progressive(Game::State s, std::span<const size_t> coarse_sizes) {
+    if (const std::vector<float>* plane = heat_map_memo_.find(s)) {
+        HeatMap heat_map(grid_height_, grid_width_);
+        std::copy(plane->begin(), plane->end(), heat_map.data());
+        return ProgressiveHeatMap(std::move(heat_map));
     }
-    HeatMap heat_map(grid_height_, std::vector<typename SolverMinThrows::Score>(grid_width_, 0.0));
 
-    auto [min_point, max_point] = target_bounds_;
+    if (const SolutionTable* table = solver_.get_solution_table(); table != nullptr && table->has_planes(grid_height_, grid_width_)) {
+        if (auto plane = table->plane(s); !plane.empty()) {
+            // Planes use the same row-major layout
+            HeatMap heat_map(grid_height_, grid_width_);
+            std::copy(plane.begin(), plane.end(), heat_map.data());
+            memoize_(s, heat_map);
+            return ProgressiveHeatMap(std::move(heat_map));
+        }
+    }
 
-    for (size_t i = 0; i < grid_width_; ++i) {
-        for (size_t j = 0; j < grid_height_; ++j) {
-            double x = min_point.x + (max_point.x - min_point.x) * (i + 0.5) / grid_width_;
-            double y = min_point.y + (max_point.y - min_point.y) * (j + 0.5) / grid_height_;
-            heat_map[j][i] = solver_.solve_aim(s, Vec2{x, y});
+    if (solver_.get_retain_aim_scores()) {
+        (void)solver_.solve(s); // Retains the plane of s unless it is solved already
+        if (auto heat_map = solver_.retained_heat_map(s, target_bounds_, grid_height_, grid_width_)) {
+            memoize_(s, *heat_map);
+            return ProgressiveHeatMap(std::move(*heat_map));
         }
     }
 
-    heat_map_memo_[s] = heat_map;
-    return heat_map;
+    return ProgressiveHeatMap(
+        target_bounds_, grid_height_, grid_width_,
+        [this, s](Vec2 aim) { return solver_.solve_aim(s, aim); },
+        coarse_sizes,
+        [this, s](const HeatMap& heat_map) { memoize_(s, heat_map); });
+}
+
+[[nodiscard]] HeatMapVisualizer::HeatMap HeatMapVisualizer::heat_map(Game::State s) {
+    // A single full-resolution pass is the plain row-major sweep
+    ProgressiveHeatMap job = progressive(s, {});
+    job.step();
+    return job.result();
 }
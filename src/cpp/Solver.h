@@ -3,7 +3,15 @@
 
 #include "Geometry.h"
 #include "Game.h"
+#include "Instrumentation.h"
+#include "LruCache.h"
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
 #include <unordered_set>
 #include <vector>
 #include <unordered_map>
@@ -19,6 +27,94 @@
  * - HeatMapVisualizer: Visualize solver output across the target
  */
 
+class SolutionTable;
+
+/**
+ * @brief How a solver searches for the best aim of a state.
+ * @ingroup solver
+ *
+ * EXHAUSTIVE evaluates every aim of the solver's grid, in index order.
+ *
+ * COARSE_TO_FINE treats the grid as the finest level of a hierarchy:
+ * 1. Evaluate a coarse subgrid of about coarse_aims aims (every stride-th column and row)
+ * 2. Keep the keep best aims evaluated so far
+ * 3. Halve the stride and evaluate the 8 neighbours of every kept aim at the new stride
+ * 4. Repeat 2-3 until the stride is 1, then polish the best aim off the grid with a
+ *    compass search, starting at half the grid spacing and halving polish_steps times
+ *
+ * All levels except the polish reuse the grid's outcome rows, so the game (and a
+ * HitProbabilityField) still compute each outcome row once. On a 100 x 100 grid the
+ * defaults evaluate roughly 700 aims per state instead of 10000.
+ *
+ * Example usage:
+ * @code
+ * SolverMinThrows solver(game, 10000, SearchPolicy::coarse_to_fine());
+ * @endcode
+ */
+struct SearchPolicy {
+    enum class Mode {
+        EXHAUSTIVE,     ///< Every aim of the grid
+        COARSE_TO_FINE  ///< Coarse subgrid, refinement around the best aims, local polish
+    };
+
+    Mode mode = Mode::EXHAUSTIVE;
+    size_t coarse_aims = 400;      ///< Aims of the coarse level, the stride is derived from it
+    size_t keep = 8;               ///< Aims refined per level
+    unsigned int polish_steps = 3; ///< Step halvings of the off-grid polish, 0 to stay on the grid
+    /**
+     * Stop evaluating an aim once a lower bound on its score exceeds the best so far
+     * (SolverMinThrows). Only aims that cannot win are skipped, so results are unchanged.
+     */
+    bool prune = false;
+
+    [[nodiscard]] static SearchPolicy exhaustive(bool prune = false) {
+        SearchPolicy policy;
+        policy.prune = prune;
+        return policy;
+    }
+    [[nodiscard]] static SearchPolicy coarse_to_fine(size_t coarse_aims = 400, size_t keep = 8,
+                                                     unsigned int polish_steps = 3, bool prune = false) {
+        return {Mode::COARSE_TO_FINE, coarse_aims, keep, polish_steps, prune};
+    }
+};
+
+/**
+ * @brief Grid of scores over the target in one contiguous row-major array.
+ * @ingroup solver
+ *
+ * Cell (r, c) is at data()[r * cols() + c]. The bindings hand data() to JS as a
+ * Float64Array view, so a map crosses into JS without walking nested vectors.
+ */
+class HeatMap {
+private:
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    std::vector<double> values_;
+
+public:
+    HeatMap() = default;
+    HeatMap(size_t rows, size_t cols, double value = 0.0) : rows_(rows), cols_(cols), values_(rows * cols, value) {}
+
+    [[nodiscard]] size_t rows() const { return rows_; }
+    [[nodiscard]] size_t cols() const { return cols_; }
+    /** @brief Number of cells, rows() * cols(). */
+    [[nodiscard]] size_t size() const { return values_.size(); }
+
+    [[nodiscard]] double& operator()(size_t r, size_t c) { return values_[r * cols_ + c]; }
+    [[nodiscard]] double operator()(size_t r, size_t c) const { return values_[r * cols_ + c]; }
+
+    /** @brief Row r, so map[r][c] works as it did for nested vectors. */
+    [[nodiscard]] std::span<double> operator[](size_t r) { return std::span(values_).subspan(r * cols_, cols_); }
+    [[nodiscard]] std::span<const double> operator[](size_t r) const { return std::span(values_).subspan(r * cols_, cols_); }
+
+    [[nodiscard]] double* data() { return values_.data(); }
+    [[nodiscard]] const double* data() const { return values_.data(); }
+    /** @brief All cells in row-major order. */
+    [[nodiscard]] std::span<const double> values() const { return values_; }
+
+    [[nodiscard]] bool operator==(const HeatMap& other) const = default;
+};
+
 /**
  * @brief Abstract base class for dart throwing solvers.
  * @ingroup solver
@@ -28,13 +124,106 @@
 class Solver {
 public:
     using Score = double; ///< Expected number of throws
+    static constexpr size_t DEFAULT_AIM_SCORE_BUDGET = size_t{64} << 20; ///< Bytes of retained planes, see set_retain_aim_scores()
 
 protected:
-    /** @brief Generate uniform grid of aim points over target bounds. */
-    std::vector<Vec2> sample_aims_() const;
-
     const size_t num_samples_;  ///< Number of aim points to sample
     const Game& game_;
+    const AimGrid& aim_grid_;        ///< Uniform grid of aim points over target bounds, shared through the game
+    const Game::AimIndex first_row_; ///< Outcome table row of aim_grid_[0]
+    SearchPolicy search_policy_;
+    size_t aim_evaluations_ = 0;     ///< Objective evaluations made by search_()
+    size_t pruned_aims_ = 0;         ///< Evaluations stopped early by branch and bound
+    size_t attributed_evaluations_ = 0; ///< Evaluations already counted for a state, see EvaluationScope_
+    std::shared_ptr<const SolutionTable> solution_table_; ///< Preloaded solutions, see use_solution_table()
+    bool retain_aim_scores_ = false;
+    LruCache<uint64_t, std::vector<float>> aim_score_planes_{DEFAULT_AIM_SCORE_BUDGET}; ///< Score per grid aim, in index order
+
+    static constexpr size_t SEED_STRIDE_ = 4; ///< Column and row stride of the subgrid that seeds pruning
+
+    /** @brief Grid indices of every SEED_STRIDE_-th column and row, evaluated first when pruning. */
+    [[nodiscard]] std::vector<size_t> seed_aims_() const;
+
+    /**
+     * @brief Find the aim with the lowest objective(row) according to the search policy.
+     *
+     * objective receives the game's outcome row of an aim. An aim replaces the current
+     * best only with a strictly lower score, so ties go to the lowest grid index and
+     * best is returned unchanged when no aim beats it.
+     *
+     * If objective also accepts a second Score argument it is passed the score to beat,
+     * and may return any value that is not lower as soon as it knows the aim cannot
+     * beat it. EXHAUSTIVE then evaluates seed_aims_() first so the bound is tight early.
+     * The coarse levels of COARSE_TO_FINE pass infinity, since they rank aims.
+     *
+     * @param best Score and aim to beat
+     * @param objective Callable Score(Game::AimIndex) or Score(Game::AimIndex, Score)
+     */
+    template <typename Objective>
+    [[nodiscard]] std::pair<Score, Vec2> search_(std::pair<Score, Vec2> best, Objective&& objective);
+
+    /**
+     * @brief search_() restricted to the grid aims within radius columns and rows of center, in index order.
+     * Warm starts use it around a state's previous best aim. With a bound-aware objective the
+     * aim nearest to center is evaluated first and seeds the bound, like seed_aims_() does.
+     */
+    template <typename Objective>
+    [[nodiscard]] std::pair<Score, Vec2> search_near_(Vec2 center, size_t radius, std::pair<Score, Vec2> best,
+                                                      Objective&& objective);
+
+    /**
+     * @brief Counts the aim evaluations of one state solve into Instrumentation.
+     * Evaluations of states solved recursively inside the scope count for those states only.
+     * Without DARTS_INSTRUMENTATION it does nothing.
+     */
+    class EvaluationScope_ {
+    private:
+        Solver& solver_;
+        Game::State state_;
+        size_t evaluations_before_;
+        size_t attributed_before_;
+
+    public:
+        EvaluationScope_(Solver& solver, Game::State state)
+            : solver_(solver), state_(state), evaluations_before_(solver.aim_evaluations_),
+              attributed_before_(solver.attributed_evaluations_) {}
+        ~EvaluationScope_() {
+            if constexpr (Instrumentation::ENABLED) {
+                const size_t own = (solver_.aim_evaluations_ - evaluations_before_)
+                                 - (solver_.attributed_evaluations_ - attributed_before_);
+                solver_.attributed_evaluations_ += own;
+                Instrumentation::count(Instrumentation::Counter::AIM_EVALUATIONS, own);
+                Instrumentation::record_state_evaluations(state_, own);
+            }
+        }
+        EvaluationScope_(const EvaluationScope_&) = delete;
+        EvaluationScope_& operator=(const EvaluationScope_&) = delete;
+    };
+
+    /** @brief Score and aim of s from the solution table, if there is one and it stores s. */
+    [[nodiscard]] std::optional<std::pair<Score, Vec2>> stored_solution_(Game::State s) const;
+
+    /** @brief Stop using a solution table whose key no longer matches, e.g. after the distribution changed. */
+    void drop_stale_solution_table_();
+
+    /** @brief Whether the next exhaustive search should record the score of every grid aim. */
+    [[nodiscard]] bool records_aim_scores_() const {
+        return retain_aim_scores_ && search_policy_.mode == SearchPolicy::Mode::EXHAUSTIVE;
+    }
+
+    /** @brief Retain the scores of every grid aim of the state with the given key. */
+    void store_aim_scores_(uint64_t key, std::vector<float> plane);
+
+    /** @brief Key of the plane of s, derived solvers with several planes per state override it. */
+    [[nodiscard]] virtual uint64_t aim_score_key_(Game::State s) const { return s; }
+
+    /**
+     * @brief Heat map over bounds from the plane with the given key, nullopt if it is not retained.
+     * Cell centres that are grid aims read their score directly, others interpolate bilinearly
+     * between the four nearest grid aims, clamped at the outermost columns and rows.
+     */
+    [[nodiscard]] std::optional<HeatMap> resample_aim_scores_(uint64_t key, Game::Bounds bounds, size_t rows,
+                                                              size_t cols);
 
 public:
     /**
@@ -42,14 +231,74 @@ public:
      * @param game Game rules and target
      * @param num_samples Number of aim points to evaluate (default 10000)
      *                    More samples = better solution but slower
+     * @param search_policy How the aims of each state are searched
      */
-    Solver(const Game& game, size_t num_samples = 10000)
-        : num_samples_(num_samples), game_(game) {}
+    Solver(const Game& game, size_t num_samples = 10000, SearchPolicy search_policy = {})
+        : num_samples_(num_samples), game_(game), aim_grid_(game.aim_grid(num_samples)),
+          first_row_(game.first_row(aim_grid_)), search_policy_(search_policy) {}
 
     virtual ~Solver() = default;
     [[nodiscard]] virtual std::pair<double, Vec2> solve(Game::State s) = 0;
     [[nodiscard]] virtual double solve_aim(Game::State s, Vec2 aim) = 0;
     [[nodiscard]] const Game& get_game() const { return game_; }
+    [[nodiscard]] const AimGrid& get_aim_grid() const { return aim_grid_; }
+    [[nodiscard]] const SearchPolicy& get_search_policy() const { return search_policy_; }
+    /** @brief Change the search policy, states already memoized keep their result. */
+    void set_search_policy(SearchPolicy search_policy) { search_policy_ = search_policy; }
+    /** @brief Number of aims evaluated while searching so far, for comparing policies. */
+    [[nodiscard]] size_t get_aim_evaluations() const { return aim_evaluations_; }
+    /** @brief Number of those evaluations that branch and bound stopped early. */
+    [[nodiscard]] size_t get_pruned_aims() const { return pruned_aims_; }
+
+    /**
+     * @brief Hash of everything the solver's results depend on, the key of its SolutionTable files.
+     * Covers the target's beds, the distribution, the game rules, the aim grid and the search
+     * policy (except prune, which does not change results). Derived solvers add their type and parameters.
+     */
+    [[nodiscard]] virtual uint64_t solution_key() const;
+
+    /**
+     * @brief Serve solve() from a table written for the same configuration.
+     * Stored states are returned without searching; other states are solved as usual
+     * and may build on the stored ones. Pass nullptr to stop using a table.
+     * @throws std::invalid_argument if the table's key differs from solution_key()
+     */
+    void use_solution_table(std::shared_ptr<const SolutionTable> table);
+    [[nodiscard]] const SolutionTable* get_solution_table() const { return solution_table_.get(); }
+
+    /**
+     * @brief Keep the score of every grid aim that solving a state computes.
+     *
+     * An exhaustive search evaluates every aim of the grid for a state and normally keeps
+     * only the best. With retention the scores are kept as a float plane per state, and
+     * retained_heat_map() turns them into a heat map without evaluating any aim again.
+     * Pruning is skipped while retention is on, since pruned aims have no score; coarse to
+     * fine searches and warm-started states evaluate only some aims and retain nothing.
+     * Turning retention off drops the planes.
+     */
+    void set_retain_aim_scores(bool retain);
+    [[nodiscard]] bool get_retain_aim_scores() const { return retain_aim_scores_; }
+
+    /**
+     * @brief Bytes the retained planes may hold, 0 for no limit.
+     * A plane takes 4 bytes per grid aim, the least recently used are evicted when full.
+     */
+    void set_aim_score_budget(size_t bytes) { aim_score_planes_.set_budget(bytes); }
+    [[nodiscard]] CacheUsage get_aim_score_usage() const { return aim_score_planes_.usage(); }
+
+    /** @brief Evict least recently used planes until at most max_bytes are held. Returns the bytes freed. */
+    size_t trim_aim_scores(size_t max_bytes) { return aim_score_planes_.trim(max_bytes); }
+
+    /**
+     * @brief Heat map of s from its retained plane, nullopt if there is none.
+     * Cells are placed as in HeatMapVisualizer. When rows, cols and bounds match the aim grid
+     * every cell is the score of its grid aim, rounded to float; otherwise cells are
+     * interpolated bilinearly between grid aims, an approximation of solve_aim().
+     */
+    [[nodiscard]] std::optional<HeatMap> retained_heat_map(Game::State s, Game::Bounds bounds, size_t rows,
+                                                           size_t cols) {
+        return resample_aim_scores_(aim_score_key_(s), bounds, rows, cols);
+    }
 };
  
 /**
@@ -61,7 +310,7 @@ public:
  * Takes into account future game states when evaluating aim points.
  *
  * Algorithm:
- * 1. Sample aim points uniformly over target bounds
+ * 1. Sample aim points uniformly over target bounds (the game's shared AimGrid)
  * 2. For each aim, compute expected throws using state transition probabilities
  * 3. Use dynamic programming: solve(s) = min over aims of (1 + expected future throws)
  * 4. Memoize results for efficiency
@@ -79,8 +328,58 @@ private:
     static constexpr double EPSILON = 1e-9;
     static constexpr double INFINITE_SCORE = 1e9;  ///< Penalty for unreachable states
 
+    static constexpr double PRUNE_TOLERANCE = 1e-12;  ///< Relative slack so rounding never prunes a winner
+
+public:
+    static constexpr size_t WARM_START_RADIUS = 3;    ///< Default search radius of warm_start(), in grid cells
+
+private:
+
     std::unordered_map<Game::State, std::pair<Score, Vec2>> memoization_;
-    std::unordered_set<Game::State> winable_;
+    std::unordered_set<Game::State> winable_ = {0};
+    std::vector<std::vector<uint16_t>> outcome_order_; ///< Per outcome table row, indices by descending probability
+    std::unordered_map<Game::State, Vec2> warm_aims_;  ///< Best aims before warm_start() of states not solved since
+    size_t warm_radius_ = WARM_START_RADIUS;
+
+    /**
+     * @brief Successor scores of one state, indexed like the game's outcome list.
+     * A negative value marks outcomes that leave the state unchanged or lead to an unwinable state.
+     */
+    struct Successors {
+        std::vector<Score> score;
+        Score lowest = INFINITE_SCORE; ///< Lowest non-negative entry of score
+    };
+
+    template <typename Rules, typename ScoreOf>
+    [[nodiscard]] Successors successors_(const Rules& rules, Game::State s, ScoreOf&& score_of) const;
+
+    /** @brief Outcome indices of row aim sorted by descending probability, computed on first use. */
+    const std::vector<uint16_t>& outcome_order_of_(Game::AimIndex aim);
+
+    /**
+     * @brief Branch and bound pass over the outcomes of aim in order of probability.
+     *
+     * With E the expected successor score and q the stuck probability of the outcomes
+     * seen so far, and r the remaining probability, the final score is at least
+     * (1 + E + r * lowest) / (1 - q): moving remaining mass to stuck outcomes only
+     * raises it. Returns true as soon as that bound exceeds to_beat.
+     */
+    [[nodiscard]] bool prunable_(Game::AimIndex aim, const std::vector<uint16_t>& order,
+                                 const Successors& successors, Score to_beat) const;
+
+    /**
+     * @brief Expected throws from s when aiming at aim, with successor scores taken from score_of.
+     * Shared by solve_aim() and solve_all() so both paths perform identical arithmetic.
+     * Instantiated per rule type of Game::with_rules().
+     */
+    template <typename Rules, typename ScoreOf>
+    [[nodiscard]] Score expected_throws_(const Rules& rules, Game::State s, Game::AimIndex aim, ScoreOf&& score_of) const;
+
+    /**
+     * @brief Score of an already solved state, without touching the memo.
+     * @throws std::logic_error if s has not been solved yet
+     */
+    [[nodiscard]] Score solved_score_(Game::State s) const;
 
 public:
     using Solver::Solver;
@@ -106,6 +405,47 @@ public:
      * @return (expected_throws, optimal_aim) pair
      */
     [[nodiscard]] std::pair<Score, Vec2> solve(Game::State s) override;
+
+    /**
+     * @brief Solve every state from 1 to max_state bottom-up, scanning aims in parallel.
+     *
+     * Requires every transition other than the self-loop to lead to a smaller state,
+     * which holds for GameFinishOnAny and GameFinishOnDouble. States are solved in
+     * increasing order; for each one the aims are split into contiguous chunks, one per
+     * thread, and the per-thread bests are reduced in chunk order. Ties therefore go to
+     * the lowest aim index, exactly like solve(), and the results are bit-identical
+     * to solving the same states serially. Afterwards solve() is a memo lookup.
+     * With a COARSE_TO_FINE search policy the states are solved bottom-up on the calling
+     * thread instead, since each search depends on its own earlier levels.
+     *
+     * @param max_state Highest state to solve
+     * @param num_threads Number of threads, 0 for std::thread::hardware_concurrency()
+     * @throws std::logic_error if a transition leads to a larger, unsolved state
+     */
+    void solve_all(Game::State max_state, size_t num_threads = 0);
+
+    /**
+     * @brief Start over after the game's distribution changed, searching near the previous optima.
+     *
+     * Call after Game::refresh_distribution(). Every solution is dropped, but the best aim of
+     * each solved state is kept. The next solve of such a state only searches the grid aims
+     * within radius columns and rows of its old aim, so only their outcome rows are computed.
+     * States without an old aim are searched as usual. Results are exact when the optimum
+     * stays inside the window, which holds for the small steps of a live calibration;
+     * construct a new solver for a guaranteed global search. A solution table that no
+     * longer matches is dropped.
+     *
+     * @param radius Half width of the search window, in grid columns and rows
+     */
+    void warm_start(size_t radius = WARM_START_RADIUS);
+
+    /** @brief Number of states that will be warm-started on their next solve. */
+    [[nodiscard]] size_t get_warm_start_states() const { return warm_aims_.size(); }
+
+    /** @brief Whether s was solved and can be finished; states that cannot are never moved to. */
+    [[nodiscard]] bool is_winable(Game::State s) const { return winable_.contains(s); }
+
+    [[nodiscard]] uint64_t solution_key() const override;
 };
 /**
  * @brief Dynamic programming solver for round-based optimal dart throwing strategy.
@@ -115,60 +455,121 @@ public:
  * Within a round, the player gets a fixed number of throws. If a throw causes an 
  * invalid/busted state (such as dropping below 0, or below 2 in Double Out), the 
  * remaining throws are lost and the score is reset to the state at the start of the round.
+ *
+ * A start score s is solved by a dense round engine. The in-round states
+ * (current score, throws left) reachable from s are stored as arrays indexed by
+ * s - current score, one layer per number of throws left. Each iteration fills
+ * all layers from the last throw backwards; each state takes the best aim from one
+ * matrix-vector product of the grid's outcome probabilities with the values of the outcomes.
+ * The expected rounds X of s appear on the right hand side through busts, and every
+ * layer also tracks dV/dX, so X is found with Newton's method on X = 1 + F(X).
+ * F is concave and piecewise linear in X, so this converges in a few iterations.
  */
 class SolverMinRounds : public Solver {
 private:
-    static constexpr double EPSILON = 1e-5;
     static constexpr double INFINITE_SCORE = 1e9;
+    static constexpr double NEWTON_TOLERANCE = 1e-12; ///< Relative change of X that ends the Newton iteration
+    static constexpr int MAX_ROUND_ITERATIONS = 50;
 
-    struct RoundStateKey {
-        Game::State round_start_score;
-        Game::State current_score;
-        unsigned int throw_number;
+public:
+    static constexpr size_t DEFAULT_ROUND_CACHE_BUDGET = size_t{64} << 20; ///< Bytes of the round DP cache, see set_round_cache_budget()
 
-        bool operator==(const RoundStateKey& other) const {
-            return round_start_score == other.round_start_score
-                && current_score == other.current_score
-                && throw_number == other.throw_number;
-        }
+private:
+    /** @brief Memoized solution of one round state. */
+    struct RoundMemo {
+        Score score = 0.0;
+        Vec2 aim{0.0, 0.0};
+        bool solved = false;
     };
 
-    struct RoundStateKeyHash {
-        size_t operator()(const RoundStateKey& key) const {
-            size_t h1 = std::hash<Game::State>{}(key.round_start_score);
-            size_t h2 = std::hash<Game::State>{}(key.current_score);
-            size_t h3 = std::hash<unsigned int>{}(key.throw_number);
-            return h1 ^ (h2 << 1) ^ (h3 << 2);
-        }
+    /** @brief Values V and slopes dV/dX of the in-round states of one start score. */
+    struct RoundLayers {
+        size_t width = 0;          ///< Entries per layer, index = start score - current score
+        std::vector<double> value; ///< [throws_left * width + index]
+        std::vector<double> slope; ///< Same layout as value
+    };
+
+    /** @brief Best first aim of a round and the value and slope it achieves. */
+    struct RoundAim {
+        double value = INFINITE_SCORE;
+        double slope = 0.0;
+        Game::AimIndex aim = 0;
+        Vec2 point{0.0, 0.0};
     };
 
     unsigned int throws_per_round_;
-    std::unordered_map<RoundStateKey, std::pair<Score, Vec2>, RoundStateKeyHash> memoization_;
+    /**
+     * Solved round states, memoization_[round start][(start - current) * throws_per_round_ + throw - 1].
+     * A start's block grows up to the lowest current score solved from it, so a round start
+     * takes throws_per_round_ entries and mid-round states the span they reach.
+     */
+    std::vector<std::vector<RoundMemo>> memoization_;
     std::unordered_set<Game::State> winable_;
-    std::unordered_map<uint64_t, double> round_dp_cache_;
+    LruCache<uint64_t, double> round_dp_cache_{DEFAULT_ROUND_CACHE_BUDGET};
+    std::unordered_map<Game::State, double> warm_values_; ///< Expected rounds before warm_start() of start scores not solved since
+
+    // Dense outcome table of the grid, built on first use
+    std::vector<double> round_table_;  ///< Column k at [k * grid size], max(0, p) / sum of p of every grid aim
+    std::vector<size_t> empty_aims_;   ///< Grid aims without any probability mass
+    std::vector<double> aim_scores_;   ///< Scratch output of the matrix-vector product
+    Game::StateDifference max_points_ = 0; ///< Most points a single throw can score
 
-    // Evaluates the expected rounds from state `current_score` with `throws_left` darts remaining.
-    // `X_start_guess` is the assumed total expected rounds from `start_score` (used when busting).
-    // Uses its own internal memoization cache for the current mini-DP step.
-    double evaluate_dp(Game::State start_score, Game::State current_score, unsigned int throws_left, double X_start_guess,
-                       std::unordered_map<unsigned int, double>& inner_memo);
+    void build_round_table_();
+
+    /** @brief Expected value of aim when outcome k is worth values[k], infinite for aims without mass. */
+    [[nodiscard]] double outcome_dot_(Game::AimIndex aim, std::span<const double> values) const;
+
+    /** @brief Aim with the lowest expected value for the given outcome values, following the search policy. */
+    [[nodiscard]] RoundAim best_aim_(std::span<const double> values);
+
+    /**
+     * @brief Value of every outcome of a throw from current_score, indexed like the game's outcome list.
+     * Finishing is worth 0 and a bust round_start_value. value_of(next) gives every other
+     * successor, including current_score itself after a miss. The values are the same for
+     * every aim, so callers compute them once per state. Instantiated per rule type of Game::with_rules().
+     */
+    template <typename Rules, typename ValueOf>
+    [[nodiscard]] std::vector<double> outcome_values_(const Rules& rules, Game::State current_score,
+                                                      double round_start_value, ValueOf&& value_of);
+
+    /**
+     * @brief Expected value of aim for outcome_values_(), normalised by its total probability (infinite without mass).
+     * Only reads the game's outcome row, so aims whose rows exist may be evaluated in parallel.
+     */
+    [[nodiscard]] double expected_after_throw_(Game::AimIndex aim, std::span<const double> values) const;
+
+    /**
+     * @brief One pass of the round engine for start score s with bust value round_start_value.
+     * Fills layers and returns the best first aim with its value F(X) and slope F'(X).
+     */
+    [[nodiscard]] RoundAim evaluate_round_(Game::State s, double round_start_value, RoundLayers& layers);
 
     std::pair<Score, Vec2> solve_round_start_state(Game::State s);
     std::pair<Score, Vec2> solve_nonstart_round_state(Game::State round_start_score, Game::State current_score, unsigned int throw_number);
     [[nodiscard]] bool is_valid_throw_number(unsigned int throw_number) const;
-    [[nodiscard]] RoundStateKey make_state_key(Game::State round_start_score, Game::State current_score, unsigned int throw_number) const;
+    /** @brief Memoized solution of a round state, nullptr if it is not solved yet. */
+    [[nodiscard]] const RoundMemo* find_memo_(Game::State round_start_score, Game::State current_score,
+                                              unsigned int throw_number) const;
+    /** @brief Memoize and return solution; states above their round start are not memoized. */
+    std::pair<Score, Vec2> memoize_(Game::State round_start_score, Game::State current_score, unsigned int throw_number,
+                                    std::pair<Score, Vec2> solution);
     [[nodiscard]] uint64_t make_round_dp_cache_key(Game::State round_start_score, Game::State current_score, unsigned int throws_left) const;
     double evaluate_dp_cached(Game::State start_score, Game::State current_score, unsigned int throws_left, double round_start_value);
 
+    /** @brief Planes of round states are keyed like the round DP cache, with the throw number. */
+    [[nodiscard]] uint64_t aim_score_key_(Game::State s) const override { return make_round_dp_cache_key(s, s, 1); }
+
 public:
     /**
      * @brief Construct solver.
      * @param game Game rules and target
      * @param throws_per_round The number of throws allowed in a single round
      * @param num_samples Number of aim points to evaluate
+     * @param search_policy How the aims of each round state are searched
      */
-    SolverMinRounds(const Game& game, unsigned int throws_per_round = 3, size_t num_samples = 10000)
-        : Solver(game, num_samples), throws_per_round_(throws_per_round) {}
+    SolverMinRounds(const Game& game, unsigned int throws_per_round = 3, size_t num_samples = 10000,
+                    SearchPolicy search_policy = {})
+        : Solver(game, num_samples, search_policy), throws_per_round_(throws_per_round) {}
 
     /**
      * @brief Compute expected rounds for a given state and aim for the FIRST dart of the round.
@@ -212,6 +613,63 @@ public:
      */
     [[nodiscard]] std::pair<Score, Vec2> solve_round_state(Game::State round_start_score, Game::State current_score,
                                                            unsigned int throw_number);
+
+    /**
+     * @brief Start over after the game's distribution changed, from the previous expected rounds.
+     *
+     * Call after Game::refresh_distribution(). Every solution is dropped, but the expected
+     * rounds X of each solved start score are kept, and Newton's method for that score starts
+     * from the old X instead of a rough guess. After a small change of the distribution the
+     * old X is close to the new root, so fewer passes of the round engine are needed. Results
+     * are the same as a fresh solve up to the Newton tolerance. A solution table that no
+     * longer matches is dropped.
+     */
+    void warm_start();
+
+    [[nodiscard]] unsigned int get_throws_per_round() const { return throws_per_round_; }
+
+    /** @brief Whether start score s was solved and can be finished; a throw to any other score busts. */
+    [[nodiscard]] bool is_winable(Game::State s) const { return winable_.contains(s); }
+
+    /**
+     * @brief Bytes the cache of mid-round values may hold, 0 for no limit.
+     * Solving a start score stores the values of its in-round states, and mid-round
+     * queries add more. The least recently used values are evicted when the cache is
+     * full and recomputed by the next query that needs them, so the budget trades
+     * memory for time without changing results beyond rounding.
+     */
+    void set_round_cache_budget(size_t bytes) { round_dp_cache_.set_budget(bytes); }
+    [[nodiscard]] CacheUsage get_round_cache_usage() const { return round_dp_cache_.usage(); }
+
+    /** @brief Evict least recently used mid-round values until at most max_bytes are held. Returns the bytes freed. */
+    size_t trim_round_cache(size_t max_bytes) { return round_dp_cache_.trim(max_bytes); }
+
+    /**
+     * @brief Expected rounds of aiming at every cell of a rows x cols map, for an in-round state.
+     *
+     * Cells are placed as in HeatMapVisualizer and equal solve_aim_round_state() of their
+     * centre. The round start, the current score and the values of every outcome are solved
+     * once for the whole map, then the cells are evaluated on num_threads threads (0 for
+     * std::thread::hardware_concurrency()). With retained aim scores the map is taken from
+     * the state's plane instead, see retained_heat_map_round_state().
+     */
+    [[nodiscard]] HeatMap heat_map(Game::State round_start_score, Game::State current_score, unsigned int throw_number,
+                                   size_t rows, size_t cols, size_t num_threads = 0);
+
+    /**
+     * @brief Heat map of an in-round state from its retained plane, see Solver::retained_heat_map().
+     * Planes are retained for round states solved with solve() or solve_round_state().
+     */
+    [[nodiscard]] std::optional<HeatMap> retained_heat_map_round_state(Game::State round_start_score,
+                                                                       Game::State current_score,
+                                                                       unsigned int throw_number,
+                                                                       Game::Bounds bounds, size_t rows, size_t cols) {
+        return resample_aim_scores_(make_round_dp_cache_key(round_start_score, current_score, throw_number),
+                                    bounds, rows, cols);
+    }
+
+    /** @brief Key of the base solver, with the number of throws per round. */
+    [[nodiscard]] uint64_t solution_key() const override;
 };
 /**
  * @brief Greedy solver that maximizes expected points per throw.
@@ -237,6 +695,8 @@ public:
 class MaxPointsSolver : public Solver {
 private:
     static constexpr double LOWEST_SCORE = 0.0;  ///< Minimum possible score (missing the board)
+
+    [[nodiscard]] double expected_points_(Game::State s, Game::AimIndex aim) const;
 public:
     using Score = double; ///< Expected points scored
 
@@ -256,6 +716,111 @@ public:
      * @return (expected_points, optimal_aim) pair
      */
     [[nodiscard]] std::pair<Score, Vec2> solve(Game::State s) override;
+
+    [[nodiscard]] uint64_t solution_key() const override;
+};
+
+/**
+ * @brief Flag that asks a long computation to stop early.
+ * @ingroup solver
+ *
+ * cancel() may be called from any thread; the computation checks the flag between aims.
+ */
+class CancellationToken {
+private:
+    std::atomic<bool> cancelled_{false};
+
+public:
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    void reset() { cancelled_.store(false, std::memory_order_relaxed); }
+    [[nodiscard]] bool is_cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @brief Heat map computed in passes of increasing resolution, in resumable steps.
+ * @ingroup solver
+ *
+ * Each coarse pass n evaluates the cells on a stride of ceil(rows / n) x ceil(cols / n)
+ * cells, and the final pass evaluates every cell left. Cells evaluated in an earlier
+ * pass are kept, so the passes together evaluate each cell exactly once. After a
+ * pass, result() holds every cell not evaluated yet at the value of the
+ * nearest evaluated cell up and to the left on that pass's stride. The result
+ * is therefore a blocky preview of the final map. After the last pass it is
+ * exactly the map a single row-major sweep gives.
+ *
+ * step() evaluates a bounded number of cells and returns, so a caller such as the web
+ * worker can post partial maps, report progress and handle cancellation in between.
+ *
+ * Example usage:
+ * @code
+ * auto job = visualizer.progressive(301); // 16x16, then 64x64, then every cell
+ * while (!job.step(512, &token)) {
+ *     if (token.is_cancelled()) return;
+ *     if (job.pass_finished()) draw(job.result());
+ * }
+ * @endcode
+ */
+class ProgressiveHeatMap {
+public:
+    using Evaluator = std::function<double(Vec2)>; ///< Score of aiming at a point
+    using Completion = std::function<void(const HeatMap&)>; ///< Called once with the final map
+    static constexpr std::array<size_t, 2> DEFAULT_COARSE_SIZES = {16, 64};
+
+private:
+    struct Pass {
+        size_t row_stride;
+        size_t col_stride;
+    };
+
+    Game::Bounds bounds_;
+    Evaluator evaluate_;
+    Completion on_complete_;
+    HeatMap map_;
+    std::vector<bool> evaluated_;
+    std::vector<Pass> passes_;
+    size_t pass_ = 0;           ///< Index of the pass in progress, passes_.size() when done
+    size_t next_cell_ = 0;      ///< Row-major index where the current pass resumes
+    size_t cells_done_ = 0;
+    bool pass_finished_ = false;
+
+    /** @brief Fill the cells not evaluated yet from their anchor on the finished pass's stride. */
+    void fill_preview_(const Pass& pass);
+    void finish_pass_();
+
+public:
+    /**
+     * @param bounds Area covered by the map, cell centres as in HeatMapVisualizer
+     * @param rows Rows of the final map
+     * @param cols Columns of the final map
+     * @param evaluate Score of a cell, called with the cell's centre
+     * @param coarse_sizes Cells per axis of the coarse passes, increasing; sizes that do not
+     *                     refine the previous pass are skipped
+     * @param on_complete Called with the final map when the last pass completes
+     */
+    ProgressiveHeatMap(Game::Bounds bounds, size_t rows, size_t cols, Evaluator evaluate,
+                       std::span<const size_t> coarse_sizes = DEFAULT_COARSE_SIZES, Completion on_complete = {});
+
+    /** @brief Job that is already complete, for maps read from a memo or a SolutionTable. */
+    explicit ProgressiveHeatMap(HeatMap finished);
+
+    /**
+     * @brief Evaluate up to max_cells more cells.
+     * Stops at the end of a pass, so that every pass can be observed, or when cancel is set.
+     * @return true once every cell has been evaluated
+     */
+    bool step(size_t max_cells = SIZE_MAX, const CancellationToken* cancel = nullptr);
+
+    [[nodiscard]] bool is_done() const { return pass_ == passes_.size(); }
+    /** @brief Whether the last step() completed a pass, so result() is a new preview. */
+    [[nodiscard]] bool pass_finished() const { return pass_finished_; }
+    /** @brief Number of passes completed so far. */
+    [[nodiscard]] size_t passes_done() const { return pass_; }
+    [[nodiscard]] size_t pass_count() const { return passes_.size(); }
+    [[nodiscard]] size_t cells_done() const { return cells_done_; }
+    [[nodiscard]] size_t cells_total() const { return map_.size(); }
+
+    /** @brief Current map, see the class description for cells not evaluated yet. */
+    [[nodiscard]] const HeatMap& result() const { return map_; }
 };
 
 /**
@@ -276,15 +841,18 @@ public:
  */
 class HeatMapVisualizer {
 public:
-    using HeatMap = std::vector<std::vector<Solver::Score>>; ///< Grid of scores [row][col]
+    using HeatMap = ::HeatMap; ///< Grid of scores, map[row][col]
     using Bounds = Game::Bounds; ///< Bounding box of target (min, max)
+    static constexpr size_t DEFAULT_MEMO_BUDGET = size_t{64} << 20; ///< Bytes of memoized maps, see set_memo_budget()
 private:
     Solver& solver_;
     size_t grid_height_;
     size_t grid_width_;
-    std::unordered_map<Game::State, HeatMap> heat_map_memo_;
+    LruCache<Game::State, std::vector<float>> heat_map_memo_{DEFAULT_MEMO_BUDGET}; ///< Finished maps, row-major like HeatMap
     Bounds target_bounds_;
 
+    void memoize_(Game::State s, const HeatMap& heat_map);
+
 public:
     /**
      * @brief Construct heat map generator.
@@ -302,11 +870,35 @@ public:
      * 
      * Each cell contains the expected number of throws when aiming at
      * the center of that cell. Lower values indicate better aim points.
+     * If the solver uses a SolutionTable with planes of this size, the map is read from it.
+     * If the solver retains aim scores, s is solved and the map is taken from its retained
+     * plane when there is one, see Solver::retained_heat_map().
      * 
      * @param s Game state
      * @return Grid of expected throws [row][col]
      */
     [[nodiscard]] HeatMap heat_map(Game::State s);
+
+    /**
+     * @brief Heat map of s computed in passes, see ProgressiveHeatMap.
+     * The finished map is memoized like heat_map(); a memoized or stored map gives a job
+     * that is already complete. The job refers to this visualizer and its solver.
+     */
+    [[nodiscard]] ProgressiveHeatMap progressive(Game::State s,
+        std::span<const size_t> coarse_sizes = ProgressiveHeatMap::DEFAULT_COARSE_SIZES);
+
+    /**
+     * @brief Bytes the memo of finished maps may hold, 0 for no limit.
+     * Maps are memoized as float, half the size of a HeatMap, and the least recently
+     * used are evicted when the memo is full. A map served from the memo is therefore
+     * rounded to float, a relative error below 6e-8; the first computation of a map
+     * is returned exactly.
+     */
+    void set_memo_budget(size_t bytes) { heat_map_memo_.set_budget(bytes); }
+    [[nodiscard]] CacheUsage get_memo_usage() const { return heat_map_memo_.usage(); }
+
+    /** @brief Evict least recently used maps until at most max_bytes are held. Returns the bytes freed. */
+    size_t trim_memo(size_t max_bytes) { return heat_map_memo_.trim(max_bytes); }
 };
 
 #endif
\ No newline at end of file
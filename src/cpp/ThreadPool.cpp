@@ -0,0 +1,80 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(num_threads - 1);
+    for (size_t i = 1; i < num_threads; ++i) {
+        workers_.emplace_back([this, i] { worker_loop_(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    workers_.clear(); // Joins
+}
+
+void ThreadPool::worker_loop_(size_t index) {
+    size_t seen_generation = 0;
+    while (true) {
+        const std::function<void(size_t)>* task;
+        {
+            std::unique_lock lock(mutex_);
+            work_ready_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) return;
+            seen_generation = generation_;
+            task = task_;
+        }
+
+        std::exception_ptr error;
+        try {
+            (*task)(index);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        std::lock_guard lock(mutex_);
+        if (error && !error_) error_ = error;
+        if (--pending_ == 0) work_done_.notify_one();
+    }
+}
+
+void ThreadPool::run(const std::function<void(size_t)>& task) {
+    {
+        std::lock_guard lock(mutex_);
+        task_ = &task;
+        pending_ = workers_.size();
+        error_ = nullptr;
+        ++generation_;
+    }
+    work_ready_.notify_all();
+
+    std::exception_ptr error;
+    try {
+        task(0);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    std::unique_lock lock(mutex_);
+    work_done_.wait(lock, [&] { return pending_ == 0; });
+    if (!error) error = error_;
+    task_ = nullptr;
+    if (error) std::rethrow_exception(error);
+}
+
+void ThreadPool::for_chunks(size_t n, const std::function<void(size_t, size_t, size_t)>& body) {
+    const size_t threads = size();
+    run([&](size_t thread) {
+        size_t begin = n * thread / threads;
+        size_t end = n * (thread + 1) / threads;
+        body(thread, begin, end);
+    });
+}
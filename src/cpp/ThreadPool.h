@@ -0,0 +1,71 @@
+#ifndef THREAD_POOL_HEADER
+#define THREAD_POOL_HEADER
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads that run one task on every thread at a time.
+ * @ingroup solver
+ *
+ * run() hands the same task to all threads, each with its own index, and blocks
+ * until all of them are done. The calling thread takes index 0, so a pool of size 1
+ * starts no threads at all. This suits the solvers, which split a loop into one
+ * contiguous chunk per thread and reduce the per-thread results afterwards.
+ *
+ * Example usage:
+ * @code
+ * ThreadPool pool(4);
+ * std::vector<double> partial(pool.size());
+ * pool.run([&](size_t thread) {
+ *     for (size_t i = thread; i < n; i += pool.size()) partial[thread] += f(i);
+ * });
+ * @endcode
+ */
+class ThreadPool {
+private:
+    std::vector<std::jthread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t generation_ = 0;     ///< Incremented once per run()
+    size_t pending_ = 0;        ///< Workers that have not finished the current task
+    bool stopping_ = false;
+    std::exception_ptr error_;  ///< First exception thrown by a worker in the current run()
+
+    void worker_loop_(size_t index);
+
+public:
+    /**
+     * @brief Start the worker threads.
+     * @param num_threads Total number of threads including the caller, 0 for std::thread::hardware_concurrency()
+     */
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** @brief Number of threads a task runs on, including the caller. */
+    [[nodiscard]] size_t size() const { return workers_.size() + 1; }
+
+    /**
+     * @brief Run task(index) for every index in [0, size()) and wait for all of them.
+     * If any invocation throws, the first exception is rethrown after all threads finish.
+     */
+    void run(const std::function<void(size_t)>& task);
+
+    /**
+     * @brief Split [0, n) into size() contiguous chunks and run body(thread, begin, end) on each.
+     * Chunk t always precedes chunk t + 1, so reductions in thread order preserve index order.
+     */
+    void for_chunks(size_t n, const std::function<void(size_t, size_t, size_t)>& body);
+};
+
+#endif
@@ -320,22 +320,20 @@ async function testHeatMapVisualizer() {
         // Generate heat map for a state
         log('Generating heat map for state 50...');
         const heatMap = heatMapVisualizer.heat_map(50);
-        log(`Heat map size: ${heatMap.size()} rows`);
-        
-        if (heatMap.size() > 0) {
-            const firstRow = heatMap.get(0);
-            log(`First row size: ${firstRow.size()} columns`);
-            
+        const rows = heatMap.rows();
+        const cols = heatMap.cols();
+        // Flat row-major values, copied before the map is deleted
+        const values = Float64Array.from(heatMap.view());
+        heatMap.delete();
+        log(`Heat map size: ${rows} rows x ${cols} columns`);
+        
+        if (values.length > 0) {
             // Find min and max values
             let minVal = Infinity;
             let maxVal = -Infinity;
-            for (let i = 0; i < heatMap.size(); i++) {
-                const row = heatMap.get(i);
-                for (let j = 0; j < row.size(); j++) {
-                    const val = row.get(j);
-                    minVal = Math.min(minVal, val);
-                    maxVal = Math.max(maxVal, val);
-                }
+            for (const val of values) {
+                minVal = Math.min(minVal, val);
+                maxVal = Math.max(maxVal, val);
             }
             log(`Heat map value range: ${minVal.toFixed(3)} to ${maxVal.toFixed(3)}`);
             testPassed('HeatMapVisualizer.heat_map() method');
@@ -380,6 +378,34 @@ async function runAllTests() {
     }
 }
 
+// Profiling counters of the tests run so far, see Instrumentation.h
+function showInstrumentation() {
+    log('\n=== Profiling Counters ===', 'warning');
+    const report = dartsModule.instrumentationReport();
+    if (!report.enabled) {
+        log('Module was built without DARTS_INSTRUMENTATION, configure with -DDARTS_INSTRUMENTATION=ON', 'warning');
+        return;
+    }
+    for (const [name, value] of Object.entries(report.counters)) {
+        log(`  ${name}: ${value}`);
+    }
+    for (const [name, timer] of Object.entries(report.timers)) {
+        log(`  ${name}: ${(timer.seconds * 1000).toFixed(1)} ms in ${timer.calls} calls`);
+    }
+    log(`  round_dp_cache_entries: ${report.roundDpCacheEntries}`);
+
+    const solved = report.aimEvaluationsByState
+        .map((evaluations, state) => ({state, evaluations}))
+        .filter(entry => entry.evaluations > 0);
+    if (solved.length > 0) {
+        const busiest = solved.reduce((a, b) => (b.evaluations > a.evaluations ? b : a));
+        log(`  aim evaluations: ${solved.length} states, most ${busiest.evaluations} for state ${busiest.state}`);
+    }
+    for (const round of report.roundConvergence) {
+        log(`  rounds state ${round.state}: ${round.iterations} iterations, final delta ${round.delta.toExponential(2)}`);
+    }
+}
+
 // Manual throw test
 async function testManualThrow() {
     clearOutput();
@@ -435,6 +461,8 @@ async function initWasm() {
         document.getElementById('testSolverBtn').disabled = false;
         document.getElementById('testHeatMapBtn').disabled = false;
         document.getElementById('testThrowBtn').disabled = false;
+        document.getElementById('instrumentationBtn').disabled = false;
+        document.getElementById('resetInstrumentationBtn').disabled = false;
         
         log('✓ Module loaded successfully!', 'success');
         log('Available classes:', 'info');
@@ -482,6 +510,11 @@ window.addEventListener('DOMContentLoaded', () => {
         await testHeatMapVisualizer();
     });
     document.getElementById('testThrowBtn').addEventListener('click', testManualThrow);
+    document.getElementById('instrumentationBtn').addEventListener('click', showInstrumentation);
+    document.getElementById('resetInstrumentationBtn').addEventListener('click', () => {
+        dartsModule.instrumentationReset();
+        log('Profiling counters reset', 'info');
+    });
     document.getElementById('clearBtn').addEventListener('click', clearOutput);
     
     initWasm();
@@ -62,6 +62,7 @@ class SolverTabController {
         this.runningBatch = false;
         this.isSolving = false;
         this.cancelRequested = false;
+        this.heatmapAbort = null; // AbortController of the progressive heat map in flight
     }
 
     q(role) {
@@ -401,7 +402,7 @@ class SolverTabController {
         return result;
     }
 
-    async _fetchHeatmap(params, cov) {
+    async _fetchHeatmap(params, cov, options = {}) {
         const key = this._heatmapCacheKey(params, cov);
         const cached = this.heatmapCache.get(key);
         if (cached) return { key, hm: cached };
@@ -415,6 +416,7 @@ class SolverTabController {
                 params.samples,
                 params.heatmapResolution,
                 params.minRoundsState,
+                options,
             )
             : await Wasm.heatmap(
                 params.pointsRemaining,
@@ -423,6 +425,7 @@ class SolverTabController {
                 params.solverType,
                 params.samples,
                 params.heatmapResolution,
+                options,
             );
 
         this._setCacheEntry(this.heatmapCache, key, hm, this.heatmapCacheLimit);
@@ -691,6 +694,7 @@ class SolverTabController {
 
     _requestCancel() {
         this.cancelRequested = true;
+        this.heatmapAbort?.abort();
         const cancelBtn = this.q('btn-cancel-solve');
         if (cancelBtn) {
             cancelBtn.setAttribute('disabled', 'disabled');
@@ -782,7 +786,22 @@ class SolverTabController {
                     await nextFrame();
                     if (this.cancelRequested) return false;
                 }
-                const { key, hm } = await this._fetchHeatmap(params, cov);
+                // Coarse previews replace the overlay, so the board stays visible while it refines
+                this.heatmapAbort = new AbortController();
+                const { key, hm } = await this._fetchHeatmap(params, cov, {
+                    progressive: true,
+                    signal: this.heatmapAbort.signal,
+                    onPartial: (partial) => {
+                        if (this.cancelRequested) return;
+                        hideLoading();
+                        this.cachedHeatmap = partial.grid;
+                        this.cachedHeatmapBounds = partial.bounds;
+                        this._renderBoard();
+                    },
+                    onProgress: ({ cellsDone, cellsTotal }) => {
+                        if (showOverlay) setLoadingMessage(`Generating heatmap... ${Math.floor(100 * cellsDone / cellsTotal)}%`);
+                    },
+                });
                 if (this.cancelRequested) return false;
                 this.cachedHeatmap = hm.grid;
                 this.cachedHeatmapBounds = hm.bounds;
@@ -797,10 +816,12 @@ class SolverTabController {
             this._showResults(result);
             return true;
         } catch (err) {
+            if (err?.name === 'AbortError') return false;
             console.error(err);
             alert(`Solve failed: ${err.message}`);
             return false;
         } finally {
+            this.heatmapAbort = null;
             this.isSolving = false;
             this.cancelRequested = false;
             this._setCancelButtonVisible(false);
@@ -1052,6 +1073,10 @@ function showLoading(msg) {
     overlay.style.animation = '';
 }
 
+function setLoadingMessage(msg) {
+    document.getElementById('loading-message').textContent = msg;
+}
+
 function hideLoading() {
     document.getElementById('loading-overlay').classList.add('hidden');
 }
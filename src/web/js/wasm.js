@@ -16,6 +16,7 @@ const pendingRequests = new Map();
 let workerPreferred = true;
 let workerEnabled = false;
 let workerHasTarget = false;
+let threading = { mode: 'single', threads: 1, crossOriginIsolated: false };
 
 // Cached WASM objects (recreated when distribution/target change)
 let _target = null;
@@ -44,11 +45,23 @@ export function isWorkerMode() {
     return workerEnabled;
 }
 
+/**
+ * Which WASM build is running.
+ * mode is 'threaded' when the worker runs darts_wasm_mt on a pthread pool of the given size,
+ * which needs a cross-origin isolated page, and 'single' for darts_wasm in the worker or on
+ * the main thread.
+ * @returns {{mode: string, threads: number, crossOriginIsolated: boolean}}
+ */
+export function getThreadingMode() {
+    return { ...threading };
+}
+
 function _supportsWorker() {
     return typeof Worker !== 'undefined';
 }
 
 function _terminateWorker() {
+    threading = { mode: 'single', threads: 1, crossOriginIsolated: threading.crossOriginIsolated };
     if (worker) {
         worker.terminate();
         worker = null;
@@ -68,10 +81,23 @@ function _onWorkerMessage(event) {
 
     const ticket = pendingRequests.get(msg.id);
     if (!ticket) return;
+
+    // Intermediate messages of a progressive request, the request stays pending
+    if (msg.type === 'progress') {
+        ticket.onProgress?.(msg);
+        return;
+    }
+    if (msg.type === 'partial') {
+        ticket.onPartial?.(_withRowViews(msg));
+        return;
+    }
+
     pendingRequests.delete(msg.id);
+    ticket.cleanup?.();
 
     if (msg.error) {
         const err = new Error(msg.error.message || 'Worker request failed');
+        err.name = msg.error.name || err.name;
         err.stack = msg.error.stack || err.stack;
         ticket.reject(err);
         return;
@@ -119,6 +145,12 @@ async function _ensureWorker() {
             worker.addEventListener('message', _onWorkerMessage);
             worker.addEventListener('error', _onWorkerError);
             workerEnabled = true;
+            threading = {
+                mode: msg.mode === 'threaded' ? 'threaded' : 'single',
+                threads: msg.threads || 1,
+                crossOriginIsolated: !!msg.crossOriginIsolated,
+            };
+            console.info(`WASM worker running the ${threading.mode} build with ${threading.threads} thread(s).`);
             resolve();
         };
 
@@ -140,11 +172,28 @@ async function _ensureWorker() {
     }
 }
 
-async function _workerRequest(type, payload) {
+function _abortError() {
+    const err = new Error('Request cancelled');
+    err.name = 'AbortError';
+    return err;
+}
+
+/**
+ * Send a request to the worker. options.signal (an AbortSignal) cancels it: a queued
+ * request is dropped and a progressive heat map stops at its next step; the promise then
+ * rejects with an AbortError. options.onPartial and options.onProgress receive the
+ * intermediate messages of progressive requests.
+ */
+async function _workerRequest(type, payload, options = {}) {
+    const { signal, onPartial, onProgress } = options;
+    if (signal?.aborted) throw _abortError();
     await _ensureWorker();
     const id = requestSeq++;
     return new Promise((resolve, reject) => {
-        pendingRequests.set(id, { resolve, reject });
+        const onAbort = () => worker?.postMessage({ type: 'cancel', payload: { id } });
+        signal?.addEventListener('abort', onAbort, { once: true });
+        const cleanup = () => signal?.removeEventListener('abort', onAbort);
+        pendingRequests.set(id, { resolve, reject, onPartial, onProgress, cleanup });
         worker.postMessage({ id, type, payload });
     });
 }
@@ -167,7 +216,13 @@ export async function init() {
     }
 
     // DartsModule is the factory placed on window by darts_wasm.js.
+    // The main thread must not block, so it always runs the single-thread build.
     module = await DartsModule();
+    threading = {
+        mode: 'single',
+        threads: 1,
+        crossOriginIsolated: typeof crossOriginIsolated !== 'undefined' && crossOriginIsolated === true,
+    };
     return module;
 }
 
@@ -210,6 +265,7 @@ export function getTargetContent() { return _targetContent; }
 
 /** Delete all cached WASM heap objects and reset change-detection keys. */
 function _cleanup() {
+    _abortProgressive();
     _heatVis?.delete();  _heatVis = null;
     _solver?.delete();   _solver = null;
     _game?.delete();     _game = null;
@@ -240,6 +296,7 @@ function _ensureObjects(covFlat, gameMode, solverType, samples) {
         _cachedCov = covKey;
     }
     if (needGame) {
+        _abortProgressive();
         _heatVis?.delete(); _heatVis = null;
         _solver?.delete();  _solver = null;
         _game?.delete();
@@ -250,6 +307,7 @@ function _ensureObjects(covFlat, gameMode, solverType, samples) {
         _cachedMode = gameMode;
     }
     if (needSolver) {
+        _abortProgressive();
         _heatVis?.delete(); _heatVis = null;
         _solver?.delete();
         const SolverClass = solverType === 'maxPoints'
@@ -272,8 +330,8 @@ function _ensureObjects(covFlat, gameMode, solverType, samples) {
 /**
  * Solve a single points-remaining value. Returns { expectedValue, optimalAim: {x,y} }.
  */
-export async function solve(pointsRemaining, covFlat, gameMode, solverType, samples) {
-    return _solveAsync(pointsRemaining, covFlat, gameMode, solverType, samples, null);
+export async function solve(pointsRemaining, covFlat, gameMode, solverType, samples, options = {}) {
+    return _solveAsync(pointsRemaining, covFlat, gameMode, solverType, samples, null, options);
 }
 
 function _normalizeMinRoundsState(pointsRemaining, solverType, minRoundsState) {
@@ -292,11 +350,11 @@ function _normalizeMinRoundsState(pointsRemaining, solverType, minRoundsState) {
     };
 }
 
-export async function solveWithRoundState(pointsRemaining, covFlat, gameMode, solverType, samples, minRoundsState) {
-    return _solveAsync(pointsRemaining, covFlat, gameMode, solverType, samples, minRoundsState);
+export async function solveWithRoundState(pointsRemaining, covFlat, gameMode, solverType, samples, minRoundsState, options = {}) {
+    return _solveAsync(pointsRemaining, covFlat, gameMode, solverType, samples, minRoundsState, options);
 }
 
-async function _solveAsync(pointsRemaining, covFlat, gameMode, solverType, samples, minRoundsState) {
+async function _solveAsync(pointsRemaining, covFlat, gameMode, solverType, samples, minRoundsState, options = {}) {
     const normalizedRoundState = _normalizeMinRoundsState(pointsRemaining, solverType, minRoundsState);
     if (workerEnabled) {
         return _workerRequest('solve', {
@@ -306,9 +364,10 @@ async function _solveAsync(pointsRemaining, covFlat, gameMode, solverType, sampl
             solverType,
             samples,
             minRoundsState: normalizedRoundState,
-        });
+        }, { signal: options.signal });
     }
 
+    if (options.signal?.aborted) throw _abortError();
     _ensureObjects(covFlat, gameMode, solverType, samples);
     const res = solverType === 'minRounds' && normalizedRoundState
         ? module.solverSolveMinRoundsRoundState(
@@ -325,20 +384,98 @@ async function _solveAsync(pointsRemaining, covFlat, gameMode, solverType, sampl
 }
 
 /**
- * Generate heatmap grid. Returns { grid: Float64Array-like, rows, cols, bounds }.
+ * Generate heatmap grid. Returns { values, grid, rows, cols, bounds }: values is one row-major
+ * Float64Array, grid[r] is a subarray view of row r into it, so grid[r][c] needs no copy.
+ *
+ * options.progressive computes the map in coarse-to-fine passes: options.onPartial gets a
+ * map of the same shape after each coarse pass, and options.onProgress gets
+ * { cellsDone, cellsTotal, pass, passes }. Starting a progressive heat map cancels the
+ * previous one, and options.signal cancels it explicitly (the promise rejects with an AbortError).
  */
-export async function heatmap(pointsRemaining, covFlat, gameMode, solverType, samples, resolution) {
-    return _heatmapAsync(pointsRemaining, covFlat, gameMode, solverType, samples, resolution, null);
+export async function heatmap(pointsRemaining, covFlat, gameMode, solverType, samples, resolution, options = {}) {
+    return _heatmapAsync(pointsRemaining, covFlat, gameMode, solverType, samples, resolution, null, options);
 }
 
-export async function heatmapWithRoundState(pointsRemaining, covFlat, gameMode, solverType, samples, resolution, minRoundsState) {
-    return _heatmapAsync(pointsRemaining, covFlat, gameMode, solverType, samples, resolution, minRoundsState);
+export async function heatmapWithRoundState(pointsRemaining, covFlat, gameMode, solverType, samples, resolution, minRoundsState, options = {}) {
+    return _heatmapAsync(pointsRemaining, covFlat, gameMode, solverType, samples, resolution, minRoundsState, options);
 }
 
-async function _heatmapAsync(pointsRemaining, covFlat, gameMode, solverType, samples, resolution, minRoundsState) {
+let _progressiveHeatmap = null; // AbortController of the running progressive heat map
+
+// Abort when either the caller's signal or the controller fires
+function _linkedSignal(controller, signal) {
+    if (signal?.aborted) controller.abort();
+    signal?.addEventListener('abort', () => controller.abort(), { once: true });
+    return controller.signal;
+}
+
+// Main-thread version of the worker's step loop; yields to the event loop between steps
+async function _runProgressive(job, options) {
+    const { signal, onPartial, onProgress } = options;
+    const STEP_CELLS = 64;
+    try {
+        while (!job.step(STEP_CELLS)) {
+            onProgress?.({
+                cellsDone: job.cells_done(),
+                cellsTotal: job.cells_total(),
+                pass: job.passes_done(),
+                passes: job.pass_count(),
+            });
+            if (job.pass_finished()) {
+                const b = _game.get_target_bounds();
+                onPartial?.(_withRowViews({
+                    values: new Float64Array(job.result_view()),
+                    rows: job.rows(),
+                    cols: job.cols(),
+                    pass: job.passes_done(),
+                    passes: job.pass_count(),
+                    bounds: { min: { x: b.min.x, y: b.min.y }, max: { x: b.max.x, y: b.max.y } },
+                }));
+            }
+            await new Promise((resolve) => setTimeout(resolve, 0));
+            if (signal?.aborted) throw _abortError();
+        }
+        return { values: new Float64Array(job.result_view()), rows: job.rows(), cols: job.cols() };
+    } finally {
+        job.delete();
+    }
+}
+
+// A main-thread progressive job refers to the solver and visualizer, so it is stopped
+// before they are deleted; it notices at its next step
+function _abortProgressive() {
+    _progressiveHeatmap?.abort();
+    _progressiveHeatmap = null;
+}
+
+function _heatVisualizer(resolution) {
+    if (!_heatVis || _heatVis._res !== resolution) {
+        _abortProgressive();
+        _heatVis?.delete();
+        _heatVis = new module.HeatMapVisualizer(_solver, resolution, resolution);
+        _heatVis._res = resolution;
+    }
+    return _heatVis;
+}
+
+function _withRowViews(result) {
+    const { values, rows, cols } = result;
+    const grid = new Array(rows);
+    for (let r = 0; r < rows; r++) grid[r] = values.subarray(r * cols, (r + 1) * cols);
+    return { ...result, grid };
+}
+
+async function _heatmapAsync(pointsRemaining, covFlat, gameMode, solverType, samples, resolution, minRoundsState, options = {}) {
     const normalizedRoundState = _normalizeMinRoundsState(pointsRemaining, solverType, minRoundsState);
+    // A newer progressive map makes the running one stale
+    const progressiveOptions = () => {
+        _abortProgressive();
+        const controller = new AbortController();
+        _progressiveHeatmap = controller;
+        return { ...options, signal: _linkedSignal(controller, options.signal) };
+    };
     if (workerEnabled) {
-        return _workerRequest('heatmap', {
+        return _withRowViews(await _workerRequest('heatmap', {
             pointsRemaining,
             covFlat,
             gameMode,
@@ -346,16 +483,39 @@ async function _heatmapAsync(pointsRemaining, covFlat, gameMode, solverType, sam
             samples,
             resolution,
             minRoundsState: normalizedRoundState,
-        });
+            progressive: !!options.progressive,
+        }, options.progressive ? progressiveOptions() : options));
     }
 
+    if (options.signal?.aborted) throw _abortError();
     _ensureObjects(covFlat, gameMode, solverType, samples);
-    let rows;
-    let cols;
-    let grid;
+    if (options.progressive) {
+        const visualizer = solverType === 'minRounds' && normalizedRoundState ? null : _heatVisualizer(resolution);
+        // After the objects exist, recreating them aborts the previous job, not this one
+        const requestOptions = progressiveOptions();
+        const job = !visualizer
+            ? module.solverProgressiveHeatMapMinRoundsRoundState(
+                _solver,
+                normalizedRoundState.roundStartScore,
+                normalizedRoundState.currentScore,
+                normalizedRoundState.throwNumber,
+                resolution,
+                resolution,
+            )
+            : module.heatMapVisualizerProgressive(visualizer, pointsRemaining);
+        const { values, rows, cols } = await _runProgressive(job, requestOptions);
+        const b = _game.get_target_bounds();
+        return _withRowViews({
+            values,
+            rows,
+            cols,
+            bounds: { min: { x: b.min.x, y: b.min.y }, max: { x: b.max.x, y: b.max.y } },
+        });
+    }
 
+    let hm;
     if (solverType === 'minRounds' && normalizedRoundState) {
-        const hm = module.solverHeatMapMinRoundsRoundState(
+        hm = module.solverHeatMapMinRoundsRoundState(
             _solver,
             normalizedRoundState.roundStartScore,
             normalizedRoundState.currentScore,
@@ -363,45 +523,25 @@ async function _heatmapAsync(pointsRemaining, covFlat, gameMode, solverType, sam
             resolution,
             resolution,
         );
-        rows = hm.size();
-        cols = rows > 0 ? hm.get(0).size() : 0;
-        grid = [];
-        for (let r = 0; r < rows; r++) {
-            const row = hm.get(r);
-            const arr = new Array(cols);
-            for (let c = 0; c < cols; c++) arr[c] = row.get(c);
-            grid.push(arr);
-        }
     } else {
-        if (!_heatVis || _heatVis._res !== resolution) {
-            _heatVis?.delete();
-            _heatVis = new module.HeatMapVisualizer(_solver, resolution, resolution);
-            _heatVis._res = resolution;
-        }
-        const hm = _heatVis.heat_map(pointsRemaining);
-        rows = hm.size();
-        cols = rows > 0 ? hm.get(0).size() : 0;
-
-        // Copy into plain JS 2D array.
-        grid = [];
-        for (let r = 0; r < rows; r++) {
-            const row = hm.get(r);
-            const arr = new Array(cols);
-            for (let c = 0; c < cols; c++) arr[c] = row.get(c);
-            grid.push(arr);
-        }
+        hm = _heatVisualizer(resolution).heat_map(pointsRemaining);
     }
+    const rows = hm.rows();
+    const cols = hm.cols();
+    // Copied out once, the view into WASM memory dies with hm
+    const values = new Float64Array(hm.view());
+    hm.delete();
 
     const bounds = _game.get_target_bounds();
-    return {
-        grid,
+    return _withRowViews({
+        values,
         rows,
         cols,
         bounds: {
             min: { x: bounds.min.x, y: bounds.min.y },
             max: { x: bounds.max.x, y: bounds.max.y },
         },
-    };
+    });
 }
 
 /**
@@ -1,12 +1,14 @@
 /* global DartsModule */
 
 let module = null;
+let threads = 1; // Threads of the loaded build, more than 1 only for darts_wasm_mt
 
 let target = null;
 let dist = null;
 let game = null;
 let solver = null;
 let heatVis = null;
+let solutionTable = null; // Kept across solvers, each one only accepts a table with its own key
 
 let cachedCov = null;
 let cachedMode = null;
@@ -37,6 +39,24 @@ function ensureObjects(covFlat, gameMode, solverType, samples) {
 
     const covKey = covFlat.join(',');
     const needDist = covKey !== cachedCov;
+
+    // A new calibration fit with everything else unchanged: update the distribution in place and
+    // warm-start the solver from its previous optima instead of rebuilding and re-solving.
+    // MaxPointsSolver keeps no solutions, it is simply rebuilt below.
+    const warmable = solverType !== 'maxPoints';
+    if (needDist && warmable && solver && gameMode === cachedMode && solverType === cachedSolverType
+        && samples === cachedSamples) {
+        dist.set_parameters(covFlat, { x: 0, y: 0 });
+        game.refresh_distribution();
+        solver.warm_start();
+        heatVis?.delete();
+        heatVis = null;
+        if (solutionTable) {
+            module.solverUseSolutionTable(solver, solutionTable);
+        }
+        cachedCov = covKey;
+        return;
+    }
     const needGame = needDist || gameMode !== cachedMode;
     const needSolver = needGame || solverType !== cachedSolverType || samples !== cachedSamples;
 
@@ -76,6 +96,12 @@ function ensureObjects(covFlat, gameMode, solverType, samples) {
         } else {
             solver = new SolverClass(game, samples);
         }
+        // Keep the aim scores of every solved state, heat maps are then read from them
+        solver.set_retain_aim_scores(true);
+
+        if (solutionTable) {
+            module.solverUseSolutionTable(solver, solutionTable);
+        }
 
         cachedSolverType = solverType;
         cachedSamples = samples;
@@ -83,16 +109,42 @@ function ensureObjects(covFlat, gameMode, solverType, samples) {
 }
 
 function handleLoadTarget(payload) {
-    const text = payload?.targetContent;
-    if (typeof text !== 'string') {
+    // Text as written by gen_target.py, or an ArrayBuffer in the binary target format
+    let content = payload?.targetContent;
+    if (content instanceof ArrayBuffer) {
+        content = new Uint8Array(content);
+    } else if (typeof content !== 'string') {
         throw new Error('Invalid target content payload');
     }
 
     cleanupAll();
-    target = new module.Target(text);
+    target = new module.Target(content);
     return { ok: true };
 }
 
+function handleLoadSolutionTable(payload) {
+    const bytes = payload?.bytes;
+    if (!(bytes instanceof ArrayBuffer)) {
+        throw new Error('Invalid solution table payload');
+    }
+
+    solutionTable?.delete();
+    solutionTable = new module.SolutionTable(new Uint8Array(bytes));
+    // Heat maps memoized from the previous table or solver would be stale
+    heatVis?.delete();
+    heatVis = null;
+    const matched = solver ? module.solverUseSolutionTable(solver, solutionTable) : false;
+    return { ok: true, states: solutionTable.state_count(), matched };
+}
+
+// With threads, solve everything up to state in one parallel pass over the aims; the
+// serial solve that follows is then a lookup. Results are the same either way.
+function solveAllIfThreaded(solverType, state) {
+    if (threads > 1 && solverType !== 'maxPoints' && solverType !== 'minRounds') {
+        module.solverSolveAll(solver, state);
+    }
+}
+
 function handleSolve(payload) {
     const {
         pointsRemaining,
@@ -104,6 +156,7 @@ function handleSolve(payload) {
     } = payload;
 
     ensureObjects(covFlat, gameMode, solverType, samples);
+    solveAllIfThreaded(solverType, pointsRemaining);
     const res = solverType === 'minRounds' && minRoundsState
         ? module.solverSolveMinRoundsRoundState(
             solver,
@@ -122,7 +175,80 @@ function handleSolve(payload) {
     };
 }
 
-function handleHeatmap(payload) {
+function heatmapBounds() {
+    const bounds = game.get_target_bounds();
+    return {
+        min: { x: bounds.min.x, y: bounds.min.y },
+        max: { x: bounds.max.x, y: bounds.max.y },
+    };
+}
+
+// One copy out of WASM memory into a buffer that is transferred, not cloned
+function copyValues(view) {
+    return new Float64Array(view);
+}
+
+function visualizerFor(resolution) {
+    if (!heatVis || heatVis._res !== resolution) {
+        heatVis?.delete();
+        heatVis = new module.HeatMapVisualizer(solver, resolution, resolution);
+        heatVis._res = resolution;
+    }
+    return heatVis;
+}
+
+// Cells per step start small and adapt, so each step takes about STEP_BUDGET_MS
+const STEP_BUDGET_MS = 30;
+
+function yieldToMessages() {
+    return new Promise((resolve) => setTimeout(resolve, 0));
+}
+
+// Runs the job in steps, posting a partial map after every coarse pass and progress after
+// every step. Messages, including cancel requests, are handled between steps.
+async function runProgressive(job, context) {
+    let cellsPerStep = 16;
+    try {
+        while (true) {
+            if (context.isCancelled()) throw cancelledError();
+            const started = performance.now();
+            const done = job.step(cellsPerStep);
+            const elapsed = performance.now() - started;
+            cellsPerStep = elapsed < STEP_BUDGET_MS / 2
+                ? cellsPerStep * 2
+                : elapsed > STEP_BUDGET_MS ? Math.max(1, Math.floor(cellsPerStep / 2)) : cellsPerStep;
+
+            self.postMessage({
+                id: context.id,
+                type: 'progress',
+                cellsDone: job.cells_done(),
+                cellsTotal: job.cells_total(),
+                pass: job.passes_done(),
+                passes: job.pass_count(),
+            });
+            if (done) break;
+            if (job.pass_finished()) {
+                const values = copyValues(job.result_view());
+                self.postMessage({
+                    id: context.id,
+                    type: 'partial',
+                    values,
+                    rows: job.rows(),
+                    cols: job.cols(),
+                    pass: job.passes_done(),
+                    passes: job.pass_count(),
+                    bounds: heatmapBounds(),
+                }, [values.buffer]);
+            }
+            await yieldToMessages();
+        }
+        return { values: copyValues(job.result_view()), rows: job.rows(), cols: job.cols(), bounds: heatmapBounds() };
+    } finally {
+        job.delete();
+    }
+}
+
+async function handleHeatmap(payload, context) {
     const {
         pointsRemaining,
         covFlat,
@@ -131,10 +257,30 @@ function handleHeatmap(payload) {
         samples,
         resolution,
         minRoundsState,
+        progressive,
     } = payload;
 
     ensureObjects(covFlat, gameMode, solverType, samples);
-    const hm = solverType === 'minRounds' && minRoundsState
+    const roundState = solverType === 'minRounds' && minRoundsState;
+    if (!roundState) {
+        solveAllIfThreaded(solverType, pointsRemaining);
+    }
+
+    if (progressive) {
+        const job = roundState
+            ? module.solverProgressiveHeatMapMinRoundsRoundState(
+                solver,
+                minRoundsState.roundStartScore,
+                minRoundsState.currentScore,
+                minRoundsState.throwNumber,
+                resolution,
+                resolution,
+            )
+            : module.heatMapVisualizerProgressive(visualizerFor(resolution), pointsRemaining);
+        return runProgressive(job, context);
+    }
+
+    const hm = roundState
         ? module.solverHeatMapMinRoundsRoundState(
             solver,
             minRoundsState.roundStartScore,
@@ -143,39 +289,18 @@ function handleHeatmap(payload) {
             resolution,
             resolution,
         )
-        : (() => {
-            if (!heatVis || heatVis._res !== resolution) {
-                heatVis?.delete();
-                heatVis = new module.HeatMapVisualizer(solver, resolution, resolution);
-                heatVis._res = resolution;
-            }
-            return heatVis.heat_map(pointsRemaining);
-        })();
-    const rows = hm.size();
-    const cols = rows > 0 ? hm.get(0).size() : 0;
+        : visualizerFor(resolution).heat_map(pointsRemaining);
+    const rows = hm.rows();
+    const cols = hm.cols();
+    const values = copyValues(hm.view());
+    hm.delete();
 
-    const grid = [];
-    for (let r = 0; r < rows; r++) {
-        const row = hm.get(r);
-        const arr = new Array(cols);
-        for (let c = 0; c < cols; c++) arr[c] = row.get(c);
-        grid.push(arr);
-    }
-
-    const bounds = game.get_target_bounds();
-    return {
-        grid,
-        rows,
-        cols,
-        bounds: {
-            min: { x: bounds.min.x, y: bounds.min.y },
-            max: { x: bounds.max.x, y: bounds.max.y },
-        },
-    };
+    return { values, rows, cols, bounds: heatmapBounds() };
 }
 
 const handlers = {
     loadTarget: handleLoadTarget,
+    loadSolutionTable: handleLoadSolutionTable,
     solve: handleSolve,
     heatmap: handleHeatmap,
 };
@@ -184,6 +309,7 @@ function postError(id, err) {
     self.postMessage({
         id,
         error: {
+            name: err?.name || 'Error',
             message: err?.message || String(err),
             stack: err?.stack || null,
         },
@@ -191,30 +317,94 @@ function postError(id, err) {
 }
 
 function postResult(id, result) {
-    self.postMessage({ id, result });
+    const transfer = result?.values instanceof Float64Array ? [result.values.buffer] : [];
+    self.postMessage({ id, result }, transfer);
+}
+
+// darts_wasm_mt needs SharedArrayBuffer, which browsers only expose on cross-origin isolated
+// pages (served with COOP: same-origin and COEP: require-corp)
+function threadsAvailable() {
+    return self.crossOriginIsolated === true && typeof SharedArrayBuffer !== 'undefined';
+}
+
+async function bootThreaded() {
+    importScripts('darts_wasm_mt.js');
+    // The pthreads load the same script; left alone they would be pointed at worker.js
+    return DartsModule({ mainScriptUrlOrBlob: new URL('darts_wasm_mt.js', self.location.href).href });
 }
 
 async function boot() {
-    importScripts('darts_wasm.js');
-    module = await DartsModule();
-    self.postMessage({ type: 'ready' });
+    let mode = 'single';
+    if (threadsAvailable()) {
+        try {
+            module = await bootThreaded();
+            mode = 'threaded';
+        } catch (err) {
+            console.warn('Threaded WASM failed to start; using the single-thread build.', err);
+            module = null;
+        }
+    }
+    if (!module) {
+        importScripts('darts_wasm.js');
+        module = await DartsModule();
+    }
+    threads = module.wasmThreadCount();
+    self.postMessage({ type: 'ready', mode, threads, crossOriginIsolated: self.crossOriginIsolated === true });
 }
 
-self.onmessage = async (event) => {
+function cancelledError() {
+    const err = new Error('Request cancelled');
+    err.name = 'AbortError';
+    return err;
+}
+
+// Requests run one at a time in arrival order. A cancel message drops a queued request,
+// or stops a running progressive heat map at its next step.
+const queue = [];
+const cancelled = new Set();
+let running = false;
+let currentId = null;
+
+async function drainQueue() {
+    if (running) return;
+    running = true;
+    while (queue.length > 0) {
+        const { id, type, payload } = queue.shift();
+        currentId = id;
+        const context = { id, isCancelled: () => cancelled.has(id) };
+        try {
+            if (context.isCancelled()) throw cancelledError();
+            const result = await handlers[type](payload || {}, context);
+            postResult(id, result);
+        } catch (err) {
+            postError(id, err);
+        } finally {
+            cancelled.delete(id);
+            currentId = null;
+        }
+    }
+    running = false;
+}
+
+self.onmessage = (event) => {
     const msg = event.data || {};
     const { id, type, payload } = msg;
 
+    if (type === 'cancel') {
+        // Requests that already finished have nothing left to cancel
+        const target = payload?.id;
+        if (target === currentId || queue.some((request) => request.id === target)) {
+            cancelled.add(target);
+        }
+        return;
+    }
     if (!handlers[type]) {
         postError(id, new Error(`Unknown worker request type: ${type}`));
         return;
     }
 
-    try {
-        const result = handlers[type](payload || {});
-        postResult(id, result);
-    } catch (err) {
-        postError(id, err);
-    }
+    queue.push({ id, type, payload });
+    drainQueue();
 };
 
 boot().catch((err) => {
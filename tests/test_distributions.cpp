@@ -1,9 +1,14 @@
 #include <cmath>
 #include <gtest/gtest.h>
 #include "Distribution.h"
+#include "GaussianKernel.h"
 #include "Geometry.h"
+#include "QuadratureRule.h"
+#include "Random.h"
+#include "ThreadPool.h"
 #include <cmath>
 #include <map>
+#include <random>
 
 typedef Vec2 P;
 
@@ -268,3 +273,289 @@ TEST(NormalDistribution, IntegrationSumsToOne) {
     EXPECT_GT(total, 0.95);
     EXPECT_LT(total, 1.05);
 }
+
+// Sector integration tests
+TEST(QuadratureNormalDistribution, SectorMatchesClosedForm) {
+    // For an isotropic Gaussian centred at the origin P(|x| < R) = 1 - exp(-R^2 / (2 sigma^2))
+    for (double sigma : {0.5, 3.0, 40.0}) {
+        NormalDistribution::covariance cov = {{{sigma * sigma, 0}, {0, sigma * sigma}}};
+        NormalDistributionQuadrature dist(cov, P{0, 0});
+        for (double radius : {1.0, 6.35, 50.0}) {
+            double expected = 1.0 - std::exp(-radius * radius / (2 * sigma * sigma));
+            EXPECT_NEAR(dist.integrate_probability(PolarSector{0, radius, -M_PI, M_PI}), expected, 1e-12);
+            EXPECT_NEAR(dist.integrate_probability(PolarSector{0, radius, 0.3, 0.3 + M_PI / 2}), expected / 4, 1e-12);
+        }
+    }
+}
+
+TEST(QuadratureNormalDistribution, SectorMatchesPolygon) {
+    NormalDistribution::covariance cov = {{{30, 8}, {8, 12}}};
+    NormalDistributionQuadrature dist(cov, P{1, -2});
+    PolarSector sector{90, 107, 0.1, 0.4};
+
+    // Finely subdivided polygon of the same sector, small enough for accurate fan quadrature
+    std::vector<P> vertices;
+    const int subdivisions = 400;
+    for (int i = 0; i <= subdivisions; ++i) {
+        double a = sector.angle_start + (sector.angle_end - sector.angle_start) * i / subdivisions;
+        vertices.emplace_back(sector.r_inner * std::cos(a), sector.r_inner * std::sin(a));
+    }
+    for (int i = subdivisions; i >= 0; --i) {
+        double a = sector.angle_start + (sector.angle_end - sector.angle_start) * i / subdivisions;
+        vertices.emplace_back(sector.r_outer * std::cos(a), sector.r_outer * std::sin(a));
+    }
+    Polygon polygon(vertices);
+
+    for (P offset : {P{95, 20}, P{100, 30}, P{85, 5}, P{110, 45}}) {
+        EXPECT_NEAR(dist.integrate_probability(sector, offset), dist.integrate_probability(polygon, offset), 5e-4);
+    }
+    // Far away sectors carry no mass
+    EXPECT_EQ(dist.integrate_probability(sector, P{-100, -100}), 0.0);
+}
+
+TEST(RandomNormalDistribution, SectorMatchesQuadrature) {
+    NormalDistribution::covariance cov = {{{4, 1}, {1, 2}}};
+    NormalDistributionRandom rand_dist(cov, P{0, 0}, 50000);
+    NormalDistributionQuadrature quad_dist(cov, P{0, 0});
+    PolarSector sector{1, 4, -0.5, 1.5};
+
+    EXPECT_NEAR(rand_dist.integrate_probability(sector, P{1, 1}), quad_dist.integrate_probability(sector, P{1, 1}), 0.01);
+}
+
+TEST(NormalDistribution, BatchDensityMatchesScalar) {
+    NormalDistribution::covariance cov = {{{3, 0.7}, {0.7, 1.5}}};
+    NormalDistributionQuadrature dist(cov, P{1, -1});
+
+    std::vector<P> points = {P{0, 0}, P{1, -1}, P{2.5, 3}, P{-4, 1}, P{10, 10}};
+    std::vector<double> densities(points.size());
+    dist.probability_density(points, densities);
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_NEAR(densities[i], dist.probability_density(points[i]), 1e-15);
+    }
+}
+
+TEST(NormalDistribution, CachedParametersFollowAddPoint) {
+    std::vector<P> points = {P{0, 0}, P{2, 1}, P{-1, 3}};
+    NormalDistributionQuadrature incremental(points);
+    incremental.add_point(P{4, -2});
+    incremental.add_point(P{1, 1});
+
+    points.push_back(P{4, -2});
+    points.push_back(P{1, 1});
+    NormalDistributionQuadrature fitted(points);
+
+    for (P p : {P{0, 0}, P{1, 2}, P{-3, 4}}) {
+        EXPECT_NEAR(incremental.probability_density(p), fitted.probability_density(p), 1e-15);
+    }
+
+    // Samples are drawn with the refreshed Cholesky factor
+    double sum_x = 0;
+    const int n = 20000;
+    for (int i = 0; i < n; ++i) sum_x += incremental.sample().x;
+    EXPECT_NEAR(sum_x / n, 1.2, 0.1);
+}
+
+TEST(NormalDistribution, StreamingFitMatchesBatchFit) {
+    RandomEngine rng(SEED);
+    std::vector<P> points;
+    NormalDistributionQuadrature streaming({{{1, 0}, {0, 1}}}, P{0, 0});
+    EXPECT_EQ(streaming.get_point_count(), 0u);
+    for (int i = 0; i < 500; ++i) {
+        // Large offsets would make a naive sum of squares lose most of its digits
+        P p{1000.0 + 30.0 * rng.uniform(), -2000.0 + 10.0 * rng.uniform() + 5.0 * rng.uniform()};
+        points.push_back(p);
+        streaming.add_point(p);
+    }
+    // Explicit parameters are replaced from the first point on
+    NormalDistributionQuadrature fitted(points);
+    EXPECT_EQ(streaming.get_point_count(), 500u);
+    EXPECT_NEAR(streaming.get_mean().x, fitted.get_mean().x, 1e-9);
+    EXPECT_NEAR(streaming.get_mean().y, fitted.get_mean().y, 1e-9);
+    for (size_t r = 0; r < 2; ++r) {
+        for (size_t c = 0; c < 2; ++c) {
+            EXPECT_NEAR(streaming.get_covariance()[r][c], fitted.get_covariance()[r][c], 1e-9);
+        }
+    }
+    EXPECT_EQ(streaming.get_covariance()[0][1], streaming.get_covariance()[1][0]);
+
+    // A fitted distribution continues its fit
+    fitted.add_point(P{1010, -1990});
+    points.push_back(P{1010, -1990});
+    NormalDistributionQuadrature refitted(points);
+    EXPECT_NEAR(fitted.get_covariance()[0][0], refitted.get_covariance()[0][0], 1e-9);
+    EXPECT_NEAR(fitted.get_covariance()[1][1], refitted.get_covariance()[1][1], 1e-9);
+
+    streaming.set_parameters({{{4, 1}, {1, 3}}}, P{1, 2});
+    EXPECT_EQ(streaming.get_point_count(), 0u);
+    EXPECT_EQ(streaming.get_mean(), (P{1, 2}));
+    NormalDistributionQuadrature explicit_dist({{{4, 1}, {1, 3}}}, P{1, 2});
+    EXPECT_EQ(streaming.probability_density(P{0, 0}), explicit_dist.probability_density(P{0, 0}));
+}
+
+TEST(GaussianKernel, SimdPathsMatchScalar) {
+    std::array<std::array<double, 2>, 2> inv_cov = {{{0.02, -0.004}, {-0.004, 0.05}}};
+    GaussianKernel kernel(inv_cov, -std::log(2 * M_PI * 20.0), P{3, -2});
+
+    // Points up to ~40 sigma out, so the clamped exponent range is exercised too
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> coord(-250.0, 250.0);
+    std::uniform_real_distribution<double> weight(-1.0, 1.0);
+    for (size_t n : {0, 1, 3, 7, 25, 200, 203}) {
+        std::vector<double> x(n), y(n), w(n);
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = coord(rng) / (i % 3 + 1);
+            y[i] = coord(rng) / (i % 3 + 1);
+            w[i] = weight(rng);
+        }
+        double scalar = kernel.weighted_sum(GaussianKernel::Isa::SCALAR, x, y, w);
+        for (auto isa : {GaussianKernel::Isa::AVX2, GaussianKernel::Isa::AVX512, GaussianKernel::Isa::WASM_SIMD128}) {
+            if (!GaussianKernel::supports(isa)) {
+                EXPECT_THROW((void)kernel.weighted_sum(isa, x, y, w), std::invalid_argument);
+                continue;
+            }
+            EXPECT_NEAR(kernel.weighted_sum(isa, x, y, w), scalar, 1e-12) << "n = " << n;
+        }
+        EXPECT_NEAR(kernel.weighted_sum(x, y, w), scalar, 1e-12);
+    }
+}
+
+TEST(GaussianKernel, FloatPathsMatchDouble) {
+    std::array<std::array<double, 2>, 2> inv_cov = {{{0.02, -0.004}, {-0.004, 0.05}}};
+    GaussianKernel kernel(inv_cov, -std::log(2 * M_PI * 20.0), P{3, -2});
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coord(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+    for (size_t n : {0, 1, 3, 7, 25, 200, 203}) {
+        std::vector<float> x(n), y(n), w(n);
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = coord(rng);
+            y[i] = coord(rng);
+            w[i] = weight(rng);
+        }
+        // Double sum of the same float inputs, so only the float arithmetic differs
+        const std::vector<double> xd(x.begin(), x.end()), yd(y.begin(), y.end()), wd(w.begin(), w.end());
+        const double reference = kernel.weighted_sum(GaussianKernel::Isa::SCALAR, xd, yd, wd);
+        const double tolerance = 1e-5 * reference + 1e-300;
+        EXPECT_NEAR(kernel.weighted_sum(GaussianKernel::Isa::SCALAR, x, y, w), reference, tolerance) << "n = " << n;
+        for (auto isa : {GaussianKernel::Isa::AVX2, GaussianKernel::Isa::AVX512, GaussianKernel::Isa::WASM_SIMD128}) {
+            if (!GaussianKernel::supports(isa)) {
+                EXPECT_THROW((void)kernel.weighted_sum(isa, x, y, w), std::invalid_argument);
+                continue;
+            }
+            EXPECT_NEAR(kernel.weighted_sum(isa, x, y, w), reference, tolerance) << "n = " << n;
+        }
+        EXPECT_NEAR(kernel.weighted_sum(x, y, w), reference, tolerance);
+    }
+}
+
+TEST(GaussianKernel, RejectsMismatchedSpans) {
+    GaussianKernel kernel({{{1, 0}, {0, 1}}}, 0.0, P{0, 0});
+    std::vector<double> x(4), y(3), w(4);
+    EXPECT_THROW((void)kernel.weighted_sum(x, y, w), std::invalid_argument);
+}
+
+TEST(Random, StreamsAreReproducibleAndDistinct) {
+    RandomEngine a(SEED, 3), b(SEED, 3), c(SEED, 4);
+    for (int i = 0; i < 100; ++i) {
+        uint64_t x = a();
+        EXPECT_EQ(x, b());
+        EXPECT_NE(x, c());
+    }
+
+    RandomEngine jumped(SEED, 3);
+    jumped.jump();
+    EXPECT_FALSE(jumped == a);
+}
+
+TEST(Random, BatchNormalSamplesAreStandardNormal) {
+    RandomEngine rng(11);
+    std::vector<double> z(200001); // Odd, so the unpaired tail is exercised
+    normal_samples(rng, z);
+    double mean = 0, var = 0;
+    for (double v : z) mean += v;
+    mean /= z.size();
+    for (double v : z) var += (v - mean) * (v - mean);
+    var /= z.size();
+    EXPECT_NEAR(mean, 0.0, 0.01);
+    EXPECT_NEAR(var, 1.0, 0.01);
+    for (double v : z) ASSERT_TRUE(std::isfinite(v));
+}
+
+TEST(NormalDistributionRandom, IntegrationIsReproducibleAcrossThreads) {
+    NormalDistribution::covariance cov = {{{4.0, 1.0}, {1.0, 2.0}}};
+    NormalDistributionRandom dist(cov, P{0, 0}, 5000);
+
+    std::vector<Polygon> regions;
+    for (int i = 0; i < 16; ++i) {
+        double x = -4.0 + 0.5 * i;
+        regions.emplace_back(std::vector<P>{P{x, -1}, P{x + 2, -1}, P{x + 2, 2}, P{x, 2}});
+    }
+    std::vector<double> serial;
+    for (const auto& region : regions) serial.push_back(dist.integrate_probability(region));
+
+    // Same values in a different order and on other threads
+    EXPECT_EQ(dist.integrate_probability(regions[5]), serial[5]);
+    for (size_t threads : {1, 3, 4}) {
+        ThreadPool pool(threads);
+        std::vector<double> parallel(regions.size());
+        pool.for_chunks(regions.size(), [&](size_t, size_t begin, size_t end) {
+            for (size_t i = end; i-- > begin;) parallel[i] = dist.integrate_probability(regions[i]);
+        });
+        EXPECT_EQ(parallel, serial);
+    }
+
+    dist.set_seed(SEED + 1);
+    EXPECT_NE(dist.integrate_probability(regions[8]), serial[8]);
+    EXPECT_NEAR(dist.integrate_probability(regions[8]), serial[8], 0.05);
+}
+
+template <size_t N>
+void expect_exact_up_to_degree(const TriangleRule<N>& rule) {
+    // Integral of r^i s^j over the reference triangle is i! j! / (i + j + 2)!, divided by its area 1/2.
+    // The weights are tabulated to 15 digits, hence the tolerance.
+    for (int i = 0; i <= rule.degree; ++i) {
+        for (int j = 0; i + j <= rule.degree; ++j) {
+            double sum = 0.0;
+            for (size_t q = 0; q < N; ++q) sum += rule.w[q] * std::pow(rule.r[q], i) * std::pow(rule.s[q], j);
+            const double exact = 2.0 * std::tgamma(i + 1) * std::tgamma(j + 1) / std::tgamma(i + j + 3);
+            EXPECT_NEAR(sum, exact, 1e-10) << N << " points, r^" << i << " s^" << j;
+        }
+    }
+}
+
+TEST(QuadratureRule, DunavantRulesAreExactToTheirDegree) {
+    expect_exact_up_to_degree(DUNAVANT_7);
+    expect_exact_up_to_degree(DUNAVANT_12);
+    expect_exact_up_to_degree(DUNAVANT_25);
+}
+
+TEST(NormalDistributionQuadrature, CheaperRulesStayCloseToTheDefault) {
+    NormalDistributionQuadrature dist({{{4.0, 1.0}, {1.0, 3.0}}}, P{0.5, -0.5});
+    Polygon region(std::vector<P>{P{-1, -2}, P{3, -1}, P{4, 2}, P{0, 3}, P{-2, 1}});
+    EXPECT_EQ(dist.get_rule(), NormalDistributionQuadrature::Rule::DUNAVANT_25);
+    const double reference = dist.integrate_probability(region, P{0.3, 0.2});
+    dist.set_rule(NormalDistributionQuadrature::Rule::DUNAVANT_12);
+    EXPECT_NEAR(dist.integrate_probability(region, P{0.3, 0.2}), reference, 2e-3);
+    dist.set_rule(NormalDistributionQuadrature::Rule::DUNAVANT_7);
+    EXPECT_NEAR(dist.integrate_probability(region, P{0.3, 0.2}), reference, 5e-3);
+}
+
+TEST(NormalDistributionQuadrature, FloatPrecisionStaysCloseToDouble) {
+    NormalDistributionQuadrature dist({{{1600.0, 200.0}, {200.0, 900.0}}}, P{2.0, -1.0});
+    Polygon region(std::vector<P>{P{-10, -20}, P{30, -10}, P{40, 20}, P{0, 30}, P{-20, 10}});
+    PolarSector sector{20.0, 60.0, 0.3, 1.1};
+    EXPECT_EQ(dist.get_precision(), Precision::DOUBLE);
+    std::vector<double> reference;
+    for (P offset : {P{0, 0}, P{15, -5}, P{-80, 40}}) {
+        reference.push_back(dist.integrate_probability(region, offset));
+        reference.push_back(dist.integrate_probability(sector, offset));
+    }
+    dist.set_precision(Precision::FLOAT);
+    size_t k = 0;
+    for (P offset : {P{0, 0}, P{15, -5}, P{-80, 40}}) {
+        EXPECT_NEAR(dist.integrate_probability(region, offset), reference[k++], 1e-6);
+        EXPECT_NEAR(dist.integrate_probability(sector, offset), reference[k++], 1e-6);
+    }
+}
@@ -2,8 +2,16 @@
 #include "Game.h"
 #include "Distribution.h"
 #include "Geometry.h"
+#include "HitProbabilityField.h"
+#include <algorithm>
+#include <cmath>
+#include <span>
 #include <sstream>
+#include <stdexcept>
 #include <map>
+#include <random>
+#include <string>
+#include <type_traits>
 
 typedef Vec2 P;
 
@@ -122,6 +130,117 @@ TEST(Target, GetBeds) {
     EXPECT_EQ(beds.size(), 2);
 }
 
+TEST(Target, RecognisesPolarSectorBeds) {
+    std::stringstream input;
+    input << "2\n";
+    // Treble bed as written by gen_target.py: inner arc forward, outer arc backward
+    input << "60 18 red treble\n";
+    for (int i = 0; i <= 8; ++i) {
+        double a = M_PI / 2 - M_PI / 20 + (M_PI / 10) * i / 8;
+        input << 99 * std::cos(a) << " " << 99 * std::sin(a) << " ";
+    }
+    for (int i = 8; i >= 0; --i) {
+        double a = M_PI / 2 - M_PI / 20 + (M_PI / 10) * i / 8;
+        input << 107 * std::cos(a) << " " << 107 * std::sin(a) << " ";
+    }
+    input << "\n";
+    input << "20 4 white normal\n-5 -5 5 -5 5 5 -5 5\n";
+    Target target(input);
+
+    const auto& beds = target.get_beds();
+    ASSERT_TRUE(beds[0].get_sector().has_value());
+    EXPECT_NEAR(beds[0].get_sector()->r_inner, 99, 1e-4);
+    EXPECT_NEAR(beds[0].get_sector()->r_outer, 107, 1e-4);
+    EXPECT_FALSE(beds[1].get_sector().has_value());
+
+    // Just inside the outer arc halfway between two vertices, where the polygon chord would miss
+    double mid_chord = M_PI / 2 + (M_PI / 10) / 16;
+    ASSERT_FALSE(beds[0].get_shape().contains(P{106.99 * std::cos(mid_chord), 106.99 * std::sin(mid_chord)}));
+    HitData hit = target.after_hit(P{106.99 * std::cos(mid_chord), 106.99 * std::sin(mid_chord)});
+    EXPECT_EQ(hit.diff, -60);
+    EXPECT_EQ(hit.type, HitData::Type::TREBLE);
+    EXPECT_EQ(target.after_hit(P{0, 0}).diff, -20);
+}
+
+// Linear scan over the beds, what after_hit() did before the spatial index
+static HitData after_hit_linear(const Target& target, P p) {
+    for (const auto& bed : target.get_beds()) {
+        if (bed.inside(p)) return bed.after_hit();
+    }
+    return HitData(HitData::Type::NORMAL, 0);
+}
+
+static std::string dartboard_like_target() {
+    // Bull, 20 sectors in four rings (the first centred on the positive x axis) and the outer bull
+    // as a full disc listed last, so the bull only wins through bed order
+    std::stringstream input;
+    const double radii[] = {6.35, 16, 99, 107, 162, 170};
+    input << 2 + 20 * 4 << "\n";
+    input << "50 36 red double\n";
+    for (int i = 0; i < 36; ++i) input << 6.35 * std::cos(2 * M_PI * i / 36) << " " << 6.35 * std::sin(2 * M_PI * i / 36) << " ";
+    input << "\n";
+    for (int ring = 2; ring < 6; ++ring) {
+        for (int sector = 0; sector < 20; ++sector) {
+            double a0 = -M_PI / 20 + sector * M_PI / 10;
+            int subdivisions = 4;
+            input << sector + 1 << " " << 2 * (subdivisions + 1) << " w " << (ring == 3 ? "treble" : ring == 5 ? "double" : "normal") << "\n";
+            for (int i = 0; i <= subdivisions; ++i) {
+                double a = a0 + (M_PI / 10) * i / subdivisions;
+                input << radii[ring - 1] * std::cos(a) << " " << radii[ring - 1] * std::sin(a) << " ";
+            }
+            for (int i = subdivisions; i >= 0; --i) {
+                double a = a0 + (M_PI / 10) * i / subdivisions;
+                input << radii[ring] * std::cos(a) << " " << radii[ring] * std::sin(a) << " ";
+            }
+            input << "\n";
+        }
+    }
+    input << "25 36 green normal\n";
+    for (int i = 0; i < 36; ++i) input << 16 * std::cos(2 * M_PI * i / 36) << " " << 16 * std::sin(2 * M_PI * i / 36) << " ";
+    input << "\n";
+    return input.str();
+}
+
+TEST(Target, SpatialIndexMatchesLinearScan) {
+    std::stringstream board_input(dartboard_like_target());
+    Target board(board_input);
+    for (const auto& bed : board.get_beds()) {
+        ASSERT_TRUE(bed.get_sector().has_value());
+    }
+
+    // Mixed target: one sector bed and overlapping plain polygons
+    std::stringstream mixed_input;
+    mixed_input << "3\n";
+    mixed_input << "60 10 red treble\n";
+    for (int i = 0; i <= 4; ++i) mixed_input << 99 * std::cos(0.1 * i) << " " << 99 * std::sin(0.1 * i) << " ";
+    for (int i = 4; i >= 0; --i) mixed_input << 107 * std::cos(0.1 * i) << " " << 107 * std::sin(0.1 * i) << " ";
+    mixed_input << "\n20 4 white normal\n-5 -5 5 -5 5 5 -5 5\n";
+    mixed_input << "7 3 blue normal\n0 0 120 0 0 120\n";
+    Target mixed(mixed_input);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> coord(-190.0, 190.0);
+    std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+    for (const Target* target : {&board, &mixed}) {
+        for (int i = 0; i < 20000; ++i) {
+            P p{coord(rng), coord(rng)};
+            HitData expected = after_hit_linear(*target, p);
+            HitData actual = target->after_hit(p);
+            ASSERT_EQ(actual, expected) << p.x << " " << p.y;
+        }
+        // Points on ring and sector boundaries
+        for (double r : {0.0, 6.35, 16.0, 99.0, 107.0, 162.0, 170.0}) {
+            for (int k = 0; k < 40; ++k) {
+                double a = -M_PI / 20 + k * M_PI / 20;
+                P p{r * std::cos(a), r * std::sin(a)};
+                ASSERT_EQ(target->after_hit(p), after_hit_linear(*target, p)) << p.x << " " << p.y;
+            }
+            P q{r * std::cos(angle(rng)), r * std::sin(angle(rng))};
+            ASSERT_EQ(target->after_hit(q), after_hit_linear(*target, q));
+        }
+    }
+}
+
 TEST(Target, Import) {
     std::stringstream input;
     input << "1\n20\n4\nred\nnormal\n0 0\n1 0\n1 1\n0 1\n";
@@ -133,6 +252,84 @@ TEST(Target, Import) {
     EXPECT_EQ(hit.diff, -20);
 }
 
+TEST(Target, BinaryRoundTrip) {
+    std::stringstream board_input(dartboard_like_target());
+    Target board(board_input);
+    std::stringstream mixed_input;
+    mixed_input << "2\n20 4 white normal\n-5 -5 5 -5 5 5 -5 5\n7 3 blue double\n0 0 120 0 0 120\n";
+    Target mixed(mixed_input);
+
+    const auto& square = mixed.get_beds()[0].get_shape();
+    EXPECT_DOUBLE_EQ(square.get_area(), 100.0);
+    EXPECT_EQ(square.get_fan_center(), P(0, 0));
+    EXPECT_EQ(square.bounding_box(), std::pair(P(-5, -5), P(5, 5)));
+    ASSERT_EQ(square.get_fan_areas().size(), 4u);
+    for (double area : square.get_fan_areas()) EXPECT_DOUBLE_EQ(area, 25.0);
+
+    NormalDistribution::covariance cov = {{{400, 50}, {50, 300}}};
+    NormalDistributionQuadrature dist(cov, P{0, 0});
+    for (const Target* original : {&board, &mixed}) {
+        std::stringstream bytes;
+        original->save_binary(bytes);
+        Target loaded(bytes);
+
+        const auto& expected = original->get_beds();
+        const auto& actual = loaded.get_beds();
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            const auto& shape = actual[i].get_shape();
+            EXPECT_EQ(actual[i].after_hit(), expected[i].after_hit());
+            EXPECT_EQ(shape.get_vertices(), expected[i].get_shape().get_vertices());
+            EXPECT_EQ(shape.get_area(), expected[i].get_shape().get_area());
+            EXPECT_EQ(shape.bounding_box(), expected[i].get_shape().bounding_box());
+            EXPECT_TRUE(std::ranges::equal(shape.get_fan_areas(), expected[i].get_shape().get_fan_areas()));
+            ASSERT_EQ(actual[i].get_sector().has_value(), expected[i].get_sector().has_value());
+            if (expected[i].get_sector()) {
+                EXPECT_EQ(actual[i].get_sector()->r_outer, expected[i].get_sector()->r_outer);
+                EXPECT_EQ(actual[i].get_sector()->angle_start, expected[i].get_sector()->angle_start);
+            }
+            EXPECT_EQ(dist.integrate_probability(shape, P(3, -7)),
+                      dist.integrate_probability(expected[i].get_shape(), P(3, -7)));
+        }
+        for (P p : {P(0, 0), P(4, 4), P(100, 10), P(-30, 140), P(60, 59)}) {
+            EXPECT_EQ(loaded.after_hit(p), original->after_hit(p));
+        }
+    }
+
+    // Truncated and foreign-version files are rejected
+    std::stringstream bytes;
+    mixed.save_binary(bytes);
+    std::string data = bytes.str();
+    std::stringstream truncated(data.substr(0, data.size() - 1));
+    EXPECT_THROW(Target{truncated}, std::runtime_error);
+    data[8] = static_cast<char>(Target::BINARY_VERSION + 1);
+    std::stringstream other_version(data);
+    EXPECT_THROW(Target{other_version}, std::runtime_error);
+}
+
+TEST(Target, BinaryRejectsCorruptCountsBeforeAllocating) {
+    std::stringstream input;
+    input << "2\n20 4 white normal\n-5 -5 5 -5 5 5 -5 5\n7 3 blue double\n0 0 120 0 0 120\n";
+    std::stringstream bytes;
+    Target(input).save_binary(bytes);
+    const std::string data = bytes.str();
+
+    // Bed count (offset 12) and vertex count (offset 16) far beyond the file, read as parse errors
+    std::string many_beds = data;
+    for (size_t k = 12; k < 16; ++k) many_beds[k] = static_cast<char>(0xFF);
+    std::stringstream many_beds_input(many_beds);
+    EXPECT_THROW(Target{many_beds_input}, std::runtime_error);
+    std::string many_vertices = data;
+    for (size_t k = 16; k < 24; ++k) many_vertices[k] = static_cast<char>(0x7F);
+    std::stringstream many_vertices_input(many_vertices);
+    EXPECT_THROW(Target{many_vertices_input}, std::runtime_error);
+    // One vertex more than the file holds
+    std::string one_more = data;
+    ++one_more[16];
+    std::stringstream one_more_input(one_more);
+    EXPECT_THROW(Target{one_more_input}, std::runtime_error);
+}
+
 // Game bounds tests
 TEST(Game, GetTargetBounds) {
     std::stringstream input;
@@ -365,6 +562,282 @@ TEST(Game, ThrowAtProbabilitiesSum) {
     EXPECT_NEAR(total_prob, 1.0, 0.01);
 }
 
+TEST(Game, OutcomeTableBudgetReusesOffGridRows) {
+    std::stringstream input;
+    input << "2\n";
+    input << "10\n4\nred\nnormal\n-3 -3\n3 -3\n3 3\n-3 3\n";
+    input << "5\n4\nblue\ndouble\n5 5\n8 5\n8 8\n5 8\n";
+    Target target(input);
+    NormalDistributionQuadrature dist({{{2, 0}, {0, 2}}}, P{0, 0});
+    GameFinishOnDouble game(target, dist);
+    GameFinishOnDouble reference(target, dist);
+
+    const size_t row_bytes = game.get_outcome_count() * sizeof(Game::Outcome) + LruCache<Vec2, Game::AimIndex>::ENTRY_OVERHEAD;
+    EXPECT_THROW(game.set_outcome_table_budget(row_bytes - 1), std::invalid_argument);
+    EXPECT_EQ(game.get_outcome_table_usage().budget, 0u);
+    game.set_outcome_table_budget(4 * row_bytes);
+    EXPECT_EQ(game.get_outcome_table_usage().budget, 4 * row_bytes);
+
+    // Aims beyond the budget evict the least recently used ones and reuse their rows
+    std::vector<P> aims;
+    for (int i = 0; i < 20; ++i) aims.push_back(P{i * 0.3, -i * 0.2});
+    for (P aim : aims) {
+        auto row = game.throw_at_outcomes(aim);
+        auto expected = reference.throw_at_outcomes(aim);
+        ASSERT_EQ(row.size(), expected.size());
+        for (size_t k = 0; k < row.size(); ++k) EXPECT_EQ(row[k].probability, expected[k].probability);
+    }
+    const CacheUsage usage = game.get_outcome_table_usage();
+    EXPECT_EQ(usage.evictions, aims.size() - 4);
+    EXPECT_LT(usage.entries, reference.get_outcome_table_usage().entries);
+    // An evicted aim gets a recomputed row, a recent one keeps its index
+    const Game::AimIndex recent = game.aim_index(aims.back());
+    EXPECT_EQ(game.aim_index(aims.back()), recent);
+    auto again = game.throw_at_outcomes(aims.front());
+    auto expected = reference.throw_at_outcomes(aims.front());
+    for (size_t k = 0; k < again.size(); ++k) EXPECT_EQ(again[k].probability, expected[k].probability);
+
+    // Lowering the budget trims right away
+    game.set_outcome_table_budget(row_bytes);
+    EXPECT_GT(game.get_outcome_table_usage().evictions, usage.evictions);
+}
+
+TEST(Game, OffGridScopePinsResolvedRows) {
+    std::stringstream input;
+    input << "2\n";
+    input << "10\n4\nred\nnormal\n-3 -3\n3 -3\n3 3\n-3 3\n";
+    input << "5\n4\nblue\ndouble\n5 5\n8 5\n8 8\n5 8\n";
+    Target target(input);
+    NormalDistributionQuadrature dist({{{2, 0}, {0, 2}}}, P{0, 0});
+    GameFinishOnDouble game(target, dist);
+    GameFinishOnDouble reference(target, dist);
+    const size_t row_bytes = game.get_outcome_count() * sizeof(Game::Outcome) + LruCache<Vec2, Game::AimIndex>::ENTRY_OVERHEAD;
+    game.set_outcome_table_budget(4 * row_bytes);
+
+    std::vector<P> aims;
+    for (int i = 0; i < 10; ++i) aims.push_back(P{i * 0.3, -i * 0.2});
+    std::vector<std::span<const Game::Outcome>> rows;
+    {
+        Game::OffGridScope pinned(game);
+        for (P aim : aims) {
+            Game::OffGridScope nested(game);
+            rows.push_back(game.throw_at_outcomes(aim));
+        }
+        // Nothing resolved in the scope was evicted, every span still holds its own aim
+        EXPECT_EQ(game.get_outcome_table_usage().evictions, 0u);
+        for (size_t i = 0; i < aims.size(); ++i) {
+            auto expected = reference.throw_at_outcomes(aims[i]);
+            for (size_t k = 0; k < expected.size(); ++k) EXPECT_EQ(rows[i][k].probability, expected[k].probability);
+        }
+    }
+    // Closing the outermost scope trims back to the budget
+    EXPECT_EQ(game.get_outcome_table_usage().evictions, aims.size() - 4);
+    EXPECT_EQ(game.get_outcome_table_usage().entries, 4u);
+}
+
+TEST(Game, OutcomeTableRowsAreStableViews) {
+    std::stringstream input;
+    input << "3\n";
+    input << "10\n4\nred\nnormal\n-3 -3\n3 -3\n3 3\n-3 3\n";
+    input << "5\n4\nblue\ndouble\n5 5\n8 5\n8 8\n5 8\n";
+    input << "10\n4\nred\nnormal\n-8 -8\n-5 -8\n-5 -5\n-8 -5\n";
+    Target target(input);
+
+    NormalDistribution::covariance cov = {{{2, 0}, {0, 2}}};
+    NormalDistributionQuadrature dist(cov, P{0, 0});
+    GameFinishOnDouble game(target, dist);
+
+    // Two beds share an outcome, plus the miss
+    EXPECT_EQ(game.get_outcome_count(), 3);
+
+    Game::AimIndex first = game.aim_index(P{0, 0});
+    std::span<const Game::Outcome> row = game.outcomes(first);
+    const Game::Outcome* row_data = row.data();
+    ASSERT_EQ(row.size(), 3);
+    EXPECT_EQ(game.aim_index(P{0, 0}), first);
+
+    // Enough new aims to start several new storage blocks
+    for (int i = 0; i < 1000; ++i) {
+        (void)game.aim_index(P{i * 0.01, -i * 0.02});
+    }
+    EXPECT_EQ(game.outcomes(first).data(), row_data);
+
+    auto distribution = game.throw_at_distribution(P{0, 0});
+    ASSERT_EQ(distribution.size(), row.size());
+    for (size_t k = 0; k < row.size(); ++k) {
+        EXPECT_EQ(distribution[k].first, row[k].hit);
+        EXPECT_EQ(distribution[k].second, row[k].probability);
+    }
+
+    auto transitions = game.throw_at(first, 10);
+    ASSERT_EQ(transitions.size(), row.size());
+    size_t k = 0;
+    for (const auto& [state, prob] : transitions) {
+        EXPECT_EQ(state, game.handle_throw(10, row[k].hit));
+        EXPECT_EQ(prob, row[k].probability);
+        ++k;
+    }
+    EXPECT_EQ(k, row.size());
+}
+
+TEST(AimGrid, IndexLayoutAndExactLookup) {
+    AimGrid grid(P{-10, -5}, P{10, 5}, 4, 3);
+    ASSERT_EQ(grid.size(), 12);
+    EXPECT_EQ(grid.index(2, 1), 7);
+    EXPECT_EQ(grid[7], (P{grid.aim_x(2), grid.aim_y(1)}));
+    EXPECT_DOUBLE_EQ(grid.aim_x(0), -7.5);
+    EXPECT_DOUBLE_EQ(grid.aim_y(2), 10.0 / 3.0);
+
+    for (size_t index = 0; index < grid.size(); ++index) {
+        size_t found;
+        ASSERT_TRUE(grid.find(grid[index], found));
+        EXPECT_EQ(found, index);
+    }
+    size_t found;
+    EXPECT_FALSE(grid.find(grid[5] + P{1e-9, 0}, found));
+    EXPECT_FALSE(grid.find(P{100, 0}, found));
+
+    AimGrid solver_grid = AimGrid::with_samples(P{0, 0}, P{1, 1}, 1000);
+    EXPECT_EQ(solver_grid.get_height(), 31);
+    EXPECT_EQ(solver_grid.get_width(), 32);
+    EXPECT_THROW(AimGrid(P{0, 0}, P{1, 1}, 0, 3), std::invalid_argument);
+}
+
+TEST(Game, SharesAimGridsAndRows) {
+    std::stringstream input;
+    input << "1\n";
+    input << "10\n4\nred\nnormal\n-3 -3\n3 -3\n3 3\n-3 3\n";
+    Target target(input);
+
+    NormalDistribution::covariance cov = {{{2, 0}, {0, 2}}};
+    NormalDistributionQuadrature dist(cov, P{0, 0});
+    GameFinishOnAny game(target, dist);
+
+    const AimGrid& grid = game.aim_grid(100);
+    EXPECT_EQ(&game.aim_grid(100), &grid);
+    EXPECT_EQ(&game.aim_grid(AimGrid(grid)), &grid);
+    EXPECT_NE(&game.aim_grid(400), &grid);
+
+    Game::AimIndex first = game.first_row(grid);
+    for (size_t a = 0; a < grid.size(); a += 7) {
+        EXPECT_EQ(game.aim_index(grid[a]), first + a);
+    }
+    AimGrid foreign(P{0, 0}, P{1, 1}, 2, 2);
+    EXPECT_THROW((void)game.first_row(foreign), std::invalid_argument);
+
+    // Off-grid aims get their own stable row
+    Game::AimIndex off_grid = game.aim_index(P{0.123, 0.456});
+    EXPECT_EQ(game.aim_index(P{0.123, 0.456}), off_grid);
+    EXPECT_GE(off_grid, first + grid.size());
+}
+
+TEST(Game, SymmetricRowsMatchDirectIntegration) {
+    std::stringstream board_input(dartboard_like_target());
+    Target board(board_input);
+
+    // The symmetries kept depend on the covariance: all eight, the two mirrors and the half turn, or the half turn
+    const std::pair<NormalDistribution::covariance, size_t> cases[] = {
+        {{{{400, 0}, {0, 400}}}, 8},
+        {{{{400, 0}, {0, 150}}}, 4},
+        {{{{400, 60}, {60, 150}}}, 2},
+    };
+    for (const auto& [cov, order] : cases) {
+        NormalDistributionQuadrature dist(cov, P{0, 0});
+        GameFinishOnDouble symmetric(board, dist);
+        GameFinishOnDouble direct(board, dist);
+        direct.set_use_symmetry(false);
+        EXPECT_EQ(symmetric.get_symmetry_order(), order);
+
+        const AimGrid& grid = symmetric.aim_grid(400);
+        const AimGrid& direct_grid = direct.aim_grid(400);
+        for (size_t a = grid.size(); a-- > 0;) {
+            auto expected = direct.outcomes(direct.first_row(direct_grid) + a);
+            auto actual = symmetric.outcomes(symmetric.first_row(grid) + a);
+            ASSERT_EQ(actual.size(), expected.size());
+            for (size_t k = 0; k < actual.size(); ++k) {
+                EXPECT_EQ(actual[k].hit, expected[k].hit);
+                // The board is written with six digits, so its sectors only agree to about 1e-6
+                EXPECT_NEAR(actual[k].probability, expected[k].probability, 1e-7) << "aim " << a << " outcome " << k;
+            }
+        }
+    }
+
+    // A shifted mean or Monte Carlo integration break the symmetry
+    NormalDistribution::covariance cov = {{{400, 0}, {0, 400}}};
+    NormalDistributionQuadrature shifted(cov, P{3, 0});
+    NormalDistributionRandom random(cov, P{0, 0}, 100);
+    EXPECT_EQ(GameFinishOnDouble(board, shifted).get_symmetry_order(), 1u);
+    EXPECT_EQ(GameFinishOnDouble(board, random).get_symmetry_order(), 1u);
+}
+
+TEST(Game, RefreshDistributionRecomputesRowsAndSymmetries) {
+    std::stringstream board_input(dartboard_like_target());
+    Target board(board_input);
+
+    NormalDistributionQuadrature dist({{{400, 0}, {0, 400}}}, P{0, 0});
+    GameFinishOnDouble game(board, dist);
+    const AimGrid& grid = game.aim_grid(400);
+    HitProbabilityField field(board, dist, grid);
+    game.use_hit_probability_field(field);
+    EXPECT_EQ(game.get_symmetry_order(), 8u);
+    (void)game.outcomes(game.first_row(grid) + 17);
+
+    const NormalDistribution::covariance tilted = {{{400, 60}, {60, 150}}};
+    dist.set_parameters(tilted);
+    game.refresh_distribution();
+    EXPECT_EQ(game.get_symmetry_order(), 2u);
+
+    // Rows are recomputed by quadrature for the new parameters, the field of the old ones is dropped
+    NormalDistributionQuadrature fresh_dist(tilted, P{0, 0});
+    GameFinishOnDouble fresh(board, fresh_dist);
+    const AimGrid& fresh_grid = fresh.aim_grid(400);
+    for (size_t a : {size_t{0}, size_t{17}, size_t{213}}) {
+        auto expected = fresh.outcomes(fresh.first_row(fresh_grid) + a);
+        auto actual = game.outcomes(game.first_row(grid) + a);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t k = 0; k < actual.size(); ++k) {
+            EXPECT_EQ(actual[k].hit, expected[k].hit);
+            EXPECT_EQ(actual[k].probability, expected[k].probability) << "aim " << a << " outcome " << k;
+        }
+    }
+}
+
+TEST(Game, CulledBedsOnlyDropNegligibleMass) {
+    std::stringstream board_input(dartboard_like_target());
+    Target board(board_input);
+
+    // A tight player aiming at treble 20, at the board centre and off the board
+    NormalDistributionQuadrature dist({{{100, 20}, {20, 60}}}, P{0, 0});
+    GameFinishOnDouble culled(board, dist);
+    GameFinishOnDouble strict(board, dist);
+    strict.set_strict_integration(true);
+    EXPECT_TRUE(strict.is_strict_integration());
+    EXPECT_EQ(culled.get_cull_sigmas(), Game::DEFAULT_CULL_SIGMAS);
+
+    const size_t num_beds = board.get_beds().size();
+    for (P aim : {P{103, 0}, P{0, 0}, P{300, 300}}) {
+        auto expected = strict.throw_at_outcomes(aim);
+        auto actual = culled.throw_at_outcomes(aim);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t k = 0; k < actual.size(); ++k) {
+            EXPECT_EQ(actual[k].hit, expected[k].hit);
+            EXPECT_NEAR(actual[k].probability, expected[k].probability, 1e-14) << "outcome " << k;
+        }
+    }
+    auto stats = culled.get_bed_cull_stats();
+    EXPECT_EQ(stats.integrated + stats.skipped, 3 * num_beds);
+    EXPECT_GT(stats.skipped, 2 * num_beds); // Far more than the off-board aim's beds
+    EXPECT_EQ(strict.get_bed_cull_stats().skipped, 0u);
+    EXPECT_EQ(strict.get_bed_cull_stats().integrated, 3 * num_beds);
+
+    // Fewer standard deviations cull more, and recompute the rows
+    culled.reset_bed_cull_stats();
+    culled.set_cull_sigmas(3.0);
+    (void)culled.throw_at_outcomes(P{103, 0});
+    EXPECT_GT(culled.get_bed_cull_stats().skipped, stats.skipped / 3);
+    EXPECT_THROW(culled.set_cull_sigmas(0.0), std::invalid_argument);
+}
+
 TEST(Game, SampleConsistentWithDistribution) {
     // Sampling many times should give distribution consistent with throw_at
     std::stringstream input;
@@ -428,3 +901,180 @@ TEST(Game, DifferentAimPoints) {
     EXPECT_TRUE(found_90);
 }
 
+
+// HitProbabilityField tests
+TEST(HitProbabilityField, MatchesQuadrature) {
+    std::stringstream input;
+    input << "3\n";
+    input << "20\n4\nred\nnormal\n-3 -3\n3 -3\n3 3\n-3 3\n";
+    input << "40\n4\nred\ndouble\n3 -3\n6 -3\n6 3\n3 3\n";
+    input << "5\n3\nblue\nnormal\n-6 4\n0 8\n-6 8\n";
+    Target target(input);
+
+    NormalDistribution::covariance cov = {{{4, 1}, {1, 3}}};
+    NormalDistributionQuadrature dist(cov, P{0.5, -0.25});
+    GameFinishOnAny game(target, dist);
+
+    HitProbabilityField field(target, dist, game.get_target_bounds(), 9, 7, 0.1);
+    auto [min_point, max_point] = game.get_target_bounds();
+
+    for (size_t i = 0; i < 9; ++i) {
+        for (size_t j = 0; j < 7; ++j) {
+            double x = min_point.x + (max_point.x - min_point.x) * (i + 0.5) / 9;
+            double y = min_point.y + (max_point.y - min_point.y) * (j + 0.5) / 7;
+            ASSERT_TRUE(field.covers(P{x, y}));
+
+            auto expected = game.throw_at_distribution(P{x, y});
+            auto actual = field.distribution_at(P{x, y});
+            ASSERT_EQ(expected.size(), actual.size());
+            for (size_t k = 0; k < expected.size(); ++k) {
+                EXPECT_EQ(expected[k].first.diff, actual[k].first.diff);
+                EXPECT_EQ(expected[k].first.type, actual[k].first.type);
+                EXPECT_NEAR(expected[k].second, actual[k].second, 2e-3);
+            }
+        }
+    }
+}
+
+TEST(HitProbabilityField, BatchMatchesSingleFields) {
+    std::stringstream input;
+    input << "3\n";
+    input << "20\n4\nred\nnormal\n-3 -3\n3 -3\n3 3\n-3 3\n";
+    input << "40\n4\nred\ndouble\n3 -3\n6 -3\n6 3\n3 3\n";
+    input << "5\n3\nblue\nnormal\n-6 4\n0 8\n-6 8\n";
+    Target target(input);
+
+    NormalDistribution::covariance wide_cov = {{{4, 1}, {1, 3}}};
+    NormalDistribution::covariance narrow_cov = {{{1, 0}, {0, 0.5}}};
+    NormalDistributionQuadrature wide(wide_cov, P{0.5, -0.25});
+    NormalDistributionQuadrature narrow(narrow_cov, P{0.5, -0.25});
+    GameFinishOnAny game(target, wide);
+    const AimGrid& grid = game.aim_grid(63);
+
+    // A batch of one is the plain field
+    const NormalDistribution* single[] = {&wide};
+    auto alone = HitProbabilityField::batch(target, single, grid, 0.1);
+    HitProbabilityField field(target, wide, grid, 0.1);
+    ASSERT_EQ(alone.size(), 1u);
+    for (size_t i = 0; i < grid.get_width(); ++i) {
+        for (size_t j = 0; j < grid.get_height(); ++j) {
+            std::vector<double> expected(field.get_outcomes().size());
+            std::vector<double> actual(alone[0].get_outcomes().size());
+            field.probabilities_at(i, j, expected);
+            alone[0].probabilities_at(i, j, actual);
+            EXPECT_EQ(expected, actual);
+        }
+    }
+
+    // Both distributions ask for the 0.1 cells, so only the transform size differs from their own fields
+    const NormalDistribution* both[] = {&wide, &narrow};
+    auto fields = HitProbabilityField::batch(target, both, grid, 0.1);
+    ASSERT_EQ(fields.size(), 2u);
+    HitProbabilityField narrow_field(target, narrow, grid, 0.1);
+    for (size_t i = 0; i < grid.get_width(); ++i) {
+        for (size_t j = 0; j < grid.get_height(); ++j) {
+            for (auto [own, batched] : {std::pair{&field, &fields[0]}, std::pair{&narrow_field, &fields[1]}}) {
+                auto expected = own->distribution_at(i, j);
+                auto actual = batched->distribution_at(i, j);
+                ASSERT_EQ(expected.size(), actual.size());
+                for (size_t k = 0; k < expected.size(); ++k) {
+                    EXPECT_EQ(expected[k].first, actual[k].first);
+                    EXPECT_NEAR(expected[k].second, actual[k].second, 1e-9);
+                }
+            }
+        }
+    }
+    EXPECT_TRUE(HitProbabilityField::batch(target, {}, grid).empty());
+}
+
+TEST(HitProbabilityField, ServesGameOnGridOnly) {
+    std::stringstream input;
+    input << "2\n";
+    input << "10\n4\nred\nnormal\n-3 -3\n3 -3\n3 3\n-3 3\n";
+    input << "5\n4\nblue\nnormal\n5 5\n8 5\n8 8\n5 8\n";
+    Target target(input);
+
+    NormalDistribution::covariance cov = {{{2, 0}, {0, 2}}};
+    NormalDistributionQuadrature dist(cov, P{0, 0});
+    GameFinishOnAny game(target, dist);
+
+    HitProbabilityField field(target, dist, game.get_target_bounds(), 4, 4);
+    game.use_hit_probability_field(field);
+    auto [min_point, max_point] = game.get_target_bounds();
+
+    P on_grid{min_point.x + (max_point.x - min_point.x) * 1.5 / 4, min_point.y + (max_point.y - min_point.y) * 2.5 / 4};
+    auto served = game.throw_at_distribution(on_grid);
+    auto from_field = field.distribution_at(1, 2);
+    ASSERT_EQ(served.size(), from_field.size());
+    double total = 0.0;
+    for (size_t k = 0; k < served.size(); ++k) {
+        EXPECT_EQ(served[k].second, from_field[k].second);
+        total += served[k].second;
+    }
+    EXPECT_NEAR(total, 1.0, 1e-12);
+
+    P off_grid = on_grid + P{0.1, 0.0};
+    EXPECT_FALSE(field.covers(off_grid));
+    EXPECT_THROW((void)field.distribution_at(off_grid), std::out_of_range);
+    auto integrated = game.throw_at_distribution(off_grid);
+    EXPECT_EQ(integrated.size(), served.size());
+}
+
+TEST(HitProbabilityField, FloatTableRoundsTheDoubleTable) {
+    std::stringstream input;
+    input << "2\n";
+    input << "20\n4\nred\nnormal\n-3 -3\n3 -3\n3 3\n-3 3\n";
+    input << "40\n4\nred\ndouble\n3 -3\n6 -3\n6 3\n3 3\n";
+    Target target(input);
+
+    NormalDistributionQuadrature dist({{{4, 1}, {1, 3}}}, P{0.5, -0.25});
+    GameFinishOnAny game(target, dist);
+    const AimGrid& grid = game.aim_grid(49);
+    HitProbabilityField exact(target, dist, grid, 0.25);
+    HitProbabilityField rounded(target, dist, grid, 0.25, Precision::FLOAT);
+    EXPECT_EQ(exact.get_precision(), Precision::DOUBLE);
+    EXPECT_EQ(rounded.get_precision(), Precision::FLOAT);
+    ASSERT_EQ(exact.get_outcomes(), rounded.get_outcomes());
+
+    std::vector<double> expected(exact.get_outcomes().size());
+    std::vector<double> actual(rounded.get_outcomes().size());
+    for (size_t i = 0; i < grid.get_width(); ++i) {
+        for (size_t j = 0; j < grid.get_height(); ++j) {
+            exact.probabilities_at(i, j, expected);
+            rounded.probabilities_at(i, j, actual);
+            for (size_t k = 0; k < expected.size(); ++k) {
+                EXPECT_EQ(actual[k], static_cast<double>(static_cast<float>(expected[k])));
+            }
+        }
+    }
+
+    // Games read the float table through the same rows
+    game.use_hit_probability_field(rounded);
+    auto served = game.throw_at_distribution(grid[grid.index(2, 3)]);
+    rounded.probabilities_at(2, 3, actual);
+    ASSERT_EQ(served.size(), actual.size());
+    for (size_t k = 0; k < served.size(); ++k) EXPECT_EQ(served[k].second, actual[k]);
+}
+
+TEST(Game, CompileTimeRulesMatchHandleThrow) {
+    std::stringstream input("1\n20\n4\nred\nnormal\n0 0\n1 0\n1 1\n0 1\n");
+    Target target(input);
+    NormalDistributionQuadrature dist({{{1.0, 0.0}, {0.0, 1.0}}}, P{0, 0});
+    GameFinishOnAny any(target, dist);
+    GameFinishOnDouble doubles(target, dist);
+    EXPECT_TRUE(any.with_rules([](const auto& rules) { return std::is_same_v<std::decay_t<decltype(rules)>, FinishOnAnyRules>; }));
+    EXPECT_TRUE(doubles.with_rules([](const auto& rules) { return std::is_same_v<std::decay_t<decltype(rules)>, FinishOnDoubleRules>; }));
+
+    const std::vector<HitData> hits = {
+        {HitData::Type::NORMAL, 0}, {HitData::Type::NORMAL, -5}, {HitData::Type::DOUBLE, -10},
+        {HitData::Type::TREBLE, -30}, {HitData::Type::DOUBLE, -40},
+    };
+    for (const Game* game : {static_cast<const Game*>(&any), static_cast<const Game*>(&doubles)}) {
+        for (Game::State s : {1u, 5u, 10u, 40u, 100u}) {
+            for (HitData hit : hits) {
+                EXPECT_EQ(game->with_rules([&](const auto& rules) { return rules(s, hit); }), game->handle_throw(s, hit));
+                EXPECT_EQ(VirtualRules{game}(s, hit), game->handle_throw(s, hit));
+            }
+        }
+    }
+}
@@ -186,3 +186,63 @@ TEST(Polygon, Pentagon) {
     EXPECT_TRUE(pentagon.contains(P{0, 0}));
     EXPECT_FALSE(pentagon.contains(P{2, 2}));
 }
+
+// Builds a ring sector polygon the way gen_target.py does: inner arc forward, outer arc backward.
+static Polygon ring_sector_polygon(double r_inner, double r_outer, double a_start, double a_end, int subdivisions) {
+    std::vector<P> vertices;
+    for (int i = 0; i <= subdivisions; ++i) {
+        double a = a_start + (a_end - a_start) * i / subdivisions;
+        vertices.emplace_back(r_inner * std::cos(a), r_inner * std::sin(a));
+    }
+    for (int i = subdivisions; i >= 0; --i) {
+        double a = a_start + (a_end - a_start) * i / subdivisions;
+        vertices.emplace_back(r_outer * std::cos(a), r_outer * std::sin(a));
+    }
+    return Polygon(vertices);
+}
+
+TEST(PolarSector, RecogniseRingSector) {
+    double a_start = M_PI / 2 - M_PI / 20;
+    double a_end = M_PI / 2 + M_PI / 20;
+    auto sector = ring_sector_polygon(99, 107, a_start, a_end, 8).as_polar_sector();
+    ASSERT_TRUE(sector.has_value());
+    EXPECT_NEAR(sector->r_inner, 99, 1e-9);
+    EXPECT_NEAR(sector->r_outer, 107, 1e-9);
+    EXPECT_NEAR(sector->angle_start, a_start, 1e-9);
+    EXPECT_NEAR(sector->angle_end, a_end, 1e-9);
+
+    // Sectors crossing the negative x axis keep a positive span
+    auto wrapped = ring_sector_polygon(16, 99, M_PI - 0.1, M_PI + 0.2, 8).as_polar_sector();
+    ASSERT_TRUE(wrapped.has_value());
+    EXPECT_NEAR(wrapped->angle_end - wrapped->angle_start, 0.3, 1e-9);
+    EXPECT_TRUE(wrapped->contains(P{-50, 0}));
+    EXPECT_TRUE(wrapped->contains(P{-50, -5}));
+    EXPECT_FALSE(wrapped->contains(P{-50, 20}));
+}
+
+TEST(PolarSector, RecogniseDisc) {
+    std::vector<P> vertices;
+    for (int i = 0; i < 160; ++i) {
+        double a = 2 * M_PI * i / 160;
+        vertices.emplace_back(6.35 * std::cos(a), 6.35 * std::sin(a));
+    }
+    auto sector = Polygon(vertices).as_polar_sector();
+    ASSERT_TRUE(sector.has_value());
+    EXPECT_EQ(sector->r_inner, 0.0);
+    EXPECT_NEAR(sector->r_outer, 6.35, 1e-9);
+    EXPECT_NEAR(sector->angle_end - sector->angle_start, 2 * M_PI, 1e-12);
+    EXPECT_TRUE(sector->contains(P{0, 0}));
+    EXPECT_TRUE(sector->contains(P{-6, 0}));
+    EXPECT_FALSE(sector->contains(P{6.4, 0}));
+}
+
+TEST(PolarSector, RejectCoarseAndGeneralShapes) {
+    Polygon square(std::vector<P>{P{-1, -1}, P{1, -1}, P{1, 1}, P{-1, 1}});
+    EXPECT_FALSE(square.as_polar_sector().has_value());
+
+    // Trapezoids with 45 degree arcs are too coarse to be treated as sectors
+    EXPECT_FALSE(ring_sector_polygon(50, 100, 0, M_PI / 4, 1).as_polar_sector().has_value());
+
+    Polygon triangle(std::vector<P>{P{0, 0}, P{2, 0}, P{1, 1.5}});
+    EXPECT_FALSE(triangle.as_polar_sector().has_value());
+}
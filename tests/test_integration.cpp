@@ -2,10 +2,27 @@
 #include "Game.h"
 #include "Solver.h"
 #include "Distribution.h"
+#include "CovarianceBatch.h"
 #include "Geometry.h"
+#include "HitProbabilityField.h"
+#include "Instrumentation.h"
+#include "MatchSimulator.h"
+#include "ResultStream.h"
+#include "SolutionTable.h"
+#include "ThreadPool.h"
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <cmath>
+#include <cstring>
+#include <iterator>
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
 
 /**
  * Integration tests for the darts solver system.
@@ -311,18 +328,22 @@ TEST(Integration, HeatMapSolverVariation) {
     HeatMapVisualizer heat_visualizer(solver, 20, 20);  // 20x20 grid
     auto heat_map = heat_visualizer.heat_map(50);
     
-    EXPECT_EQ(heat_map.size(), 20) << "Heat map should have correct height";
-    EXPECT_EQ(heat_map[0].size(), 20) << "Heat map should have correct width";
+    EXPECT_EQ(heat_map.rows(), 20) << "Heat map should have correct height";
+    EXPECT_EQ(heat_map.cols(), 20) << "Heat map should have correct width";
+
+    // Row-major: row r is y, column c is x, at the cell centres
+    auto [min_point, max_point] = game.get_target_bounds();
+    Vec2 cell{min_point.x + (max_point.x - min_point.x) * 3.5 / 20, min_point.y + (max_point.y - min_point.y) * 12.5 / 20};
+    EXPECT_EQ(heat_map(12, 3), solver.solve_aim(50, cell));
+    EXPECT_EQ(heat_map[12][3], heat_map.data()[12 * 20 + 3]);
     
     // Find min and max values
     double min_val = std::numeric_limits<double>::max();
     double max_val = std::numeric_limits<double>::lowest();
     
-    for (const auto& row : heat_map) {
-        for (double val : row) {
-            min_val = std::min(min_val, val);
-            max_val = std::max(max_val, val);
-        }
+    for (double val : heat_map.values()) {
+        min_val = std::min(min_val, val);
+        max_val = std::max(max_val, val);
     }
     
     EXPECT_GT(max_val, min_val) 
@@ -646,19 +667,17 @@ TEST(MaxPointsSolver, HeatMapVisualization) {
     HeatMapVisualizer visualizer(solver, 15, 15);  // 15x15 grid
     auto heat_map = visualizer.heat_map(100);
     
-    EXPECT_EQ(heat_map.size(), 15) << "Heat map should have correct height";
-    EXPECT_EQ(heat_map[0].size(), 15) << "Heat map should have correct width";
+    EXPECT_EQ(heat_map.rows(), 15) << "Heat map should have correct height";
+    EXPECT_EQ(heat_map.cols(), 15) << "Heat map should have correct width";
     
     // Find min and max expected points
     double min_score = std::numeric_limits<double>::max();
     double max_score = std::numeric_limits<double>::lowest();
     
-    for (const auto& row : heat_map) {
-        for (double score : row) {
-            min_score = std::min(min_score, score);
-            max_score = std::max(max_score, score);
-            EXPECT_GE(score, 0.0) << "All scores should be non-negative";
-        }
+    for (double score : heat_map.values()) {
+        min_score = std::min(min_score, score);
+        max_score = std::max(max_score, score);
+        EXPECT_GE(score, 0.0) << "All scores should be non-negative";
     }
     
     // Heat map should show variation (different aims give different expected scores)
@@ -694,10 +713,10 @@ TEST(Integration, HeatMapWithDifferentSolvers) {
     auto heat_map_points = max_points_viz.heat_map(50);
     
     // Both should have correct dimensions
-    EXPECT_EQ(heat_map_throws.size(), 10);
-    EXPECT_EQ(heat_map_throws[0].size(), 10);
-    EXPECT_EQ(heat_map_points.size(), 10);
-    EXPECT_EQ(heat_map_points[0].size(), 10);
+    EXPECT_EQ(heat_map_throws.rows(), 10);
+    EXPECT_EQ(heat_map_throws.cols(), 10);
+    EXPECT_EQ(heat_map_points.rows(), 10);
+    EXPECT_EQ(heat_map_points.cols(), 10);
     
     // Both should show variation
     double min_throws = std::numeric_limits<double>::max();
@@ -723,6 +742,45 @@ TEST(Integration, HeatMapWithDifferentSolvers) {
     EXPECT_LT(max_points, 50.0) << "Max points shouldn't exceed highest zone value";
 }
 
+/**
+ * Test: ProgressiveHeatMap refines in passes to exactly the plain heat map,
+ * evaluating each cell once, and can be cancelled and resumed
+ */
+TEST(Integration, ProgressiveHeatMapRefinesToPlainMap) {
+    size_t calls = 0;
+    Game::Bounds bounds{Vec2{0, 0}, Vec2{40, 30}};
+    ProgressiveHeatMap counted(bounds, 30, 40, [&calls](Vec2 aim) { ++calls; return aim.x + 100 * aim.y; });
+    ASSERT_EQ(counted.pass_count(), 2u); // Strides of 2x3 cells, then every cell; 64 cells per axis does not refine
+    while (!counted.step(7)) {
+        if (counted.pass_finished()) {
+            EXPECT_EQ(counted.result()(1, 5), counted.result()(0, 4)) << "Preview cells copy their stride anchor";
+        }
+    }
+    EXPECT_EQ(calls, 30u * 40u);
+    EXPECT_EQ(counted.cells_done(), counted.cells_total());
+    EXPECT_DOUBLE_EQ(counted.result()(1, 5), 5.5 + 100 * 1.5);
+
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{200, 0}, {0, 200}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinThrows solver(game, 400);
+    HeatMapVisualizer plain(solver, 20, 24);
+    HeatMapVisualizer progressive(solver, 20, 24);
+
+    CancellationToken token;
+    auto job = progressive.progressive(40, std::array<size_t, 1>{4});
+    EXPECT_FALSE(job.step(10, &token));
+    token.cancel();
+    const size_t done = job.cells_done();
+    EXPECT_FALSE(job.step(SIZE_MAX, &token));
+    EXPECT_EQ(job.cells_done(), done) << "A cancelled job evaluates nothing more";
+    token.reset();
+    while (!job.step(SIZE_MAX, &token)) {}
+    EXPECT_EQ(job.result(), plain.heat_map(40));
+    EXPECT_TRUE(progressive.progressive(40).is_done()) << "The finished map is memoized";
+}
+
 
 // === SolverMinRounds Tests ===
 
@@ -827,3 +885,715 @@ TEST(SolverMinRounds, MidRoundDependsOnRoundStartScore) {
     // can have a different expected value.
     EXPECT_NE(state_from_40.first, state_from_80.first);
 }
+
+TEST(SolverMinRounds, RoundStartValueIsAFixedPoint) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{200.0, 0.0}, {0.0, 200.0}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+
+    for (unsigned int throws : {1u, 3u}) {
+        SolverMinRounds solver(game, throws, 225);
+        for (Game::State s : {40u, 50u, 90u}) {
+            auto [rounds, aim] = solver.solve(s);
+            ASSERT_LT(rounds, 1e4);
+            // Evaluating the chosen aim with busts worth the solved value must reproduce it
+            EXPECT_NEAR(solver.solve_aim(s, aim), rounds, 1e-9 * rounds) << "s=" << s << " throws=" << throws;
+        }
+    }
+}
+
+TEST(SolverMinRounds, HeatMapMatchesEveryCellAndMemoizesRoundStates) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{200.0, 0.0}, {0.0, 200.0}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinRounds solver(game, 3, 225);
+    const auto [min_point, max_point] = game.get_target_bounds();
+
+    // Mid-round, round start and an unreachable current score above the round start
+    for (auto [start, current, throw_number] : {std::tuple{80u, 40u, 2u}, {90u, 90u, 1u}, {40u, 60u, 3u}}) {
+        const HeatMap map = solver.heat_map(start, current, throw_number, 7, 9, 4);
+        ASSERT_EQ(map.rows(), 7u);
+        ASSERT_EQ(map.cols(), 9u);
+        for (size_t r = 0; r < map.rows(); ++r) {
+            for (size_t c = 0; c < map.cols(); ++c) {
+                const Vec2 aim{min_point.x + (max_point.x - min_point.x) * (c + 0.5) / 9,
+                               min_point.y + (max_point.y - min_point.y) * (r + 0.5) / 7};
+                EXPECT_EQ(map(r, c), solver.solve_aim_round_state(start, current, throw_number, aim));
+            }
+        }
+    }
+    EXPECT_EQ(solver.heat_map(80, 0, 2, 2, 2), HeatMap(2, 2, 0.0));
+
+    // Memoized round states answer like a fresh solver
+    SolverMinRounds fresh(game, 3, 225);
+    for (auto [start, current, throw_number] : {std::tuple{80u, 40u, 2u}, {80u, 40u, 3u}, {80u, 41u, 2u}, {40u, 40u, 1u}}) {
+        auto first = solver.solve_round_state(start, current, throw_number);
+        auto again = solver.solve_round_state(start, current, throw_number);
+        auto expected = fresh.solve_round_state(start, current, throw_number);
+        EXPECT_EQ(again, first);
+        EXPECT_NEAR(first.first, expected.first, 1e-9 * expected.first);
+    }
+}
+
+TEST(SolverMinRounds, HeatMapCellsKeepTheirRowsUnderASmallOutcomeBudget) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{200.0, 0.0}, {0.0, 200.0}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    const size_t row_bytes = game.get_outcome_count() * sizeof(Game::Outcome) + LruCache<Vec2, Game::AimIndex>::ENTRY_OVERHEAD;
+    game.set_outcome_table_budget(4 * row_bytes);
+    SolverMinRounds solver(game, 3, 225);
+    const auto [min_point, max_point] = game.get_target_bounds();
+
+    // 100 cells resolve far more off-grid rows than the budget holds
+    const HeatMap map = solver.heat_map(80, 40, 2, 10, 10, 4);
+    EXPECT_GE(game.get_outcome_table_usage().evictions, 100u - 4u); // Trimmed back to the budget on return
+    for (size_t r = 0; r < 10; ++r) {
+        for (size_t c = 0; c < 10; ++c) {
+            const Vec2 aim{min_point.x + (max_point.x - min_point.x) * (c + 0.5) / 10,
+                           min_point.y + (max_point.y - min_point.y) * (r + 0.5) / 10};
+            EXPECT_EQ(map(r, c), solver.solve_aim_round_state(80, 40, 2, aim));
+        }
+    }
+}
+
+// === Parallel SolverMinThrows Tests ===
+
+TEST(SolverMinThrows, SolveAllMatchesSerialBitForBit) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{150.0, 20.0}, {20.0, 120.0}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+
+    for (bool finish_on_double : {false, true}) {
+        GameFinishOnAny any_serial(target, dist), any_parallel(target, dist);
+        GameFinishOnDouble double_serial(target, dist), double_parallel(target, dist);
+        const Game& serial_game = finish_on_double ? static_cast<const Game&>(double_serial) : any_serial;
+        const Game& parallel_game = finish_on_double ? static_cast<const Game&>(double_parallel) : any_parallel;
+
+        SolverMinThrows serial(serial_game, 400);
+        SolverMinThrows parallel(parallel_game, 400);
+        parallel.solve_all(70, 4);
+
+        for (Game::State s = 0; s <= 70; ++s) {
+            auto expected = serial.solve(s);
+            auto actual = parallel.solve(s);
+            EXPECT_EQ(actual.first, expected.first) << "state " << s;
+            EXPECT_EQ(actual.second.x, expected.second.x) << "state " << s;
+            EXPECT_EQ(actual.second.y, expected.second.y) << "state " << s;
+        }
+    }
+}
+
+TEST(SolverMinThrows, SolversShareTheGameAimGrid) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{100.0, 0.0}, {0.0, 100.0}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+
+    SolverMinThrows min_throws(game, 400);
+    MaxPointsSolver max_points(game, 400);
+    EXPECT_EQ(&min_throws.get_aim_grid(), &max_points.get_aim_grid());
+
+    // Grid aims and solve_aim() from outside see the same rows
+    auto [score, aim] = min_throws.solve(32);
+    EXPECT_EQ(min_throws.solve_aim(32, aim), score);
+}
+
+TEST(SolverMinThrows, SolveAllThreadCountDoesNotMatter) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{100.0, 0.0}, {0.0, 100.0}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+
+    SolverMinThrows one_thread(game, 300);
+    SolverMinThrows many_threads(game, 300);
+    one_thread.solve_all(40, 1);
+    many_threads.solve_all(40, 7);
+
+    for (Game::State s = 1; s <= 40; ++s) {
+        EXPECT_EQ(one_thread.solve(s).first, many_threads.solve(s).first);
+    }
+    // State 1 cannot be finished on a double
+    EXPECT_GE(many_threads.solve(1).first, 1e8);
+}
+
+TEST(SolverMinThrows, WarmStartSearchesNearThePreviousOptima) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{150.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinThrows solver(game, 400);
+    solver.solve_all(80, 1);
+
+    // One more calibration throw moves the distribution a little
+    const NormalDistribution::covariance moved = {{{160.0, 5.0}, {5.0, 150.0}}};
+    dist.set_parameters(moved);
+    game.refresh_distribution();
+    NormalDistributionQuadrature fresh_dist(moved, Vec2{0, 0});
+    GameFinishOnDouble fresh_game(target, fresh_dist);
+    SolverMinThrows fresh(fresh_game, 400);
+    fresh.solve_all(80, 1);
+
+    // Only states that could be finished keep an aim, the others are searched in full again
+    size_t winable = 0;
+    for (Game::State s = 1; s <= 80; ++s) {
+        if (fresh.solve(s).first < 1e9) ++winable;
+    }
+    ASSERT_GT(winable, 0u);
+
+    // A window over the whole grid is the exhaustive search
+    solver.warm_start(solver.get_aim_grid().get_width());
+    EXPECT_EQ(solver.get_warm_start_states(), winable);
+    solver.solve_all(80, 1);
+    EXPECT_EQ(solver.get_warm_start_states(), 0u);
+    for (Game::State s = 1; s <= 80; ++s) {
+        EXPECT_EQ(solver.solve(s), fresh.solve(s)) << "state " << s;
+    }
+
+    // The default window evaluates a fraction of the aims and still finds the optima nearby
+    const size_t before = solver.get_aim_evaluations();
+    solver.warm_start();
+    solver.solve_all(80, 1);
+    EXPECT_LE(solver.get_aim_evaluations() - before, (80u - winable) * 400u + winable * 49u);
+    for (Game::State s = 1; s <= 80; ++s) {
+        EXPECT_NEAR(solver.solve(s).first, fresh.solve(s).first, 1e-3 * fresh.solve(s).first) << "state " << s;
+    }
+}
+
+TEST(SolverMinRounds, WarmStartConvergesToTheFreshSolution) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{150.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinRounds solver(game, 3, 100);
+    for (Game::State s = 2; s <= 60; ++s) (void)solver.solve(s);
+
+    const NormalDistribution::covariance moved = {{{170.0, 0.0}, {0.0, 160.0}}};
+    dist.set_parameters(moved);
+    game.refresh_distribution();
+    solver.warm_start();
+    NormalDistributionQuadrature fresh_dist(moved, Vec2{0, 0});
+    GameFinishOnDouble fresh_game(target, fresh_dist);
+    SolverMinRounds fresh(fresh_game, 3, 100);
+    for (Game::State s = 2; s <= 60; ++s) {
+        auto warm = solver.solve(s);
+        auto expected = fresh.solve(s);
+        EXPECT_NEAR(warm.first, expected.first, 1e-9 * expected.first) << "state " << s;
+        EXPECT_EQ(warm.second, expected.second) << "state " << s;
+    }
+}
+
+TEST(ThreadPool, RunsEveryIndexAndPropagatesExceptions) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+
+    std::vector<int> visits(pool.size(), 0);
+    pool.run([&](size_t thread) { ++visits[thread]; });
+    pool.run([&](size_t thread) { ++visits[thread]; });
+    EXPECT_EQ(visits, std::vector<int>(4, 2));
+
+    std::vector<size_t> covered(103, 0);
+    pool.for_chunks(covered.size(), [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) ++covered[i];
+    });
+    EXPECT_EQ(covered, std::vector<size_t>(103, 1));
+
+    EXPECT_THROW(pool.run([](size_t thread) {
+        if (thread == 2) throw std::runtime_error("worker failure");
+    }), std::runtime_error);
+    // The pool stays usable after a failed run
+    pool.run([&](size_t thread) { ++visits[thread]; });
+    EXPECT_EQ(visits[3], 3);
+}
+
+TEST(SearchPolicy, CoarseToFineMatchesExhaustiveWithFewerEvaluations) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{150, 20}, {20, 120}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+
+    SolverMinThrows exhaustive(game, 2500);
+    SolverMinThrows coarse_to_fine(game, 2500, SearchPolicy::coarse_to_fine(256, 8));
+    for (Game::State s = 2; s <= 120; s += 2) {
+        auto [exact, exact_aim] = exhaustive.solve(s);
+        auto [searched, searched_aim] = coarse_to_fine.solve(s);
+        if (exact >= 1e9) {
+            EXPECT_GE(searched, 1e9) << "state " << s;
+            continue;
+        }
+        // The polish may even beat the best grid aim
+        EXPECT_LT(searched, exact * 1.01) << "state " << s;
+    }
+    EXPECT_LT(coarse_to_fine.get_aim_evaluations() * 5, exhaustive.get_aim_evaluations());
+}
+
+TEST(SearchPolicy, MaxPointsAndRoundsUseThePolicy) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{100, 0}, {0, 100}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnAny game(target, dist);
+
+    MaxPointsSolver exhaustive(game, 900);
+    MaxPointsSolver coarse_to_fine(game, 900, SearchPolicy::coarse_to_fine(64, 4, 0));
+    EXPECT_NEAR(coarse_to_fine.solve(1000).first, exhaustive.solve(1000).first, 0.01 * exhaustive.solve(1000).first);
+    EXPECT_LT(coarse_to_fine.get_aim_evaluations() * 3, exhaustive.get_aim_evaluations());
+    // Without polish the aim stays on the grid
+    size_t index;
+    EXPECT_TRUE(coarse_to_fine.get_aim_grid().find(coarse_to_fine.solve(1000).second, index));
+
+    SolverMinRounds rounds_exhaustive(game, 3, 400);
+    SolverMinRounds rounds_searched(game, 3, 400, SearchPolicy::coarse_to_fine(49, 4));
+    for (Game::State s : {20u, 40u, 70u}) {
+        EXPECT_LT(rounds_searched.solve(s).first, rounds_exhaustive.solve(s).first * 1.02) << "state " << s;
+    }
+    EXPECT_LT(rounds_searched.get_aim_evaluations(), rounds_exhaustive.get_aim_evaluations());
+}
+
+TEST(SearchPolicy, PruningKeepsResultsBitForBit) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{120, 15}, {15, 90}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+
+    Instrumentation::reset();
+    SolverMinThrows plain(game, 1600);
+    SolverMinThrows pruned(game, 1600, SearchPolicy::exhaustive(true));
+    SolverMinThrows pruned_all(game, 1600, SearchPolicy::exhaustive(true));
+    pruned_all.solve_all(120, 3);
+    for (Game::State s = 1; s <= 120; ++s) {
+        auto expected = plain.solve(s);
+        auto result = pruned.solve(s);
+        EXPECT_EQ(result.first, expected.first) << "state " << s;
+        EXPECT_EQ(result.second, expected.second) << "state " << s;
+        EXPECT_EQ(pruned_all.solve(s).first, expected.first) << "state " << s;
+        EXPECT_EQ(pruned_all.solve(s).second, expected.second) << "state " << s;
+    }
+    EXPECT_EQ(plain.get_pruned_aims(), 0u);
+    // Most states of this board are unwinable and have no score to beat
+    EXPECT_GT(pruned.get_pruned_aims(), 0u);
+    EXPECT_LT(pruned.get_pruned_aims(), pruned.get_aim_evaluations());
+    EXPECT_GT(pruned_all.get_pruned_aims(), 0u);
+    const uint64_t counted = Instrumentation::report().counters[static_cast<size_t>(Instrumentation::Counter::PRUNED_AIMS)];
+    EXPECT_EQ(counted, Instrumentation::ENABLED ? pruned.get_pruned_aims() + pruned_all.get_pruned_aims() : 0u);
+}
+
+// === SolutionTable Tests ===
+
+TEST(SolutionTable, RoundTripServesSolversAndHeatMaps) {
+    Target target = create_simple_target();
+    NormalDistribution::covariance cov = {{{150.0, 0.0}, {0.0, 150.0}}};
+    NormalDistributionQuadrature dist(cov, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    const std::string path = (std::filesystem::temp_directory_path() / "darts_solution_table_test.dsol").string();
+
+    SolverMinThrows writer(game, 400);
+    SolutionTable::write(path, writer, 90, 12, 10);
+    HeatMapVisualizer computed(writer, 12, 10);
+
+    auto table = SolutionTable::open(path);
+    EXPECT_EQ(table->get_state_count(), 91u);
+    SolverMinThrows reader(game, 400);
+    reader.use_solution_table(table);
+    for (Game::State s = 1; s <= 90; ++s) {
+        auto expected = writer.solve(s);
+        auto stored = reader.solve(s);
+        EXPECT_EQ(stored.first, expected.first) << "state " << s;
+        EXPECT_EQ(stored.second, expected.second) << "state " << s;
+    }
+    EXPECT_EQ(reader.get_aim_evaluations(), 0u);
+    // States past the table are solved on top of the stored ones
+    EXPECT_EQ(reader.solve(100).first, writer.solve(100).first);
+
+    HeatMapVisualizer served(reader, 12, 10);
+    EXPECT_EQ(served.heat_map(40), computed.heat_map(40));
+    EXPECT_EQ(HeatMapVisualizer(reader, 5, 5).heat_map(40), HeatMapVisualizer(writer, 5, 5).heat_map(40)); // No planes of this size
+
+    // Any change of configuration changes the key
+    SolverMinRounds rounds(game, 3, 400);
+    SolverMinThrows coarser(game, 100);
+    NormalDistributionQuadrature wider({{{200.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble wider_game(target, wider);
+    GameFinishOnAny any_game(target, dist);
+    EXPECT_THROW(rounds.use_solution_table(table), std::invalid_argument);
+    EXPECT_THROW(coarser.use_solution_table(table), std::invalid_argument);
+    EXPECT_THROW(SolverMinThrows(wider_game, 400).use_solution_table(table), std::invalid_argument);
+    EXPECT_THROW(SolverMinThrows(any_game, 400).use_solution_table(table), std::invalid_argument);
+    EXPECT_NE(SolverMinRounds(game, 3, 400).solution_key(), SolverMinRounds(game, 1, 400).solution_key());
+    EXPECT_EQ(SolverMinThrows(game, 400, SearchPolicy::exhaustive(true)).solution_key(), reader.solution_key());
+
+    // The same bytes from memory, then damaged copies
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> chars((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto bytes = std::as_bytes(std::span(chars));
+    EXPECT_EQ(SolutionTable::from_bytes(bytes)->find(40), table->find(40));
+    EXPECT_THROW((void)SolutionTable::from_bytes(bytes.first(bytes.size() - 8)), std::runtime_error);
+    std::vector<std::byte> wrong_version(bytes.begin(), bytes.end());
+    wrong_version[8] = std::byte{99};
+    EXPECT_THROW((void)SolutionTable::from_bytes(wrong_version), std::runtime_error);
+    EXPECT_THROW((void)SolutionTable::open(path + ".missing"), std::runtime_error);
+
+    table.reset();
+    reader.use_solution_table(nullptr);
+    std::filesystem::remove(path);
+}
+
+TEST(SolutionTable, KeyCoversTheSourceOfHitProbabilities) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{150.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble field_game(target, dist);
+    HitProbabilityField field(target, dist, field_game.aim_grid(400));
+    field_game.use_hit_probability_field(field);
+    const std::string path = (std::filesystem::temp_directory_path() / "darts_field_table_test.dsol").string();
+    SolverMinThrows writer(field_game, 400);
+    SolutionTable::write(path, writer, 40);
+    auto table = SolutionTable::open(path);
+
+    // Pure quadrature results differ from the field's by its discretisation
+    GameFinishOnDouble quadrature_game(target, dist);
+    EXPECT_THROW(SolverMinThrows(quadrature_game, 400).use_solution_table(table), std::invalid_argument);
+    SolverMinThrows reader(field_game, 400);
+    EXPECT_NO_THROW(reader.use_solution_table(table));
+
+    // Resolution and precision of the field, and bed culling, are part of the key too
+    GameFinishOnDouble other_game(target, dist);
+    HitProbabilityField coarse(target, dist, other_game.aim_grid(400), 2.0);
+    other_game.use_hit_probability_field(coarse);
+    EXPECT_NE(SolverMinThrows(other_game, 400).solution_key(), writer.solution_key());
+    HitProbabilityField rounded(target, dist, other_game.aim_grid(400), 1.0, Precision::FLOAT);
+    other_game.use_hit_probability_field(rounded);
+    EXPECT_NE(SolverMinThrows(other_game, 400).solution_key(), writer.solution_key());
+    const uint64_t quadrature_key = SolverMinThrows(quadrature_game, 400).solution_key();
+    quadrature_game.set_cull_sigmas(4.0);
+    EXPECT_NE(SolverMinThrows(quadrature_game, 400).solution_key(), quadrature_key);
+    quadrature_game.set_cull_sigmas(Game::DEFAULT_CULL_SIGMAS);
+    EXPECT_EQ(SolverMinThrows(quadrature_game, 400).solution_key(), quadrature_key);
+    quadrature_game.set_strict_integration(true);
+    EXPECT_NE(SolverMinThrows(quadrature_game, 400).solution_key(), quadrature_key);
+
+    table.reset();
+    reader.use_solution_table(nullptr);
+    std::filesystem::remove(path);
+}
+
+TEST(CovarianceBatch, TablesMatchProfilesSolvedOneByOne) {
+    Target target = create_simple_target();
+    const std::vector<NormalDistribution::covariance> covariances = {
+        {{{150.0, 0.0}, {0.0, 150.0}}}, {{{400.0, 50.0}, {50.0, 300.0}}}, {{{900.0, 0.0}, {0.0, 900.0}}}};
+    std::vector<std::string> paths;
+    for (size_t p = 0; p < covariances.size(); ++p) {
+        paths.push_back((std::filesystem::temp_directory_path() / ("darts_batch_test_" + std::to_string(p) + ".dsol")).string());
+    }
+
+    CovarianceBatch<GameFinishOnDouble> batch(target, covariances, 400);
+    auto keys = batch.write(paths, 60, 2);
+    ASSERT_EQ(keys.size(), covariances.size());
+
+    // The same fields and solver by hand
+    std::vector<std::unique_ptr<NormalDistributionQuadrature>> distributions;
+    std::vector<const NormalDistribution*> views;
+    for (const auto& cov : covariances) {
+        distributions.push_back(std::make_unique<NormalDistributionQuadrature>(cov, Vec2{0, 0}));
+        views.push_back(distributions.back().get());
+    }
+    GameFinishOnDouble probe(target, *distributions[0]);
+    auto fields = HitProbabilityField::batch(target, views, probe.aim_grid(400));
+    for (size_t p = 0; p < covariances.size(); ++p) {
+        GameFinishOnDouble game(target, *distributions[p]);
+        game.use_hit_probability_field(fields[p]);
+        SolverMinThrows solver(game, 400);
+        EXPECT_EQ(keys[p], solver.solution_key());
+
+        auto table = SolutionTable::open(paths[p]);
+        EXPECT_EQ(table->get_key(), keys[p]);
+        for (Game::State s = 1; s <= 60; ++s) {
+            auto expected = solver.solve(s);
+            auto stored = table->find(s);
+            ASSERT_TRUE(stored.has_value());
+            EXPECT_EQ(stored->first, expected.first) << "profile " << p << ", state " << s;
+            EXPECT_EQ(stored->second, expected.second) << "profile " << p << ", state " << s;
+        }
+        std::filesystem::remove(paths[p]);
+    }
+    EXPECT_THROW((void)batch.write({paths[0]}, 60), std::invalid_argument);
+}
+
+TEST(MatchSimulator, MeanDartsMatchesSolverExpectation) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{150.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinThrows solver(game, 400);
+    MatchSimulator simulator(game, LegPolicy::from_solver(solver, 100));
+
+    auto result = simulator.simulate(100, 20000, 2);
+    EXPECT_EQ(result.legs, 20000u);
+    EXPECT_EQ(result.unfinished, 0u);
+    const double expected = solver.solve(100).first;
+    const double sem = result.darts.std_dev / std::sqrt(20000.0);
+    EXPECT_NEAR(result.darts.mean, expected, 4 * sem);
+    EXPECT_LT(result.darts.ci_low, result.darts.mean);
+    EXPECT_GT(result.darts.ci_high, result.darts.mean);
+    EXPECT_GE(result.darts_thrown, 20000u * 3); // 100 takes at least three darts
+
+    // Rounds of a per-dart policy are darts in groups of three
+    EXPECT_GE(result.rounds.mean * 3, result.darts.mean);
+    EXPECT_LT(result.rounds.mean * 3 - 3, result.darts.mean);
+    EXPECT_THROW((void)simulator.simulate(101, 10), std::out_of_range);
+}
+
+TEST(MatchSimulator, MeanRoundsMatchesRoundSolverExpectation) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{150.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinRounds solver(game, 3, 100);
+    MatchSimulator simulator(game, LegPolicy::from_solver(solver, 100));
+    EXPECT_EQ(LegPolicy::from_solver(solver, 100).get_throws_per_round(), 3u);
+
+    auto result = simulator.simulate(100, 20000, 2);
+    EXPECT_EQ(result.unfinished, 0u);
+    const double expected = solver.solve(100).first;
+    const double sem = result.rounds.std_dev / std::sqrt(20000.0);
+    EXPECT_NEAR(result.rounds.mean, expected, 4 * sem);
+    uint64_t finished = 0;
+    for (uint64_t count : result.rounds.histogram) finished += count;
+    EXPECT_EQ(finished, 20000u);
+}
+
+TEST(MatchSimulator, ThreadCountDoesNotMatter) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{400.0, 50.0}, {50.0, 300.0}}}, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinThrows solver(game, 400);
+    MatchSimulator simulator(game, LegPolicy::from_solver(solver, 80), 7);
+
+    auto serial = simulator.simulate(80, 3000, 1);
+    auto parallel = simulator.simulate(80, 3000, 3);
+    EXPECT_EQ(serial.darts.histogram, parallel.darts.histogram);
+    EXPECT_EQ(serial.rounds.histogram, parallel.rounds.histogram);
+    EXPECT_EQ(serial.darts_thrown, parallel.darts_thrown);
+    EXPECT_EQ(serial.darts.mean, parallel.darts.mean);
+}
+
+TEST(Instrumentation, CountsHotPathsOnlyWhenCompiledIn) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{150.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    Instrumentation::reset();
+    SolverMinThrows solver(game, 100);
+    (void)solver.solve(60);
+    SolverMinRounds rounds(game, 3, 100);
+    (void)rounds.solve(60);
+    HeatMapVisualizer visualizer(solver, 5, 4);
+    (void)visualizer.heat_map(60);
+
+    const auto report = Instrumentation::report();
+    auto counter = [&](Instrumentation::Counter c) { return report.counters[static_cast<size_t>(c)]; };
+    if constexpr (!Instrumentation::ENABLED) {
+        for (uint64_t value : report.counters) EXPECT_EQ(value, 0u);
+        EXPECT_TRUE(report.aim_evaluations_by_state.empty());
+        EXPECT_TRUE(report.round_convergence.empty());
+        return;
+    }
+    EXPECT_EQ(counter(Instrumentation::Counter::HEAT_MAP_CELLS), 20u);
+    EXPECT_GT(counter(Instrumentation::Counter::INTEGRATIONS), 0u);
+    EXPECT_GT(counter(Instrumentation::Counter::OUTCOME_ROW_HITS), counter(Instrumentation::Counter::OUTCOME_ROW_MISSES));
+    // Every evaluation is counted once, for the state whose search made it
+    uint64_t by_state = 0;
+    for (uint64_t evaluations : report.aim_evaluations_by_state) by_state += evaluations;
+    EXPECT_EQ(by_state, counter(Instrumentation::Counter::AIM_EVALUATIONS));
+    EXPECT_EQ(by_state, solver.get_aim_evaluations() + rounds.get_aim_evaluations());
+    ASSERT_GT(report.aim_evaluations_by_state.size(), 60u);
+    EXPECT_EQ(report.aim_evaluations_by_state[60] > 0, true);
+
+    ASSERT_FALSE(report.round_convergence.empty());
+    EXPECT_EQ(report.round_convergence.back().state, 60u);
+    unsigned int iterations = 0;
+    for (const auto& round : report.round_convergence) iterations += round.iterations;
+    EXPECT_EQ(iterations, counter(Instrumentation::Counter::ROUND_ITERATIONS));
+    EXPECT_GT(report.round_dp_cache_entries, 0u);
+    EXPECT_GT(report.timer_calls[static_cast<size_t>(Instrumentation::Timer::SOLVE_MIN_THROWS)], 0u);
+
+    Instrumentation::reset();
+    EXPECT_EQ(Instrumentation::report().counters[static_cast<size_t>(Instrumentation::Counter::INTEGRATIONS)], 0u);
+}
+
+TEST(LruCache, EvictsLeastRecentlyUsedWithinBudget) {
+    constexpr size_t entry = 100 + LruCache<int, int>::ENTRY_OVERHEAD;
+    LruCache<int, int> cache(3 * entry);
+    for (int key = 0; key < 3; ++key) cache.insert(key, key, 100);
+    ASSERT_NE(cache.find(0), nullptr); // 1 is now the least recently used
+    cache.insert(3, 3, 100);
+    EXPECT_FALSE(cache.contains(1));
+    EXPECT_TRUE(cache.contains(0));
+    EXPECT_EQ(cache.usage().bytes, 3 * entry);
+    EXPECT_EQ(cache.usage().evictions, 1u);
+
+    std::vector<int> evicted;
+    EXPECT_EQ(cache.trim(entry, [&](int key, int) { evicted.push_back(key); }), 2 * entry);
+    EXPECT_EQ(evicted, (std::vector<int>{2, 0}));
+    cache.insert(4, 4, 4 * entry); // Larger than the whole budget
+    EXPECT_FALSE(cache.contains(4));
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(Integration, BoundedCachesKeepResults) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{150.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinThrows solver(game, 100);
+
+    HeatMapVisualizer visualizer(solver, 6, 5);
+    const size_t map_bytes = 6 * 5 * sizeof(float) + LruCache<Game::State, std::vector<float>>::ENTRY_OVERHEAD;
+    visualizer.set_memo_budget(2 * map_bytes);
+    auto first = visualizer.heat_map(40);
+    (void)visualizer.heat_map(41);
+    (void)visualizer.heat_map(42);
+    EXPECT_EQ(visualizer.get_memo_usage().entries, 2u);
+    EXPECT_EQ(visualizer.get_memo_usage().bytes, 2 * map_bytes);
+    EXPECT_EQ(visualizer.get_memo_usage().evictions, 1u);
+    auto again = visualizer.heat_map(40); // Evicted, computed again
+    auto memoized = visualizer.heat_map(40);
+    for (size_t i = 0; i < first.size(); ++i) {
+        EXPECT_EQ(again.data()[i], first.data()[i]);
+        EXPECT_FLOAT_EQ(memoized.data()[i], first.data()[i]);
+    }
+    EXPECT_EQ(visualizer.trim_memo(0), 2 * map_bytes);
+
+    // Heat map cells are off-grid aims; trimmed rows are reused by the next ones
+    const CacheUsage rows_before = game.get_outcome_table_usage();
+    EXPECT_GT(game.trim_off_grid_rows(0), 0u);
+    EXPECT_LT(game.get_outcome_table_usage().entries, rows_before.entries);
+    HeatMapVisualizer shifted(solver, 5, 6);
+    (void)shifted.heat_map(40);
+    EXPECT_EQ(game.get_outcome_table_usage().entries, rows_before.entries);
+    auto recomputed = visualizer.heat_map(40); // Served from reused rows
+    for (size_t i = 0; i < first.size(); ++i) EXPECT_EQ(recomputed.data()[i], first.data()[i]);
+
+    SolverMinRounds unbounded(game, 3, 100);
+    SolverMinRounds bounded(game, 3, 100);
+    bounded.set_round_cache_budget(4096);
+    for (Game::State s : {30u, 50u, 60u}) {
+        EXPECT_NEAR(bounded.solve(s).first, unbounded.solve(s).first, 1e-9);
+        EXPECT_NEAR(bounded.solve_aim_round_state(s, s - 5, 2, Vec2{0, 0}),
+                    unbounded.solve_aim_round_state(s, s - 5, 2, Vec2{0, 0}), 1e-9);
+    }
+    EXPECT_LE(bounded.get_round_cache_usage().bytes, 4096u);
+    EXPECT_GT(bounded.get_round_cache_usage().evictions, 0u);
+}
+
+TEST(Integration, RetainedAimScoresServeHeatMaps) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{150.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinThrows computed(game, 100);
+    SolverMinThrows retained(game, 100, SearchPolicy::exhaustive(true));
+    retained.set_retain_aim_scores(true);
+    retained.solve_all(100);
+    EXPECT_EQ(retained.get_aim_score_usage().entries, 100u);
+    EXPECT_EQ(retained.get_pruned_aims(), 0u); // Every aim needs a score
+
+    // The grid is 10 x 10 over the target bounds, so a 10 x 10 map reads the plane
+    HeatMapVisualizer from_plane(retained, 10, 10);
+    HeatMapVisualizer evaluated(computed, 10, 10);
+    for (Game::State s : {40u, 60u, 100u}) {
+        auto expected = evaluated.heat_map(s);
+        auto served = from_plane.heat_map(s);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_FLOAT_EQ(served.data()[i], expected.data()[i]);
+        }
+        // A 5 x 5 map's centres lie between four grid aims
+        auto coarse = retained.retained_heat_map(s, game.get_target_bounds(), 5, 5);
+        ASSERT_TRUE(coarse.has_value());
+        for (size_t r = 0; r < 5; ++r) {
+            for (size_t c = 0; c < 5; ++c) {
+                const double mean = (served(2 * r, 2 * c) + served(2 * r, 2 * c + 1)
+                                     + served(2 * r + 1, 2 * c) + served(2 * r + 1, 2 * c + 1)) / 4.0;
+                EXPECT_NEAR((*coarse)(r, c), mean, 1e-9 * std::abs(mean));
+            }
+        }
+    }
+    EXPECT_FALSE(retained.retained_heat_map(101, game.get_target_bounds(), 10, 10).has_value());
+    retained.set_retain_aim_scores(false);
+    EXPECT_EQ(retained.get_aim_score_usage().entries, 0u);
+
+    SolverMinRounds rounds(game, 3, 100);
+    rounds.set_retain_aim_scores(true);
+    (void)rounds.solve(60);
+    (void)rounds.solve_round_state(60, 40, 2);
+    const auto bounds = game.get_target_bounds();
+    auto start = rounds.retained_heat_map(60, bounds, 10, 10);
+    auto mid_round = rounds.retained_heat_map_round_state(60, 40, 2, bounds, 10, 10);
+    ASSERT_TRUE(start.has_value());
+    ASSERT_TRUE(mid_round.has_value());
+    for (size_t r = 0; r < 10; ++r) {
+        for (size_t c = 0; c < 10; ++c) {
+            const Vec2 aim = rounds.get_aim_grid()[rounds.get_aim_grid().index(c, r)];
+            const double start_value = rounds.solve_aim(60, aim);
+            const double mid_value = rounds.solve_aim_round_state(60, 40, 2, aim);
+            EXPECT_NEAR((*start)(r, c), start_value, 1e-6 * start_value);
+            EXPECT_NEAR((*mid_round)(r, c), mid_value, 1e-6 * mid_value);
+        }
+    }
+}
+
+TEST(ResultStream, WritesNpyRecordsInBothModes) {
+    Target target = create_simple_target();
+    NormalDistributionQuadrature dist({{{150.0, 0.0}, {0.0, 150.0}}}, Vec2{0, 0});
+    GameFinishOnDouble game(target, dist);
+    SolverMinThrows solver(game, 100);
+    HeatMapVisualizer visualizer(solver, 4, 3);
+    const Game::Bounds bounds = game.get_target_bounds();
+
+    for (bool background : {false, true}) {
+        const std::string path = (std::filesystem::temp_directory_path() / "darts_result_stream_test.npy").string();
+        {
+            ResultStream stream(path, 3, 4, 3, bounds, background);
+            for (Game::State s = 40; s < 43; ++s) {
+                auto [score, aim] = solver.solve(s);
+                stream.push({s, score, aim, visualizer.heat_map(s)});
+            }
+            EXPECT_THROW(stream.push({43, 0.0, Vec2{0, 0}, HeatMap(4, 3)}), std::invalid_argument);
+            stream.close();
+        }
+
+        std::ifstream input(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        ASSERT_GE(bytes.size(), 10u);
+        EXPECT_EQ(bytes.substr(0, 8), std::string("\x93NUMPY\x01\x00", 8));
+        const size_t header_size = static_cast<unsigned char>(bytes[8]) | (static_cast<unsigned char>(bytes[9]) << 8);
+        const std::string header = bytes.substr(10, header_size);
+        EXPECT_NE(header.find(ResultStream::dtype_descr(4, 3)), std::string::npos);
+        EXPECT_NE(header.find("'shape': (3,)"), std::string::npos);
+        EXPECT_EQ(header.back(), '\n');
+        EXPECT_EQ((10 + header_size) % 64, 0u);
+        ASSERT_EQ(bytes.size(), 10 + header_size + 3 * ResultStream::record_size(4, 3));
+
+        for (Game::State s = 40; s < 43; ++s) {
+            const char* record = bytes.data() + 10 + header_size + (s - 40) * ResultStream::record_size(4, 3);
+            uint32_t state;
+            double fields[7];
+            std::memcpy(&state, record, sizeof(state));
+            std::memcpy(fields, record + sizeof(state), sizeof(fields));
+            EXPECT_EQ(state, s);
+            EXPECT_EQ(fields[0], solver.solve(s).first);
+            EXPECT_EQ(fields[1], solver.solve(s).second.x);
+            EXPECT_EQ(fields[3], bounds.min.x);
+            EXPECT_EQ(fields[6], bounds.max.y);
+            const HeatMap expected = visualizer.heat_map(s);
+            for (size_t cell = 0; cell < expected.size(); ++cell) {
+                float value;
+                std::memcpy(&value, record + sizeof(state) + sizeof(fields) + cell * sizeof(float), sizeof(value));
+                EXPECT_EQ(value, static_cast<float>(expected.data()[cell]));
+            }
+        }
+        std::filesystem::remove(path);
+    }
+
+    // Without heat maps the records stop after the extent, and closing early is an error
+    const std::string path = (std::filesystem::temp_directory_path() / "darts_result_stream_short.npy").string();
+    ResultStream stream(path, 2, 0, 0, bounds);
+    EXPECT_EQ(ResultStream::record_size(0, 0), 60u);
+    EXPECT_EQ(ResultStream::dtype_descr(0, 0).find("heat_map"), std::string::npos);
+    stream.push({40, 1.0, Vec2{0, 0}, HeatMap(4, 3)});
+    EXPECT_THROW(stream.close(), std::runtime_error);
+    std::filesystem::remove(path);
+}
@@ -10,8 +10,28 @@ import numpy as np
 import argparse
 
 
+def parse_npy_results(filename):
+    """Load the record array written by darts_solver --stream, without parsing any text."""
+    records = np.load(filename, mmap_mode='r')
+    has_heat_maps = 'heat_map' in records.dtype.names
+    results = []
+    for record in records:
+        results.append({
+            'state': int(record['state']),
+            'expected_throws': float(record['score']),
+            'aim': (float(record['aim'][0]), float(record['aim'][1])),
+            'heat_map': np.asarray(record['heat_map'], dtype=np.float64) if has_heat_maps else None,
+            'heat_map_extent': tuple(float(v) for v in record['extent'])
+        })
+    return results, None
+
+
 def parse_results(filename):
     """Parse the results file and extract state, expected throws, aim coordinates, and heat maps."""
+    with open(filename, 'rb') as f:
+        if f.read(6) == b'\x93NUMPY':
+            return parse_npy_results(filename)
+
     results = []
     avg_distance = None
     
@@ -295,13 +315,13 @@ def visualize_state(results, state_num, avg_distance=None, show_heatmap=True, he
         return
     
     # Determine if we should show dartboard colors
-    has_heatmap = show_heatmap and state_data.get('heat_map')
+    has_heatmap = show_heatmap and state_data.get('heat_map') is not None
     
     # Draw dartboard (disable colors if heat map is shown)
     draw_dartboard(ax, show_colors=not has_heatmap)
     
     # Draw heat map if available and requested
-    if show_heatmap and state_data.get('heat_map'):
+    if show_heatmap and state_data.get('heat_map') is not None:
         draw_heat_map(ax, state_data['heat_map'], state_data.get('heat_map_extent'), vmax=heat_vmax)
     
     # Plot the optimal aim point
@@ -404,13 +424,13 @@ def interactive_visualizer(results, avg_distance=None, show_heatmap=True, heat_v
             return
         
         # Determine if we should show dartboard colors
-        has_heatmap = show_heatmap and state_data.get('heat_map')
+        has_heatmap = show_heatmap and state_data.get('heat_map') is not None
         
         # Draw dartboard (disable colors if heat map is shown)
         draw_dartboard(ax, show_colors=not has_heatmap)
         
         # Draw heat map if available and requested
-        if show_heatmap and state_data.get('heat_map'):
+        if show_heatmap and state_data.get('heat_map') is not None:
             result = draw_heat_map(ax, state_data['heat_map'], state_data.get('heat_map_extent'), vmax=heat_vmax)
             if result and result[1] is not None:
                 current_colorbar[0] = result[1]
@@ -473,7 +493,7 @@ def interactive_visualizer(results, avg_distance=None, show_heatmap=True, heat_v
 def main():
     parser = argparse.ArgumentParser(description='Visualize darts optimal aim points')  
     parser.add_argument('--file', '-f', default='results.out', 
-                       help='Results file to read (default: results.out)')
+                       help='Results file to read, text or the .npy of darts_solver --stream (default: results.out)')
     parser.add_argument('--state', '-s', type=int, 
                        help='Show specific state number')
     parser.add_argument('--all', '-a', action='store_true', 